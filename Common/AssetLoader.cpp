@@ -0,0 +1,320 @@
+//***************************************************************************************
+// AssetLoader.cpp
+//***************************************************************************************
+
+#include "AssetLoader.h"
+#include "MeshBuilder.h"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+using Microsoft::WRL::ComPtr;
+
+AssetLoader::AssetLoader(ThreadPool& pool, ID3D12Device* device, ID3D12CommandQueue* queue,
+	GeometryRegistry* registry, GeometryResidency* residency)
+	: mPool(pool), mDevice(device), mQueue(queue), mRegistry(registry), mResidency(residency)
+{
+	ThrowIfFailed(mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+		IID_PPV_ARGS(mUploadAlloc.GetAddressOf())));
+
+	ThrowIfFailed(mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT,
+		mUploadAlloc.Get(), nullptr, IID_PPV_ARGS(mUploadList.GetAddressOf())));
+
+	// Start off in a closed state; Publish resets the list before each upload.
+	ThrowIfFailed(mUploadList->Close());
+
+	ThrowIfFailed(mDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mUploadFence)));
+}
+
+AssetLoader::~AssetLoader()
+{
+	// The loads may reference objects owned by whoever queued them.
+	for(auto& load : mGeometries)
+		load.Work.wait();
+	for(auto& load : mMaterials)
+		load.Work.wait();
+
+	if(mUploadFence->GetCompletedValue() < mUploadFenceValue)
+	{
+		HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
+		ThrowIfFailed(mUploadFence->SetEventOnCompletion(mUploadFenceValue, eventHandle));
+		WaitForSingleObject(eventHandle, INFINITE);
+		CloseHandle(eventHandle);
+	}
+}
+
+std::shared_future<MeshGeometry*> AssetLoader::LoadGeometry(std::function<std::unique_ptr<MeshGeometry>()> load,
+	GeometryResidency::ReloadFn reload)
+{
+	PendingLoad<MeshGeometry> pending;
+	pending.Work = mPool.Submit(std::move(load));
+	pending.Reload = std::move(reload);
+
+	std::shared_future<MeshGeometry*> published = pending.Published.get_future().share();
+	mGeometries.push_back(std::move(pending));
+
+	return published;
+}
+
+std::shared_future<MeshGeometry*> AssetLoader::LoadGeometryFromCache(std::wstring cacheFile, std::wstring sourceFile,
+	std::function<std::unique_ptr<MeshGeometry>()> build)
+{
+	// Geometry without CPU copies can only be uploaded by the registry and only be
+	// refilled by the residency.
+	const bool map = mRegistry != nullptr && mResidency != nullptr;
+	auto copyData = map ? std::make_shared<MeshCache::CopyDataFn>() : nullptr;
+
+	auto load = [cacheFile, sourceFile, build = std::move(build), copyData]()
+	{
+		std::unique_ptr<MeshGeometry> geo = copyData != nullptr ?
+			MeshCache::Map(cacheFile, sourceFile, *copyData) : MeshCache::Read(cacheFile, sourceFile);
+
+		return geo != nullptr ? std::move(geo) : build();
+	};
+
+	PendingLoad<MeshGeometry> pending;
+	pending.Work = mPool.Submit(std::move(load));
+	pending.Reload = ReloadFromCache(std::move(cacheFile), std::move(sourceFile));
+	pending.CopyData = std::move(copyData);
+
+	std::shared_future<MeshGeometry*> published = pending.Published.get_future().share();
+	mGeometries.push_back(std::move(pending));
+
+	return published;
+}
+
+std::shared_future<Material*> AssetLoader::LoadMaterial(std::function<std::unique_ptr<Material>()> load)
+{
+	PendingLoad<Material> pending;
+	pending.Work = mPool.Submit(std::move(load));
+
+	std::shared_future<Material*> published = pending.Published.get_future().share();
+	mMaterials.push_back(std::move(pending));
+
+	return published;
+}
+
+GeometryResidency::ReloadFn AssetLoader::ReloadFromCache(std::wstring cacheFile, std::wstring sourceFile)
+{
+	return [cacheFile = std::move(cacheFile), sourceFile = std::move(sourceFile)](MeshGeometry& geo)
+	{
+		std::unique_ptr<MeshGeometry> loaded = MeshCache::Read(cacheFile, sourceFile);
+		if(loaded == nullptr || loaded->VertexBufferCPU == nullptr || loaded->IndexBufferCPU == nullptr ||
+		   loaded->VertexBufferByteSize != geo.VertexBufferByteSize ||
+		   loaded->IndexBufferByteSize != geo.IndexBufferByteSize)
+		{
+			return false;
+		}
+
+		geo.VertexBufferCPU = loaded->VertexBufferCPU;
+		geo.IndexBufferCPU = loaded->IndexBufferCPU;
+		return true;
+	};
+}
+
+void AssetLoader::Retire(std::unique_ptr<MeshGeometry> geo)
+{
+	if(mResidency != nullptr)
+		mResidency->Untrack(*geo);
+
+	// The upload fence value was signaled on the drawing queue after every frame
+	// submitted so far, which are the only ones that can draw the old geometry.
+	if(mRegistry != nullptr)
+	{
+		mRegistry->Unregister(mRegistry->Find(*geo), mUploadFence.Get(), mUploadFenceValue);
+		mCompactPending = true;
+	}
+
+	mRetiredGeometries.emplace_back(std::move(geo), mUploadFenceValue);
+}
+
+template<typename T>
+std::vector<AssetLoader::PendingLoad<T>> AssetLoader::TakeFinished(std::vector<PendingLoad<T>>& loads)
+{
+	std::vector<PendingLoad<T>> finished;
+
+	auto it = std::stable_partition(loads.begin(), loads.end(), [](PendingLoad<T>& load)
+	{
+		return load.Work.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+	});
+
+	std::move(it, loads.end(), std::back_inserter(finished));
+	loads.erase(it, loads.end());
+
+	return finished;
+}
+
+size_t AssetLoader::Publish(GeometryMap& geometries, MaterialMap& materials)
+{
+	size_t publishedCount = 0;
+
+	// Failed loads are reported through their futures too; the first is rethrown
+	// once everything else that finished has been published.
+	std::exception_ptr error;
+	auto takeResult = [&error](auto& load, auto& result)
+	{
+		try
+		{
+			result = load.Work.get();
+			return true;
+		}
+		catch(...)
+		{
+			load.Published.set_exception(std::current_exception());
+			if(!error)
+				error = std::current_exception();
+		}
+
+		return false;
+	};
+
+	//
+	// Geometries.  The upload allocator can only be reset once the GPU is done with
+	// the previous upload; until then finished geometries stay queued.
+	//
+
+	const UINT64 completedUpload = mUploadFence->GetCompletedValue();
+
+	mRetiredGeometries.erase(std::remove_if(mRetiredGeometries.begin(), mRetiredGeometries.end(),
+		[completedUpload](const auto& retired) { return retired.second <= completedUpload; }),
+		mRetiredGeometries.end());
+
+	mRetiredArenas.erase(std::remove_if(mRetiredArenas.begin(), mRetiredArenas.end(),
+		[completedUpload](const auto& retired) { return retired.second <= completedUpload; }),
+		mRetiredArenas.end());
+
+	if(completedUpload >= mUploadFenceValue)
+	{
+		std::vector<PendingLoad<MeshGeometry>> finished = TakeFinished(mGeometries);
+
+		std::vector<std::unique_ptr<MeshGeometry>> geos(finished.size());
+		std::vector<bool> loaded(finished.size());
+		bool upload = false;
+		for(size_t i = 0; i < finished.size(); ++i)
+		{
+			loaded[i] = takeResult(finished[i], geos[i]);
+			upload |= geos[i] != nullptr;
+		}
+
+		// Retired geometries leave holes in the arenas.  They are packed once that
+		// would release an arena and less than half of the arenas is in use, before
+		// the new geometries are placed.
+		bool compact = false;
+		if(mCompactPending)
+		{
+			compact = mRegistry->GetReclaimableByteSize() > 0 &&
+				mRegistry->GetUsedByteSize()*2 < mRegistry->GetArenaByteSize();
+			mCompactPending = false;
+		}
+
+		if(upload || compact)
+		{
+			ThrowIfFailed(mUploadAlloc->Reset());
+			ThrowIfFailed(mUploadList->Reset(mUploadAlloc.Get(), nullptr));
+
+			std::vector<ComPtr<ID3D12Resource>> retiredArenas;
+			if(compact)
+				mRegistry->Compact(mUploadList.Get(), retiredArenas);
+
+			for(size_t i = 0; i < finished.size(); ++i)
+			{
+				MeshGeometry* geo = geos[i].get();
+				if(geo == nullptr)
+					continue;
+
+				if(mRegistry == nullptr)
+				{
+					MeshBuilder::Upload(*geo, mDevice, mUploadList.Get());
+					continue;
+				}
+
+				// A mapped cache is copied from the mapping, which is closed as soon as the
+				// copy is in the upload heap.  A malformed one fails its load only.
+				std::shared_ptr<MeshCache::CopyDataFn> copyData = std::move(finished[i].CopyData);
+				if(copyData == nullptr || !*copyData)
+				{
+					mRegistry->Register(*geo, mUploadList.Get());
+					continue;
+				}
+
+				try
+				{
+					mRegistry->Register(*geo, *copyData, mUploadList.Get());
+				}
+				catch(const std::runtime_error&)
+				{
+					finished[i].Published.set_exception(std::current_exception());
+					if(!error)
+						error = std::current_exception();
+
+					loaded[i] = false;
+					geos[i] = nullptr;
+				}
+
+				*copyData = nullptr;
+			}
+
+			ThrowIfFailed(mUploadList->Close());
+			ID3D12CommandList* cmdsLists[] = { mUploadList.Get() };
+			mQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+
+			// Work submitted to the queue after this sees the uploaded buffers; the
+			// fence only guards reuse of the allocator and the upload heaps.
+			ThrowIfFailed(mQueue->Signal(mUploadFence.Get(), ++mUploadFenceValue));
+
+			// The old arenas were signaled after every frame that draws from them and
+			// after the copies out of them.
+			for(auto& arena : retiredArenas)
+				mRetiredArenas.emplace_back(std::move(arena), mUploadFenceValue);
+		}
+
+		for(size_t i = 0; i < finished.size(); ++i)
+		{
+			if(!loaded[i])
+				continue;
+
+			MeshGeometry* published = geos[i].get();
+			if(published != nullptr)
+			{
+				// The upload heaps can go once the fence passes this upload's value.
+				if(mResidency != nullptr)
+					mResidency->Track(*published, mUploadFence.Get(), mUploadFenceValue, std::move(finished[i].Reload));
+
+				auto& slot = geometries[published->Name];
+				if(slot != nullptr)
+					Retire(std::move(slot));
+
+				slot = std::move(geos[i]);
+				++publishedCount;
+			}
+
+			finished[i].Published.set_value(published);
+		}
+	}
+
+	//
+	// Materials need no upload.
+	//
+
+	std::vector<PendingLoad<Material>> finished = TakeFinished(mMaterials);
+	for(PendingLoad<Material>& load : finished)
+	{
+		std::unique_ptr<Material> mat;
+		if(!takeResult(load, mat))
+			continue;
+
+		Material* published = mat.get();
+		if(published != nullptr)
+		{
+			materials[published->Name] = std::move(mat);
+			++publishedCount;
+		}
+
+		load.Published.set_value(published);
+	}
+
+	if(error)
+		std::rethrow_exception(error);
+
+	return publishedCount;
+}
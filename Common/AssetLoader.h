@@ -0,0 +1,146 @@
+//***************************************************************************************
+// AssetLoader.h
+//
+// Loads meshes and materials in the background.  Each load runs on a ThreadPool worker
+// and produces the asset with its CPU copies; Publish, called by the main thread once
+// per frame, uploads the geometries that are done on the loader's own command list and
+// hands the finished assets to the application.  Loads that are still running simply
+// are not there yet, so the frame goes on without them.
+//
+// Given a GeometryResidency, published geometries are tracked by it: their uploaders
+// go once the upload completes, and the CPU copies of those loaded with a reload
+// function, usually one reading them back from a cache file, can be evicted.  Geometry
+// loaded from a cache file is uploaded straight from its mapping and starts out with
+// its CPU copies evicted.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "GeometryRegistry.h"
+#include "GeometryResidency.h"
+#include "MeshCache.h"
+#include "ThreadPool.h"
+
+class AssetLoader
+{
+public:
+
+	using GeometryMap = std::unordered_map<std::string, std::unique_ptr<MeshGeometry>>;
+	using MaterialMap = std::unordered_map<std::string, std::unique_ptr<Material>>;
+
+	// Uploads are submitted to queue, which must be the queue the geometries are drawn on.
+	// With a registry the geometries are sub-allocated from its arenas; otherwise each
+	// gets buffers of its own.  residency must outlive the loader.
+	AssetLoader(ThreadPool& pool, ID3D12Device* device, ID3D12CommandQueue* queue,
+		GeometryRegistry* registry = nullptr, GeometryResidency* residency = nullptr);
+	AssetLoader(const AssetLoader& rhs) = delete;
+	AssetLoader& operator=(const AssetLoader& rhs) = delete;
+
+	// Waits for the loads still running and for the last upload.
+	~AssetLoader();
+
+	///<summary>
+	/// Runs load on a worker.  It returns the geometry with its CPU copies, or nullptr if
+	/// there is nothing to load.  The future becomes ready when Publish has made the
+	/// geometry resident, so only wait on it from another thread or poll it.  With a
+	/// GeometryResidency, reload refills evicted CPU copies on the thread that asks for
+	/// them, so it should be cheap, such as ReloadFromCache; without one the copies
+	/// are never evicted.
+	///</summary>
+	std::shared_future<MeshGeometry*> LoadGeometry(std::function<std::unique_ptr<MeshGeometry>()> load,
+		GeometryResidency::ReloadFn reload = nullptr);
+
+	///<summary>
+	/// Maps the MeshCache file cacheFile on a worker.  With a registry and a
+	/// GeometryResidency, Publish copies its vertex and index data from the mapping
+	/// straight into the upload heap, decoding it there if it is compressed, and
+	/// publishes the geometry without CPU copies; ReloadFromCache reads them back when
+	/// they are asked for.  Otherwise the cache is read into the CPU copies, as
+	/// MeshCache::Read does.  If the cache is missing or stale, build, which runs on the
+	/// same worker, makes the geometry with its CPU copies instead.
+	///</summary>
+	std::shared_future<MeshGeometry*> LoadGeometryFromCache(std::wstring cacheFile, std::wstring sourceFile,
+		std::function<std::unique_ptr<MeshGeometry>()> build);
+
+	///<summary>
+	/// Runs load on a worker.  The future becomes ready when Publish has added the
+	/// material.
+	///</summary>
+	std::shared_future<Material*> LoadMaterial(std::function<std::unique_ptr<Material>()> load);
+
+	///<summary>
+	/// Moves the assets that finished loading into geometries and materials, keyed by
+	/// name, and returns how many were added.  Geometries are uploaded first, on a
+	/// command list submitted to the queue before returning, so they can be drawn by
+	/// anything submitted after.  If the previous upload is still in flight they wait
+	/// for a later call.  An exception thrown by a load is rethrown here.
+	///
+	/// A geometry published under the name of one in geometries replaces it.  The old
+	/// one is unregistered and untracked right away, but kept alive, with its ranges
+	/// unused, until the frames submitted before the replacement are done with it;
+	/// point anything that draws it at the new one before the next frame.  If that
+	/// leaves the registry's arenas less than half used, and packing them would release
+	/// an arena, the next upload compacts them first.
+	///</summary>
+	size_t Publish(GeometryMap& geometries, MaterialMap& materials);
+
+	// Number of loads not published yet.
+	size_t GetPendingCount()const { return mGeometries.size() + mMaterials.size(); }
+
+	///<summary>
+	/// A reload function that reads the CPU copies back from a MeshCache file, as
+	/// MeshCache::Read does, and fails if the file is gone or no longer matches the
+	/// geometry.
+	///</summary>
+	static GeometryResidency::ReloadFn ReloadFromCache(std::wstring cacheFile, std::wstring sourceFile);
+
+private:
+
+	template<typename T>
+	struct PendingLoad
+	{
+		std::future<std::unique_ptr<T>> Work;
+		std::promise<T*> Published;
+
+		// Refills evicted CPU copies; geometries only.
+		GeometryResidency::ReloadFn Reload;
+
+		// Set by the worker of a geometry mapped from a cache; the geometry is uploaded
+		// from the mapping.
+		std::shared_ptr<MeshCache::CopyDataFn> CopyData;
+	};
+
+	// Stops tracking and registering a geometry that was replaced and keeps it until
+	// the frames drawn with it are done.
+	void Retire(std::unique_ptr<MeshGeometry> geo);
+
+	// Moves the loads whose work is done out of loads, keeping their order.
+	template<typename T>
+	static std::vector<PendingLoad<T>> TakeFinished(std::vector<PendingLoad<T>>& loads);
+
+	ThreadPool& mPool;
+	ID3D12Device* mDevice = nullptr;
+	ID3D12CommandQueue* mQueue = nullptr;
+	GeometryRegistry* mRegistry = nullptr;
+	GeometryResidency* mResidency = nullptr;
+
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> mUploadAlloc;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mUploadList;
+	Microsoft::WRL::ComPtr<ID3D12Fence> mUploadFence;
+	UINT64 mUploadFenceValue = 0;
+
+	std::vector<PendingLoad<MeshGeometry>> mGeometries;
+	std::vector<PendingLoad<Material>> mMaterials;
+
+	// Replaced geometries and the upload fence value signaled after the last frame
+	// that may draw them.
+	std::vector<std::pair<std::unique_ptr<MeshGeometry>, UINT64>> mRetiredGeometries;
+
+	// Set when a geometry is retired, so the next upload checks whether to compact.
+	bool mCompactPending = false;
+
+	// Arenas replaced by a compaction and the upload fence value after which neither
+	// its copies nor any earlier frame read them.
+	std::vector<std::pair<Microsoft::WRL::ComPtr<ID3D12Resource>, UINT64>> mRetiredArenas;
+};
@@ -0,0 +1,72 @@
+//***************************************************************************************
+// DirtyTracker.cpp
+//***************************************************************************************
+
+#include "DirtyTracker.h"
+#include <stdexcept>
+
+DirtyTracker::DirtyTracker(UINT frameResourceCount)
+	: mFrameResourceCount(frameResourceCount), mPending(frameResourceCount)
+{
+	if(frameResourceCount == 0 || frameResourceCount > kMaxFrameResources)
+		throw std::invalid_argument("DirtyTracker supports 1 to 8 frame resources.");
+}
+
+void DirtyTracker::Resize(UINT count)
+{
+	if(count < mPendingMask.size())
+	{
+		for(auto& pending : mPending)
+			pending.erase(std::remove_if(pending.begin(), pending.end(), [count](UINT i) { return i >= count; }), pending.end());
+	}
+
+	mPendingMask.resize(count, 0);
+}
+
+void DirtyTracker::MarkDirty(UINT i)
+{
+	assert(i < mPendingMask.size());
+
+	std::uint8_t& mask = mPendingMask[i];
+	for(UINT f = 0; f < mFrameResourceCount; ++f)
+	{
+		if((mask & (1u << f)) == 0)
+			mPending[f].push_back(i);
+	}
+
+	mask = (std::uint8_t)((1u << mFrameResourceCount) - 1);
+}
+
+const std::vector<UINT>& DirtyTracker::TakePending(UINT frameIndex)
+{
+	assert(frameIndex < mFrameResourceCount);
+
+	std::vector<UINT>& pending = mPending[frameIndex];
+	const std::uint8_t bit = (std::uint8_t)(1u << frameIndex);
+
+	mTaken.clear();
+
+	// Once a good part of the objects changed, collecting them in order from the masks
+	// is cheaper than sorting the list.
+	if(pending.size() >= mPendingMask.size() / 16)
+	{
+		for(UINT i = 0; i < (UINT)mPendingMask.size(); ++i)
+		{
+			if(mPendingMask[i] & bit)
+			{
+				mTaken.push_back(i);
+				mPendingMask[i] &= ~bit;
+			}
+		}
+	}
+	else
+	{
+		mTaken.swap(pending);
+		std::sort(mTaken.begin(), mTaken.end());
+		for(UINT i : mTaken)
+			mPendingMask[i] &= ~bit;
+	}
+
+	pending.clear();
+	return mTaken;
+}
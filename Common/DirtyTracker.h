@@ -0,0 +1,50 @@
+//***************************************************************************************
+// DirtyTracker.h
+//
+// Records which of a set of objects, such as render items or materials, changed, for a
+// ring of frame resources that each hold their own copy of the objects' constants.
+// Every frame resource has a pending list of the objects changed since it was last
+// written, so updating it costs in proportion to what changed rather than to how many
+// objects there are.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+
+class DirtyTracker
+{
+public:
+	// At most kMaxFrameResources frame resources are supported.
+	static const UINT kMaxFrameResources = 8;
+
+	explicit DirtyTracker(UINT frameResourceCount);
+	DirtyTracker(const DirtyTracker& rhs) = delete;
+	DirtyTracker& operator=(const DirtyTracker& rhs) = delete;
+
+	// Resizes to count objects.  New objects start clean; removed ones are dropped from
+	// the pending lists.
+	void Resize(UINT count);
+
+	UINT GetCount()const { return (UINT)mPendingMask.size(); }
+
+	// Queues object i for every frame resource that does not have it pending yet.
+	void MarkDirty(UINT i);
+
+	///<summary>
+	/// Returns the objects frame resource frameIndex missed, in ascending order so
+	/// neighbors can be written together, and clears its list.  The result stays
+	/// valid until the next call.
+	///</summary>
+	const std::vector<UINT>& TakePending(UINT frameIndex);
+
+private:
+	UINT mFrameResourceCount = 0;
+
+	// Bit f of mPendingMask[i] is set while object i is in mPending[f].
+	std::vector<std::uint8_t> mPendingMask;
+	std::vector<std::vector<UINT>> mPending;
+
+	// The list handed out by TakePending.
+	std::vector<UINT> mTaken;
+};
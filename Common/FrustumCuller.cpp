@@ -0,0 +1,460 @@
+//***************************************************************************************
+// FrustumCuller.cpp
+//***************************************************************************************
+
+#include "FrustumCuller.h"
+#include <cfloat>
+#include <cstring>
+
+#if (defined(_M_X64) || defined(_M_IX86)) && !defined(_XM_NO_INTRINSICS_)
+#define FRUSTUM_CULLER_AVX
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	// An empty sphere's radius; no center is far enough in front of a plane to reach it.
+	const float kEmptyRadius = -FLT_MAX;
+
+	// Lanes whose bit is set in an 8-bit mask, lowest first, and how many there are.
+	// Cull writes all the entries of a group of lanes and advances past the set ones only.
+	struct LaneTable
+	{
+		LaneTable()
+		{
+			for(UINT mask = 0; mask < 256; ++mask)
+			{
+				UINT count = 0;
+				for(UINT lane = 0; lane < 8; ++lane)
+				{
+					if(mask & (1u << lane))
+						Lanes[mask][count++] = (std::uint8_t)lane;
+				}
+
+				Counts[mask] = (std::uint8_t)count;
+			}
+		}
+
+		alignas(8) std::uint8_t Lanes[256][8] = {};
+		std::uint8_t Counts[256] = {};
+	};
+
+	const LaneTable kLaneTable;
+
+	FrustumCuller::Width DetectMaxWidth()
+	{
+#if defined(FRUSTUM_CULLER_AVX)
+		int info[4];
+		__cpuid(info, 0);
+		const int maxLeaf = info[0];
+
+		// FMA and AVX, and an OS that saves the AVX registers.
+		__cpuid(info, 1);
+		const int fmaAvxOsxsave = (1 << 12) | (1 << 27) | (1 << 28);
+		if(maxLeaf < 7 || (info[2] & fmaAvxOsxsave) != fmaAvxOsxsave)
+			return FrustumCuller::Width::Four;
+
+		const unsigned long long xcr0 = _xgetbv(0);
+		if((xcr0 & 0x6) != 0x6)
+			return FrustumCuller::Width::Four;
+
+		// AVX2 and BMI2.
+		__cpuidex(info, 7, 0);
+		const int avx2Bmi2 = (1 << 5) | (1 << 8);
+		if((info[1] & avx2Bmi2) != avx2Bmi2)
+			return FrustumCuller::Width::Four;
+
+		// AVX512F, and an OS that saves the mask and upper ZMM registers too.
+		if((info[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6)
+			return FrustumCuller::Width::Sixteen;
+
+		return FrustumCuller::Width::Eight;
+#else
+		return FrustumCuller::Width::Four;
+#endif
+	}
+
+	// Gathers the sign bits of the four lanes of a comparison result.
+	inline int MoveMask(FXMVECTOR v)
+	{
+#if defined(_XM_SSE_INTRINSICS_) && !defined(_XM_NO_INTRINSICS_)
+		return _mm_movemask_ps(v);
+#else
+		std::uint32_t lanes[4];
+		XMStoreInt4(lanes, v);
+		return (int)((lanes[0] >> 31) | (lanes[1] >> 31 << 1) | (lanes[2] >> 31 << 2) | (lanes[3] >> 31 << 3));
+#endif
+	}
+
+	inline XMVECTOR LoadLanes(const float* lanes)
+	{
+		return XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(lanes));
+	}
+
+	// The six planes with a box's coordinates down the lanes, planes 0 to 3 in the first
+	// vector of each pair and 4 and 5, twice, in the second.
+	struct BoxPlanes
+	{
+		BoxPlanes(const XMFLOAT4 planes[6])
+		{
+			for(int group = 0; group < 2; ++group)
+			{
+				const XMFLOAT4* p = group == 0 ? planes : planes + 4;
+				const int q = group == 0 ? 2 : 0;
+				X[group] = XMVectorSet(p[0].x, p[1].x, p[q].x, p[q + 1].x);
+				Y[group] = XMVectorSet(p[0].y, p[1].y, p[q].y, p[q + 1].y);
+				Z[group] = XMVectorSet(p[0].z, p[1].z, p[q].z, p[q + 1].z);
+				W[group] = XMVectorSet(p[0].w, p[1].w, p[q].w, p[q + 1].w);
+				AbsX[group] = XMVectorAbs(X[group]);
+				AbsY[group] = XMVectorAbs(Y[group]);
+				AbsZ[group] = XMVectorAbs(Z[group]);
+			}
+		}
+
+		bool Outside(const BoundingBox& box)const
+		{
+			XMVECTOR cx = XMVectorReplicate(box.Center.x);
+			XMVECTOR cy = XMVectorReplicate(box.Center.y);
+			XMVECTOR cz = XMVectorReplicate(box.Center.z);
+			XMVECTOR ex = XMVectorReplicate(box.Extents.x);
+			XMVECTOR ey = XMVectorReplicate(box.Extents.y);
+			XMVECTOR ez = XMVectorReplicate(box.Extents.z);
+
+			for(int group = 0; group < 2; ++group)
+			{
+				XMVECTOR distance = XMVectorMultiplyAdd(cx, X[group], XMVectorMultiplyAdd(cy, Y[group], XMVectorMultiplyAdd(cz, Z[group], W[group])));
+				XMVECTOR extent = XMVectorMultiplyAdd(ex, AbsX[group], XMVectorMultiplyAdd(ey, AbsY[group], XMVectorMultiply(ez, AbsZ[group])));
+				if(MoveMask(XMVectorGreaterOrEqual(XMVectorAdd(distance, extent), XMVectorZero())) != 0xf)
+					return true;
+			}
+
+			return false;
+		}
+
+		XMVECTOR X[2], Y[2], Z[2], W[2];
+		XMVECTOR AbsX[2], AbsY[2], AbsZ[2];
+	};
+
+#if defined(FRUSTUM_CULLER_AVX)
+	// The six planes with a box's coordinates down the lanes of one AVX vector, the last
+	// two lanes repeating plane 0.  The AVX versions of Cull use this rather than
+	// BoxPlanes so they never mix SSE and AVX encodings.
+	struct BoxPlanesAvx
+	{
+		BoxPlanesAvx(const XMFLOAT4 planes[6])
+		{
+			const XMFLOAT4* p = planes;
+			X = _mm256_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x, p[4].x, p[5].x, p[0].x, p[0].x);
+			Y = _mm256_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y, p[4].y, p[5].y, p[0].y, p[0].y);
+			Z = _mm256_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z, p[4].z, p[5].z, p[0].z, p[0].z);
+			W = _mm256_setr_ps(p[0].w, p[1].w, p[2].w, p[3].w, p[4].w, p[5].w, p[0].w, p[0].w);
+
+			const __m256 signBit = _mm256_set1_ps(-0.0f);
+			AbsX = _mm256_andnot_ps(signBit, X);
+			AbsY = _mm256_andnot_ps(signBit, Y);
+			AbsZ = _mm256_andnot_ps(signBit, Z);
+		}
+
+		bool Outside(const BoundingBox& box)const
+		{
+			__m256 distance = _mm256_fmadd_ps(_mm256_broadcast_ss(&box.Center.x), X,
+				_mm256_fmadd_ps(_mm256_broadcast_ss(&box.Center.y), Y, _mm256_fmadd_ps(_mm256_broadcast_ss(&box.Center.z), Z, W)));
+			__m256 extent = _mm256_fmadd_ps(_mm256_broadcast_ss(&box.Extents.x), AbsX,
+				_mm256_fmadd_ps(_mm256_broadcast_ss(&box.Extents.y), AbsY, _mm256_mul_ps(_mm256_broadcast_ss(&box.Extents.z), AbsZ)));
+
+			return _mm256_movemask_ps(_mm256_cmp_ps(_mm256_add_ps(distance, extent), _mm256_setzero_ps(), _CMP_GE_OQ)) != 0xff;
+		}
+
+		__m256 X, Y, Z, W;
+		__m256 AbsX, AbsY, AbsZ;
+	};
+
+	// Removes the entries of visible whose box is outside, of those at the ascending
+	// positions given, and returns how many are left.
+	UINT RemoveOutsideBoxes(UINT* visible, UINT visibleCount, const UINT* positions, UINT positionCount,
+		const BoundingBox* boxes, const BoxPlanesAvx& planes)
+	{
+		// Entries before read move down to write; they are in place until the first
+		// entry is removed.
+		UINT write = 0;
+		UINT read = 0;
+		for(UINT k = 0; k < positionCount; ++k)
+		{
+			const UINT position = positions[k];
+			if(!planes.Outside(boxes[visible[position]]))
+				continue;
+
+			if(write != read)
+				memmove(visible + write, visible + read, (position - read)*sizeof(UINT));
+			write += position - read;
+			read = position + 1;
+		}
+
+		if(write != read)
+			memmove(visible + write, visible + read, (visibleCount - read)*sizeof(UINT));
+
+		return write + visibleCount - read;
+	}
+#endif
+}
+
+FrustumCuller::Width FrustumCuller::GetMaxWidth()
+{
+	static const Width maxWidth = DetectMaxWidth();
+	return maxWidth;
+}
+
+void FrustumCuller::SetWidth(Width width)
+{
+	mWidth = (UINT)width < (UINT)GetMaxWidth() ? width : GetMaxWidth();
+}
+
+void FrustumCuller::Resize(UINT count)
+{
+	SphereBlock empty = {};
+	for(UINT lane = 0; lane < BlockSize; ++lane)
+		empty.Radius[lane] = kEmptyRadius;
+
+	const UINT oldCount = mCount;
+	mSpheres.resize((count + BlockSize - 1) / BlockSize, empty);
+	mBoxes.resize(mSpheres.size()*BlockSize);
+	mVisible.resize(mSpheres.size()*BlockSize);
+	mStraddling.resize(mVisible.size());
+	mCount = count;
+
+	// The lanes of the last block past the count may still hold bounds: after a shrink,
+	// or after growing from before a shrink.
+	for(UINT i = std::min(oldCount, count); i % BlockSize != 0; ++i)
+		mSpheres[i / BlockSize].Radius[i % BlockSize] = kEmptyRadius;
+}
+
+void FrustumCuller::SetBounds(UINT i, const BoundingSphere& sphere, const BoundingBox& box)
+{
+	assert(i < mCount);
+
+	const UINT lane = i % BlockSize;
+
+	SphereBlock& s = mSpheres[i / BlockSize];
+	s.CenterX[lane] = sphere.Center.x;
+	s.CenterY[lane] = sphere.Center.y;
+	s.CenterZ[lane] = sphere.Center.z;
+	s.Radius[lane] = sphere.Radius;
+
+	mBoxes[i] = box;
+}
+
+UINT FrustumCuller::Cull(const XMVECTOR planes[6])
+{
+	XMFLOAT4 plane[6];
+	for(int p = 0; p < 6; ++p)
+		XMStoreFloat4(&plane[p], planes[p]);
+
+	switch(mWidth)
+	{
+#if defined(FRUSTUM_CULLER_AVX)
+	case Width::Sixteen:
+		return CullSixteen(plane);
+	case Width::Eight:
+		return CullEight(plane);
+#endif
+	default:
+		return CullFour(plane);
+	}
+}
+
+//
+// A sphere is culled when its center is more than its radius behind a plane, which is
+// when the smallest signed distance of the center to the six planes is below minus
+// the radius.  When that distance is at least the radius the sphere is in front of
+// every plane and its box need not be tested.  A box is culled when its center is
+// further behind a plane than the box reaches along the plane's normal,
+// |n.x|*e.x + |n.y|*e.y + |n.z|*e.z.
+//
+// The smallest distance is taken as a tree of minimums rather than a chain, so each
+// block waits on three of them rather than five.  The three versions below differ only
+// in how many spheres they test at once.
+//
+
+UINT FrustumCuller::CullFour(const XMFLOAT4 planes[6])
+{
+	XMVECTOR planeX[6], planeY[6], planeZ[6], planeW[6];
+	for(int p = 0; p < 6; ++p)
+	{
+		planeX[p] = XMVectorReplicate(planes[p].x);
+		planeY[p] = XMVectorReplicate(planes[p].y);
+		planeZ[p] = XMVectorReplicate(planes[p].z);
+		planeW[p] = XMVectorReplicate(planes[p].w);
+	}
+
+	const BoxPlanes boxPlanes(planes);
+
+	auto distanceTo = [&](int p, FXMVECTOR x, FXMVECTOR y, FXMVECTOR z)
+	{
+		return XMVectorMultiplyAdd(x, planeX[p], XMVectorMultiplyAdd(y, planeY[p], XMVectorMultiplyAdd(z, planeZ[p], planeW[p])));
+	};
+
+	UINT* visible = mVisible.data();
+	UINT visibleCount = 0;
+
+	const UINT blockCount = (UINT)mSpheres.size();
+	for(UINT b = 0; b < blockCount; ++b)
+	{
+		const SphereBlock& s = mSpheres[b];
+		const BoundingBox* boxes = &mBoxes[b*BlockSize];
+
+		for(UINT first = 0; first < BlockSize; first += 4)
+		{
+			XMVECTOR x = LoadLanes(s.CenterX + first);
+			XMVECTOR y = LoadLanes(s.CenterY + first);
+			XMVECTOR z = LoadLanes(s.CenterZ + first);
+			XMVECTOR radius = LoadLanes(s.Radius + first);
+
+			XMVECTOR distance = XMVectorMin(XMVectorMin(distanceTo(0, x, y, z), distanceTo(1, x, y, z)),
+				XMVectorMin(XMVectorMin(distanceTo(2, x, y, z), distanceTo(3, x, y, z)), XMVectorMin(distanceTo(4, x, y, z), distanceTo(5, x, y, z))));
+
+			int mask = MoveMask(XMVectorGreaterOrEqual(distance, XMVectorNegate(radius)));
+			const int straddling = mask & ~MoveMask(XMVectorGreaterOrEqual(distance, radius));
+
+			for(int lane = 0; lane < 4; ++lane)
+			{
+				if((straddling & (1 << lane)) != 0 && boxPlanes.Outside(boxes[first + lane]))
+					mask &= ~(1 << lane);
+			}
+
+			const UINT firstIndex = b*BlockSize + first;
+			const std::uint8_t* lanes = kLaneTable.Lanes[mask];
+			for(int k = 0; k < 4; ++k)
+				visible[visibleCount + k] = firstIndex + lanes[k];
+			visibleCount += kLaneTable.Counts[mask];
+		}
+	}
+
+	return visibleCount;
+}
+
+#if defined(FRUSTUM_CULLER_AVX)
+
+UINT FrustumCuller::CullEight(const XMFLOAT4 planes[6])
+{
+	__m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+	for(int p = 0; p < 6; ++p)
+	{
+		planeX[p] = _mm256_set1_ps(planes[p].x);
+		planeY[p] = _mm256_set1_ps(planes[p].y);
+		planeZ[p] = _mm256_set1_ps(planes[p].z);
+		planeW[p] = _mm256_set1_ps(planes[p].w);
+	}
+
+	const BoxPlanesAvx boxPlanes(planes);
+
+	auto distanceTo = [&](int p, __m256 x, __m256 y, __m256 z)
+	{
+		return _mm256_fmadd_ps(x, planeX[p], _mm256_fmadd_ps(y, planeY[p], _mm256_fmadd_ps(z, planeZ[p], planeW[p])));
+	};
+
+	UINT* visible = mVisible.data();
+	UINT visibleCount = 0;
+	UINT* straddling = mStraddling.data();
+	UINT straddlingCount = 0;
+
+	const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+	const UINT blockCount = (UINT)mSpheres.size();
+	for(UINT b = 0; b < blockCount; ++b)
+	{
+		const SphereBlock& s = mSpheres[b];
+
+		for(UINT first = 0; first < BlockSize; first += 8)
+		{
+			const __m256 x = _mm256_load_ps(s.CenterX + first);
+			const __m256 y = _mm256_load_ps(s.CenterY + first);
+			const __m256 z = _mm256_load_ps(s.CenterZ + first);
+			const __m256 radius = _mm256_load_ps(s.Radius + first);
+
+			__m256 distance = _mm256_min_ps(_mm256_min_ps(distanceTo(0, x, y, z), distanceTo(1, x, y, z)),
+				_mm256_min_ps(_mm256_min_ps(distanceTo(2, x, y, z), distanceTo(3, x, y, z)), _mm256_min_ps(distanceTo(4, x, y, z), distanceTo(5, x, y, z))));
+
+			const UINT mask = _mm256_movemask_ps(_mm256_cmp_ps(distance, _mm256_xor_ps(radius, signBit), _CMP_GE_OQ));
+			const UINT straddlingMask = mask & ~_mm256_movemask_ps(_mm256_cmp_ps(distance, radius, _CMP_GE_OQ));
+
+			const __m128i lanes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(kLaneTable.Lanes[mask]));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(visible + visibleCount),
+				_mm256_add_epi32(_mm256_set1_epi32(b*BlockSize + first), _mm256_cvtepu8_epi32(lanes)));
+
+			// Where the straddling lanes went among the visible ones.
+			const UINT straddlingKept = _pext_u32(straddlingMask, mask);
+			const __m128i keptLanes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(kLaneTable.Lanes[straddlingKept]));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(straddling + straddlingCount),
+				_mm256_add_epi32(_mm256_set1_epi32(visibleCount), _mm256_cvtepu8_epi32(keptLanes)));
+
+			visibleCount += kLaneTable.Counts[mask];
+			straddlingCount += kLaneTable.Counts[straddlingKept];
+		}
+	}
+
+	return RemoveOutsideBoxes(visible, visibleCount, straddling, straddlingCount, mBoxes.data(), boxPlanes);
+}
+
+UINT FrustumCuller::CullSixteen(const XMFLOAT4 planes[6])
+{
+	__m512 planeX[6], planeY[6], planeZ[6], planeW[6];
+	for(int p = 0; p < 6; ++p)
+	{
+		planeX[p] = _mm512_set1_ps(planes[p].x);
+		planeY[p] = _mm512_set1_ps(planes[p].y);
+		planeZ[p] = _mm512_set1_ps(planes[p].z);
+		planeW[p] = _mm512_set1_ps(planes[p].w);
+	}
+
+	const BoxPlanesAvx boxPlanes(planes);
+
+	auto distanceTo = [&](int p, __m512 x, __m512 y, __m512 z)
+	{
+		return _mm512_fmadd_ps(x, planeX[p], _mm512_fmadd_ps(y, planeY[p], _mm512_fmadd_ps(z, planeZ[p], planeW[p])));
+	};
+
+	UINT* visible = mVisible.data();
+	UINT visibleCount = 0;
+	UINT* straddling = mStraddling.data();
+	UINT straddlingCount = 0;
+
+	const __m512 zero = _mm512_setzero_ps();
+	const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	__m512i index = lanes;
+	const __m512i blockSize = _mm512_set1_epi32(BlockSize);
+
+	const UINT blockCount = (UINT)mSpheres.size();
+	for(UINT b = 0; b < blockCount; ++b, index = _mm512_add_epi32(index, blockSize))
+	{
+		const SphereBlock& s = mSpheres[b];
+		const __m512 x = _mm512_load_ps(s.CenterX);
+		const __m512 y = _mm512_load_ps(s.CenterY);
+		const __m512 z = _mm512_load_ps(s.CenterZ);
+		const __m512 radius = _mm512_load_ps(s.Radius);
+
+		__m512 distance = _mm512_min_ps(_mm512_min_ps(distanceTo(0, x, y, z), distanceTo(1, x, y, z)),
+			_mm512_min_ps(_mm512_min_ps(distanceTo(2, x, y, z), distanceTo(3, x, y, z)), _mm512_min_ps(distanceTo(4, x, y, z), distanceTo(5, x, y, z))));
+
+		const __mmask16 mask = _mm512_cmp_ps_mask(distance, _mm512_sub_ps(zero, radius), _CMP_GE_OQ);
+		const __mmask16 straddlingMask = mask & ~_mm512_cmp_ps_mask(distance, radius, _CMP_GE_OQ);
+
+		// Compressing into a register and storing all sixteen entries is faster than
+		// compressing straight to memory on some CPUs.
+		_mm512_storeu_si512(visible + visibleCount, _mm512_maskz_compress_epi32(mask, index));
+
+		// Where the straddling lanes went among the visible ones.
+		const __mmask16 straddlingKept = (__mmask16)_pext_u32(straddlingMask, mask);
+		_mm512_storeu_si512(straddling + straddlingCount,
+			_mm512_maskz_compress_epi32(straddlingKept, _mm512_add_epi32(lanes, _mm512_set1_epi32(visibleCount))));
+
+		visibleCount += _mm_popcnt_u32(mask);
+		straddlingCount += _mm_popcnt_u32(straddlingMask);
+	}
+
+	return RemoveOutsideBoxes(visible, visibleCount, straddling, straddlingCount, mBoxes.data(), boxPlanes);
+}
+
+#endif
@@ -0,0 +1,87 @@
+//***************************************************************************************
+// FrustumCuller.h
+//
+// World space bounds of many objects, a bounding sphere and an axis-aligned box each.
+// The spheres are kept in blocks of sixteen with every coordinate in its own array, so
+// a frustum plane is tested against many spheres with a few vector instructions.  Cull
+// walks the sphere blocks once; the few objects whose sphere straddles a plane have
+// their box tested against all six planes at once.  The indices of the objects that may
+// be visible are written to a compact list.
+//
+// Cull uses the widest vectors the CPU has: AVX-512 tests a whole block at once, AVX2
+// half a block and DirectXMath a quarter.  The AVX code is chosen at run time, so the
+// project needs no /arch switch.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+
+class FrustumCuller
+{
+public:
+	// How many objects Cull tests with one vector instruction.
+	enum class Width { Four = 4, Eight = 8, Sixteen = 16 };
+
+	FrustumCuller() = default;
+	FrustumCuller(const FrustumCuller& rhs) = delete;
+	FrustumCuller& operator=(const FrustumCuller& rhs) = delete;
+
+	// The widest the CPU and OS support, which every culler starts with.
+	static Width GetMaxWidth();
+
+	// Narrows the vectors Cull uses, for tests and benchmarks; wider than GetMaxWidth
+	// is clamped to it.
+	void SetWidth(Width width);
+	Width GetWidth()const { return mWidth; }
+
+	// Resizes to count objects.  New objects are empty and culled until they are set.
+	void Resize(UINT count);
+
+	UINT GetCount()const { return mCount; }
+
+	// Sets the bounds of object i.  Both should enclose the object; it is culled if
+	// either is entirely behind a plane.
+	void SetBounds(UINT i, const DirectX::BoundingSphere& sphere, const DirectX::BoundingBox& box);
+
+	///<summary>
+	/// Tests every object against the six planes of a frustum, whose normals point into
+	/// it as MathHelper::ExtractFrustumPlanes returns them, and returns how many have
+	/// neither their sphere nor their box entirely behind any plane.  Their indices, in
+	/// ascending order, are in GetVisible until the next call.
+	///</summary>
+	UINT Cull(const DirectX::XMVECTOR planes[6]);
+
+	const UINT* GetVisible()const { return mVisible.data(); }
+
+private:
+	static const UINT BlockSize = 16;
+
+	struct SphereBlock
+	{
+		alignas(64) float CenterX[BlockSize];
+		alignas(64) float CenterY[BlockSize];
+		alignas(64) float CenterZ[BlockSize];
+		alignas(64) float Radius[BlockSize];
+	};
+
+	UINT CullFour(const DirectX::XMFLOAT4 planes[6]);
+	UINT CullEight(const DirectX::XMFLOAT4 planes[6]);
+	UINT CullSixteen(const DirectX::XMFLOAT4 planes[6]);
+
+	// The boxes are apart from the spheres so the pass over the spheres reads nothing
+	// else, and one object to a box so testing one reads a single cache line or two.
+	std::vector<SphereBlock> mSpheres;
+	std::vector<DirectX::BoundingBox> mBoxes;
+	UINT mCount = 0;
+	Width mWidth = GetMaxWidth();
+
+	// A whole block of entries per block, so Cull can write a block's indices without
+	// checking for room.
+	std::vector<UINT> mVisible;
+
+	// Where in mVisible the objects whose sphere straddles a plane are, so the AVX
+	// versions of Cull can test their boxes after the pass over the spheres rather than
+	// wait on each box in it.
+	std::vector<UINT> mStraddling;
+};
@@ -4,9 +4,226 @@
 
 #include "GeometryGenerator.h"
 #include <algorithm>
+#include <unordered_map>
 
 using namespace DirectX;
 
+namespace
+{
+	using uint32 = GeometryGenerator::uint32;
+
+	// The fixed-topology shapes are all subdivided this many times.
+	constexpr uint32 kShapeSubdivisions = 3;
+
+	// A fixed-topology shape at unit size.  Each vertex position is multiplied by
+	// the scale vector ScaleSets selects, so parts of a shape can follow different
+	// parameters (the top and bottom of a truncated pyramid).
+	template<uint32 NumVertices, uint32 NumIndices>
+	struct ShapeTable
+	{
+		float Positions[NumVertices][3];
+		uint32 ScaleSets[NumVertices];
+		uint32 Indices[NumIndices];
+	};
+
+	template<uint32 V, uint32 I>
+	constexpr bool IndicesInRange(const ShapeTable<V, I>& table)
+	{
+		for(uint32 i = 0; i < I; ++i)
+		{
+			if(table.Indices[i] >= V)
+				return false;
+		}
+
+		return I % 3 == 0;
+	}
+
+	template<uint32 V, uint32 I>
+	constexpr uint32 CountUniqueEdges(const ShapeTable<V, I>& table)
+	{
+		uint32 count = 0;
+		for(uint32 e = 0; e < I; ++e)
+		{
+			uint32 a = table.Indices[e];
+			uint32 b = table.Indices[e - e%3 + (e + 1)%3];
+
+			bool seen = false;
+			for(uint32 f = 0; f < e && !seen; ++f)
+			{
+				uint32 c = table.Indices[f];
+				uint32 d = table.Indices[f - f%3 + (f + 1)%3];
+				seen = (a == c && b == d) || (a == d && b == c);
+			}
+
+			if(!seen)
+				++count;
+		}
+
+		return count;
+	}
+
+	// Each subdivision adds a vertex per edge, splits every edge in two and adds
+	// three edges inside each triangle.
+	template<uint32 V, uint32 I>
+	constexpr uint32 SubdividedVertexCount(const ShapeTable<V, I>& table, uint32 levels)
+	{
+		uint32 vertices = V;
+		uint32 edges = CountUniqueEdges(table);
+		uint32 triangles = I / 3;
+
+		for(uint32 i = 0; i < levels; ++i)
+		{
+			vertices += edges;
+			edges = 2*edges + 3*triangles;
+			triangles *= 4;
+		}
+
+		return vertices;
+	}
+
+	//
+	// Unit tables of the fixed-topology shapes.  Positions span [-0.5, 0.5] and are
+	// scaled by (width, height, depth) unless noted otherwise.
+	//
+
+	constexpr ShapeTable<6, 24> kWedgeTable =
+	{
+		{
+			{ -0.5f, -0.5f, -0.5f }, // bottom-front-left
+			{ -0.5f, -0.5f, +0.5f }, // bottom-back-left
+			{ +0.5f, -0.5f, -0.5f }, // bottom-front-right
+			{ +0.5f, -0.5f, +0.5f }, // bottom-back-right
+			{ +0.5f, +0.5f, +0.5f }, // top-right
+			{ -0.5f, +0.5f, +0.5f }, // top-left
+		},
+		{ 0, 0, 0, 0, 0, 0 },
+		{
+			0, 2, 1,   2, 3, 1, // bottom
+			4, 3, 2,            // right side
+			5, 0, 1,            // left side
+			2, 0, 5,   2, 5, 4, // front
+			5, 1, 3,   5, 3, 4, // back
+		}
+	};
+
+	constexpr ShapeTable<5, 18> kPyramidTable =
+	{
+		{
+			{ 0.0f, +0.5f, 0.0f },   // top-center
+			{ -0.5f, -0.5f, -0.5f }, // bottom-front-left
+			{ -0.5f, -0.5f, +0.5f }, // bottom-back-left
+			{ +0.5f, -0.5f, -0.5f }, // bottom-front-right
+			{ +0.5f, -0.5f, +0.5f }, // bottom-back-right
+		},
+		{ 0, 0, 0, 0, 0 },
+		{
+			1, 3, 4,   1, 4, 2, // bottom
+			0, 2, 4,            // right side
+			0, 3, 1,            // left side
+			0, 4, 3,            // front
+			0, 1, 2,            // back
+		}
+	};
+
+	// Scale set 0 is (bottomWidth, height, bottomDepth) and 1 is (topWidth, height, topDepth).
+	constexpr ShapeTable<8, 36> kTruncatedPyramidTable =
+	{
+		{
+			{ -0.5f, -0.5f, -0.5f }, // bottom-front-left
+			{ -0.5f, -0.5f, +0.5f }, // bottom-back-left
+			{ +0.5f, -0.5f, -0.5f }, // bottom-front-right
+			{ +0.5f, -0.5f, +0.5f }, // bottom-back-right
+			{ -0.5f, +0.5f, -0.5f }, // top-front-left
+			{ -0.5f, +0.5f, +0.5f }, // top-back-left
+			{ +0.5f, +0.5f, -0.5f }, // top-front-right
+			{ +0.5f, +0.5f, +0.5f }, // top-back-right
+		},
+		{ 0, 0, 0, 0, 1, 1, 1, 1 },
+		{
+			0, 2, 1,   2, 3, 1, // bottom
+			2, 6, 3,   3, 6, 7, // right side
+			1, 5, 0,   0, 5, 4, // left side
+			0, 4, 2,   2, 4, 6, // front
+			3, 7, 1,   1, 7, 5, // back
+			4, 5, 6,   6, 5, 7, // top
+		}
+	};
+
+	constexpr ShapeTable<6, 24> kTriangularPrismTable =
+	{
+		{
+			{ -0.5f, -0.5f, +0.5f }, // bottom back left
+			{ +0.5f, -0.5f, +0.5f }, // bottom back right
+			{ -0.5f, -0.5f, -0.5f }, // bottom front left
+			{ +0.5f, -0.5f, -0.5f }, // bottom front right
+			{ 0.0f, +0.5f, +0.5f },  // top back
+			{ 0.0f, +0.5f, -0.5f },  // top front
+		},
+		{ 0, 0, 0, 0, 0, 0 },
+		{
+			0, 2, 3,   0, 3, 1, // bottom
+			0, 5, 2,   0, 4, 5, // left
+			3, 4, 1,   3, 5, 4, // right
+			4, 0, 1,            // back
+			5, 3, 2,            // front
+		}
+	};
+
+	// Scaled by (width, height, width).
+	constexpr ShapeTable<4, 12> kTetrahedronTable =
+	{
+		{
+			{ 0.0f, +0.5f, 0.0f },   // top center
+			{ 0.0f, -0.5f, +0.5f },  // bottom back
+			{ -0.5f, -0.5f, -0.5f }, // bottom front left
+			{ +0.5f, -0.5f, -0.5f }, // bottom front right
+		},
+		{ 0, 0, 0, 0 },
+		{
+			1, 2, 3, // bottom
+			1, 0, 2, // left
+			1, 3, 0, // right
+			2, 0, 3, // front
+		}
+	};
+
+	static_assert(IndicesInRange(kWedgeTable), "Wedge table has an invalid index.");
+	static_assert(IndicesInRange(kPyramidTable), "Pyramid table has an invalid index.");
+	static_assert(IndicesInRange(kTruncatedPyramidTable), "Truncated pyramid table has an invalid index.");
+	static_assert(IndicesInRange(kTriangularPrismTable), "Triangular prism table has an invalid index.");
+	static_assert(IndicesInRange(kTetrahedronTable), "Tetrahedron table has an invalid index.");
+
+	///<summary>
+	/// Fills meshData with the table's vertices scaled by scales[ScaleSets[i]] and given
+	/// the attributes of the prototype vertex.  Room for the subdivided mesh is reserved
+	/// up front so the Subdivide calls that follow never reallocate.
+	///</summary>
+	template<uint32 V, uint32 I>
+	void InstantiateShape(const ShapeTable<V, I>& table, const XMVECTOR* scales,
+		const GeometryGenerator::Vertex& prototype, GeometryGenerator::MeshData& meshData)
+	{
+		meshData.Vertices.reserve(SubdividedVertexCount(table, kShapeSubdivisions));
+		meshData.Indices32.reserve(I << (2*kShapeSubdivisions));
+
+		meshData.Vertices.assign(V, prototype);
+		for(uint32 i = 0; i < V; ++i)
+		{
+			XMVECTOR unit = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(table.Positions[i]));
+
+			// Zero components stay +0.0f whatever the sign of the scale.
+			XMVECTOR p = XMVectorSelect(unit, XMVectorMultiply(unit, scales[table.ScaleSets[i]]),
+				XMVectorNotEqual(unit, XMVectorZero()));
+
+			XMStoreFloat3(&meshData.Vertices[i].Position, p);
+		}
+
+		meshData.Indices32.assign(table.Indices, table.Indices + I);
+	}
+
+	// Normal, tangent and texture coordinates shared by the fixed-topology shapes.
+	const GeometryGenerator::Vertex kShapeAttributes(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
 GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float height, float depth, uint32 numSubdivisions)
 {
     MeshData meshData;
@@ -213,13 +430,6 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
  
 void GeometryGenerator::Subdivide(MeshData& meshData)
 {
-	// Save a copy of the input geometry.
-	MeshData inputCopy = meshData;
-
-
-	meshData.Vertices.resize(0);
-	meshData.Indices32.resize(0);
-
 	//       v1
 	//       *
 	//      / \
@@ -230,47 +440,77 @@ void GeometryGenerator::Subdivide(MeshData& meshData)
 	// *-----*-----*
 	// v0    m2     v2
 
-	uint32 numTris = (uint32)inputCopy.Indices32.size()/3;
+	uint32 numVerts = (uint32)meshData.Vertices.size();
+	uint32 numTris = (uint32)meshData.Indices32.size()/3;
+
+	//
+	// Assign one midpoint vertex per unique edge.  Triangles that share an edge
+	// (by vertex index) share its midpoint, so hard edges built from duplicated
+	// vertices, like the box faces, stay split.
+	//
+
+	std::unordered_map<uint64, uint32> edgeMidPoints;
+	edgeMidPoints.reserve(numTris*3);
+
+	std::vector<uint32> edges;
+	edges.reserve(numTris*3);
+
+	std::vector<uint32> triMidPoints(numTris*3);
+
 	for(uint32 i = 0; i < numTris; ++i)
 	{
-		Vertex v0 = inputCopy.Vertices[ inputCopy.Indices32[i*3+0] ];
-		Vertex v1 = inputCopy.Vertices[ inputCopy.Indices32[i*3+1] ];
-		Vertex v2 = inputCopy.Vertices[ inputCopy.Indices32[i*3+2] ];
-
-		//
-		// Generate the midpoints.
-		//
-
-        Vertex m0 = MidPoint(v0, v1);
-        Vertex m1 = MidPoint(v1, v2);
-        Vertex m2 = MidPoint(v0, v2);
-
-		//
-		// Add new geometry.
-		//
-
-		meshData.Vertices.push_back(v0); // 0
-		meshData.Vertices.push_back(v1); // 1
-		meshData.Vertices.push_back(v2); // 2
-		meshData.Vertices.push_back(m0); // 3
-		meshData.Vertices.push_back(m1); // 4
-		meshData.Vertices.push_back(m2); // 5
- 
-		meshData.Indices32.push_back(i*6+0);
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+5);
+		for(uint32 e = 0; e < 3; ++e)
+		{
+			// Edge e of the triangle runs v0->v1, v1->v2 and v0->v2 to match m0, m1, m2.
+			uint32 a = meshData.Indices32[i*3 + (e == 2 ? 0 : e)];
+			uint32 b = meshData.Indices32[i*3 + (e == 2 ? 2 : e+1)];
+
+			uint64 key = a < b ? ((uint64)a << 32) | b : ((uint64)b << 32) | a;
+
+			auto result = edgeMidPoints.emplace(key, numVerts + (uint32)edges.size()/2);
+			if(result.second)
+			{
+				edges.push_back(a);
+				edges.push_back(b);
+			}
+
+			triMidPoints[i*3 + e] = result.first->second;
+		}
+	}
+
+	//
+	// Generate the midpoints directly after the existing vertices.
+	//
+
+	uint32 numEdges = (uint32)edges.size()/2;
+	meshData.Vertices.resize(numVerts + numEdges);
+
+	for(uint32 i = 0; i < numEdges; ++i)
+		meshData.Vertices[numVerts + i] = MidPoint(meshData.Vertices[edges[i*2]], meshData.Vertices[edges[i*2+1]]);
+
+	//
+	// Emit four triangles per input triangle.  Walk backwards so the output,
+	// which is four times larger, never overwrites input that is still unread.
+	//
+
+	meshData.Indices32.resize(numTris*12);
+
+	for(uint32 i = numTris; i-- > 0;)
+	{
+		uint32 v0 = meshData.Indices32[i*3+0];
+		uint32 v1 = meshData.Indices32[i*3+1];
+		uint32 v2 = meshData.Indices32[i*3+2];
 
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+4);
-		meshData.Indices32.push_back(i*6+5);
+		uint32 m0 = triMidPoints[i*3+0];
+		uint32 m1 = triMidPoints[i*3+1];
+		uint32 m2 = triMidPoints[i*3+2];
 
-		meshData.Indices32.push_back(i*6+5);
-		meshData.Indices32.push_back(i*6+4);
-		meshData.Indices32.push_back(i*6+2);
+		uint32* out = &meshData.Indices32[i*12];
 
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+1);
-		meshData.Indices32.push_back(i*6+4);
+		out[0] = v0; out[1]  = m0; out[2]  = m2;
+		out[3] = m0; out[4]  = m1; out[5]  = m2;
+		out[6] = m2; out[7]  = m1; out[8]  = v2;
+		out[9] = m0; out[10] = v1; out[11] = m1;
 	}
 }
 
@@ -660,72 +900,66 @@ GeometryGenerator::MeshData GeometryGenerator::CreateDiamondOfDeath(float height
 {
 	MeshData meshData;
 
+	// The octagons come from cos/sin, which are not constexpr, so this table is
+	// built once on first use.  Scale set 1 scales y by the height; the bottom
+	// point (set 0) and the octagon radii do not depend on it.
 	//
-	// Create the vertices.
-	//
+	// The hand-written version this replaced copied 37 vertices out of its 17, so
+	// its meshes had 19 extra unreferenced vertices and midpoint indices 19 higher.
+	// Apart from that the output is unchanged; Tests/ShapeTests.cpp checks both.
+	static const ShapeTable<17, 72> diamondTable = []()
+	{
+		ShapeTable<17, 72> table = {};
 
-	Vertex v[17];
+		//Bottom point vert
+		table.Positions[0][1] = 0.25f;
 
+		// Used polygon formula to create the large (bottom) and small (top) octagons
+		for(uint32 k = 1; k <= 8; ++k)
+		{
+			table.Positions[k][0] = cos((k * (2 * XM_PI)) / 8)*0.75f;
+			table.Positions[k][1] = 0.75f;
+			table.Positions[k][2] = sin((k * (2 * XM_PI)) / 8)*0.75f;
+			table.ScaleSets[k] = 1;
+
+			table.Positions[k + 8][0] = cos((k * (2 * XM_PI)) / 8)*0.25f;
+			table.Positions[k + 8][1] = 1.0f;
+			table.Positions[k + 8][2] = sin((k * (2 * XM_PI)) / 8)*0.25f;
+			table.ScaleSets[k + 8] = 1;
+		}
 
-	float verts = 17.f;
-	float heightBottom;
-	heightBottom = 0.75f * height;
+		for(uint32 k = 0; k < 8; ++k)
+		{
+			uint32 b0 = k + 1, b1 = (k + 1) % 8 + 1;
+			uint32 t0 = b0 + 8, t1 = b1 + 8;
 
-	//Bottom point vert
-	v[0] = Vertex(0.0f, 0.25f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	// bottom center point
-	// Used polygon formula to create the large and small octagons
-	v[1] = Vertex(cos((1 * (2 * XM_PI)) / 8)*0.75f, heightBottom, sin((1 * (2 * XM_PI)) / 8)*0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[2] = Vertex(cos((2 * (2 * XM_PI)) / 8)*0.75f, heightBottom, sin((2 * (2 * XM_PI)) / 8)*0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[3] = Vertex(cos((3 * (2 * XM_PI)) / 8)*0.75f, heightBottom, sin((3 * (2 * XM_PI)) / 8)*0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[4] = Vertex(cos((4 * (2 * XM_PI)) / 8)*0.75f, heightBottom, sin((4 * (2 * XM_PI)) / 8)*0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[5] = Vertex(cos((5 * (2 * XM_PI)) / 8)*0.75f, heightBottom, sin((5 * (2 * XM_PI)) / 8)*0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[6] = Vertex(cos((6 * (2 * XM_PI)) / 8)*0.75f, heightBottom, sin((6 * (2 * XM_PI)) / 8)*0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[7] = Vertex(cos((7 * (2 * XM_PI)) / 8)*0.75f, heightBottom, sin((7 * (2 * XM_PI)) / 8)*0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[8] = Vertex(cos((8 * (2 * XM_PI)) / 8)*0.75f, heightBottom, sin((8 * (2 * XM_PI)) / 8)*0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	//Top Octagon Vets
-	v[9] = Vertex(cos((1 * (2 * XM_PI)) / 8)*0.25f, height, sin((1 * (2 * XM_PI)) / 8)*0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[10] = Vertex(cos((2 * (2 * XM_PI)) / 8)*0.25f, height, sin((2 * (2 * XM_PI)) / 8)*0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[11] = Vertex(cos((3 * (2 * XM_PI)) / 8)*0.25f, height, sin((3 * (2 * XM_PI)) / 8)*0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[12] = Vertex(cos((4 * (2 * XM_PI)) / 8)*0.25f, height, sin((4 * (2 * XM_PI)) / 8)*0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[13] = Vertex(cos((5 * (2 * XM_PI)) / 8)*0.25f, height, sin((5 * (2 * XM_PI)) / 8)*0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[14] = Vertex(cos((6 * (2 * XM_PI)) / 8)*0.25f, height, sin((6 * (2 * XM_PI)) / 8)*0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[15] = Vertex(cos((7 * (2 * XM_PI)) / 8)*0.25f, height, sin((7 * (2 * XM_PI)) / 8)*0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[16] = Vertex(cos((8 * (2 * XM_PI)) / 8)*0.25f, height, sin((8 * (2 * XM_PI)) / 8)*0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-
-	meshData.Vertices.assign(&v[0], &v[36]);
-
-	uint32 i[72];
+			// Bottom fan
+			uint32* fan = &table.Indices[k*3];
+			fan[0] = 0;		fan[1] = b0;	fan[2] = b1;
 
-	i[0] = 0;	i[1] = 1;	i[2] = 2;
-	i[3] = 0;	i[4] = 2;	i[5] = 3;
-	i[6] = 0;	i[7] = 3;	i[8] = 4;
-	i[9] = 0;	i[10] = 4;	i[11] = 5;
-	i[12] = 0;	i[13] = 5;	i[14] = 6;
-	i[15] = 0;	i[16] = 6;	i[17] = 7;
-	i[18] = 0;	i[19] = 7;	i[20] = 8;
-	i[21] = 0;	i[22] = 8;	i[23] = 1;
+			// Side between the octagons
+			uint32* side = &table.Indices[24 + k*6];
+			side[0] = b0;	side[1] = t0;	side[2] = b1;
+			side[3] = b1;	side[4] = t0;	side[5] = t1;
+		}
 
+		return table;
+	}();
 
-	i[24] = 1;	i[25] = 9;	i[26] = 2;
-	i[27] = 2;	i[28] = 9;	i[29] = 10;
-	i[30] = 2;	i[31] = 10;	i[32] = 3;
-	i[33] = 3;	i[34] = 10;	i[35] = 11;
-	i[36] = 3;	i[37] = 11;	i[38] = 4;
-	i[39] = 4;	i[40] = 11;	i[41] = 12;
-	i[42] = 4;	i[43] = 12;	i[44] = 5;
-	i[45] = 5;	i[46] = 12;	i[47] = 13;
-	i[48] = 5;	i[49] = 13;	i[50] = 6;
-	i[51] = 6;	i[52] = 13;	i[53] = 14;
-	i[54] = 6;	i[55] = 14;	i[56] = 7;
-	i[57] = 7;	i[58] = 14;	i[59] = 15;
-	i[60] = 7;	i[61] = 15;	i[62] = 8;
-	i[63] = 8;	i[64] = 15;	i[65] = 16;
-	i[66] = 8;	i[67] = 16;	i[68] = 1;
-	i[69] = 1;	i[70] = 16;	i[71] = 9;
-	meshData.Indices32.assign(&i[0], &i[72]);
+	XMVECTOR scales[2] =
+	{
+		XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f),
+		XMVectorSet(1.0f, height, 1.0f, 0.0f)
+	};
+	InstantiateShape(diamondTable, scales, Vertex(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f), meshData);
 
-	for (uint32 i = 0; i < 3; ++i)
+	// Only the bottom point carries a normal and texture coordinates.
+	Vertex& bottom = meshData.Vertices[0];
+	bottom.Normal = XMFLOAT3(0.0f, 0.0f, -1.0f);
+	bottom.TangentU = XMFLOAT3(1.0f, 0.0f, 0.0f);
+	bottom.TexC = XMFLOAT2(0.0f, 1.0f);
+
+	for (uint32 i = 0; i < kShapeSubdivisions; ++i)
 	{
 		Subdivide(meshData);
 	}
@@ -800,44 +1034,10 @@ GeometryGenerator::MeshData GeometryGenerator::CreateWedge(float width, float de
 {
 	MeshData meshData;
 
-	//
-	// Create the vertices.
-	//
-
-	Vertex v[6];
-	
-	v[0] = Vertex(-(width*0.5f), -(height*0.5f), -(depth*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-front-left
-	v[1] = Vertex(-(width*0.5f), -(height*0.5f), depth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-back-left
-	v[2] = Vertex(width*0.5f, -(height*0.5f), -(depth*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-front-right
-	v[3] = Vertex(width*0.5f, -(height*0.5f), depth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-back-right
-	v[4] = Vertex(width*0.5f, height*0.5f, depth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-right
-	v[5] = Vertex(-(width*0.5f), height*0.5f, depth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-left
-	
-	meshData.Vertices.assign(&v[0], &v[6]);
-
-	uint32 i[24];
-
-	// Bottom
-	i[0] = 0;	i[1] = 2;	i[2] = 1;
-	i[3] = 2;	i[4] = 3;	i[5] = 1;
-
-	// Right Side
-	i[6] = 4;	i[7] = 3;	i[8] = 2;
-
-	// Left Side
-	i[9] = 5;	i[10] = 0;	i[11] = 1;
-
-	// Front
-	i[12] = 2;	i[13] = 0;	i[14] = 5;
-	i[15] = 2;	i[16] = 5;	i[17] = 4;
-
-	// Back
-	i[18] = 5;	i[19] = 1;	i[20] = 3;
-	i[21] = 5;	i[22] = 3;	i[23] = 4;
+	XMVECTOR scale = XMVectorSet(width, height, depth, 0.0f);
+	InstantiateShape(kWedgeTable, &scale, kShapeAttributes, meshData);
 
-	meshData.Indices32.assign(&i[0], &i[24]);
-
-	for (uint32 i = 0; i < 3; ++i)
+	for (uint32 i = 0; i < kShapeSubdivisions; ++i)
 	{
 		Subdivide(meshData);
 	}
@@ -850,37 +1050,10 @@ GeometryGenerator::MeshData GeometryGenerator::CreatePyramid(float width, float
 {
 	MeshData meshData;
 
-	Vertex v[5];
-
-	v[0] = Vertex(0.0f, height*0.5f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-center
-	v[1] = Vertex(-(width*0.5f), -(height*0.5f), -(depth*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-front-left
-	v[2] = Vertex(-(width*0.5f), -(height*0.5f), depth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-back-left
-	v[3] = Vertex(width*0.5f, -(height*0.5f), -(depth*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-front-right
-	v[4] = Vertex(width*0.5f, -(height*0.5f), depth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-back-right
-
-	meshData.Vertices.assign(&v[0], &v[5]);
-
-	uint32 i[18];
-
-	// Bottom
-	i[0] = 1;	i[1] = 3;	i[2] = 4;
-	i[3] = 1;	i[4] = 4;	i[5] = 2;
+	XMVECTOR scale = XMVectorSet(width, height, depth, 0.0f);
+	InstantiateShape(kPyramidTable, &scale, kShapeAttributes, meshData);
 
-	// Right Side
-	i[6] = 0;	i[7] = 2;	i[8] = 4;
-
-	// Left Side
-	i[9] = 0;	i[10] = 3;	i[11] = 1;
-
-	// Front
-	i[12] = 0;	i[13] = 4;	i[14] = 3;
-
-	// Back
-	i[15] = 0;	i[16] = 1;	i[17] = 2;
-
-	meshData.Indices32.assign(&i[0], &i[18]);
-
-	for (uint32 i = 0; i < 3; ++i)
+	for (uint32 i = 0; i < kShapeSubdivisions; ++i)
 	{
 		Subdivide(meshData);
 	}
@@ -893,49 +1066,14 @@ GeometryGenerator::MeshData GeometryGenerator::CreateTruncatedPyramid(float bott
 {
 	MeshData meshData;
 
-	Vertex v[8];
-
-	v[0] = Vertex(-(bottomWidth*0.5f), -(height*0.5f), -(bottomDepth*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-front-left
-	v[1] = Vertex(-(bottomWidth*0.5f), -(height*0.5f), bottomDepth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-back-left
-	v[2] = Vertex(bottomWidth*0.5f, -(height*0.5f), -(bottomDepth*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-front-right
-	v[3] = Vertex(bottomWidth*0.5f, -(height*0.5f), bottomDepth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-back-right
-
-	v[4] = Vertex(-(topWidth*0.5f), height*0.5f, -(topDepth*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-front-left
-	v[5] = Vertex(-(topWidth*0.5f), height*0.5f, topDepth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-back-left
-	v[6] = Vertex(topWidth*0.5f, height*0.5f, -(topDepth*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-front-right
-	v[7] = Vertex(topWidth*0.5f, height*0.5f, topDepth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-back-right
-
-	meshData.Vertices.assign(&v[0], &v[8]);
-
-	uint32 i[36];
-
-	// Bottom
-	i[0] = 0;	i[1] = 2;	i[2] = 1;
-	i[3] = 2;	i[4] = 3;	i[5] = 1;
-
-	// Right Side
-	i[6] = 2;	i[7] = 6;	i[8] = 3;
-	i[9] = 3;	i[10] = 6;	i[11] = 7;
-
-	//Left Side
-	i[12] = 1;	i[13] = 5;	i[14] = 0;
-	i[15] = 0;	i[16] = 5;	i[17] = 4;
-
-	// Front
-	i[18] = 0;	i[19] = 4;	i[20] = 2;
-	i[21] = 2;	i[22] = 4;	i[23] = 6;
-
-	// Back
-	i[24] = 3;	i[25] = 7;	i[26] = 1;
-	i[27] = 1;	i[28] = 7;	i[29] = 5;
-
-	// Top
-	i[30] = 4;	i[31] = 5;	i[32] = 6;
-	i[33] = 6;	i[34] = 5;	i[35] = 7;
-
-	meshData.Indices32.assign(&i[0], &i[36]);
+	XMVECTOR scales[2] =
+	{
+		XMVectorSet(bottomWidth, height, bottomDepth, 0.0f),
+		XMVectorSet(topWidth, height, topDepth, 0.0f)
+	};
+	InstantiateShape(kTruncatedPyramidTable, scales, kShapeAttributes, meshData);
 
-	for (uint32 i = 0; i < 3; ++i)
+	for (uint32 i = 0; i < kShapeSubdivisions; ++i)
 	{
 		Subdivide(meshData);
 	}
@@ -948,79 +1086,10 @@ GeometryGenerator::MeshData GeometryGenerator::CreateTriangularPrism(float width
 {
 	MeshData meshData;
 
-	/*
-	Vertex v[6];
-
-	v[0] = Vertex(-(bottomSideLength*0.5f), -(height*0.5f), -(bottomSideLength*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-left
-	v[1] = Vertex(-(bottomSideLength*0.25f), -(height*0.5f), bottomSideLength*0.25f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-back
-	v[2] = Vertex(bottomSideLength*0.5f, -(height*0.5f), -(bottomSideLength*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-right
-	v[3] = Vertex(-(topSideLength*0.5), height*0.5f, -(topSideLength*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-Left
-	v[4] = Vertex(-(topSideLength*0.25f), height*0.5f, topSideLength*0.25f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-back
-	v[5] = Vertex(topSideLength*0.5f, height*0.5f, -(topSideLength*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-right
-	
-
-	meshData.Vertices.assign(&v[0], &v[6]);
-
-	uint32 i[36];
-	
-	// Bottom
-	i[0] = 0;	i[1] = 2;	i[2] = 1;
-	
-
-	// Right Side
-	i[3] = 2;	i[4] = 4;	i[5] = 1;
-	i[6] = 5;	i[7] = 4;	i[8] = 2;
-
-	//Left Side
-	i[9] = 5;	i[10] = 2;	i[11] = 0;
-	i[12] = 0;	i[13] = 3;	i[14] = 5;
-
-	// Back
-	i[15] = 1;	i[16] = 3;	i[17] = 0;
-	i[18] = 4;	i[19] = 3;	i[20] = 1;
-
-	// Top
-	i[21] = 5;	i[22] = 3;	i[23] = 4;
-	*/
-
-	Vertex v[6];
-
-	v[0] = Vertex(-(width * 0.5f), -(height * 0.5f), depth * 0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom back left
-	v[1] = Vertex(width * 0.5f, -(height * 0.5f), depth * 0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom back right
-	v[2] = Vertex(-(width * 0.5f), -(height * 0.5f), -(depth * 0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom front left
-	v[3] = Vertex(width * 0.5f, -(height * 0.5f), -(depth * 0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom front right
-
-	v[4] = Vertex(0.0f, height * 0.5f, depth * 0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top back
-	v[5] = Vertex(0.0f, height * 0.5f, -(depth * 0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top front
-
+	XMVECTOR scale = XMVectorSet(width, height, depth, 0.0f);
+	InstantiateShape(kTriangularPrismTable, &scale, kShapeAttributes, meshData);
 
-	meshData.Vertices.assign(&v[0], &v[6]);
-
-	uint32 i[36];
-
-	// Bottom
-	i[0] = 0;	i[1] = 2;	i[2] = 3;
-	i[3] = 0;	i[4] = 3;	i[5] = 1;
-
-	// Left
-	i[6] = 0;	i[7] = 5;	i[8] = 2;
-	i[9] = 0;	i[10] = 4;	i[11] = 5;
-
-	// Right
-	i[12] = 3;	i[13] = 4;	i[14] = 1;
-	i[15] = 3;	i[16] = 5;	i[17] = 4;
-
-	// Back
-	i[18] = 4;	i[19] = 0;	i[20] = 1;
-
-	// Front
-	i[21] = 5;	i[22] = 3;	i[23] = 2;
-
-
-	meshData.Indices32.assign(&i[0], &i[24]);
-	
-
-	for (uint32 i = 0; i < 3; ++i)
+	for (uint32 i = 0; i < kShapeSubdivisions; ++i)
 	{
 		Subdivide(meshData);
 	}
@@ -1033,34 +1102,10 @@ GeometryGenerator::MeshData GeometryGenerator::CreateTetrahedron(float width, fl
 {
 	MeshData meshData;
 
-	Vertex v[4];
-
-	v[0] = Vertex(0.0f, height * 0.5f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top center
-	v[1] = Vertex(0.0f, -(height * 0.5f), width * 0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom back
-	v[2] = Vertex(-(width * 0.5f), -(height * 0.5f), -(width * 0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom front left
-	v[3] = Vertex(width * 0.5f, -(height * 0.5f), -(width * 0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom front right
-	
-	meshData.Vertices.assign(&v[0], &v[4]);
-
-	uint32 i[12];
-
-	// Bottom
-	i[0] = 1;	i[1] = 2;	i[2] = 3;
-
-	// Left
-	i[3] = 1;	i[4] = 0;	i[5] = 2;
-	
-	// Right
-	i[6] = 1;	i[7] = 3;	i[8] = 0;
-	
-	// Front
-	i[9] = 2;	i[10] = 0;	i[11] = 3;
-	
+	XMVECTOR scale = XMVectorSet(width, height, width, 0.0f);
+	InstantiateShape(kTetrahedronTable, &scale, kShapeAttributes, meshData);
 
-	meshData.Indices32.assign(&i[0], &i[12]);
-
-
-	for (uint32 i = 0; i < 3; ++i)
+	for (uint32 i = 0; i < kShapeSubdivisions; ++i)
 	{
 		Subdivide(meshData);
 	}
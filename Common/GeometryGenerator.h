@@ -15,6 +15,8 @@
 #pragma once
 
 #include <cstdint>
+#include <stdexcept>
+#include <string>
 #include <DirectXMath.h>
 #include <vector>
 
@@ -24,6 +26,7 @@ public:
 
     using uint16 = std::uint16_t;
     using uint32 = std::uint32_t;
+    using uint64 = std::uint64_t;
 
 	struct Vertex
 	{
@@ -58,13 +61,24 @@ public:
 		std::vector<Vertex> Vertices;
         std::vector<uint32> Indices32;
 
+        // Throws std::out_of_range if an index does not fit in 16 bits; use
+        // IndexPacker to store such meshes.
         std::vector<uint16>& GetIndices16()
         {
 			if(mIndices16.empty())
 			{
 				mIndices16.resize(Indices32.size());
 				for(size_t i = 0; i < Indices32.size(); ++i)
+				{
+					if(Indices32[i] > 0xffff)
+					{
+						mIndices16.clear();
+						throw std::out_of_range("MeshData::GetIndices16: index " +
+							std::to_string(Indices32[i]) + " does not fit in 16 bits");
+					}
+
 					mIndices16[i] = static_cast<uint16>(Indices32[i]);
+				}
 			}
 
 			return mIndices16;
@@ -120,6 +134,10 @@ public:
 	MeshData CreateTetrahedron(float width, float height);
 
 private:
+	///<summary>
+	/// Splits every triangle into four.  Triangles that share an edge share the
+	/// new midpoint vertex, so each level adds one vertex per unique edge.
+	///</summary>
 	void Subdivide(MeshData& meshData);
     Vertex MidPoint(const Vertex& v0, const Vertex& v1);
     void BuildCylinderTopCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, MeshData& meshData);
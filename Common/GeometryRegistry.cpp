@@ -0,0 +1,483 @@
+//***************************************************************************************
+// GeometryRegistry.cpp
+//***************************************************************************************
+
+#include "GeometryRegistry.h"
+#include <algorithm>
+#include <stdexcept>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	// Index arenas are allocated in units of this many bytes.
+	const UINT kIndexUnitByteSize = 4;
+}
+
+GeometryRegistry::GeometryRegistry(ID3D12Device* device, UINT vertexArenaByteSize, UINT indexArenaByteSize)
+	: mDevice(device), mVertexArenaByteSize(vertexArenaByteSize)
+{
+	mIndexGroup.ElementByteSize = kIndexUnitByteSize;
+	mIndexGroup.DefaultCapacity = indexArenaByteSize / kIndexUnitByteSize;
+}
+
+GeometryRegistry::Handle GeometryRegistry::Register(MeshGeometry& geo, ID3D12GraphicsCommandList* cmdList)
+{
+	if(geo.VertexBufferCPU == nullptr || geo.IndexBufferCPU == nullptr)
+		throw std::invalid_argument("GeometryRegistry::Register: " + geo.Name + " has no CPU copies");
+
+	return Register(geo, [&geo](void* vertices, void* indices)
+	{
+		memcpy(vertices, geo.VertexBufferCPU->GetBufferPointer(), geo.VertexBufferByteSize);
+		memcpy(indices, geo.IndexBufferCPU->GetBufferPointer(), geo.IndexBufferByteSize);
+	}, cmdList);
+}
+
+GeometryRegistry::Handle GeometryRegistry::Register(MeshGeometry& geo, const WriteDataFn& writeData,
+	ID3D12GraphicsCommandList* cmdList)
+{
+	if(geo.VertexByteStride == 0)
+		throw std::invalid_argument("GeometryRegistry::Register: " + geo.Name + " has no vertex stride");
+
+	FreeCompletedRanges();
+
+	const UINT vertexCount = geo.VertexBufferByteSize / geo.VertexByteStride;
+	const UINT indexUnits = (geo.IndexBufferByteSize + kIndexUnitByteSize - 1) / kIndexUnitByteSize;
+	if(vertexCount == 0 || indexUnits == 0)
+		throw std::invalid_argument("GeometryRegistry::Register: " + geo.Name + " is empty");
+
+	//
+	// Stage both buffers in one upload heap before taking any ranges, so a failure to
+	// create or write it leaves the arenas as they were.
+	//
+
+	const UINT vbByteSize = vertexCount*geo.VertexByteStride;
+	const UINT ibByteSize = geo.IndexBufferByteSize;
+
+	ComPtr<ID3D12Resource> uploader;
+	ThrowIfFailed(mDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer((UINT64)vbByteSize + ibByteSize),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(uploader.GetAddressOf())));
+
+	BYTE* mapped = nullptr;
+	ThrowIfFailed(uploader->Map(0, nullptr, reinterpret_cast<void**>(&mapped)));
+	try
+	{
+		writeData(mapped, mapped + vbByteSize);
+	}
+	catch(...)
+	{
+		uploader->Unmap(0, nullptr);
+		throw;
+	}
+	uploader->Unmap(0, nullptr);
+
+	//
+	// Allocate the ranges and copy into them.  Allocating the index range can create
+	// an arena, which can throw; the vertex range goes back if it does.  Nothing after
+	// that throws, so once both ranges are taken the geometry is registered.
+	//
+
+	Slot slot;
+	slot.Geo = &geo;
+	slot.Live = true;
+	slot.VertexGroup = &GetVertexGroup(geo.VertexByteStride);
+
+	// Make room for the slot up front, so handing it out below cannot throw.
+	if(mFreeSlots.empty() && mSlots.size() == mSlots.capacity())
+		mSlots.reserve(mSlots.size()*2 + 1);
+
+	Allocation& alloc = slot.Alloc;
+	alloc.VertexArena = Allocate(*slot.VertexGroup, vertexCount, alloc.VertexOffset);
+	alloc.VertexCount = vertexCount;
+
+	UINT indexOffset = 0;
+	try
+	{
+		alloc.IndexArena = Allocate(mIndexGroup, indexUnits, indexOffset);
+	}
+	catch(...)
+	{
+		FreeRange({ slot.VertexGroup, alloc.VertexArena, alloc.VertexOffset, vertexCount });
+		throw;
+	}
+
+	alloc.IndexByteOffset = indexOffset*kIndexUnitByteSize;
+	alloc.IndexByteSize = geo.IndexBufferByteSize;
+
+	geo.VertexBufferUploader = uploader;
+	geo.IndexBufferUploader = nullptr;
+
+	Arena& vertexArena = slot.VertexGroup->Arenas[alloc.VertexArena];
+	Arena& indexArena = mIndexGroup.Arenas[alloc.IndexArena];
+
+	Transition(cmdList, vertexArena, D3D12_RESOURCE_STATE_COPY_DEST);
+	Transition(cmdList, indexArena, D3D12_RESOURCE_STATE_COPY_DEST);
+
+	cmdList->CopyBufferRegion(vertexArena.Buffer.Get(), (UINT64)alloc.VertexOffset*geo.VertexByteStride,
+		geo.VertexBufferUploader.Get(), 0, vbByteSize);
+	cmdList->CopyBufferRegion(indexArena.Buffer.Get(), alloc.IndexByteOffset,
+		geo.VertexBufferUploader.Get(), vbByteSize, ibByteSize);
+
+	Transition(cmdList, vertexArena, D3D12_RESOURCE_STATE_GENERIC_READ);
+	Transition(cmdList, indexArena, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	//
+	// Hand out a slot; released slots are reused under a new generation.
+	//
+
+	Handle handle;
+	if(!mFreeSlots.empty())
+	{
+		handle.Index = mFreeSlots.back();
+		mFreeSlots.pop_back();
+
+		slot.Generation = mSlots[handle.Index].Generation;
+		mSlots[handle.Index] = slot;
+	}
+	else
+	{
+		handle.Index = (UINT)mSlots.size();
+		mSlots.push_back(slot);
+	}
+
+	handle.Generation = slot.Generation;
+	UpdateGeometry(mSlots[handle.Index]);
+
+	return handle;
+}
+
+void GeometryRegistry::Unregister(Handle handle)
+{
+	ReleaseSlot(handle, nullptr, 0);
+}
+
+void GeometryRegistry::Unregister(Handle handle, ID3D12Fence* fence, UINT64 fenceValue)
+{
+	ReleaseSlot(handle, fence, fenceValue);
+}
+
+bool GeometryRegistry::IsValid(Handle handle)const
+{
+	return handle.Index < mSlots.size() && mSlots[handle.Index].Live &&
+		mSlots[handle.Index].Generation == handle.Generation;
+}
+
+GeometryRegistry::Handle GeometryRegistry::Find(const MeshGeometry& geo)const
+{
+	Handle handle;
+	for(UINT i = 0; i < (UINT)mSlots.size(); ++i)
+	{
+		if(mSlots[i].Live && mSlots[i].Geo == &geo)
+		{
+			handle.Index = i;
+			handle.Generation = mSlots[i].Generation;
+			break;
+		}
+	}
+
+	return handle;
+}
+
+const GeometryRegistry::Allocation& GeometryRegistry::GetAllocation(Handle handle)const
+{
+	assert(IsValid(handle));
+	return mSlots[handle.Index].Alloc;
+}
+
+void GeometryRegistry::Compact(ID3D12GraphicsCommandList* cmdList, std::vector<ComPtr<ID3D12Resource>>& retiredBuffers)
+{
+	auto compactGroup = [this, cmdList, &retiredBuffers](ArenaGroup& group, bool vertices)
+	{
+		struct Range
+		{
+			Slot* Owner;
+			UINT Arena;
+			UINT Offset;
+			UINT Size;
+		};
+
+		// Repack the live ranges in their current order, so geometries registered
+		// together stay together.
+		std::vector<Range> ranges;
+		for(Slot& slot : mSlots)
+		{
+			if(!slot.Live)
+				continue;
+
+			const Allocation& alloc = slot.Alloc;
+			if(vertices && slot.VertexGroup == &group)
+				ranges.push_back({ &slot, alloc.VertexArena, alloc.VertexOffset, alloc.VertexCount });
+			else if(!vertices)
+			{
+				ranges.push_back({ &slot, alloc.IndexArena, alloc.IndexByteOffset / kIndexUnitByteSize,
+					(alloc.IndexByteSize + kIndexUnitByteSize - 1) / kIndexUnitByteSize });
+			}
+		}
+
+		std::sort(ranges.begin(), ranges.end(), [](const Range& a, const Range& b)
+		{
+			return a.Arena != b.Arena ? a.Arena < b.Arena : a.Offset < b.Offset;
+		});
+
+		std::vector<Arena> oldArenas;
+		oldArenas.swap(group.Arenas);
+
+		for(Arena& arena : oldArenas)
+			Transition(cmdList, arena, D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+		for(const Range& range : ranges)
+		{
+			UINT offset = 0;
+			UINT arena = Allocate(group, range.Size, offset);
+
+			cmdList->CopyBufferRegion(group.Arenas[arena].Buffer.Get(), (UINT64)offset*group.ElementByteSize,
+				oldArenas[range.Arena].Buffer.Get(), (UINT64)range.Offset*group.ElementByteSize,
+				(UINT64)range.Size*group.ElementByteSize);
+
+			Allocation& alloc = range.Owner->Alloc;
+			if(vertices)
+			{
+				alloc.VertexArena = arena;
+				alloc.VertexOffset = offset;
+			}
+			else
+			{
+				alloc.IndexArena = arena;
+				alloc.IndexByteOffset = offset*kIndexUnitByteSize;
+			}
+		}
+
+		for(Arena& arena : group.Arenas)
+			Transition(cmdList, arena, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+		for(Arena& arena : oldArenas)
+			retiredBuffers.push_back(arena.Buffer);
+	};
+
+	// Retired ranges are not carried over, so they need no fence any more.
+	mRetiredRanges.clear();
+
+	for(auto& group : mVertexGroups)
+		compactGroup(*group, true);
+	compactGroup(mIndexGroup, false);
+
+	for(const Slot& slot : mSlots)
+	{
+		if(slot.Live)
+			UpdateGeometry(slot);
+	}
+}
+
+UINT GeometryRegistry::GetArenaCount()const
+{
+	size_t count = mIndexGroup.Arenas.size();
+	for(auto& group : mVertexGroups)
+		count += group->Arenas.size();
+
+	return (UINT)count;
+}
+
+UINT64 GeometryRegistry::GetUsedByteSize()const
+{
+	UINT64 byteSize = 0;
+	for(const Arena& arena : mIndexGroup.Arenas)
+		byteSize += (UINT64)arena.Used*mIndexGroup.ElementByteSize;
+
+	for(auto& group : mVertexGroups)
+	{
+		for(const Arena& arena : group->Arenas)
+			byteSize += (UINT64)arena.Used*group->ElementByteSize;
+	}
+
+	return byteSize;
+}
+
+UINT64 GeometryRegistry::GetArenaByteSize()const
+{
+	UINT64 byteSize = 0;
+	for(const Arena& arena : mIndexGroup.Arenas)
+		byteSize += (UINT64)arena.Capacity*mIndexGroup.ElementByteSize;
+
+	for(auto& group : mVertexGroups)
+	{
+		for(const Arena& arena : group->Arenas)
+			byteSize += (UINT64)arena.Capacity*group->ElementByteSize;
+	}
+
+	return byteSize;
+}
+
+UINT64 GeometryRegistry::GetReclaimableByteSize()const
+{
+	auto reclaimable = [](const ArenaGroup& group)
+	{
+		UINT64 used = 0;
+		UINT64 capacity = 0;
+		for(const Arena& arena : group.Arenas)
+		{
+			used += arena.Used;
+			capacity += arena.Capacity;
+		}
+
+		// Packed, the ranges fill whole default arenas, or one arena of their own if
+		// they are larger.
+		const UINT64 defaultCapacity = MathHelper::Max<UINT64>(group.DefaultCapacity, 1);
+		const UINT64 packed = MathHelper::Max(used, (used + defaultCapacity - 1) / defaultCapacity * defaultCapacity);
+		return capacity > packed ? (capacity - packed)*group.ElementByteSize : 0;
+	};
+
+	UINT64 byteSize = reclaimable(mIndexGroup);
+	for(auto& group : mVertexGroups)
+		byteSize += reclaimable(*group);
+
+	return byteSize;
+}
+
+GeometryRegistry::ArenaGroup& GeometryRegistry::GetVertexGroup(UINT vertexByteStride)
+{
+	for(auto& group : mVertexGroups)
+	{
+		if(group->ElementByteSize == vertexByteStride)
+			return *group;
+	}
+
+	auto group = std::make_unique<ArenaGroup>();
+	group->ElementByteSize = vertexByteStride;
+	group->DefaultCapacity = mVertexArenaByteSize / vertexByteStride;
+
+	mVertexGroups.push_back(std::move(group));
+	return *mVertexGroups.back();
+}
+
+GeometryRegistry::Arena& GeometryRegistry::CreateArena(ArenaGroup& group, UINT capacity)
+{
+	Arena arena;
+	arena.Capacity = capacity;
+	arena.Allocator = RangeAllocator(capacity);
+	arena.State = D3D12_RESOURCE_STATE_COPY_DEST;
+
+	ThrowIfFailed(mDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer((UINT64)capacity*group.ElementByteSize),
+		arena.State,
+		nullptr,
+		IID_PPV_ARGS(arena.Buffer.GetAddressOf())));
+
+	group.Arenas.push_back(std::move(arena));
+	return group.Arenas.back();
+}
+
+UINT GeometryRegistry::Allocate(ArenaGroup& group, UINT size, UINT& offset)
+{
+	for(size_t i = 0; i < group.Arenas.size(); ++i)
+	{
+		Arena& arena = group.Arenas[i];
+		if(arena.Allocator.Allocate(size, offset))
+		{
+			arena.Used += size;
+			return (UINT)i;
+		}
+	}
+
+	Arena& arena = CreateArena(group, MathHelper::Max(group.DefaultCapacity, size));
+	arena.Allocator.Allocate(size, offset);
+	arena.Used += size;
+
+	return (UINT)group.Arenas.size() - 1;
+}
+
+void GeometryRegistry::Transition(ID3D12GraphicsCommandList* cmdList, Arena& arena, D3D12_RESOURCE_STATES state)
+{
+	if(arena.State == state)
+		return;
+
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(arena.Buffer.Get(), arena.State, state));
+	arena.State = state;
+}
+
+void GeometryRegistry::UpdateGeometry(const Slot& slot)
+{
+	const Allocation& alloc = slot.Alloc;
+	const Arena& vertexArena = slot.VertexGroup->Arenas[alloc.VertexArena];
+	const Arena& indexArena = mIndexGroup.Arenas[alloc.IndexArena];
+
+	MeshGeometry& geo = *slot.Geo;
+	geo.VertexBufferGPU = vertexArena.Buffer;
+	geo.IndexBufferGPU = indexArena.Buffer;
+	geo.BaseVertexLocation = alloc.BaseVertexLocation();
+	geo.IndexByteOffset = alloc.IndexByteOffset;
+	geo.SharedVertexBufferByteSize = vertexArena.Capacity*slot.VertexGroup->ElementByteSize;
+	geo.SharedIndexBufferByteSize = indexArena.Capacity*mIndexGroup.ElementByteSize;
+}
+
+void GeometryRegistry::ReleaseSlot(Handle handle, ID3D12Fence* fence, UINT64 fenceValue)
+{
+	if(!IsValid(handle))
+		return;
+
+	Slot& slot = mSlots[handle.Index];
+	const Allocation& alloc = slot.Alloc;
+
+	RetiredRange vertexRange;
+	vertexRange.Group = slot.VertexGroup;
+	vertexRange.Arena = alloc.VertexArena;
+	vertexRange.Offset = alloc.VertexOffset;
+	vertexRange.Size = alloc.VertexCount;
+
+	RetiredRange indexRange;
+	indexRange.Group = &mIndexGroup;
+	indexRange.Arena = alloc.IndexArena;
+	indexRange.Offset = alloc.IndexByteOffset / kIndexUnitByteSize;
+	indexRange.Size = (alloc.IndexByteSize + kIndexUnitByteSize - 1) / kIndexUnitByteSize;
+
+	for(RetiredRange* range : { &vertexRange, &indexRange })
+	{
+		if(fence != nullptr && fence->GetCompletedValue() < fenceValue)
+		{
+			range->Fence = fence;
+			range->FenceValue = fenceValue;
+			mRetiredRanges.push_back(*range);
+		}
+		else
+			FreeRange(*range);
+	}
+
+	MeshGeometry& geo = *slot.Geo;
+	geo.VertexBufferGPU = nullptr;
+	geo.IndexBufferGPU = nullptr;
+	geo.BaseVertexLocation = 0;
+	geo.IndexByteOffset = 0;
+	geo.SharedVertexBufferByteSize = 0;
+	geo.SharedIndexBufferByteSize = 0;
+
+	slot.Geo = nullptr;
+	slot.Live = false;
+	++slot.Generation;
+	mFreeSlots.push_back(handle.Index);
+}
+
+void GeometryRegistry::FreeRange(const RetiredRange& range)
+{
+	Arena& arena = range.Group->Arenas[range.Arena];
+	arena.Allocator.Free(range.Offset, range.Size);
+	arena.Used -= range.Size;
+}
+
+void GeometryRegistry::FreeCompletedRanges()
+{
+	auto pending = std::partition(mRetiredRanges.begin(), mRetiredRanges.end(), [](const RetiredRange& range)
+	{
+		return range.Fence->GetCompletedValue() < range.FenceValue;
+	});
+
+	for(auto it = pending; it != mRetiredRanges.end(); ++it)
+		FreeRange(*it);
+
+	mRetiredRanges.erase(pending, mRetiredRanges.end());
+}
@@ -0,0 +1,181 @@
+//***************************************************************************************
+// GeometryRegistry.h
+//
+// Sub-allocates the vertex and index data of many MeshGeometry objects from a few large
+// default heap buffers ("arenas") instead of two committed buffers per geometry.
+// Vertices go to arenas of their stride and indices to shared index arenas; ranges come
+// from a best-fit free list (RangeAllocator) that merges neighbours when they are
+// released.  Geometries in the same arenas bind the same buffers, so consecutive draws
+// of them only change their draw arguments.
+//
+// Registered geometries are identified by handles that stay valid while their data
+// moves, for example when Compact packs the arenas.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "RangeAllocator.h"
+#include <functional>
+
+class GeometryRegistry
+{
+public:
+
+	struct Handle
+	{
+		UINT Index = UINT_MAX;
+		UINT Generation = 0;
+	};
+
+	// Where a registered geometry's data currently lives.
+	struct Allocation
+	{
+		UINT VertexArena = 0;
+		UINT VertexOffset = 0;
+		UINT VertexCount = 0;
+
+		UINT IndexArena = 0;
+		UINT IndexByteOffset = 0;
+		UINT IndexByteSize = 0;
+
+		// Same as the geometry's MeshGeometry::BaseVertexLocation.
+		INT BaseVertexLocation()const { return (INT)VertexOffset; }
+	};
+
+	///<summary>
+	/// Arenas are created on demand with room for vertexArenaByteSize bytes of vertices
+	/// or indexArenaByteSize bytes of indices, or for the geometry that needs them if it
+	/// is larger.
+	///</summary>
+	GeometryRegistry(ID3D12Device* device, UINT vertexArenaByteSize = 16*1024*1024,
+		UINT indexArenaByteSize = 8*1024*1024);
+	GeometryRegistry(const GeometryRegistry& rhs) = delete;
+	GeometryRegistry& operator=(const GeometryRegistry& rhs) = delete;
+
+	///<summary>
+	/// Allocates room for geo, which must have its CPU copies, and records the copy of
+	/// its data on cmdList.  geo's GPU buffers are replaced by the arenas and its
+	/// offsets set; the upload heap is kept in geo.VertexBufferUploader.  geo must stay
+	/// at the same address until it is unregistered.
+	///</summary>
+	Handle Register(MeshGeometry& geo, ID3D12GraphicsCommandList* cmdList);
+
+	// Writes a geometry's vertex and index data, VertexBufferByteSize and
+	// IndexBufferByteSize bytes, to vertices and indices.
+	using WriteDataFn = std::function<void(void* vertices, void* indices)>;
+
+	///<summary>
+	/// Same as Register, for a geometry without CPU copies: writeData writes its data
+	/// straight into the upload heap, for example from a file mapped by MeshCache::Map.
+	/// If writeData throws, nothing is registered.
+	///</summary>
+	Handle Register(MeshGeometry& geo, const WriteDataFn& writeData, ID3D12GraphicsCommandList* cmdList);
+
+	///<summary>
+	/// Releases the ranges of a geometry and clears its GPU buffers.  The GPU must be
+	/// done drawing it; the ranges may be reused by the next Register.
+	///</summary>
+	void Unregister(Handle handle);
+
+	///<summary>
+	/// Same as Unregister, for a geometry the GPU may still be drawing: its ranges are
+	/// not reused until fence has reached fenceValue.  Signal fenceValue on the queue
+	/// after the last frame that draws the geometry.
+	///</summary>
+	void Unregister(Handle handle, ID3D12Fence* fence, UINT64 fenceValue);
+
+	bool IsValid(Handle handle)const;
+
+	// Handle of a registered geometry, or an invalid handle.
+	Handle Find(const MeshGeometry& geo)const;
+
+	// The allocation of a registered geometry.  The handle must be valid.
+	const Allocation& GetAllocation(Handle handle)const;
+
+	///<summary>
+	/// Moves every registered geometry into new, tightly packed arenas, records the
+	/// copies on cmdList and updates the geometries.  The old arenas are appended to
+	/// retiredBuffers; keep them until the GPU has executed cmdList and finished the
+	/// frames that were drawn from them.  Ranges still waiting on their fence stay in
+	/// the old arenas and are dropped with them.
+	///</summary>
+	void Compact(ID3D12GraphicsCommandList* cmdList,
+		std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>>& retiredBuffers);
+
+	UINT GetArenaCount()const;
+
+	// Bytes of the arenas in use and in total.
+	UINT64 GetUsedByteSize()const;
+	UINT64 GetArenaByteSize()const;
+
+	///<summary>
+	/// Bytes of arenas Compact would release, roughly: those beyond the default sized
+	/// arenas the ranges in use would pack into.  Zero if compacting frees no arena.
+	///</summary>
+	UINT64 GetReclaimableByteSize()const;
+
+private:
+
+	struct Arena
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Buffer;
+		D3D12_RESOURCE_STATES State = D3D12_RESOURCE_STATE_COPY_DEST;
+		UINT Capacity = 0;
+		UINT Used = 0;
+		RangeAllocator Allocator;
+	};
+
+	// Arenas of one element size: a vertex stride, or 4 for indices, which are
+	// allocated in 4-byte units so 16 and 32-bit submeshes both start on an index.
+	struct ArenaGroup
+	{
+		UINT ElementByteSize = 0;
+		UINT DefaultCapacity = 0;
+		std::vector<Arena> Arenas;
+	};
+
+	// A range of an unregistered geometry that frames in flight may still read.
+	struct RetiredRange
+	{
+		ArenaGroup* Group = nullptr;
+		UINT Arena = 0;
+		UINT Offset = 0;
+		UINT Size = 0;
+
+		Microsoft::WRL::ComPtr<ID3D12Fence> Fence;
+		UINT64 FenceValue = 0;
+	};
+
+	struct Slot
+	{
+		MeshGeometry* Geo = nullptr;
+		UINT Generation = 0;
+		bool Live = false;
+
+		ArenaGroup* VertexGroup = nullptr;
+		Allocation Alloc;
+	};
+
+	ArenaGroup& GetVertexGroup(UINT vertexByteStride);
+	Arena& CreateArena(ArenaGroup& group, UINT capacity);
+	UINT Allocate(ArenaGroup& group, UINT size, UINT& offset);
+	void Transition(ID3D12GraphicsCommandList* cmdList, Arena& arena, D3D12_RESOURCE_STATES state);
+	void UpdateGeometry(const Slot& slot);
+	void ReleaseSlot(Handle handle, ID3D12Fence* fence, UINT64 fenceValue);
+	void FreeRange(const RetiredRange& range);
+	void FreeCompletedRanges();
+
+	ID3D12Device* mDevice = nullptr;
+	UINT mVertexArenaByteSize = 0;
+
+	std::vector<std::unique_ptr<ArenaGroup>> mVertexGroups;
+	ArenaGroup mIndexGroup;
+
+	std::vector<Slot> mSlots;
+	std::vector<UINT> mFreeSlots;
+
+	// Ranges that go back to their arenas once their fences pass.  They still count
+	// as used until then.
+	std::vector<RetiredRange> mRetiredRanges;
+};
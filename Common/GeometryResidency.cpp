@@ -0,0 +1,110 @@
+//***************************************************************************************
+// GeometryResidency.cpp
+//***************************************************************************************
+
+#include "GeometryResidency.h"
+
+GeometryResidency::GeometryResidency(size_t cpuByteBudget)
+	: mByteBudget(cpuByteBudget)
+{
+}
+
+size_t GeometryResidency::GetCpuByteSize(const MeshGeometry& geo)
+{
+	size_t byteSize = 0;
+	if(geo.VertexBufferCPU != nullptr)
+		byteSize += geo.VertexBufferCPU->GetBufferSize();
+	if(geo.IndexBufferCPU != nullptr)
+		byteSize += geo.IndexBufferCPU->GetBufferSize();
+
+	return byteSize;
+}
+
+void GeometryResidency::Track(MeshGeometry& geo, ID3D12Fence* fence, UINT64 fenceValue, ReloadFn reload)
+{
+	Untrack(geo);
+
+	Entry entry;
+	entry.Geo = &geo;
+	entry.Reload = std::move(reload);
+	entry.UploadFence = fence;
+	entry.UploadFenceValue = fenceValue;
+	entry.ByteSize = GetCpuByteSize(geo);
+
+	mEntries.push_front(std::move(entry));
+	mLookup[&geo] = mEntries.begin();
+	mByteSize += mEntries.front().ByteSize;
+}
+
+void GeometryResidency::Untrack(const MeshGeometry& geo)
+{
+	auto it = mLookup.find(&geo);
+	if(it == mLookup.end())
+		return;
+
+	mByteSize -= it->second->ByteSize;
+	mEntries.erase(it->second);
+	mLookup.erase(it);
+}
+
+void GeometryResidency::Update()
+{
+	for(Entry& entry : mEntries)
+	{
+		if(entry.UploadFence != nullptr && entry.UploadFence->GetCompletedValue() >= entry.UploadFenceValue)
+		{
+			entry.Geo->DisposeUploaders();
+			entry.UploadFence = nullptr;
+		}
+	}
+
+	Evict();
+}
+
+void GeometryResidency::Evict()
+{
+	auto it = mEntries.end();
+	while(mByteSize > mByteBudget && it != mEntries.begin())
+	{
+		--it;
+
+		// Copies that could not be brought back are kept.
+		if(it->ByteSize == 0 || !it->Reload)
+			continue;
+
+		it->Geo->VertexBufferCPU = nullptr;
+		it->Geo->IndexBufferCPU = nullptr;
+
+		mByteSize -= it->ByteSize;
+		it->ByteSize = 0;
+		++mEvictionCount;
+	}
+}
+
+bool GeometryResidency::AcquireCpuCopies(MeshGeometry& geo)
+{
+	auto it = mLookup.find(&geo);
+	if(it == mLookup.end())
+		return false;
+
+	Entry& entry = *it->second;
+	mEntries.splice(mEntries.begin(), mEntries, it->second);
+
+	if(entry.ByteSize != 0)
+		return true;
+
+	if(!entry.Reload || !entry.Reload(geo) || geo.VertexBufferCPU == nullptr || geo.IndexBufferCPU == nullptr)
+		return false;
+
+	entry.ByteSize = GetCpuByteSize(geo);
+	mByteSize += entry.ByteSize;
+	++mReloadCount;
+
+	return true;
+}
+
+void GeometryResidency::SetByteBudget(size_t cpuByteBudget)
+{
+	mByteBudget = cpuByteBudget;
+	Evict();
+}
@@ -0,0 +1,92 @@
+//***************************************************************************************
+// GeometryResidency.h
+//
+// Tracks the memory a MeshGeometry holds besides its GPU buffers.  Upload heaps are
+// released once the fence value their copy was submitted with has completed.  The
+// system memory copies (VertexBufferCPU, IndexBufferCPU) are kept only while the
+// copies of all tracked geometries fit a byte budget; the least recently used are
+// dropped beyond it and reloaded when a picking or collision user asks for them.
+//
+// Not thread-safe; used from the thread that draws.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include <functional>
+#include <list>
+
+class GeometryResidency
+{
+public:
+
+	// Refills the CPU copies of an evicted geometry.  Returns false if it cannot.
+	using ReloadFn = std::function<bool(MeshGeometry& geo)>;
+
+	explicit GeometryResidency(size_t cpuByteBudget = 16*1024*1024);
+	GeometryResidency(const GeometryResidency& rhs) = delete;
+	GeometryResidency& operator=(const GeometryResidency& rhs) = delete;
+
+	///<summary>
+	/// Starts tracking geo, whose upload was submitted before fence is signaled with
+	/// fenceValue.  geo counts as just used.  Without a reload function its CPU copies
+	/// are never evicted, since nothing could bring them back.  geo must stay at the
+	/// same address until it is untracked.
+	///</summary>
+	void Track(MeshGeometry& geo, ID3D12Fence* fence, UINT64 fenceValue, ReloadFn reload);
+
+	// Stops tracking geo, leaving its CPU copies and uploaders as they are.
+	void Untrack(const MeshGeometry& geo);
+
+	///<summary>
+	/// Releases the uploaders of the geometries whose upload has completed and evicts
+	/// the least recently used CPU copies until the rest fit the budget.  Call once per
+	/// frame.
+	///</summary>
+	void Update();
+
+	///<summary>
+	/// Makes the CPU copies of a tracked geometry resident, reloading them if they were
+	/// evicted, and marks them as just used.  They stay valid until the next Update.
+	/// Returns false if geo is not tracked or cannot be reloaded.
+	///</summary>
+	bool AcquireCpuCopies(MeshGeometry& geo);
+
+	// Evicts right away if the copies no longer fit.
+	void SetByteBudget(size_t cpuByteBudget);
+
+	// Bytes of CPU copies held by tracked geometries.
+	size_t GetByteSize()const { return mByteSize; }
+
+	size_t GetEvictionCount()const { return mEvictionCount; }
+	size_t GetReloadCount()const { return mReloadCount; }
+
+private:
+
+	struct Entry
+	{
+		MeshGeometry* Geo = nullptr;
+		ReloadFn Reload;
+
+		// Cleared once the uploaders are released.
+		Microsoft::WRL::ComPtr<ID3D12Fence> UploadFence;
+		UINT64 UploadFenceValue = 0;
+
+		// Size of the CPU copies while they are resident, else zero.
+		size_t ByteSize = 0;
+	};
+
+	static size_t GetCpuByteSize(const MeshGeometry& geo);
+
+	// Drops least recently used CPU copies until the rest fit the budget.
+	void Evict();
+
+	// Most recently used first.
+	std::list<Entry> mEntries;
+	std::unordered_map<const MeshGeometry*, std::list<Entry>::iterator> mLookup;
+
+	size_t mByteBudget = 0;
+	size_t mByteSize = 0;
+	size_t mEvictionCount = 0;
+	size_t mReloadCount = 0;
+};
@@ -0,0 +1,73 @@
+//***************************************************************************************
+// IndexPacker.cpp
+//***************************************************************************************
+
+#include "IndexPacker.h"
+
+SubmeshGeometry IndexPacker::Layout(const std::uint32_t* indices, size_t indexCount, INT baseVertexLocation, size_t& byteOffset)
+{
+	std::uint32_t minIndex = UINT32_MAX;
+	std::uint32_t maxIndex = 0;
+	for(size_t i = 0; i < indexCount; ++i)
+	{
+		minIndex = MathHelper::Min(minIndex, indices[i]);
+		maxIndex = MathHelper::Max(maxIndex, indices[i]);
+	}
+
+	if(indexCount == 0)
+		minIndex = maxIndex = 0;
+
+	bool use16 = maxIndex - minIndex <= 0xffff;
+	size_t indexSize = use16 ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+
+	// Index buffer views must start at a multiple of their index size.
+	byteOffset = (byteOffset + indexSize - 1) / indexSize * indexSize;
+
+	SubmeshGeometry submesh;
+	submesh.IndexCount = (UINT)indexCount;
+	submesh.StartIndexLocation = (UINT)(byteOffset / indexSize);
+	submesh.BaseVertexLocation = baseVertexLocation + (INT)minIndex;
+	submesh.IndexFormat = use16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
+	byteOffset += indexCount*indexSize;
+
+	return submesh;
+}
+
+void IndexPacker::Write(const std::uint32_t* indices, size_t indexCount, INT baseVertexLocation,
+	const SubmeshGeometry& submesh, void* buffer)
+{
+	std::uint32_t minIndex = (std::uint32_t)(submesh.BaseVertexLocation - baseVertexLocation);
+
+	if(submesh.IndexFormat == DXGI_FORMAT_R16_UINT)
+	{
+		std::uint16_t* dst = static_cast<std::uint16_t*>(buffer) + submesh.StartIndexLocation;
+		for(size_t i = 0; i < indexCount; ++i)
+			dst[i] = static_cast<std::uint16_t>(indices[i] - minIndex);
+	}
+	else
+	{
+		std::uint32_t* dst = static_cast<std::uint32_t*>(buffer) + submesh.StartIndexLocation;
+		for(size_t i = 0; i < indexCount; ++i)
+			dst[i] = indices[i] - minIndex;
+	}
+}
+
+SubmeshGeometry IndexPacker::Append(const std::uint32_t* indices, size_t indexCount, INT baseVertexLocation)
+{
+	size_t byteSize = mData.size();
+	SubmeshGeometry submesh = Layout(indices, indexCount, baseVertexLocation, byteSize);
+
+	mData.resize(byteSize);
+	Write(indices, indexCount, baseVertexLocation, submesh, mData.data());
+
+	if(submesh.IndexFormat == DXGI_FORMAT_R32_UINT)
+		++mIndex32SubmeshCount;
+
+	return submesh;
+}
+
+SubmeshGeometry IndexPacker::Append(const std::vector<std::uint32_t>& indices, INT baseVertexLocation)
+{
+	return Append(indices.data(), indices.size(), baseVertexLocation);
+}
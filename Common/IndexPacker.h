@@ -0,0 +1,43 @@
+//***************************************************************************************
+// IndexPacker.h
+//
+// Packs the index lists of several submeshes into one index buffer.  Each submesh is
+// rebased to the smallest vertex it references and stored with 16-bit indices whenever
+// the rebased range fits, otherwise with 32-bit indices.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+
+class IndexPacker
+{
+public:
+
+	///<summary>
+	/// Appends a submesh whose indices are relative to baseVertexLocation and returns
+	/// its draw arguments.  The returned submesh's BaseVertexLocation includes the
+	/// rebase and its IndexFormat tells which view of the buffer to draw it with.
+	///</summary>
+	SubmeshGeometry Append(const std::uint32_t* indices, size_t indexCount, INT baseVertexLocation);
+	SubmeshGeometry Append(const std::vector<std::uint32_t>& indices, INT baseVertexLocation);
+
+	///<summary>
+	/// Two-pass form of Append for callers that pack into a buffer of their own.  Layout
+	/// returns the draw arguments of a submesh placed at byteOffset and advances byteOffset
+	/// past it; Write stores the submesh's indices once the buffer exists.
+	///</summary>
+	static SubmeshGeometry Layout(const std::uint32_t* indices, size_t indexCount, INT baseVertexLocation, size_t& byteOffset);
+	static void Write(const std::uint32_t* indices, size_t indexCount, INT baseVertexLocation,
+		const SubmeshGeometry& submesh, void* buffer);
+
+	const void* GetData()const { return mData.data(); }
+	UINT GetByteSize()const { return (UINT)mData.size(); }
+
+	// Number of submeshes that needed 32-bit indices.
+	UINT GetIndex32SubmeshCount()const { return mIndex32SubmeshCount; }
+
+private:
+	std::vector<std::uint8_t> mData;
+	UINT mIndex32SubmeshCount = 0;
+};
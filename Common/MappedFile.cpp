@@ -0,0 +1,65 @@
+//***************************************************************************************
+// MappedFile.cpp
+//***************************************************************************************
+
+#include "MappedFile.h"
+#include "d3dUtil.h"
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::wstring& filename)
+{
+	Close();
+
+	mFile = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if(mFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(mFile, &size))
+	{
+		HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+		Close();
+		ThrowIfFailed(hr);
+	}
+
+	mSize = (size_t)size.QuadPart;
+
+	// Zero-length files cannot be mapped.
+	if(mSize == 0)
+		return true;
+
+	mMapping = CreateFileMappingW(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(mMapping != nullptr)
+		mView = MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+
+	if(mView == nullptr)
+	{
+		HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+		Close();
+		ThrowIfFailed(hr);
+	}
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if(mView != nullptr)
+		UnmapViewOfFile(mView);
+
+	if(mMapping != nullptr)
+		CloseHandle(mMapping);
+
+	if(mFile != INVALID_HANDLE_VALUE)
+		CloseHandle(mFile);
+
+	mFile = INVALID_HANDLE_VALUE;
+	mMapping = nullptr;
+	mView = nullptr;
+	mSize = 0;
+}
@@ -0,0 +1,39 @@
+//***************************************************************************************
+// MappedFile.h
+//
+// Read-only memory mapping of a whole file.  The view stays valid until the object is
+// closed or destroyed.
+//***************************************************************************************
+
+#pragma once
+
+#include <windows.h>
+#include <string>
+
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile& rhs) = delete;
+	MappedFile& operator=(const MappedFile& rhs) = delete;
+	~MappedFile();
+
+	///<summary>
+	/// Maps the file for reading.  Returns false if the file cannot be opened; throws a
+	/// DxException if it opens but cannot be mapped.
+	///</summary>
+	bool Open(const std::wstring& filename);
+	void Close();
+
+	bool IsOpen()const { return mFile != INVALID_HANDLE_VALUE; }
+
+	// Empty files map to a null view of size zero.
+	const char* GetData()const { return static_cast<const char*>(mView); }
+	size_t GetSize()const { return mSize; }
+
+private:
+	HANDLE mFile = INVALID_HANDLE_VALUE;
+	HANDLE mMapping = nullptr;
+	const void* mView = nullptr;
+	size_t mSize = 0;
+};
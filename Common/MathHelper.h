@@ -89,6 +89,26 @@ public:
         return I;
     }
 
+    // Extracts the left, right, bottom, top, near and far planes of the frustum
+    // described by a view-projection matrix (Gribb/Hartmann).  The planes are
+    // normalized and their normals point into the frustum.
+    static void ExtractFrustumPlanes(DirectX::XMVECTOR planes[6], DirectX::CXMMATRIX viewProj)
+    {
+        // With row vectors, clip = v*M, so the clip coordinates are the dot
+        // products of v with the columns of M (the rows of its transpose).
+        DirectX::XMMATRIX T = DirectX::XMMatrixTranspose(viewProj);
+
+        planes[0] = T.r[3] + T.r[0];
+        planes[1] = T.r[3] - T.r[0];
+        planes[2] = T.r[3] + T.r[1];
+        planes[3] = T.r[3] - T.r[1];
+        planes[4] = T.r[2];
+        planes[5] = T.r[3] - T.r[2];
+
+        for(int i = 0; i < 6; ++i)
+            planes[i] = DirectX::XMPlaneNormalize(planes[i]);
+    }
+
     static DirectX::XMVECTOR RandUnitVec3();
     static DirectX::XMVECTOR RandHemisphereUnitVec3(DirectX::XMVECTOR n);
 
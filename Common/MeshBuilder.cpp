@@ -0,0 +1,213 @@
+//***************************************************************************************
+// MeshBuilder.cpp
+//***************************************************************************************
+
+#include "MeshBuilder.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace DirectX;
+
+void MeshBuilder::AddMesh(const std::string& name, const XMFLOAT3* positions, const XMFLOAT3* normals,
+	size_t vertexStride, size_t vertexCount, const std::uint32_t* indices, size_t indexCount,
+	std::vector<MeshCluster> clusters)
+{
+	PendingMesh mesh;
+	mesh.Name = name;
+	mesh.Positions = positions;
+	mesh.Normals = normals;
+	mesh.VertexStride = vertexStride;
+	mesh.VertexCount = vertexCount;
+	mesh.Indices = indices;
+	mesh.IndexCount = indexCount;
+	mesh.Clusters = std::move(clusters);
+
+	// Each mesh is quantized relative to its own bounds.
+	mesh.Decode = MeshQuantizer::ComputeDecode(positions, vertexStride, vertexCount);
+	MeshOptimizer::ComputeBounds(positions, vertexStride, vertexCount, mesh.Bounds, mesh.Sphere);
+
+	mMeshes.push_back(std::move(mesh));
+}
+
+void MeshBuilder::AddMesh(const std::string& name, const GeometryGenerator::MeshData& meshData,
+	std::vector<MeshCluster> clusters)
+{
+	const GeometryGenerator::Vertex* v = meshData.Vertices.data();
+	AddMesh(name, &v->Position, &v->Normal, sizeof(GeometryGenerator::Vertex), meshData.Vertices.size(),
+		meshData.Indices32.data(), meshData.Indices32.size(), std::move(clusters));
+}
+
+void MeshBuilder::AddLod(const std::string& name, std::vector<std::uint32_t> indices, float error,
+	std::vector<MeshCluster> clusters)
+{
+	auto it = std::find_if(mMeshes.begin(), mMeshes.end(),
+		[&name](const PendingMesh& mesh) { return mesh.Name == name; });
+	if(it == mMeshes.end())
+		throw std::invalid_argument("MeshBuilder::AddLod: no mesh named " + name);
+
+	PendingLod lod;
+	lod.Mesh = (size_t)(it - mMeshes.begin());
+	lod.Level = ++it->LodCount;
+	lod.Indices = std::move(indices);
+	lod.Clusters = std::move(clusters);
+	lod.Error = error;
+
+	mLods.push_back(std::move(lod));
+}
+
+std::unique_ptr<MeshGeometry> MeshBuilder::Build(const std::string& geoName, ID3D12Device* device,
+	ID3D12GraphicsCommandList* cmdList)
+{
+	auto geo = Pack(geoName);
+	Upload(*geo, device, cmdList);
+
+	return geo;
+}
+
+std::unique_ptr<MeshGeometry> MeshBuilder::Pack(const std::string& geoName)
+{
+	auto geo = std::make_unique<MeshGeometry>();
+	geo->Name = geoName;
+
+	//
+	// Lay out both buffers first so each is allocated exactly once.  The submeshes
+	// are laid out straight into DrawArgs, which never moves its elements, so the
+	// levels of detail can point at them.
+	//
+
+	std::vector<INT> baseVertexLocations(mMeshes.size());
+	size_t vertexCount = 0;
+	for(size_t i = 0; i < mMeshes.size(); ++i)
+	{
+		baseVertexLocations[i] = (INT)vertexCount;
+		vertexCount += mMeshes[i].VertexCount;
+	}
+
+	size_t ibByteSize = 0;
+
+	std::vector<SubmeshGeometry*> fullDetail(mMeshes.size());
+	for(size_t i = 0; i < mMeshes.size(); ++i)
+	{
+		const PendingMesh& mesh = mMeshes[i];
+
+		SubmeshGeometry& submesh = geo->DrawArgs[mesh.Name];
+		submesh = IndexPacker::Layout(mesh.Indices, mesh.IndexCount, baseVertexLocations[i], ibByteSize);
+		fullDetail[i] = &submesh;
+	}
+
+	std::vector<SubmeshGeometry*> lodDetail(mLods.size());
+	for(size_t i = 0; i < mLods.size(); ++i)
+	{
+		const PendingLod& lod = mLods[i];
+
+		SubmeshGeometry& submesh = geo->DrawArgs[mMeshes[lod.Mesh].Name + "_lod" + std::to_string(lod.Level)];
+		submesh = IndexPacker::Layout(lod.Indices.data(), lod.Indices.size(), baseVertexLocations[lod.Mesh], ibByteSize);
+		lodDetail[i] = &submesh;
+	}
+
+	const UINT vbByteSize = (UINT)(vertexCount * sizeof(PackedVertex));
+
+	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
+	ThrowIfFailed(D3DCreateBlob((UINT)ibByteSize, &geo->IndexBufferCPU));
+
+	//
+	// Pack the vertices and indices into the blobs.  The indices are written in
+	// layout order, so the only bytes left are the alignment padding in front of a
+	// 32-bit run.  It is never drawn; zero it so the buffer contents do not depend
+	// on uninitialized memory.
+	//
+
+	PackedVertex* vertices = static_cast<PackedVertex*>(geo->VertexBufferCPU->GetBufferPointer());
+	BYTE* indices = static_cast<BYTE*>(geo->IndexBufferCPU->GetBufferPointer());
+	size_t writtenBytes = 0;
+
+	auto writeIndices = [&](const std::uint32_t* src, size_t count, INT baseVertexLocation, const SubmeshGeometry& submesh)
+	{
+		const size_t indexSize = submesh.IndexFormat == DXGI_FORMAT_R16_UINT ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+		const size_t start = submesh.StartIndexLocation*indexSize;
+
+		ZeroMemory(indices + writtenBytes, start - writtenBytes);
+		IndexPacker::Write(src, count, baseVertexLocation, submesh, indices);
+		writtenBytes = start + count*indexSize;
+	};
+
+	for(size_t i = 0; i < mMeshes.size(); ++i)
+	{
+		PendingMesh& mesh = mMeshes[i];
+
+		mesh.Error = MeshQuantizer::Quantize(mesh.Positions, mesh.Normals, mesh.VertexStride, mesh.VertexCount,
+			mesh.Decode, vertices + baseVertexLocations[i]);
+
+		writeIndices(mesh.Indices, mesh.IndexCount, baseVertexLocations[i], *fullDetail[i]);
+	}
+
+	for(size_t i = 0; i < mLods.size(); ++i)
+	{
+		const PendingLod& lod = mLods[i];
+		writeIndices(lod.Indices.data(), lod.Indices.size(), baseVertexLocations[lod.Mesh], *lodDetail[i]);
+	}
+
+	geo->VertexByteStride = sizeof(PackedVertex);
+	geo->VertexBufferByteSize = vbByteSize;
+	geo->IndexFormat = fullDetail.empty() ? DXGI_FORMAT_R16_UINT : fullDetail[0]->IndexFormat;
+	geo->IndexBufferByteSize = (UINT)ibByteSize;
+
+	//
+	// Fill in the rest of the draw arguments.
+	//
+
+	for(size_t i = 0; i < mMeshes.size(); ++i)
+	{
+		SubmeshGeometry& submesh = *fullDetail[i];
+		submesh.Clusters = std::move(mMeshes[i].Clusters);
+		submesh.Decode = mMeshes[i].Decode;
+		submesh.Bounds = mMeshes[i].Bounds;
+		submesh.Sphere = mMeshes[i].Sphere;
+	}
+
+	for(size_t i = 0; i < mLods.size(); ++i)
+	{
+		PendingLod& lod = mLods[i];
+		SubmeshGeometry& full = *fullDetail[lod.Mesh];
+
+		SubmeshGeometry& submesh = *lodDetail[i];
+		submesh.Clusters = std::move(lod.Clusters);
+		submesh.LodError = lod.Error;
+		submesh.Decode = full.Decode;
+		submesh.Bounds = full.Bounds;
+		submesh.Sphere = full.Sphere;
+
+		full.Lods.push_back(&submesh);
+	}
+
+	// The queued meshes may be gone once this returns.
+	for(PendingMesh& mesh : mMeshes)
+	{
+		mesh.Positions = mesh.Normals = nullptr;
+		mesh.Indices = nullptr;
+	}
+	mLods.clear();
+
+	return geo;
+}
+
+MeshQuantizer::QuantizationError MeshBuilder::GetQuantizationError(const std::string& name)const
+{
+	for(const PendingMesh& mesh : mMeshes)
+	{
+		if(mesh.Name == name)
+			return mesh.Error;
+	}
+
+	return MeshQuantizer::QuantizationError();
+}
+
+void MeshBuilder::Upload(MeshGeometry& geo, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList)
+{
+	geo.VertexBufferGPU = d3dUtil::CreateDefaultBuffer(device, cmdList,
+		geo.VertexBufferCPU->GetBufferPointer(), geo.VertexBufferByteSize, geo.VertexBufferUploader);
+
+	geo.IndexBufferGPU = d3dUtil::CreateDefaultBuffer(device, cmdList,
+		geo.IndexBufferCPU->GetBufferPointer(), geo.IndexBufferByteSize, geo.IndexBufferUploader);
+}
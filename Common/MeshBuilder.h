@@ -0,0 +1,92 @@
+//***************************************************************************************
+// MeshBuilder.h
+//
+// Collects the submeshes of one MeshGeometry and packs them straight into its final
+// vertex and index buffers.  Meshes are only referenced until Build, which sizes the
+// buffers once, quantizes each vertex and rebases each index directly into the CPU
+// copies, uploads them and records the SubmeshGeometry of every mesh.  Packing and
+// uploading can also be done separately, the first on any thread.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "GeometryGenerator.h"
+#include "IndexPacker.h"
+#include "MeshQuantizer.h"
+
+class MeshBuilder
+{
+public:
+
+	///<summary>
+	/// Queues a mesh.  positions and normals point at the first vertex's attributes and
+	/// vertexStride is the size of a source vertex.  The vertices and indices are read by
+	/// Build and must stay valid until then.
+	///</summary>
+	void AddMesh(const std::string& name, const DirectX::XMFLOAT3* positions, const DirectX::XMFLOAT3* normals,
+		size_t vertexStride, size_t vertexCount, const std::uint32_t* indices, size_t indexCount,
+		std::vector<MeshCluster> clusters = {});
+	void AddMesh(const std::string& name, const GeometryGenerator::MeshData& meshData,
+		std::vector<MeshCluster> clusters = {});
+
+	///<summary>
+	/// Queues the next level of detail of a mesh added earlier.  The indices reference
+	/// the mesh's vertices; the level is registered as "<name>_lod1", "<name>_lod2", ...
+	/// and linked to the full detail submesh.
+	///</summary>
+	void AddLod(const std::string& name, std::vector<std::uint32_t> indices, float error,
+		std::vector<MeshCluster> clusters = {});
+
+	///<summary>
+	/// Creates the geometry of every queued mesh and records its upload on cmdList.  The
+	/// full detail index lists come first and the levels of detail after them.
+	///</summary>
+	std::unique_ptr<MeshGeometry> Build(const std::string& geoName, ID3D12Device* device,
+		ID3D12GraphicsCommandList* cmdList);
+
+	///<summary>
+	/// Same as Build, but only fills the CPU copies; the GPU buffers are left for Upload.
+	/// Needs no device, so it can run on a worker thread.
+	///</summary>
+	std::unique_ptr<MeshGeometry> Pack(const std::string& geoName);
+
+	///<summary>
+	/// Creates the GPU buffers of geo from its CPU copies and records the upload on cmdList.
+	///</summary>
+	static void Upload(MeshGeometry& geo, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList);
+
+	// Largest error the quantization of a mesh introduced.  Valid after Build.
+	MeshQuantizer::QuantizationError GetQuantizationError(const std::string& name)const;
+
+private:
+
+	struct PendingMesh
+	{
+		std::string Name;
+		const DirectX::XMFLOAT3* Positions = nullptr;
+		const DirectX::XMFLOAT3* Normals = nullptr;
+		size_t VertexStride = 0;
+		size_t VertexCount = 0;
+		const std::uint32_t* Indices = nullptr;
+		size_t IndexCount = 0;
+		std::vector<MeshCluster> Clusters;
+		VertexDecode Decode;
+		DirectX::BoundingBox Bounds;
+		DirectX::BoundingSphere Sphere;
+		MeshQuantizer::QuantizationError Error;
+		UINT LodCount = 0;
+	};
+
+	struct PendingLod
+	{
+		size_t Mesh = 0;
+		UINT Level = 0;
+		std::vector<std::uint32_t> Indices;
+		std::vector<MeshCluster> Clusters;
+		float Error = 0.0f;
+	};
+
+	std::vector<PendingMesh> mMeshes;
+	std::vector<PendingLod> mLods;
+};
@@ -0,0 +1,603 @@
+//***************************************************************************************
+// MeshCache.cpp
+//***************************************************************************************
+
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "MeshCodec.h"
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_set>
+
+using namespace DirectX;
+
+namespace
+{
+	const char kMagic[4] = { 'M', 'S', 'H', 'C' };
+
+	// Bump whenever the layout below or the processing that produces cached meshes
+	// (welding, optimization, simplification, quantization) changes.
+	const std::uint32_t kVersion = 4;
+
+	// The vertex and index data are stored together, encoded by MeshCodec.
+	const std::uint32_t kFlagCompressed = 0x1;
+
+	const std::uint64_t kSectionAlignment = 16;
+
+	struct FileHeader
+	{
+		char Magic[4];
+		std::uint32_t Version;
+
+		// Stamp of the source file the cache was built from.
+		std::uint64_t SourceSize;
+		std::uint64_t SourceWriteTime;
+
+		std::uint64_t SubmeshOffset;
+		std::uint64_t ClusterOffset;
+		std::uint64_t StringOffset;
+		std::uint64_t VertexOffset;
+		std::uint64_t IndexOffset;
+
+		std::uint32_t StringByteSize;
+		std::uint32_t VertexByteSize;
+		std::uint32_t IndexByteSize;
+		std::uint32_t VertexByteStride;
+		std::uint32_t IndexFormat;
+		std::uint32_t SubmeshCount;
+		std::uint32_t ClusterCount;
+
+		// Geometry name in the string table.
+		std::uint32_t NameOffset;
+		std::uint32_t NameLength;
+
+		// Union of the full detail submeshes' bounds.
+		float BoundsCenter[3];
+		float BoundsExtents[3];
+
+		std::uint32_t Flags;
+
+		// With kFlagCompressed, the size of the encoded data at VertexOffset.  Vertex and
+		// IndexByteSize are then the decoded sizes and IndexOffset is unused.
+		std::uint32_t EncodedByteSize;
+
+		std::uint32_t Reserved[3];
+	};
+
+	struct SubmeshRecord
+	{
+		std::uint32_t NameOffset;
+		std::uint32_t NameLength;
+		std::uint32_t IndexCount;
+		std::uint32_t StartIndexLocation;
+		std::int32_t BaseVertexLocation;
+		std::uint32_t IndexFormat;
+		std::uint32_t FirstCluster;
+		std::uint32_t ClusterCount;
+
+		// Record of the full detail submesh this is a level of detail of, or -1.
+		// Levels follow their full detail submesh, finest first.
+		std::int32_t Parent;
+		float LodError;
+
+		float BoundsCenter[3];
+		float BoundsExtents[3];
+		float SphereCenter[3];
+		float SphereRadius;
+		float DecodeScale[3];
+		float DecodeBias[3];
+
+		std::uint32_t Reserved[2];
+	};
+
+	struct ClusterRecord
+	{
+		std::uint32_t StartIndex;
+		std::uint32_t IndexCount;
+		float BoxCenter[3];
+		float BoxExtents[3];
+		float SphereCenter[3];
+		float SphereRadius;
+		float ConeAxis[3];
+		float ConeCutoff;
+	};
+
+	static_assert(sizeof(FileHeader) == 144, "FileHeader has unexpected padding.");
+	static_assert(sizeof(SubmeshRecord) == 112, "SubmeshRecord has unexpected padding.");
+	static_assert(sizeof(ClusterRecord) == 64, "ClusterRecord has unexpected padding.");
+
+	std::uint64_t AlignUp(std::uint64_t offset)
+	{
+		return (offset + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment;
+	}
+
+	void StoreFloat3(float* dst, const XMFLOAT3& v)
+	{
+		dst[0] = v.x; dst[1] = v.y; dst[2] = v.z;
+	}
+
+	XMFLOAT3 LoadFloat3(const float* src)
+	{
+		return XMFLOAT3(src[0], src[1], src[2]);
+	}
+
+	bool GetSourceStamp(const std::wstring& sourceFile, std::uint64_t& size, std::uint64_t& writeTime)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if(!GetFileAttributesExW(sourceFile.c_str(), GetFileExInfoStandard, &data))
+			return false;
+
+		size = ((std::uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+		writeTime = ((std::uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+		return true;
+	}
+
+	bool InRange(std::uint64_t offset, std::uint64_t byteSize, std::uint64_t fileSize)
+	{
+		return offset % kSectionAlignment == 0 && offset <= fileSize && byteSize <= fileSize - offset;
+	}
+
+	// Where the vertex and index data of a mapped cache are, and their decoded sizes.
+	struct CacheData
+	{
+		UINT VertexByteSize = 0;
+		UINT VertexByteStride = 0;
+		UINT IndexByteSize = 0;
+
+		// Packed data, if the cache is not compressed.
+		const char* Vertices = nullptr;
+		const char* Indices = nullptr;
+
+		// Encoded data, if it is.
+		const std::uint8_t* Encoded = nullptr;
+		size_t EncodedByteSize = 0;
+		std::vector<MeshCodec::IndexRange> Ranges;
+	};
+
+	// Copies or decodes the data into vertices and indices, which hold
+	// data.VertexByteSize and data.IndexByteSize bytes.
+	bool CopyData(const CacheData& data, void* vertices, void* indices)
+	{
+		if(data.Encoded == nullptr)
+		{
+			CopyMemory(vertices, data.Vertices, data.VertexByteSize);
+			CopyMemory(indices, data.Indices, data.IndexByteSize);
+			return true;
+		}
+
+		return MeshCodec::Decode(vertices, data.VertexByteSize / data.VertexByteStride, data.VertexByteStride,
+			indices, data.IndexByteSize, data.Ranges, data.Encoded, data.EncodedByteSize);
+	}
+
+	// Validates a mapped cache and creates its geometry without buffers.  cacheData is
+	// set to where its vertex and index data are in the mapping.
+	std::unique_ptr<MeshGeometry> ReadGeometry(const MappedFile& file, const std::wstring& sourceFile,
+		CacheData& cacheData)
+	{
+		if(file.GetSize() < sizeof(FileHeader))
+			return nullptr;
+
+		const char* data = file.GetData();
+		const std::uint64_t fileSize = file.GetSize();
+
+		FileHeader header;
+		memcpy(&header, data, sizeof(header));
+
+		if(memcmp(header.Magic, kMagic, sizeof(kMagic)) != 0 || header.Version != kVersion)
+			return nullptr;
+
+		// Pre-cooked assets are read without their sources.
+		if(!sourceFile.empty())
+		{
+			std::uint64_t sourceSize = 0;
+			std::uint64_t sourceWriteTime = 0;
+			if(!GetSourceStamp(sourceFile, sourceSize, sourceWriteTime) ||
+			   header.SourceSize != sourceSize || header.SourceWriteTime != sourceWriteTime)
+			{
+				return nullptr;
+			}
+		}
+
+		//
+		// Validate the sections before trusting any offset in them.
+		//
+
+		const bool compressed = (header.Flags & kFlagCompressed) != 0;
+
+		if(!InRange(header.SubmeshOffset, (std::uint64_t)header.SubmeshCount*sizeof(SubmeshRecord), fileSize) ||
+		   !InRange(header.ClusterOffset, (std::uint64_t)header.ClusterCount*sizeof(ClusterRecord), fileSize) ||
+		   !InRange(header.StringOffset, header.StringByteSize, fileSize) ||
+		   (std::uint64_t)header.NameOffset + header.NameLength > header.StringByteSize)
+		{
+			return nullptr;
+		}
+
+		if(compressed)
+		{
+			if(!InRange(header.VertexOffset, header.EncodedByteSize, fileSize) ||
+			   header.VertexByteStride == 0 || header.VertexByteSize % header.VertexByteStride != 0)
+			{
+				return nullptr;
+			}
+		}
+		else if(!InRange(header.VertexOffset, header.VertexByteSize, fileSize) ||
+			    !InRange(header.IndexOffset, header.IndexByteSize, fileSize))
+		{
+			return nullptr;
+		}
+
+		const SubmeshRecord* submeshes = reinterpret_cast<const SubmeshRecord*>(data + header.SubmeshOffset);
+		const ClusterRecord* clusters = reinterpret_cast<const ClusterRecord*>(data + header.ClusterOffset);
+		const char* strings = data + header.StringOffset;
+
+		for(std::uint32_t i = 0; i < header.SubmeshCount; ++i)
+		{
+			const SubmeshRecord& r = submeshes[i];
+			std::uint64_t indexSize = r.IndexFormat == DXGI_FORMAT_R32_UINT ? 4 : 2;
+
+			if((std::uint64_t)r.NameOffset + r.NameLength > header.StringByteSize ||
+			   ((std::uint64_t)r.StartIndexLocation + r.IndexCount)*indexSize > header.IndexByteSize ||
+			   (std::uint64_t)r.FirstCluster + r.ClusterCount > header.ClusterCount ||
+			   r.Parent >= (std::int32_t)i || (r.Parent >= 0 && submeshes[r.Parent].Parent >= 0))
+			{
+				return nullptr;
+			}
+		}
+
+		auto geo = std::make_unique<MeshGeometry>();
+		geo->Name.assign(strings + header.NameOffset, header.NameLength);
+
+		cacheData = CacheData();
+		cacheData.VertexByteSize = header.VertexByteSize;
+		cacheData.VertexByteStride = header.VertexByteStride;
+		cacheData.IndexByteSize = header.IndexByteSize;
+		if(compressed)
+		{
+			cacheData.Encoded = reinterpret_cast<const std::uint8_t*>(data + header.VertexOffset);
+			cacheData.EncodedByteSize = header.EncodedByteSize;
+		}
+		else
+		{
+			cacheData.Vertices = data + header.VertexOffset;
+			cacheData.Indices = data + header.IndexOffset;
+		}
+
+		geo->VertexByteStride = header.VertexByteStride;
+		geo->VertexBufferByteSize = header.VertexByteSize;
+		geo->IndexFormat = (DXGI_FORMAT)header.IndexFormat;
+		geo->IndexBufferByteSize = header.IndexByteSize;
+
+		std::vector<SubmeshGeometry*> records(header.SubmeshCount);
+		for(std::uint32_t i = 0; i < header.SubmeshCount; ++i)
+		{
+			const SubmeshRecord& r = submeshes[i];
+
+			SubmeshGeometry& submesh = geo->DrawArgs[std::string(strings + r.NameOffset, r.NameLength)];
+			submesh.IndexCount = r.IndexCount;
+			submesh.StartIndexLocation = r.StartIndexLocation;
+			submesh.BaseVertexLocation = r.BaseVertexLocation;
+			submesh.IndexFormat = (DXGI_FORMAT)r.IndexFormat;
+			submesh.Bounds = BoundingBox(LoadFloat3(r.BoundsCenter), LoadFloat3(r.BoundsExtents));
+			submesh.Sphere = BoundingSphere(LoadFloat3(r.SphereCenter), r.SphereRadius);
+			submesh.LodError = r.LodError;
+			submesh.Decode.Scale = LoadFloat3(r.DecodeScale);
+			submesh.Decode.Bias = LoadFloat3(r.DecodeBias);
+
+			submesh.Clusters.resize(r.ClusterCount);
+			for(std::uint32_t c = 0; c < r.ClusterCount; ++c)
+			{
+				const ClusterRecord& cr = clusters[r.FirstCluster + c];
+
+				MeshCluster& cluster = submesh.Clusters[c];
+				cluster.StartIndex = cr.StartIndex;
+				cluster.IndexCount = cr.IndexCount;
+				cluster.Bounds = BoundingBox(LoadFloat3(cr.BoxCenter), LoadFloat3(cr.BoxExtents));
+				cluster.Sphere = BoundingSphere(LoadFloat3(cr.SphereCenter), cr.SphereRadius);
+				cluster.ConeAxis = LoadFloat3(cr.ConeAxis);
+				cluster.ConeCutoff = cr.ConeCutoff;
+			}
+
+			records[i] = &submesh;
+			if(r.Parent >= 0)
+				records[r.Parent]->Lods.push_back(&submesh);
+		}
+
+		if(compressed)
+			cacheData.Ranges = MeshCache::GetIndexRanges(*geo);
+
+		return geo;
+	}
+}
+
+bool MeshCache::Save(const std::wstring& cacheFile, const std::wstring& sourceFile, const MeshGeometry& geo)
+{
+	return Save(cacheFile, sourceFile, geo, Encoding::Packed);
+}
+
+bool MeshCache::Save(const std::wstring& cacheFile, const std::wstring& sourceFile, const MeshGeometry& geo,
+	Encoding encoding)
+{
+	if(geo.VertexBufferCPU == nullptr || geo.IndexBufferCPU == nullptr)
+		return false;
+
+	FileHeader header = {};
+	memcpy(header.Magic, kMagic, sizeof(kMagic));
+	header.Version = kVersion;
+	if(!GetSourceStamp(sourceFile, header.SourceSize, header.SourceWriteTime))
+		return false;
+
+	//
+	// Order the submeshes: each full detail submesh, sorted by name, followed by its
+	// levels of detail.
+	//
+
+	std::unordered_set<const SubmeshGeometry*> lods;
+	for(auto& e : geo.DrawArgs)
+		lods.insert(e.second.Lods.begin(), e.second.Lods.end());
+
+	std::vector<const std::pair<const std::string, SubmeshGeometry>*> fullDetail;
+	for(auto& e : geo.DrawArgs)
+	{
+		if(lods.count(&e.second) == 0)
+			fullDetail.push_back(&e);
+	}
+
+	std::sort(fullDetail.begin(), fullDetail.end(),
+		[](const auto* a, const auto* b) { return a->first < b->first; });
+
+	std::unordered_map<const SubmeshGeometry*, const std::string*> names;
+	for(auto& e : geo.DrawArgs)
+		names[&e.second] = &e.first;
+
+	std::vector<SubmeshRecord> submeshes;
+	std::vector<ClusterRecord> clusters;
+	std::string strings = geo.Name;
+
+	header.NameOffset = 0;
+	header.NameLength = (std::uint32_t)geo.Name.size();
+
+	BoundingBox bounds;
+	bool firstBounds = true;
+
+	auto addSubmesh = [&](const std::string& name, const SubmeshGeometry& submesh, std::int32_t parent)
+	{
+		SubmeshRecord r = {};
+		r.NameOffset = (std::uint32_t)strings.size();
+		r.NameLength = (std::uint32_t)name.size();
+		r.IndexCount = submesh.IndexCount;
+		r.StartIndexLocation = submesh.StartIndexLocation;
+		r.BaseVertexLocation = submesh.BaseVertexLocation;
+		r.IndexFormat = (std::uint32_t)submesh.IndexFormat;
+		r.FirstCluster = (std::uint32_t)clusters.size();
+		r.ClusterCount = (std::uint32_t)submesh.Clusters.size();
+		r.Parent = parent;
+		r.LodError = submesh.LodError;
+		StoreFloat3(r.BoundsCenter, submesh.Bounds.Center);
+		StoreFloat3(r.BoundsExtents, submesh.Bounds.Extents);
+		StoreFloat3(r.SphereCenter, submesh.Sphere.Center);
+		r.SphereRadius = submesh.Sphere.Radius;
+		StoreFloat3(r.DecodeScale, submesh.Decode.Scale);
+		StoreFloat3(r.DecodeBias, submesh.Decode.Bias);
+
+		strings += name;
+
+		for(const MeshCluster& c : submesh.Clusters)
+		{
+			ClusterRecord cr = {};
+			cr.StartIndex = c.StartIndex;
+			cr.IndexCount = c.IndexCount;
+			StoreFloat3(cr.BoxCenter, c.Bounds.Center);
+			StoreFloat3(cr.BoxExtents, c.Bounds.Extents);
+			StoreFloat3(cr.SphereCenter, c.Sphere.Center);
+			cr.SphereRadius = c.Sphere.Radius;
+			StoreFloat3(cr.ConeAxis, c.ConeAxis);
+			cr.ConeCutoff = c.ConeCutoff;
+			clusters.push_back(cr);
+		}
+
+		submeshes.push_back(r);
+	};
+
+	for(auto* e : fullDetail)
+	{
+		const SubmeshGeometry& full = e->second;
+
+		std::int32_t parent = (std::int32_t)submeshes.size();
+		addSubmesh(e->first, full, -1);
+
+		for(const SubmeshGeometry* lod : full.Lods)
+			addSubmesh(*names[lod], *lod, parent);
+
+		if(firstBounds)
+			bounds = full.Bounds;
+		else
+			BoundingBox::CreateMerged(bounds, bounds, full.Bounds);
+
+		firstBounds = false;
+	}
+
+	StoreFloat3(header.BoundsCenter, bounds.Center);
+	StoreFloat3(header.BoundsExtents, bounds.Extents);
+
+	//
+	// Lay out the sections.
+	//
+
+	header.VertexByteStride = geo.VertexByteStride;
+	header.IndexFormat = (std::uint32_t)geo.IndexFormat;
+	header.SubmeshCount = (std::uint32_t)submeshes.size();
+	header.ClusterCount = (std::uint32_t)clusters.size();
+	header.StringByteSize = (std::uint32_t)strings.size();
+	header.VertexByteSize = geo.VertexBufferByteSize;
+	header.IndexByteSize = geo.IndexBufferByteSize;
+
+	// MeshCodec codes 16-bit lanes, so odd strides stay packed.
+	std::vector<std::uint8_t> encoded;
+	if(encoding == Encoding::Compressed && geo.VertexByteStride != 0 && geo.VertexByteStride % 2 == 0)
+	{
+		try
+		{
+			MeshCodec::Encode(geo.VertexBufferCPU->GetBufferPointer(), geo.VertexBufferByteSize / geo.VertexByteStride,
+				geo.VertexByteStride, geo.IndexBufferCPU->GetBufferPointer(), geo.IndexBufferByteSize,
+				GetIndexRanges(geo), encoded);
+		}
+		catch(const std::invalid_argument& e)
+		{
+			OutputDebugStringA(("MeshCache: storing " + geo.Name + " uncompressed: " + e.what() + "\n").c_str());
+			encoded.clear();
+		}
+
+		if(!encoded.empty())
+		{
+			header.Flags |= kFlagCompressed;
+			header.EncodedByteSize = (std::uint32_t)encoded.size();
+		}
+	}
+
+	header.SubmeshOffset = AlignUp(sizeof(FileHeader));
+	header.ClusterOffset = AlignUp(header.SubmeshOffset + submeshes.size()*sizeof(SubmeshRecord));
+	header.StringOffset = AlignUp(header.ClusterOffset + clusters.size()*sizeof(ClusterRecord));
+	header.VertexOffset = AlignUp(header.StringOffset + strings.size());
+	header.IndexOffset = (header.Flags & kFlagCompressed) ? 0 : AlignUp(header.VertexOffset + header.VertexByteSize);
+
+	//
+	// Write to a temporary file and move it over the old cache, so a crash never
+	// leaves a truncated cache behind.
+	//
+
+	std::wstring tempFile = cacheFile + L".tmp";
+	{
+		std::ofstream fout(tempFile, std::ios::binary | std::ios::trunc);
+		if(!fout)
+			return false;
+
+		const char padding[kSectionAlignment] = {};
+		auto writeSection = [&fout, &padding](std::uint64_t offset, const void* data, size_t byteSize)
+		{
+			std::uint64_t position = (std::uint64_t)fout.tellp();
+			fout.write(padding, (std::streamsize)(offset - position));
+			fout.write(static_cast<const char*>(data), (std::streamsize)byteSize);
+		};
+
+		fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		writeSection(header.SubmeshOffset, submeshes.data(), submeshes.size()*sizeof(SubmeshRecord));
+		writeSection(header.ClusterOffset, clusters.data(), clusters.size()*sizeof(ClusterRecord));
+		writeSection(header.StringOffset, strings.data(), strings.size());
+		if(header.Flags & kFlagCompressed)
+		{
+			writeSection(header.VertexOffset, encoded.data(), encoded.size());
+		}
+		else
+		{
+			writeSection(header.VertexOffset, geo.VertexBufferCPU->GetBufferPointer(), header.VertexByteSize);
+			writeSection(header.IndexOffset, geo.IndexBufferCPU->GetBufferPointer(), header.IndexByteSize);
+		}
+
+		if(!fout)
+		{
+			fout.close();
+			DeleteFileW(tempFile.c_str());
+			return false;
+		}
+	}
+
+	if(!MoveFileExW(tempFile.c_str(), cacheFile.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileW(tempFile.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+std::unique_ptr<MeshGeometry> MeshCache::Map(const std::wstring& cacheFile, const std::wstring& sourceFile,
+	CopyDataFn& copyData)
+{
+	auto file = std::make_shared<MappedFile>();
+	if(!file->Open(cacheFile))
+		return nullptr;
+
+	CacheData cacheData;
+	std::unique_ptr<MeshGeometry> geo = ReadGeometry(*file, sourceFile, cacheData);
+	if(geo == nullptr)
+		return nullptr;
+
+	// The function owns the mapping, so the data stays readable until it is dropped.
+	std::string name = geo->Name;
+	copyData = [file, cacheData = std::move(cacheData), name](void* vertices, void* indices)
+	{
+		if(!CopyData(cacheData, vertices, indices))
+			throw std::runtime_error(name + ": the compressed mesh data is malformed");
+	};
+
+	return geo;
+}
+
+std::unique_ptr<MeshGeometry> MeshCache::Read(const std::wstring& cacheFile, const std::wstring& sourceFile)
+{
+	CopyDataFn copyData;
+	std::unique_ptr<MeshGeometry> geo = Map(cacheFile, sourceFile, copyData);
+	if(geo == nullptr)
+		return nullptr;
+
+	// Compressed data is decoded straight into the CPU copies.
+	ThrowIfFailed(D3DCreateBlob(geo->VertexBufferByteSize, &geo->VertexBufferCPU));
+	ThrowIfFailed(D3DCreateBlob(geo->IndexBufferByteSize, &geo->IndexBufferCPU));
+
+	try
+	{
+		copyData(geo->VertexBufferCPU->GetBufferPointer(), geo->IndexBufferCPU->GetBufferPointer());
+	}
+	catch(const std::runtime_error&)
+	{
+		return nullptr;
+	}
+
+	return geo;
+}
+
+std::vector<MeshCodec::IndexRange> MeshCache::GetIndexRanges(const MeshGeometry& geo)
+{
+	std::vector<MeshCodec::IndexRange> ranges;
+	for(const auto& e : geo.DrawArgs)
+	{
+		const SubmeshGeometry& submesh = e.second;
+		if(submesh.IndexCount == 0 || submesh.IndexCount % 3 != 0)
+			continue;
+
+		MeshCodec::IndexRange range;
+		range.IndexByteSize = submesh.IndexFormat == DXGI_FORMAT_R32_UINT ? 4 : 2;
+		range.ByteOffset = (size_t)submesh.StartIndexLocation*range.IndexByteSize;
+		range.IndexCount = submesh.IndexCount;
+		range.BaseVertex = submesh.BaseVertexLocation;
+		ranges.push_back(range);
+	}
+
+	// DrawArgs is unordered and Read rebuilds it in another order than the geometry
+	// Save was given, so ranges at the same offset are ordered by every field, the
+	// longest first, and the same one is kept either way.
+	std::sort(ranges.begin(), ranges.end(), [](const MeshCodec::IndexRange& a, const MeshCodec::IndexRange& b)
+	{
+		return std::tie(a.ByteOffset, b.IndexCount, a.IndexByteSize, a.BaseVertex) <
+			std::tie(b.ByteOffset, a.IndexCount, b.IndexByteSize, b.BaseVertex);
+	});
+
+	size_t end = 0;
+	auto overlaps = [&end](const MeshCodec::IndexRange& r)
+	{
+		if(r.ByteOffset < end)
+			return true;
+
+		end = r.ByteOffset + r.IndexCount*r.IndexByteSize;
+		return false;
+	};
+
+	ranges.erase(std::remove_if(ranges.begin(), ranges.end(), overlaps), ranges.end());
+	return ranges;
+}
+
+std::uint32_t MeshCache::GetVersion()
+{
+	return kVersion;
+}
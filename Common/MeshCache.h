@@ -0,0 +1,78 @@
+//***************************************************************************************
+// MeshCache.h
+//
+// Versioned binary container for a processed MeshGeometry: header and bounds, submesh
+// table (with clusters, levels of detail and vertex decode), then the packed vertex
+// and index data, every section 16-byte aligned.  A cache file remembers the size and
+// write time of the source it was built from and is ignored once they change.
+//
+// The vertex and index data can instead be stored compressed by MeshCodec, which
+// trades a plain copy out of the mapping for a smaller file and a decode that outruns
+// the disk.  Either way they can be copied from the mapping to where the GPU reads
+// them without a copy in between.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "MeshCodec.h"
+#include <functional>
+
+class MeshCache
+{
+public:
+
+	enum class Encoding
+	{
+		// The vertex and index data as the GPU reads them.
+		Packed,
+
+		// Encoded by MeshCodec.  Geometry with an odd vertex stride or indices the codec
+		// cannot take is stored packed.
+		Compressed
+	};
+
+	///<summary>
+	/// Writes geo, which must still have its CPU copies, to cacheFile and stamps it with
+	/// the current size and write time of sourceFile.  The file is replaced atomically.
+	/// Returns false if it could not be written.
+	///</summary>
+	static bool Save(const std::wstring& cacheFile, const std::wstring& sourceFile, const MeshGeometry& geo,
+		Encoding encoding);
+	static bool Save(const std::wstring& cacheFile, const std::wstring& sourceFile, const MeshGeometry& geo);
+
+	// Copies or decodes the vertex and index data of a mapped cache to vertices and
+	// indices, which hold the geometry's VertexBufferByteSize and IndexBufferByteSize
+	// bytes.  Throws std::runtime_error if compressed data is malformed.  The file stays
+	// mapped while the function exists.
+	using CopyDataFn = std::function<void(void* vertices, void* indices)>;
+
+	///<summary>
+	/// Maps cacheFile and, if it is valid and was built from the current sourceFile,
+	/// returns its geometry without CPU copies; copyData is set to copy the vertex and
+	/// index data out of the mapping, for example straight into an upload heap with
+	/// GeometryRegistry::Register.  Returns nullptr if the cache is missing, stale, from
+	/// another version or malformed.  An empty sourceFile skips the staleness check, for
+	/// assets cooked offline and read without their sources.  Needs no device, so it
+	/// can run on a worker thread.
+	///</summary>
+	static std::unique_ptr<MeshGeometry> Map(const std::wstring& cacheFile, const std::wstring& sourceFile,
+		CopyDataFn& copyData);
+
+	///<summary>
+	/// Same as Map, but copies the vertex and index data into the CPU copies, decoding
+	/// it first if it is compressed, and closes the file.
+	///</summary>
+	static std::unique_ptr<MeshGeometry> Read(const std::wstring& cacheFile, const std::wstring& sourceFile);
+
+	///<summary>
+	/// The triangle lists of geo's submeshes that a compressed cache codes with
+	/// MeshCodec, sorted by offset.  Lists that overlap an earlier one, as a level of
+	/// detail sharing its parent's indices would, are left to the raw bytes.  The
+	/// result does not depend on the order of geo.DrawArgs.
+	///</summary>
+	static std::vector<MeshCodec::IndexRange> GetIndexRanges(const MeshGeometry& geo);
+
+	// Version of the file layout; files of any other version are not read.
+	static std::uint32_t GetVersion();
+};
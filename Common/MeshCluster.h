@@ -0,0 +1,32 @@
+//***************************************************************************************
+// MeshCluster.h
+//
+// A cluster of a submesh's triangles with its culling bounds.  Kept apart from
+// MeshOptimizer, which builds clusters, so d3dUtil.h can hold them in SubmeshGeometry
+// without pulling the mesh processing code into every file.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+// A contiguous run of triangles inside a submesh together with the bounds needed
+// to cull it on the CPU.  Built by MeshOptimizer::BuildClusters.
+struct MeshCluster
+{
+	// Index range relative to the first index of the owning submesh.
+	std::uint32_t StartIndex = 0;
+	std::uint32_t IndexCount = 0;
+
+	DirectX::BoundingBox Bounds;
+	DirectX::BoundingSphere Sphere;
+
+	// Normal cone of the cluster's triangles.  The whole cluster faces away from
+	// an eye at e when dot(c - e, ConeAxis) >= ConeCutoff*length(c - e) + r, where
+	// c and r are the bounding sphere center and radius.  ConeCutoff is 1 when the
+	// normals spread too far for the test to ever succeed.
+	DirectX::XMFLOAT3 ConeAxis = { 0.0f, 0.0f, 0.0f };
+	float ConeCutoff = 1.0f;
+};
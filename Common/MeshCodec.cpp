@@ -0,0 +1,501 @@
+//***************************************************************************************
+// MeshCodec.cpp
+//***************************************************************************************
+
+#include "MeshCodec.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+	using uint8 = std::uint8_t;
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+	using int64 = std::int64_t;
+
+	using IndexRange = MeshCodec::IndexRange;
+
+	const uint32 kNone = ~0u;
+
+	// Values per group of a lane; each group starts with a byte holding its bit width.
+	const size_t kGroupSize = 16;
+
+	// Recent triangles searched for an edge to predict across.  Vertex cache optimized
+	// meshes almost always find one among the last 16.
+	const size_t kTriangleFifoSize = 16;
+
+	// Longest varint of a coded index: 33 bits of zigzagged delta plus one.
+	const unsigned kMaxVarintShift = 28;
+
+	uint16 ZigZag(uint16 delta)
+	{
+		return (uint16)((delta << 1) ^ (uint16)((std::int16_t)delta >> 15));
+	}
+
+	uint16 UnZigZag(uint16 value)
+	{
+		return (uint16)((value >> 1) ^ (uint16)(0 - (value & 1)));
+	}
+
+	void WriteVarint(uint64 value, std::vector<uint8>& data)
+	{
+		while(value >= 0x80)
+		{
+			data.push_back((uint8)(value | 0x80));
+			value >>= 7;
+		}
+
+		data.push_back((uint8)value);
+	}
+
+	bool ReadVarint(const uint8*& data, const uint8* end, uint64& value)
+	{
+		value = 0;
+		for(unsigned shift = 0; data != end; shift += 7)
+		{
+			uint8 b = *data++;
+			value |= (uint64)(b & 0x7f) << shift;
+
+			if((b & 0x80) == 0)
+				return true;
+
+			if(shift == kMaxVarintShift)
+				return false;
+		}
+
+		return false;
+	}
+
+	bool RangesFit(const std::vector<IndexRange>& ranges, size_t indexByteSize)
+	{
+		size_t end = 0;
+		for(const IndexRange& r : ranges)
+		{
+			if((r.IndexByteSize != 2 && r.IndexByteSize != 4) || r.ByteOffset % r.IndexByteSize != 0 ||
+			   r.IndexCount % 3 != 0 || r.ByteOffset < end || r.ByteOffset > indexByteSize ||
+			   r.IndexCount > (indexByteSize - r.ByteOffset) / r.IndexByteSize)
+			{
+				return false;
+			}
+
+			end = r.ByteOffset + r.IndexCount*r.IndexByteSize;
+		}
+
+		return true;
+	}
+
+	uint32 GetIndex(const uint8* indices, const IndexRange& range, size_t i)
+	{
+		const uint8* p = indices + range.ByteOffset;
+		return range.IndexByteSize == 2 ? reinterpret_cast<const uint16*>(p)[i] : reinterpret_cast<const uint32*>(p)[i];
+	}
+
+	void EncodeIndices(const uint8* indices, const IndexRange& range, std::vector<uint8>& data)
+	{
+		uint64 next = 0;
+		int64 last = 0;
+
+		for(size_t i = 0; i < range.IndexCount; ++i)
+		{
+			int64 index = GetIndex(indices, range, i);
+
+			if((uint64)index == next)
+			{
+				data.push_back(0);
+			}
+			else
+			{
+				int64 delta = index - last;
+				WriteVarint((((uint64)delta << 1) ^ (uint64)(delta >> 63)) + 1, data);
+			}
+
+			last = index;
+			next = std::max(next, (uint64)index + 1);
+		}
+	}
+
+	template<typename IndexT>
+	bool DecodeIndices(IndexT* indices, size_t indexCount, const uint8*& data, const uint8* end)
+	{
+		const uint64 largest = (IndexT)~0u;
+
+		int64 next = 0;
+		int64 last = 0;
+
+		for(size_t i = 0; i < indexCount; ++i)
+		{
+			// Most indices fit in one byte.
+			uint64 code;
+			if(data != end && *data < 0x80)
+				code = *data++;
+			else if(!ReadVarint(data, end, code))
+				return false;
+
+			// New vertices and deltas are mixed about evenly, so both are computed and
+			// one selected rather than branching on the code.
+			uint64 zigzag = code - 1;
+			int64 delta = (int64)((zigzag >> 1) ^ (0 - (zigzag & 1)));
+			int64 index = code == 0 ? next : last + delta;
+
+			// Also rejects negative indices.
+			if((uint64)index > largest)
+				return false;
+
+			indices[i] = (IndexT)index;
+
+			last = index;
+			next = index < next ? next : index + 1;
+		}
+
+		return true;
+	}
+
+	void EncodeLane(const uint16* values, size_t count, std::vector<uint8>& data)
+	{
+		for(size_t first = 0; first < count; first += kGroupSize)
+		{
+			uint16 group[kGroupSize] = {};
+			std::copy(values + first, values + std::min(first + kGroupSize, count), group);
+
+			uint16 largest = *std::max_element(group, group + kGroupSize);
+
+			unsigned width = 0;
+			while(width < 16 && (largest >> width) != 0)
+				++width;
+
+			data.push_back((uint8)width);
+
+			// 16 values of width bits are exactly 2*width bytes.
+			uint32 buffer = 0;
+			unsigned bits = 0;
+			for(uint16 value : group)
+			{
+				buffer |= (uint32)value << bits;
+				for(bits += width; bits >= 8; bits -= 8)
+				{
+					data.push_back((uint8)buffer);
+					buffer >>= 8;
+				}
+			}
+		}
+	}
+
+	// values has room for count rounded up to whole groups.
+	bool DecodeLane(uint16* values, size_t count, const uint8*& data, const uint8* end)
+	{
+		for(size_t first = 0; first < count; first += kGroupSize)
+		{
+			if(data == end)
+				return false;
+
+			unsigned width = *data++;
+			if(width > 16 || (size_t)(end - data) < 2*width)
+				return false;
+
+			uint16* group = values + first;
+			if(width == 0)
+			{
+				std::fill(group, group + kGroupSize, (uint16)0);
+				continue;
+			}
+
+			uint32 mask = (1u << width) - 1;
+			uint32 buffer = 0;
+			unsigned bits = 0;
+			for(size_t i = 0; i < kGroupSize; ++i)
+			{
+				while(bits < width)
+				{
+					buffer |= (uint32)*data++ << bits;
+					bits += 8;
+				}
+
+				group[i] = (uint16)(buffer & mask);
+				buffer >>= width;
+				bits -= width;
+			}
+		}
+
+		return true;
+	}
+
+	// How a vertex is predicted from the vertices A, B and C passed with it.
+	enum class Prediction
+	{
+		None,			// The first vertex: 0.
+		Vertex,			// A.
+		Midpoint,		// (A + B)/2.
+		Parallelogram	// A + B - C.
+	};
+
+	///<summary>
+	/// Visits every vertex once, in the order the triangles of the ranges first reference
+	/// them followed by the vertices no triangle references, and calls
+	/// visit(vertex, prediction, a, b, c).  A new vertex of a triangle whose other two
+	/// vertices are known is predicted across the edge they form if one of the last
+	/// triangles shares it.  Returns false if a range references a vertex that does not
+	/// exist.
+	///</summary>
+	template<typename VisitFn>
+	bool WalkVertices(const uint8* indices, const std::vector<IndexRange>& ranges, size_t vertexCount,
+		VisitFn visit)
+	{
+		std::vector<uint8> visited(vertexCount, 0);
+		uint32 last = kNone;
+
+		// Directed edges of the recent triangles, as from << 32 | to, with the vertex
+		// opposite them; three per triangle, overwritten oldest first.  Unused entries
+		// match no edge.
+		uint64 edges[3*kTriangleFifoSize];
+		uint32 opposites[3*kTriangleFifoSize];
+		std::fill(std::begin(edges), std::end(edges), ~0ull);
+		size_t nextTriangle = 0;
+
+		auto edgeKey = [](uint32 from, uint32 to) { return (uint64)from << 32 | to; };
+
+		auto visitTriangle = [&](const uint32 t[3])
+		{
+			for(int k = 0; k < 3; ++k)
+			{
+				uint32 v = t[k];
+				if(visited[v])
+					continue;
+
+				uint32 a = t[k == 2 ? 0 : k + 1];
+				uint32 b = t[k == 0 ? 2 : k - 1];
+				bool hasA = visited[a] != 0;
+				bool hasB = visited[b] != 0;
+
+				if(hasA && hasB)
+				{
+					// A neighbour with the same winding has the edge running from b to a.
+					// It is usually one of the newest triangles, so search those first.
+					uint64 key = edgeKey(b, a);
+					uint32 c = kNone;
+					for(size_t n = 1; n <= kTriangleFifoSize; ++n)
+					{
+						size_t slot = 3*((nextTriangle - n) % kTriangleFifoSize);
+						const uint64* e = &edges[slot];
+						if(e[0] == key || e[1] == key || e[2] == key)
+						{
+							c = opposites[slot + (e[0] == key ? 0 : e[1] == key ? 1 : 2)];
+							break;
+						}
+					}
+
+					visit(v, c != kNone ? Prediction::Parallelogram : Prediction::Midpoint, a, b, c);
+				}
+				else if(hasA || hasB)
+				{
+					visit(v, Prediction::Vertex, hasA ? a : b, kNone, kNone);
+				}
+				else
+				{
+					visit(v, last == kNone ? Prediction::None : Prediction::Vertex, last, kNone, kNone);
+				}
+
+				visited[v] = 1;
+				last = v;
+			}
+
+			size_t slot = 3*(nextTriangle++ % kTriangleFifoSize);
+			for(int k = 0; k < 3; ++k)
+			{
+				edges[slot + k] = edgeKey(t[k], t[k == 2 ? 0 : k + 1]);
+				opposites[slot + k] = t[k == 0 ? 2 : k - 1];
+			}
+		};
+
+		for(const IndexRange& range : ranges)
+		{
+			for(size_t i = 0; i < range.IndexCount; i += 3)
+			{
+				uint32 t[3];
+				for(int k = 0; k < 3; ++k)
+				{
+					int64 vertex = range.BaseVertex + GetIndex(indices, range, i + k);
+					if(vertex < 0 || vertex >= (int64)vertexCount)
+						return false;
+
+					t[k] = (uint32)vertex;
+				}
+
+				visitTriangle(t);
+			}
+		}
+
+		for(size_t v = 0; v < vertexCount; ++v)
+		{
+			if(!visited[v])
+			{
+				visit((uint32)v, last == kNone ? Prediction::None : Prediction::Vertex, last, kNone, kNone);
+				last = (uint32)v;
+			}
+		}
+
+		return true;
+	}
+
+	///<summary>
+	/// Calls store(lane, predicted value) for every lane of a vertex.
+	///</summary>
+	template<typename StoreFn>
+	void PredictLanes(const uint16* vertices, size_t laneCount, Prediction prediction,
+		uint32 a, uint32 b, uint32 c, StoreFn store)
+	{
+		const uint16* va = vertices + (size_t)a*laneCount;
+		const uint16* vb = vertices + (size_t)b*laneCount;
+		const uint16* vc = vertices + (size_t)c*laneCount;
+
+		switch(prediction)
+		{
+		case Prediction::None:
+			for(size_t lane = 0; lane < laneCount; ++lane)
+				store(lane, (uint16)0);
+			break;
+		case Prediction::Vertex:
+			for(size_t lane = 0; lane < laneCount; ++lane)
+				store(lane, va[lane]);
+			break;
+		case Prediction::Midpoint:
+			for(size_t lane = 0; lane < laneCount; ++lane)
+				store(lane, (uint16)(((uint32)va[lane] + vb[lane]) >> 1));
+			break;
+		case Prediction::Parallelogram:
+			for(size_t lane = 0; lane < laneCount; ++lane)
+				store(lane, (uint16)(va[lane] + vb[lane] - vc[lane]));
+			break;
+		}
+	}
+
+	size_t RoundUpToGroup(size_t count)
+	{
+		return (count + kGroupSize - 1) / kGroupSize * kGroupSize;
+	}
+}
+
+void MeshCodec::Encode(const void* vertices, size_t vertexCount, size_t vertexByteStride,
+	const void* indices, size_t indexByteSize, const std::vector<IndexRange>& ranges,
+	std::vector<uint8>& data)
+{
+	if(vertexByteStride % 2 != 0)
+		throw std::invalid_argument("MeshCodec::Encode: vertex stride " + std::to_string(vertexByteStride) + " is odd");
+
+	if(!RangesFit(ranges, indexByteSize))
+		throw std::invalid_argument("MeshCodec::Encode: index ranges do not fit the index buffer");
+
+	//
+	// Indices, with the bytes between the ranges as they are.
+	//
+
+	const uint8* indexBytes = static_cast<const uint8*>(indices);
+	size_t copied = 0;
+	for(const IndexRange& range : ranges)
+	{
+		data.insert(data.end(), indexBytes + copied, indexBytes + range.ByteOffset);
+		EncodeIndices(indexBytes, range, data);
+		copied = range.ByteOffset + range.IndexCount*range.IndexByteSize;
+	}
+
+	data.insert(data.end(), indexBytes + copied, indexBytes + indexByteSize);
+
+	//
+	// Prediction errors of the vertices, lane by lane.
+	//
+
+	const uint16* lanes = static_cast<const uint16*>(vertices);
+	size_t laneCount = vertexByteStride / 2;
+	size_t paddedCount = RoundUpToGroup(vertexCount);
+
+	std::vector<uint16> errors(laneCount*paddedCount, 0);
+	size_t coded = 0;
+
+	bool valid = WalkVertices(indexBytes, ranges, vertexCount,
+		[&](uint32 v, Prediction prediction, uint32 a, uint32 b, uint32 c)
+	{
+		const uint16* vertex = lanes + (size_t)v*laneCount;
+		PredictLanes(lanes, laneCount, prediction, a, b, c, [&](size_t lane, uint16 predicted)
+		{
+			errors[lane*paddedCount + coded] = ZigZag((uint16)(vertex[lane] - predicted));
+		});
+
+		++coded;
+	});
+
+	if(!valid)
+		throw std::invalid_argument("MeshCodec::Encode: an index references a vertex out of range");
+
+	for(size_t lane = 0; lane < laneCount; ++lane)
+		EncodeLane(&errors[lane*paddedCount], vertexCount, data);
+}
+
+bool MeshCodec::Decode(void* vertices, size_t vertexCount, size_t vertexByteStride,
+	void* indices, size_t indexByteSize, const std::vector<IndexRange>& ranges,
+	const uint8* data, size_t dataByteSize)
+{
+	if(vertexByteStride % 2 != 0 || !RangesFit(ranges, indexByteSize))
+		return false;
+
+	const uint8* end = data + dataByteSize;
+
+	uint8* indexBytes = static_cast<uint8*>(indices);
+	size_t copied = 0;
+	auto copyRaw = [&](size_t until)
+	{
+		if((size_t)(end - data) < until - copied)
+			return false;
+
+		memcpy(indexBytes + copied, data, until - copied);
+		data += until - copied;
+		return true;
+	};
+
+	for(const IndexRange& range : ranges)
+	{
+		if(!copyRaw(range.ByteOffset))
+			return false;
+
+		uint8* rangeBytes = indexBytes + range.ByteOffset;
+		bool decoded = range.IndexByteSize == 2 ?
+			DecodeIndices(reinterpret_cast<uint16*>(rangeBytes), range.IndexCount, data, end) :
+			DecodeIndices(reinterpret_cast<uint32*>(rangeBytes), range.IndexCount, data, end);
+
+		if(!decoded)
+			return false;
+
+		copied = range.ByteOffset + range.IndexCount*range.IndexByteSize;
+	}
+
+	if(!copyRaw(indexByteSize))
+		return false;
+
+	uint16* lanes = static_cast<uint16*>(vertices);
+	size_t laneCount = vertexByteStride / 2;
+	size_t paddedCount = RoundUpToGroup(vertexCount);
+
+	std::vector<uint16> errors(laneCount*paddedCount);
+	for(size_t lane = 0; lane < laneCount; ++lane)
+	{
+		if(!DecodeLane(&errors[lane*paddedCount], vertexCount, data, end))
+			return false;
+	}
+
+	size_t decoded = 0;
+	bool valid = WalkVertices(indexBytes, ranges, vertexCount,
+		[&](uint32 v, Prediction prediction, uint32 a, uint32 b, uint32 c)
+	{
+		uint16* vertex = lanes + (size_t)v*laneCount;
+		PredictLanes(lanes, laneCount, prediction, a, b, c, [&](size_t lane, uint16 predicted)
+		{
+			vertex[lane] = (uint16)(predicted + UnZigZag(errors[lane*paddedCount + decoded]));
+		});
+
+		++decoded;
+	});
+
+	return valid && data == end;
+}
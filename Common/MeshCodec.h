@@ -0,0 +1,62 @@
+//***************************************************************************************
+// MeshCodec.h
+//
+// Lossless compression of a vertex buffer together with the index buffer that draws
+// from it, for storage on disk, in the spirit of meshoptimizer's codec.
+//
+// Every index is either the next vertex no triangle has referenced yet, coded as 0, or
+// the zigzagged difference from the previous index plus 1, as a little endian varint.
+//
+// Vertices are coded in the order the triangles first reference them, as 16-bit lanes.
+// Each is predicted from the triangle that introduces it: by the parallelogram across
+// the edge it shares with one of the last few triangles, else from the triangle's other
+// vertices, else from the previous vertex.  The zigzagged prediction errors of a lane
+// are stored in groups of 16 at the bit width the group needs.
+//
+// Decoding reads the data once, front to back, with no searches beyond the short
+// triangle FIFO, so it runs well ahead of the disk the compressed data comes from.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class MeshCodec
+{
+public:
+
+	using uint8 = std::uint8_t;
+
+	// A triangle list in the index buffer.
+	struct IndexRange
+	{
+		size_t ByteOffset = 0;
+		size_t IndexCount = 0;
+
+		// 2 or 4.
+		size_t IndexByteSize = 2;
+
+		// Added to the indices to get the vertex, as in DrawIndexedInstanced.
+		std::int64_t BaseVertex = 0;
+	};
+
+	///<summary>
+	/// Appends the encoding of a vertex buffer and its index buffer to data.  ranges are
+	/// the triangle lists of the index buffer, sorted by offset and not overlapping;
+	/// bytes outside them are stored as they are.  vertexByteStride must be even.
+	/// Throws std::invalid_argument if the ranges do not fit the buffers.
+	///</summary>
+	static void Encode(const void* vertices, size_t vertexCount, size_t vertexByteStride,
+		const void* indices, size_t indexByteSize, const std::vector<IndexRange>& ranges,
+		std::vector<uint8>& data);
+
+	///<summary>
+	/// Decodes buffers written by Encode with the same sizes and ranges.  Returns false if
+	/// the data is truncated or malformed.
+	///</summary>
+	static bool Decode(void* vertices, size_t vertexCount, size_t vertexByteStride,
+		void* indices, size_t indexByteSize, const std::vector<IndexRange>& ranges,
+		const uint8* data, size_t dataByteSize);
+};
@@ -0,0 +1,461 @@
+//***************************************************************************************
+// MeshNormals.cpp
+//***************************************************************************************
+
+#include "MeshNormals.h"
+#include "MeshOptimizer.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+using namespace DirectX;
+
+namespace
+{
+	using uint32 = std::uint32_t;
+
+	// Work smaller than this runs on the calling thread.
+	const size_t kMinRangeSize = 16 * 1024;
+
+	// Corners at one vertex whose normals differ by less than this share the vertex.
+	const float kNormalMatchTolerance = 1.0e-4f;
+
+	///<summary>
+	/// Calls body(first, last) for ranges that cover [0, count), in parallel on pool
+	/// when there is enough work for more than one range.
+	///</summary>
+	void ForEachRange(ThreadPool* pool, size_t count, const std::function<void(size_t, size_t)>& body)
+	{
+		size_t rangeCount = 1;
+		if(pool != nullptr && pool->GetWorkerCount() > 0)
+			rangeCount = std::min(count / kMinRangeSize + 1, (size_t)(pool->GetWorkerCount() + 1) * 4);
+
+		if(rangeCount <= 1)
+		{
+			body(0, count);
+			return;
+		}
+
+		pool->ParallelFor(rangeCount, [count, rangeCount, &body](size_t k)
+		{
+			body(count*k / rangeCount, count*(k + 1) / rangeCount);
+		});
+	}
+
+	// Attribute i of a strided vertex array.
+	template<typename T>
+	T* Element(T* first, size_t stride, size_t i)
+	{
+		return reinterpret_cast<T*>(const_cast<char*>(reinterpret_cast<const char*>(first)) + i*stride);
+	}
+
+	void ValidateIndices(const char* function, const uint32* indices, size_t indexCount, size_t vertexCount)
+	{
+		if(indexCount % 3 != 0)
+			throw std::invalid_argument(std::string(function) + ": the index count is not a multiple of 3");
+
+		for(size_t i = 0; i < indexCount; ++i)
+		{
+			if(indices[i] >= vertexCount)
+				throw std::invalid_argument(std::string(function) + ": index " + std::to_string(indices[i]) +
+					" is out of range");
+		}
+	}
+
+	// Angle of a triangle at corner k.
+	float CornerAngle(const XMVECTOR p[3], int k)
+	{
+		return XMVectorGetX(XMVector3AngleBetweenVectors(p[(k + 1) % 3] - p[k], p[(k + 2) % 3] - p[k]));
+	}
+
+	// The corners with key k are Corners[First[k]] to Corners[First[k + 1] - 1], in
+	// ascending order.
+	struct CornerLists
+	{
+		std::vector<uint32> First;
+		std::vector<uint32> Corners;
+	};
+
+	///<summary>
+	/// Counting sort of the corners by the key of the vertex they reference, which is
+	/// the vertex itself if keys is null.  Two passes of integer work, so it is left
+	/// to the calling thread.
+	///</summary>
+	CornerLists GroupCorners(const uint32* indices, size_t indexCount, const uint32* keys, size_t keyCount)
+	{
+		auto key = [indices, keys](size_t corner) { return keys != nullptr ? keys[indices[corner]] : indices[corner]; };
+
+		CornerLists lists;
+		lists.First.assign(keyCount + 1, 0);
+		for(size_t c = 0; c < indexCount; ++c)
+			++lists.First[key(c) + 1];
+
+		for(size_t k = 0; k < keyCount; ++k)
+			lists.First[k + 1] += lists.First[k];
+
+		std::vector<uint32> next(lists.First.begin(), lists.First.end() - 1);
+		lists.Corners.resize(indexCount);
+		for(size_t c = 0; c < indexCount; ++c)
+			lists.Corners[next[key(c)]++] = (uint32)c;
+
+		return lists;
+	}
+
+	///<summary>
+	/// Numbers the distinct positions and returns the number of every vertex's
+	/// position, so corners of vertices split for texture seams still average.
+	///</summary>
+	std::vector<uint32> GroupPositions(const XMFLOAT3* positions, size_t stride, size_t vertexCount,
+		uint32& positionCount)
+	{
+		struct Key
+		{
+			uint32 Bits[3];
+			uint32 Vertex;
+		};
+
+		std::vector<Key> keys(vertexCount);
+		for(size_t v = 0; v < vertexCount; ++v)
+		{
+			std::memcpy(keys[v].Bits, Element(positions, stride, v), sizeof(keys[v].Bits));
+			for(uint32& bits : keys[v].Bits)
+			{
+				// -0 and +0 are the same position.
+				if((bits & 0x7fffffff) == 0)
+					bits = 0;
+			}
+
+			keys[v].Vertex = (uint32)v;
+		}
+
+		std::sort(keys.begin(), keys.end(), [](const Key& a, const Key& b)
+		{
+			return std::memcmp(a.Bits, b.Bits, sizeof(a.Bits)) < 0;
+		});
+
+		std::vector<uint32> positionIds(vertexCount);
+		positionCount = 0;
+		for(size_t i = 0; i < vertexCount; ++i)
+		{
+			if(i > 0 && std::memcmp(keys[i].Bits, keys[i - 1].Bits, sizeof(keys[i].Bits)) != 0)
+				++positionCount;
+
+			positionIds[keys[i].Vertex] = positionCount;
+		}
+
+		if(vertexCount > 0)
+			++positionCount;
+
+		return positionIds;
+	}
+
+	XMVECTOR AnyPerpendicular(FXMVECTOR n)
+	{
+		XMVECTOR axis = fabsf(XMVectorGetX(n)) < 0.9f ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+		XMVECTOR t = XMVector3Cross(n, axis);
+
+		float lengthSq = XMVectorGetX(XMVector3LengthSq(t));
+		return lengthSq > 0.0f ? t / sqrtf(lengthSq) : XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+	}
+}
+
+void MeshNormals::ComputeNormals(const XMFLOAT3* positions, XMFLOAT3* normals,
+	size_t vertexStride, size_t vertexCount, uint32* indices, size_t indexCount,
+	std::vector<Split>& splits, ThreadPool* pool, const Options& options)
+{
+	splits.clear();
+	ValidateIndices("MeshNormals::ComputeNormals", indices, indexCount, vertexCount);
+
+	size_t triangleCount = indexCount / 3;
+
+	// Unit face normals and corner angles.  Degenerate triangles get a zero normal, so
+	// they add nothing to their vertices.
+	std::vector<XMFLOAT3> faceNormals(triangleCount);
+	std::vector<float> cornerAngles(indexCount);
+
+	ForEachRange(pool, triangleCount, [&](size_t first, size_t last)
+	{
+		for(size_t t = first; t < last; ++t)
+		{
+			XMVECTOR p[3];
+			for(int k = 0; k < 3; ++k)
+				p[k] = XMLoadFloat3(Element(positions, vertexStride, indices[3*t + k]));
+
+			XMVECTOR n = XMVector3Cross(p[1] - p[0], p[2] - p[0]);
+			float lengthSq = XMVectorGetX(XMVector3LengthSq(n));
+
+			XMStoreFloat3(&faceNormals[t], lengthSq > 0.0f ? n / sqrtf(lengthSq) : XMVectorZero());
+			for(int k = 0; k < 3; ++k)
+				cornerAngles[3*t + k] = lengthSq > 0.0f ? CornerAngle(p, k) : 0.0f;
+		}
+	});
+
+	uint32 positionCount = 0;
+	std::vector<uint32> positionIds = GroupPositions(positions, vertexStride, vertexCount, positionCount);
+	CornerLists corners = GroupCorners(indices, indexCount, positionIds.data(), positionCount);
+
+	const uint32* groups = options.SmoothingGroups;
+	float creaseCos = cosf(options.CreaseAngle);
+
+	auto smoothTogether = [&](uint32 a, uint32 b)
+	{
+		if(a == b)
+			return true;
+
+		if(groups != nullptr && (groups[a] & groups[b]) == 0)
+			return false;
+
+		// A degenerate face has no direction to form a crease with.
+		XMVECTOR na = XMLoadFloat3(&faceNormals[a]);
+		XMVECTOR nb = XMLoadFloat3(&faceNormals[b]);
+		if(XMVector3Equal(na, XMVectorZero()) || XMVector3Equal(nb, XMVectorZero()))
+			return true;
+
+		return XMVectorGetX(XMVector3Dot(na, nb)) >= creaseCos;
+	};
+
+	struct Scratch
+	{
+		std::vector<XMFLOAT3> Normals;
+		std::vector<uint32> Vertices;
+		std::vector<uint32> Leaders;
+		std::vector<bool> NeedsVertex;
+	};
+
+	// Without smoothing groups or creases every face at a position averages with every
+	// other, so all its corners get the same sum.
+	bool smoothAll = groups == nullptr && options.CreaseAngle >= XM_PI;
+
+	// Works out the normal of every corner at position p from the faces it smooths
+	// with.  Corner i then shares the vertex of corner Leaders[i], the first corner of
+	// the same vertex with a matching normal.  Leaders after the first of a vertex need
+	// a vertex of their own; returns how many.
+	auto resolvePosition = [&](uint32 p, Scratch& s)
+	{
+		uint32 first = corners.First[p];
+		uint32 count = corners.First[p + 1] - first;
+		const uint32* list = &corners.Corners[first];
+
+		s.Normals.resize(count);
+		s.Vertices.resize(count);
+		s.Leaders.resize(count);
+		s.NeedsVertex.assign(count, false);
+
+		for(uint32 i = 0; i < count; ++i)
+		{
+			s.Vertices[i] = indices[list[i]];
+
+			if(smoothAll && i > 0)
+			{
+				s.Normals[i] = s.Normals[0];
+				continue;
+			}
+
+			uint32 triangle = list[i] / 3;
+
+			XMVECTOR sum = XMVectorZero();
+			for(uint32 j = 0; j < count; ++j)
+			{
+				if(smoothAll || smoothTogether(triangle, list[j] / 3))
+					sum += cornerAngles[list[j]]*XMLoadFloat3(&faceNormals[list[j] / 3]);
+			}
+
+			// Only degenerate faces meet here; any direction is as good as another.
+			float lengthSq = XMVectorGetX(XMVector3LengthSq(sum));
+			XMStoreFloat3(&s.Normals[i], lengthSq > 0.0f ? sum / sqrtf(lengthSq) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		}
+
+		uint32 splitCount = 0;
+		for(uint32 i = 0; i < count; ++i)
+		{
+			bool vertexTaken = false;
+			s.Leaders[i] = i;
+
+			for(uint32 j = 0; j < i; ++j)
+			{
+				if(s.Leaders[j] != j || s.Vertices[j] != s.Vertices[i])
+					continue;
+
+				vertexTaken = true;
+				if(MeshOptimizer::NormalsMatch(s.Normals[i], s.Normals[j], kNormalMatchTolerance))
+				{
+					s.Leaders[i] = j;
+					break;
+				}
+			}
+
+			if(s.Leaders[i] == i && vertexTaken)
+			{
+				s.NeedsVertex[i] = true;
+				++splitCount;
+			}
+		}
+
+		return splitCount;
+	};
+
+	// First pass: store the normals of the existing vertices and count the vertices
+	// every position has to add, so each range knows where its new vertices go.
+	std::vector<uint32> firstSplit(positionCount + 1, 0);
+	ForEachRange(pool, positionCount, [&](size_t first, size_t last)
+	{
+		Scratch scratch;
+		for(size_t p = first; p < last; ++p)
+		{
+			firstSplit[p + 1] = resolvePosition((uint32)p, scratch);
+
+			for(uint32 i = 0; i < (uint32)scratch.Leaders.size(); ++i)
+			{
+				if(scratch.Leaders[i] == i && !scratch.NeedsVertex[i])
+					*Element(normals, vertexStride, scratch.Vertices[i]) = scratch.Normals[i];
+			}
+		}
+	});
+
+	for(uint32 p = 0; p < positionCount; ++p)
+		firstSplit[p + 1] += firstSplit[p];
+
+	splits.resize(firstSplit[positionCount]);
+	if(splits.empty())
+		return;
+
+	// Second pass: the positions with new vertices are resolved again, which gives the
+	// same result, and their corners redirected.  The indices are only written here.
+	ForEachRange(pool, positionCount, [&](size_t first, size_t last)
+	{
+		Scratch scratch;
+		for(size_t p = first; p < last; ++p)
+		{
+			if(firstSplit[p] == firstSplit[p + 1])
+				continue;
+
+			resolvePosition((uint32)p, scratch);
+
+			const uint32* list = &corners.Corners[corners.First[p]];
+			uint32 count = corners.First[p + 1] - corners.First[p];
+			uint32 nextSplit = firstSplit[p];
+
+			// Leaders come before the corners that follow them.
+			for(uint32 i = 0; i < count; ++i)
+			{
+				uint32 leader = scratch.Leaders[i];
+				if(leader != i)
+				{
+					scratch.Vertices[i] = scratch.Vertices[leader];
+				}
+				else if(scratch.NeedsVertex[i])
+				{
+					splits[nextSplit].Source = scratch.Vertices[i];
+					splits[nextSplit].Normal = scratch.Normals[i];
+					scratch.Vertices[i] = (uint32)vertexCount + nextSplit++;
+				}
+
+				indices[list[i]] = scratch.Vertices[i];
+			}
+		}
+	});
+}
+
+void MeshNormals::ComputeTangents(const XMFLOAT3* positions, const XMFLOAT3* normals,
+	const XMFLOAT2* texCoords, XMFLOAT3* tangents, size_t vertexStride,
+	size_t vertexCount, const uint32* indices, size_t indexCount, ThreadPool* pool)
+{
+	ValidateIndices("MeshNormals::ComputeTangents", indices, indexCount, vertexCount);
+
+	CornerLists corners = GroupCorners(indices, indexCount, nullptr, vertexCount);
+
+	// Each vertex sums the tangents of its own corners, recomputing the triangle's
+	// texture gradient instead of storing it per corner.
+	ForEachRange(pool, vertexCount, [&](size_t first, size_t last)
+	{
+		for(size_t v = first; v < last; ++v)
+		{
+			if(corners.First[v] == corners.First[v + 1])
+				continue;
+
+			XMVECTOR n = XMLoadFloat3(Element(normals, vertexStride, v));
+
+			// Tangents of right and left-handed corners are summed separately so mirrored
+			// sides do not cancel out.
+			XMVECTOR sums[2] = { XMVectorZero(), XMVectorZero() };
+			float weights[2] = { 0.0f, 0.0f };
+
+			for(uint32 i = corners.First[v]; i < corners.First[v + 1]; ++i)
+			{
+				uint32 corner = corners.Corners[i];
+				const uint32* triangle = &indices[corner - corner % 3];
+
+				XMVECTOR p[3];
+				XMFLOAT2 uv[3];
+				for(int k = 0; k < 3; ++k)
+				{
+					p[k] = XMLoadFloat3(Element(positions, vertexStride, triangle[k]));
+					uv[k] = *Element(texCoords, vertexStride, triangle[k]);
+				}
+
+				XMVECTOR e1 = p[1] - p[0];
+				XMVECTOR e2 = p[2] - p[0];
+				float du1 = uv[1].x - uv[0].x, dv1 = uv[1].y - uv[0].y;
+				float du2 = uv[2].x - uv[0].x, dv2 = uv[2].y - uv[0].y;
+
+				float det = du1*dv2 - du2*dv1;
+				if(det == 0.0f || XMVector3Equal(XMVector3Cross(e1, e2), XMVectorZero()))
+					continue;
+
+				XMVECTOR t = (e1*dv2 - e2*dv1) / det;
+				XMVECTOR b = (e2*du1 - e1*du2) / det;
+
+				// Keep the part in the plane of the vertex normal.
+				t -= n*XMVector3Dot(n, t);
+				float lengthSq = XMVectorGetX(XMVector3LengthSq(t));
+				if(lengthSq <= 0.0f)
+					continue;
+
+				t /= sqrtf(lengthSq);
+
+				int side = XMVectorGetX(XMVector3Dot(XMVector3Cross(n, t), b)) < 0.0f ? 1 : 0;
+				float weight = CornerAngle(p, corner % 3);
+
+				sums[side] += weight*t;
+				weights[side] += weight;
+			}
+
+			XMVECTOR t = weights[1] > weights[0] ? sums[1] : sums[0];
+			float lengthSq = XMVectorGetX(XMVector3LengthSq(t));
+
+			XMStoreFloat3(Element(tangents, vertexStride, v), lengthSq > 0.0f ? t / sqrtf(lengthSq) : AnyPerpendicular(n));
+		}
+	});
+}
+
+bool MeshNormals::NormalsAreValid(const XMFLOAT3* normals, size_t vertexStride, size_t vertexCount, float tolerance)
+{
+	for(size_t v = 0; v < vertexCount; ++v)
+	{
+		const XMFLOAT3& n = *Element(normals, vertexStride, v);
+
+		// Written so NaNs fail the test.
+		if(!(fabsf(n.x*n.x + n.y*n.y + n.z*n.z - 1.0f) <= tolerance))
+			return false;
+	}
+
+	return true;
+}
+
+void MeshNormals::GenerateNormalsAndTangents(GeometryGenerator::MeshData& meshData, ThreadPool* pool, const Options& options)
+{
+	using Vertex = GeometryGenerator::Vertex;
+
+	GenerateNormals(meshData.Vertices, meshData.Indices32, &Vertex::Position, &Vertex::Normal, pool, options);
+	GenerateTangents(meshData.Vertices, meshData.Indices32, &Vertex::Position, &Vertex::Normal,
+		&Vertex::TexC, &Vertex::TangentU, pool);
+}
+
+void MeshNormals::GenerateNormalsAndTangents(GeometryGenerator::MeshData& meshData, ThreadPool* pool)
+{
+	GenerateNormalsAndTangents(meshData, pool, Options());
+}
@@ -0,0 +1,134 @@
+//***************************************************************************************
+// MeshNormals.h
+//
+// Regenerates vertex normals and tangents of triangle lists, for imported meshes whose
+// normals are missing or broken and for models that come without the TangentU of
+// GeometryGenerator::Vertex.
+//
+// Normals are angle-weighted averages of the faces around a position.  Faces only
+// average across an edge when they share a smoothing group and meet at less than the
+// crease angle, so a vertex on a hard edge is split into one vertex per side.
+// Tangents follow MikkTSpace: per-corner tangents from the texture coordinates,
+// projected onto the normal plane and weighted by the corner angle.
+//
+// Every pass runs over ranges of triangles or vertices on an optional ThreadPool.  A
+// vertex gathers from the corners that reference it rather than having triangles
+// scatter into it, so ranges never write to the same vertex and nothing is atomic.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include "GeometryGenerator.h"
+
+class ThreadPool;
+
+class MeshNormals
+{
+public:
+
+	using uint32 = std::uint32_t;
+
+	struct Options
+	{
+		// Faces meeting at a larger angle (in radians) are not averaged, leaving a hard
+		// edge.  The default smooths every edge.
+		float CreaseAngle = DirectX::XM_PI;
+
+		// Optional smoothing group bitmask per triangle.  Faces are only averaged if
+		// their masks share a bit; a triangle with mask 0 is flat shaded.
+		const uint32* SmoothingGroups = nullptr;
+	};
+
+	// A vertex added by ComputeNormals: a copy of vertex Source with another normal.
+	struct Split
+	{
+		uint32 Source = 0;
+		DirectX::XMFLOAT3 Normal;
+	};
+
+	///<summary>
+	/// Computes the normals of the vertices referenced by indices.  positions and normals
+	/// point at the first vertex's attributes and vertexStride is the vertex size;
+	/// normals of unreferenced vertices are left alone.  Where a vertex needs more than
+	/// one normal, the indices of the other sides are redirected to new vertices
+	/// vertexCount, vertexCount + 1, ... described by splits.  Throws
+	/// std::invalid_argument if the indices are not a triangle list of those vertices.
+	///</summary>
+	static void ComputeNormals(const DirectX::XMFLOAT3* positions, DirectX::XMFLOAT3* normals,
+		size_t vertexStride, size_t vertexCount, uint32* indices, size_t indexCount,
+		std::vector<Split>& splits, ThreadPool* pool, const Options& options);
+
+	///<summary>
+	/// Computes the tangent of every referenced vertex from its normal and texture
+	/// coordinates.  Where the corners around a vertex disagree on the handedness of
+	/// their texture mapping, as on mirrored seams, the side with the most weight wins.
+	/// Vertices whose faces have no texture gradient get an arbitrary tangent
+	/// perpendicular to the normal.
+	///</summary>
+	static void ComputeTangents(const DirectX::XMFLOAT3* positions, const DirectX::XMFLOAT3* normals,
+		const DirectX::XMFLOAT2* texCoords, DirectX::XMFLOAT3* tangents, size_t vertexStride,
+		size_t vertexCount, const uint32* indices, size_t indexCount, ThreadPool* pool = nullptr);
+
+	///<summary>
+	/// Returns true if every normal is finite and of unit length within tolerance.
+	///</summary>
+	static bool NormalsAreValid(const DirectX::XMFLOAT3* normals, size_t vertexStride, size_t vertexCount,
+		float tolerance = 1.0e-2f);
+
+	///<summary>
+	/// Regenerates the normals of a vertex array, for example
+	/// GenerateNormals(vertices, indices, &Vertex::Pos, &Vertex::Normal).  Split vertices
+	/// are appended to vertices.
+	///</summary>
+	template<typename VertexT>
+	static void GenerateNormals(std::vector<VertexT>& vertices, std::vector<uint32>& indices,
+		DirectX::XMFLOAT3 VertexT::* position, DirectX::XMFLOAT3 VertexT::* normal,
+		ThreadPool* pool, const Options& options)
+	{
+		if(vertices.empty())
+			return;
+
+		std::vector<Split> splits;
+		ComputeNormals(&(vertices[0].*position), &(vertices[0].*normal), sizeof(VertexT),
+			vertices.size(), indices.data(), indices.size(), splits, pool, options);
+
+		vertices.reserve(vertices.size() + splits.size());
+		for(const Split& split : splits)
+		{
+			vertices.push_back(vertices[split.Source]);
+			vertices.back().*normal = split.Normal;
+		}
+	}
+
+	template<typename VertexT>
+	static void GenerateNormals(std::vector<VertexT>& vertices, std::vector<uint32>& indices,
+		DirectX::XMFLOAT3 VertexT::* position, DirectX::XMFLOAT3 VertexT::* normal, ThreadPool* pool = nullptr)
+	{
+		GenerateNormals(vertices, indices, position, normal, pool, Options());
+	}
+
+	template<typename VertexT>
+	static void GenerateTangents(std::vector<VertexT>& vertices, const std::vector<uint32>& indices,
+		DirectX::XMFLOAT3 VertexT::* position, DirectX::XMFLOAT3 VertexT::* normal,
+		DirectX::XMFLOAT2 VertexT::* texCoord, DirectX::XMFLOAT3 VertexT::* tangent,
+		ThreadPool* pool = nullptr)
+	{
+		if(vertices.empty())
+			return;
+
+		ComputeTangents(&(vertices[0].*position), &(vertices[0].*normal), &(vertices[0].*texCoord),
+			&(vertices[0].*tangent), sizeof(VertexT), vertices.size(), indices.data(), indices.size(), pool);
+	}
+
+	///<summary>
+	/// Regenerates the normals, then the tangents, of a generated or imported mesh.
+	/// Call this before GetIndices16.
+	///</summary>
+	static void GenerateNormalsAndTangents(GeometryGenerator::MeshData& meshData,
+		ThreadPool* pool, const Options& options);
+	static void GenerateNormalsAndTangents(GeometryGenerator::MeshData& meshData, ThreadPool* pool = nullptr);
+};
@@ -0,0 +1,890 @@
+//***************************************************************************************
+// MeshOptimizer.cpp
+//***************************************************************************************
+
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+	// Size of the cache modelled by the Forsyth scoring function.  It is larger than
+	// real hardware caches on purpose; the order it produces degrades gracefully.
+	const int kMaxCacheSize = 32;
+
+	const float kCacheDecayPower = 1.5f;
+	const float kLastTriScore = 0.75f;
+	const float kValenceBoostScale = 2.0f;
+	const float kValenceBoostPower = 0.5f;
+
+	// Garland-Heckbert error quadric: the sum of squared distances to a set of
+	// planes, weighted by triangle area.
+	struct Quadric
+	{
+		double A00 = 0, A01 = 0, A02 = 0, A11 = 0, A12 = 0, A22 = 0;
+		double B0 = 0, B1 = 0, B2 = 0;
+		double C = 0;
+		double Weight = 0;
+
+		void AddPlane(double a, double b, double c, double d, double w)
+		{
+			A00 += w*a*a; A01 += w*a*b; A02 += w*a*c;
+			A11 += w*b*b; A12 += w*b*c; A22 += w*c*c;
+			B0 += w*a*d; B1 += w*b*d; B2 += w*c*d;
+			C += w*d*d;
+			Weight += w;
+		}
+
+		void Add(const Quadric& q)
+		{
+			A00 += q.A00; A01 += q.A01; A02 += q.A02;
+			A11 += q.A11; A12 += q.A12; A22 += q.A22;
+			B0 += q.B0; B1 += q.B1; B2 += q.B2;
+			C += q.C;
+			Weight += q.Weight;
+		}
+
+		// Area weighted mean squared distance of p to the planes.
+		double Error(const XMFLOAT3& p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			double e = x*(A00*x + 2.0*(A01*y + A02*z + B0)) +
+				y*(A11*y + 2.0*(A12*z + B1)) +
+				z*(A22*z + 2.0*B2) + C;
+
+			return Weight > 0.0 ? std::max(e, 0.0) / Weight : 0.0;
+		}
+	};
+
+	float VertexScore(int cachePosition, MeshOptimizer::uint32 liveTriangles)
+	{
+		// No triangles left to draw means the vertex is of no further use.
+		if(liveTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if(cachePosition >= 0)
+		{
+			if(cachePosition < 3)
+			{
+				// The vertices of the last triangle get a fixed score so the
+				// ordering does not favour strips over fans.
+				score = kLastTriScore;
+			}
+			else
+			{
+				const float scaler = 1.0f / (kMaxCacheSize - 3);
+				score = powf(1.0f - (cachePosition - 3)*scaler, kCacheDecayPower);
+			}
+		}
+
+		// Boost vertices with few remaining triangles so lone triangles get
+		// cleaned up rather than left for the end.
+		score += kValenceBoostScale * powf((float)liveTriangles, -kValenceBoostPower);
+
+		return score;
+	}
+}
+
+size_t MeshOptimizer::WeldVertices(GeometryGenerator::MeshData& meshData, const WeldOptions& options)
+{
+	return WeldVertices(meshData.Vertices, meshData.Indices32, options.PositionTolerance,
+		[](const GeometryGenerator::Vertex& v) -> const XMFLOAT3& { return v.Position; },
+		[&options](const GeometryGenerator::Vertex& a, const GeometryGenerator::Vertex& b)
+		{
+			return NormalsMatch(a.Normal, b.Normal, options.NormalTolerance) &&
+				NormalsMatch(a.TangentU, b.TangentU, options.NormalTolerance) &&
+				fabsf(a.TexC.x - b.TexC.x) <= options.TexCoordTolerance &&
+				fabsf(a.TexC.y - b.TexC.y) <= options.TexCoordTolerance;
+		});
+}
+
+size_t MeshOptimizer::WeldVertices(GeometryGenerator::MeshData& meshData)
+{
+	return WeldVertices(meshData, WeldOptions());
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32* indices, size_t indexCount,
+	size_t vertexCount, uint32 cacheSize)
+{
+	VertexCacheStats stats;
+	if(indexCount == 0 || vertexCount == 0)
+		return stats;
+
+	// A vertex is resident while fewer than cacheSize misses happened since it was
+	// last brought into the cache, which is exactly a FIFO of that size.
+	std::vector<uint32> timestamps(vertexCount, 0);
+	std::vector<bool> referenced(vertexCount, false);
+	uint32 timestamp = cacheSize + 1;
+	uint32 misses = 0;
+	uint32 uniqueVertices = 0;
+
+	for(size_t i = 0; i < indexCount; ++i)
+	{
+		uint32 v = indices[i];
+
+		if(timestamp - timestamps[v] > cacheSize)
+		{
+			timestamps[v] = timestamp++;
+			++misses;
+		}
+
+		if(!referenced[v])
+		{
+			referenced[v] = true;
+			++uniqueVertices;
+		}
+	}
+
+	stats.ACMR = (float)misses / (indexCount/3);
+	stats.ATVR = (float)misses / uniqueVertices;
+
+	return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32* indices, size_t indexCount, size_t vertexCount)
+{
+	uint32 numTris = (uint32)(indexCount/3);
+	if(numTris == 0)
+		return;
+
+	//
+	// Build the vertex to triangle adjacency in one flat array.
+	//
+
+	std::vector<uint32> liveTriangles(vertexCount, 0);
+	for(size_t i = 0; i < indexCount; ++i)
+		++liveTriangles[indices[i]];
+
+	std::vector<uint32> adjacencyOffsets(vertexCount + 1, 0);
+	for(size_t v = 0; v < vertexCount; ++v)
+		adjacencyOffsets[v+1] = adjacencyOffsets[v] + liveTriangles[v];
+
+	std::vector<uint32> adjacency(indexCount);
+	{
+		std::vector<uint32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for(uint32 t = 0; t < numTris; ++t)
+		{
+			adjacency[fill[indices[t*3+0]]++] = t;
+			adjacency[fill[indices[t*3+1]]++] = t;
+			adjacency[fill[indices[t*3+2]]++] = t;
+		}
+	}
+
+	//
+	// Initial scores.
+	//
+
+	std::vector<float> vertexScores(vertexCount);
+	for(size_t v = 0; v < vertexCount; ++v)
+		vertexScores[v] = VertexScore(-1, liveTriangles[v]);
+
+	std::vector<bool> emitted(numTris, false);
+
+	uint32 bestTriangle = 0;
+	float bestScore = -1.0f;
+	for(uint32 t = 0; t < numTris; ++t)
+	{
+		float score = vertexScores[indices[t*3+0]] + vertexScores[indices[t*3+1]] + vertexScores[indices[t*3+2]];
+		if(score > bestScore)
+		{
+			bestScore = score;
+			bestTriangle = t;
+		}
+	}
+
+	std::vector<uint32> result(indexCount);
+
+	// The cache holds up to kMaxCacheSize vertices plus the three pushed in by the
+	// triangle being emitted.
+	uint32 cache[kMaxCacheSize + 3];
+	uint32 cacheCount = 0;
+
+	uint32 inputCursor = 0;
+
+	for(uint32 out = 0; out < numTris; ++out)
+	{
+		if(bestScore < 0.0f)
+		{
+			// Nothing in the cache touches a live triangle; fall back to the next
+			// triangle in input order.
+			while(emitted[inputCursor])
+				++inputCursor;
+
+			bestTriangle = inputCursor;
+		}
+
+		uint32 tri[3] = { indices[bestTriangle*3+0], indices[bestTriangle*3+1], indices[bestTriangle*3+2] };
+
+		result[out*3+0] = tri[0];
+		result[out*3+1] = tri[1];
+		result[out*3+2] = tri[2];
+		emitted[bestTriangle] = true;
+
+		// Remove the triangle from the adjacency of its vertices.
+		for(uint32 k = 0; k < 3; ++k)
+		{
+			uint32 v = tri[k];
+			uint32* begin = &adjacency[adjacencyOffsets[v]];
+			uint32* end = begin + liveTriangles[v];
+			uint32* it = std::find(begin, end, bestTriangle);
+			std::swap(*it, *(end - 1));
+			--liveTriangles[v];
+		}
+
+		// Push the triangle's vertices to the front of the cache.
+		uint32 newCache[kMaxCacheSize + 3];
+		uint32 newCacheCount = 0;
+
+		newCache[newCacheCount++] = tri[0];
+		newCache[newCacheCount++] = tri[1];
+		newCache[newCacheCount++] = tri[2];
+
+		for(uint32 i = 0; i < cacheCount; ++i)
+		{
+			uint32 v = cache[i];
+			if(v != tri[0] && v != tri[1] && v != tri[2])
+				newCache[newCacheCount++] = v;
+		}
+
+		// Vertices pushed past the end of the modelled cache lose their cache score.
+		for(uint32 i = kMaxCacheSize; i < newCacheCount; ++i)
+		{
+			uint32 v = newCache[i];
+			vertexScores[v] = VertexScore(-1, liveTriangles[v]);
+		}
+
+		cacheCount = std::min<uint32>(newCacheCount, kMaxCacheSize);
+		std::copy(newCache, newCache + cacheCount, cache);
+
+		for(uint32 i = 0; i < cacheCount; ++i)
+		{
+			uint32 v = cache[i];
+			vertexScores[v] = VertexScore((int)i, liveTriangles[v]);
+		}
+
+		// Rescore the live triangles touching the cache and pick the best of them.
+		bestScore = -1.0f;
+		for(uint32 i = 0; i < newCacheCount; ++i)
+		{
+			uint32 v = newCache[i];
+			const uint32* adj = &adjacency[adjacencyOffsets[v]];
+
+			for(uint32 j = 0; j < liveTriangles[v]; ++j)
+			{
+				uint32 t = adj[j];
+				float score = vertexScores[indices[t*3+0]] + vertexScores[indices[t*3+1]] + vertexScores[indices[t*3+2]];
+
+				if(score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = t;
+				}
+			}
+		}
+	}
+
+	std::copy(result.begin(), result.end(), indices);
+}
+
+void MeshOptimizer::OptimizeClusterVertexCache(uint32* indices, size_t vertexCount,
+	const std::vector<MeshCluster>& clusters)
+{
+	// Each cluster is optimized with its vertices renumbered from zero, so the work
+	// is proportional to the cluster and not to the whole mesh.
+	const uint32 unassigned = ~0u;
+	std::vector<uint32> localIndex(vertexCount, unassigned);
+	std::vector<uint32> globalIndex;
+	std::vector<uint32> local;
+	std::vector<uint32> original;
+
+	for(const MeshCluster& cluster : clusters)
+	{
+		uint32* clusterIndices = indices + cluster.StartIndex;
+
+		globalIndex.clear();
+		local.resize(cluster.IndexCount);
+		for(uint32 i = 0; i < cluster.IndexCount; ++i)
+		{
+			uint32& l = localIndex[clusterIndices[i]];
+			if(l == unassigned)
+			{
+				l = (uint32)globalIndex.size();
+				globalIndex.push_back(clusterIndices[i]);
+			}
+
+			local[i] = l;
+		}
+
+		original = local;
+		OptimizeVertexCache(local.data(), local.size(), globalIndex.size());
+
+		if(AnalyzeVertexCache(local.data(), local.size(), globalIndex.size()).ACMR <=
+		   AnalyzeVertexCache(original.data(), original.size(), globalIndex.size()).ACMR)
+		{
+			for(uint32 i = 0; i < cluster.IndexCount; ++i)
+				clusterIndices[i] = globalIndex[local[i]];
+		}
+
+		for(uint32 v : globalIndex)
+			localIndex[v] = unassigned;
+	}
+}
+
+std::vector<MeshOptimizer::uint32> MeshOptimizer::OptimizeVertexFetch(uint32* indices, size_t indexCount, size_t vertexCount)
+{
+	const uint32 unassigned = ~0u;
+
+	std::vector<uint32> remap(vertexCount, unassigned);
+	uint32 next = 0;
+
+	for(size_t i = 0; i < indexCount; ++i)
+	{
+		uint32& newIndex = remap[indices[i]];
+		if(newIndex == unassigned)
+			newIndex = next++;
+
+		indices[i] = newIndex;
+	}
+
+	for(size_t v = 0; v < vertexCount; ++v)
+	{
+		if(remap[v] == unassigned)
+			remap[v] = next++;
+	}
+
+	return remap;
+}
+
+std::vector<MeshCluster> MeshOptimizer::BuildClusters(const XMFLOAT3* positions, size_t positionStride,
+	size_t vertexCount, uint32* indices, size_t indexCount, uint32 maxVertices, uint32 maxTriangles)
+{
+	auto position = [positions, positionStride](uint32 v)
+	{
+		return XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const char*>(positions) + v*positionStride));
+	};
+
+	uint32 numTris = (uint32)(indexCount/3);
+
+	//
+	// Vertex to triangle adjacency, as in OptimizeVertexCache.
+	//
+
+	std::vector<uint32> adjacencyOffsets(vertexCount + 1, 0);
+	for(size_t i = 0; i < indexCount; ++i)
+		++adjacencyOffsets[indices[i] + 1];
+
+	for(size_t v = 0; v < vertexCount; ++v)
+		adjacencyOffsets[v+1] += adjacencyOffsets[v];
+
+	std::vector<uint32> adjacency(indexCount);
+	{
+		std::vector<uint32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for(uint32 t = 0; t < numTris; ++t)
+		{
+			adjacency[fill[indices[t*3+0]]++] = t;
+			adjacency[fill[indices[t*3+1]]++] = t;
+			adjacency[fill[indices[t*3+2]]++] = t;
+		}
+	}
+
+	//
+	// Grow each cluster from a seed triangle, always adding the neighbouring
+	// triangle that brings in the fewest new vertices.
+	//
+
+	std::vector<bool> emitted(numTris, false);
+	std::vector<uint32> vertexCluster(vertexCount, ~0u);
+	std::vector<uint32> result;
+	result.reserve(indexCount);
+
+	std::vector<MeshCluster> clusters;
+	std::vector<uint32> candidates;
+
+	uint32 seedCursor = 0;
+
+	while(result.size() < indexCount)
+	{
+		uint32 clusterId = (uint32)clusters.size();
+		uint32 clusterVertices = 0;
+		uint32 clusterTriangles = 0;
+
+		MeshCluster cluster;
+		cluster.StartIndex = (uint32)result.size();
+
+		while(emitted[seedCursor])
+			++seedCursor;
+
+		candidates.clear();
+		uint32 next = seedCursor;
+
+		while(true)
+		{
+			// Add the triangle and queue its neighbours.
+			emitted[next] = true;
+			++clusterTriangles;
+
+			for(uint32 k = 0; k < 3; ++k)
+			{
+				uint32 v = indices[next*3+k];
+				result.push_back(v);
+
+				if(vertexCluster[v] != clusterId)
+				{
+					vertexCluster[v] = clusterId;
+					++clusterVertices;
+
+					candidates.insert(candidates.end(),
+						adjacency.begin() + adjacencyOffsets[v], adjacency.begin() + adjacencyOffsets[v+1]);
+				}
+			}
+
+			if(clusterTriangles == maxTriangles)
+				break;
+
+			uint32 best = ~0u;
+			uint32 bestNew = 4;
+			size_t live = 0;
+
+			for(size_t i = 0; i < candidates.size(); ++i)
+			{
+				uint32 t = candidates[i];
+				if(emitted[t])
+					continue;
+
+				// Compact the candidate list while scanning it.
+				candidates[live++] = t;
+
+				uint32 newVertices = (vertexCluster[indices[t*3+0]] != clusterId) +
+					(vertexCluster[indices[t*3+1]] != clusterId) +
+					(vertexCluster[indices[t*3+2]] != clusterId);
+
+				if(newVertices < bestNew && clusterVertices + newVertices <= maxVertices)
+				{
+					best = t;
+					bestNew = newVertices;
+				}
+			}
+
+			candidates.resize(live);
+
+			if(best == ~0u)
+				break;
+
+			next = best;
+		}
+
+		cluster.IndexCount = (uint32)result.size() - cluster.StartIndex;
+
+		//
+		// Bounds and normal cone.
+		//
+
+		const uint32* clusterIndices = &result[cluster.StartIndex];
+
+		XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+		XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+		XMVECTOR normalSum = XMVectorZero();
+
+		for(uint32 i = 0; i < cluster.IndexCount; i += 3)
+		{
+			XMVECTOR p0 = position(clusterIndices[i+0]);
+			XMVECTOR p1 = position(clusterIndices[i+1]);
+			XMVECTOR p2 = position(clusterIndices[i+2]);
+
+			vMin = XMVectorMin(vMin, XMVectorMin(p0, XMVectorMin(p1, p2)));
+			vMax = XMVectorMax(vMax, XMVectorMax(p0, XMVectorMax(p1, p2)));
+
+			// Triangles are clockwise front facing, so the outward normal is (p1-p0)x(p2-p0).
+			normalSum += XMVector3Normalize(XMVector3Cross(p1 - p0, p2 - p0));
+		}
+
+		XMVECTOR center = 0.5f*(vMin + vMax);
+		XMStoreFloat3(&cluster.Bounds.Center, center);
+		XMStoreFloat3(&cluster.Bounds.Extents, 0.5f*(vMax - vMin));
+
+		float radiusSq = 0.0f;
+		for(uint32 i = 0; i < cluster.IndexCount; ++i)
+			radiusSq = std::max(radiusSq, XMVectorGetX(XMVector3LengthSq(position(clusterIndices[i]) - center)));
+
+		XMStoreFloat3(&cluster.Sphere.Center, center);
+		cluster.Sphere.Radius = sqrtf(radiusSq);
+
+		XMVECTOR axis = XMVector3Normalize(normalSum);
+		float minDot = 1.0f;
+		for(uint32 i = 0; i < cluster.IndexCount; i += 3)
+		{
+			XMVECTOR p0 = position(clusterIndices[i+0]);
+			XMVECTOR p1 = position(clusterIndices[i+1]);
+			XMVECTOR p2 = position(clusterIndices[i+2]);
+
+			XMVECTOR n = XMVector3Normalize(XMVector3Cross(p1 - p0, p2 - p0));
+			minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(n, axis)));
+		}
+
+		XMStoreFloat3(&cluster.ConeAxis, axis);
+
+		// Past ~84 degrees of spread the cone test can no longer succeed.
+		cluster.ConeCutoff = minDot <= 0.1f ? 1.0f : sqrtf(1.0f - minDot*minDot);
+
+		clusters.push_back(cluster);
+	}
+
+	std::copy(result.begin(), result.end(), indices);
+
+	return clusters;
+}
+
+void MeshOptimizer::ComputeBounds(const XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+	BoundingBox& box, BoundingSphere& sphere)
+{
+	box = BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+	sphere = BoundingSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), 0.0f);
+	if(vertexCount == 0)
+		return;
+
+	const char* first = reinterpret_cast<const char*>(positions);
+	auto position = [first, positionStride](size_t i)
+	{
+		return XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(first + i*positionStride));
+	};
+
+	// Four independent min/max chains so consecutive vertices do not wait on each
+	// other; they are merged at the end.
+	XMVECTOR vMin[4], vMax[4];
+	for(int k = 0; k < 4; ++k)
+	{
+		vMin[k] = XMVectorReplicate(+FLT_MAX);
+		vMax[k] = XMVectorReplicate(-FLT_MAX);
+	}
+
+	size_t i = 0;
+	for(; i + 4 <= vertexCount; i += 4)
+	{
+		for(int k = 0; k < 4; ++k)
+		{
+			XMVECTOR p = position(i + k);
+			vMin[k] = XMVectorMin(vMin[k], p);
+			vMax[k] = XMVectorMax(vMax[k], p);
+		}
+	}
+
+	for(; i < vertexCount; ++i)
+	{
+		XMVECTOR p = position(i);
+		vMin[0] = XMVectorMin(vMin[0], p);
+		vMax[0] = XMVectorMax(vMax[0], p);
+	}
+
+	XMVECTOR boxMin = XMVectorMin(XMVectorMin(vMin[0], vMin[1]), XMVectorMin(vMin[2], vMin[3]));
+	XMVECTOR boxMax = XMVectorMax(XMVectorMax(vMax[0], vMax[1]), XMVectorMax(vMax[2], vMax[3]));
+
+	XMVECTOR center = 0.5f*(boxMin + boxMax);
+	XMStoreFloat3(&box.Center, center);
+	XMStoreFloat3(&box.Extents, 0.5f*(boxMax - boxMin));
+
+	// The squared distances stay in vector registers; XMVector3LengthSq replicates
+	// the result, so any lane holds the maximum.
+	XMVECTOR radiusSq[4] = { XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorZero() };
+
+	for(i = 0; i + 4 <= vertexCount; i += 4)
+	{
+		for(int k = 0; k < 4; ++k)
+			radiusSq[k] = XMVectorMax(radiusSq[k], XMVector3LengthSq(position(i + k) - center));
+	}
+
+	for(; i < vertexCount; ++i)
+		radiusSq[0] = XMVectorMax(radiusSq[0], XMVector3LengthSq(position(i) - center));
+
+	XMVECTOR maxRadiusSq = XMVectorMax(XMVectorMax(radiusSq[0], radiusSq[1]), XMVectorMax(radiusSq[2], radiusSq[3]));
+
+	XMStoreFloat3(&sphere.Center, center);
+	sphere.Radius = XMVectorGetX(XMVectorSqrt(maxRadiusSq));
+}
+
+bool MeshOptimizer::IsClusterVisible(const MeshCluster& cluster, FXMVECTOR eyePos,
+	const XMVECTOR planes[6], bool testBackfacing)
+{
+	XMVECTOR center = XMLoadFloat3(&cluster.Sphere.Center);
+	float radius = cluster.Sphere.Radius;
+
+	for(int i = 0; i < 6; ++i)
+	{
+		if(XMVectorGetX(XMPlaneDotCoord(planes[i], center)) < -radius)
+			return false;
+	}
+
+	if(testBackfacing)
+	{
+		XMVECTOR toCenter = center - eyePos;
+		float d = XMVectorGetX(XMVector3Dot(toCenter, XMLoadFloat3(&cluster.ConeAxis)));
+		if(d >= cluster.ConeCutoff*XMVectorGetX(XMVector3Length(toCenter)) + radius)
+			return false;
+	}
+
+	return true;
+}
+
+std::vector<MeshOptimizer::uint32> MeshOptimizer::Simplify(const XMFLOAT3* positions, size_t positionStride,
+	size_t vertexCount, const uint32* indices, size_t indexCount, size_t targetIndexCount, float* resultError)
+{
+	auto position = [positions, positionStride](uint32 v) -> const XMFLOAT3&
+	{
+		return *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const char*>(positions) + v*positionStride);
+	};
+
+	//
+	// Vertices that share a position (texture or normal seams) form one group.
+	// Seams and open borders are locked so the outline of the mesh is kept.
+	//
+
+	std::vector<uint32> group(vertexCount);
+	std::vector<uint32> groupSize(vertexCount, 0);
+	{
+		std::unordered_map<uint64, uint32> firstByPosition;
+		firstByPosition.reserve(vertexCount);
+
+		for(uint32 v = 0; v < vertexCount; ++v)
+		{
+			const XMFLOAT3& p = position(v);
+
+			uint32 bits[3];
+			memcpy(bits, &p, sizeof(bits));
+			uint64 key = ((uint64)bits[0] * 73856093u) ^ ((uint64)bits[1] * 19349663u << 20) ^ ((uint64)bits[2] * 83492791u << 40);
+
+			// Fall back to a linear probe on the rare hash collision.
+			uint32 g = v;
+			for(auto it = firstByPosition.find(key); it != firstByPosition.end(); it = firstByPosition.find(++key))
+			{
+				const XMFLOAT3& q = position(it->second);
+				if(q.x == p.x && q.y == p.y && q.z == p.z)
+				{
+					g = it->second;
+					break;
+				}
+			}
+
+			if(g == v)
+				firstByPosition.emplace(key, v);
+
+			group[v] = g;
+			++groupSize[g];
+		}
+	}
+
+	std::vector<bool> locked(vertexCount, false);
+	{
+		std::unordered_map<uint64, uint32> directedEdges;
+		directedEdges.reserve(indexCount);
+
+		for(size_t i = 0; i < indexCount; ++i)
+		{
+			uint32 a = group[indices[i]];
+			uint32 b = group[indices[i - i%3 + (i+1)%3]];
+			++directedEdges[((uint64)a << 32) | b];
+		}
+
+		for(const auto& edge : directedEdges)
+		{
+			uint32 a = (uint32)(edge.first >> 32);
+			uint32 b = (uint32)edge.first;
+			if(directedEdges.find(((uint64)b << 32) | a) == directedEdges.end())
+				locked[a] = locked[b] = true;
+		}
+
+		for(uint32 v = 0; v < vertexCount; ++v)
+		{
+			if(groupSize[group[v]] > 1 || locked[group[v]])
+				locked[v] = true;
+		}
+	}
+
+	//
+	// Plane quadrics, accumulated per position group.
+	//
+
+	std::vector<Quadric> quadrics(vertexCount);
+	for(size_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		XMVECTOR p0 = XMLoadFloat3(&position(indices[i+0]));
+		XMVECTOR p1 = XMLoadFloat3(&position(indices[i+1]));
+		XMVECTOR p2 = XMLoadFloat3(&position(indices[i+2]));
+
+		XMVECTOR n = XMVector3Cross(p1 - p0, p2 - p0);
+		float area = 0.5f*XMVectorGetX(XMVector3Length(n));
+		if(area <= 0.0f)
+			continue;
+
+		XMFLOAT3 normal;
+		XMStoreFloat3(&normal, XMVector3Normalize(n));
+		float d = -XMVectorGetX(XMVector3Dot(XMLoadFloat3(&normal), p0));
+
+		for(size_t k = 0; k < 3; ++k)
+			quadrics[group[indices[i+k]]].AddPlane(normal.x, normal.y, normal.z, d, area);
+	}
+
+	//
+	// Collapse edges in passes.  Each pass sorts the candidate collapses by error
+	// and performs the cheapest ones whose neighbourhoods do not overlap.
+	//
+
+	struct Collapse
+	{
+		uint32 From;
+		uint32 To;
+		float Error;
+	};
+
+	std::vector<uint32> result(indices, indices + indexCount);
+	targetIndexCount -= targetIndexCount % 3;
+
+	std::vector<uint32> adjacencyOffsets;
+	std::vector<uint32> adjacency;
+	std::vector<Collapse> collapses;
+	std::vector<uint32> remap(vertexCount);
+	std::vector<bool> touched(vertexCount);
+
+	float maxError = 0.0f;
+
+	while(result.size() > targetIndexCount)
+	{
+		size_t triCount = result.size()/3;
+
+		adjacencyOffsets.assign(vertexCount + 1, 0);
+		for(uint32 v : result)
+			++adjacencyOffsets[v + 1];
+
+		for(size_t v = 0; v < vertexCount; ++v)
+			adjacencyOffsets[v+1] += adjacencyOffsets[v];
+
+		adjacency.resize(result.size());
+		{
+			std::vector<uint32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for(size_t t = 0; t < triCount; ++t)
+			{
+				adjacency[fill[result[t*3+0]]++] = (uint32)t;
+				adjacency[fill[result[t*3+1]]++] = (uint32)t;
+				adjacency[fill[result[t*3+2]]++] = (uint32)t;
+			}
+		}
+
+		// Interior edges show up once in each direction; keep one of them.
+		collapses.clear();
+		for(size_t i = 0; i < result.size(); ++i)
+		{
+			uint32 a = result[i];
+			uint32 b = result[i - i%3 + (i+1)%3];
+			if(a > b || (locked[a] && locked[b]))
+				continue;
+
+			Quadric q = quadrics[group[a]];
+			q.Add(quadrics[group[b]]);
+
+			float errorAB = locked[a] ? FLT_MAX : (float)q.Error(position(b));
+			float errorBA = locked[b] ? FLT_MAX : (float)q.Error(position(a));
+
+			if(errorAB <= errorBA)
+				collapses.push_back({ a, b, errorAB });
+			else
+				collapses.push_back({ b, a, errorBA });
+		}
+
+		std::sort(collapses.begin(), collapses.end(),
+			[](const Collapse& x, const Collapse& y) { return x.Error < y.Error; });
+
+		if(collapses.empty())
+			break;
+
+		// Neighbouring collapses block each other within a pass, so cap the error
+		// near that of the collapse that would reach the target.  Cheaper collapses
+		// that were blocked get another chance in the next pass.
+		size_t collapseGoal = std::max<size_t>((triCount - targetIndexCount/3)/2, 1);
+		float errorLimit = collapses[std::min(collapseGoal, collapses.size()) - 1].Error*1.5f;
+
+		for(uint32 v = 0; v < vertexCount; ++v)
+			remap[v] = v;
+
+		touched.assign(vertexCount, false);
+
+		size_t performed = 0;
+		for(const Collapse& c : collapses)
+		{
+			if(triCount*3 <= targetIndexCount || c.Error > errorLimit)
+				break;
+
+			if(touched[c.From] || touched[c.To])
+				continue;
+
+			// Reject the collapse if it flips a surviving triangle around From.
+			const XMFLOAT3& target = position(c.To);
+			bool flips = false;
+			size_t removed = 0;
+
+			for(uint32 j = adjacencyOffsets[c.From]; j < adjacencyOffsets[c.From+1] && !flips; ++j)
+			{
+				const uint32* tri = &result[adjacency[j]*3];
+				if(tri[0] == c.To || tri[1] == c.To || tri[2] == c.To)
+				{
+					++removed;
+					continue;
+				}
+
+				XMVECTOR p[3];
+				XMVECTOR q[3];
+				for(int k = 0; k < 3; ++k)
+				{
+					p[k] = XMLoadFloat3(&position(tri[k]));
+					q[k] = tri[k] == c.From ? XMLoadFloat3(&target) : p[k];
+				}
+
+				XMVECTOR n0 = XMVector3Cross(p[1] - p[0], p[2] - p[0]);
+				XMVECTOR n1 = XMVector3Cross(q[1] - q[0], q[2] - q[0]);
+				flips = XMVectorGetX(XMVector3Dot(n0, n1)) <= 0.0f;
+			}
+
+			if(flips)
+				continue;
+
+			remap[c.From] = c.To;
+			quadrics[group[c.To]].Add(quadrics[group[c.From]]);
+			maxError = std::max(maxError, c.Error);
+			triCount -= removed;
+			++performed;
+
+			for(uint32 j = adjacencyOffsets[c.From]; j < adjacencyOffsets[c.From+1]; ++j)
+			{
+				const uint32* tri = &result[adjacency[j]*3];
+				touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+			}
+		}
+
+		if(performed == 0)
+			break;
+
+		// Apply the collapses and drop the triangles that became degenerate.
+		size_t write = 0;
+		for(size_t i = 0; i < result.size(); i += 3)
+		{
+			uint32 a = remap[result[i+0]];
+			uint32 b = remap[result[i+1]];
+			uint32 c = remap[result[i+2]];
+			if(a == b || b == c || c == a)
+				continue;
+
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+
+		result.resize(write);
+	}
+
+	if(resultError != nullptr)
+		*resultError = sqrtf(maxError);
+
+	return result;
+}
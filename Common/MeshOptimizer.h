@@ -0,0 +1,296 @@
+//***************************************************************************************
+// MeshOptimizer.h
+//
+// Welds duplicate vertices and reorders triangle lists so the GPU's post-transform
+// vertex cache and vertex fetch are used efficiently.  Works on any vertex type stored
+// in a std::vector together with a 32-bit triangle list index buffer.
+//***************************************************************************************
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include "GeometryGenerator.h"
+#include "MeshCluster.h"
+
+class MeshOptimizer
+{
+public:
+
+    using uint32 = std::uint32_t;
+    using uint64 = std::uint64_t;
+
+	struct WeldOptions
+	{
+		// Largest per-component position difference of two vertices that get merged.
+		float PositionTolerance = 1.0e-5f;
+
+		// Largest per-component normal and tangent difference of two vertices that get
+		// merged.  Vertices on either side of a hard edge stay separate.
+		float NormalTolerance = 1.0e-3f;
+
+		// Largest per-component texture coordinate difference of two vertices that get
+		// merged.  Vertices on either side of a texture seam stay separate.
+		float TexCoordTolerance = 1.0e-5f;
+	};
+
+	struct VertexCacheStats
+	{
+		// Average cache miss ratio: transformed vertices per triangle (0.5 is ideal
+		// for large closed meshes, 3.0 is the worst case).
+		float ACMR = 0.0f;
+
+		// Average transform to vertex ratio: transformed vertices per referenced
+		// vertex (1.0 is ideal).
+		float ATVR = 0.0f;
+	};
+
+	struct OptimizeStats
+	{
+		VertexCacheStats Before;
+		VertexCacheStats After;
+	};
+
+	///<summary>
+	/// Merges vertices whose positions are within positionTolerance of each other and
+	/// for which attributesMatch(a, b) returns true, then remaps the indices.  Vertices
+	/// are hashed into a grid so each one is only compared with its neighbours.  A
+	/// tolerance of zero, or less, merges only vertices at exactly the same position,
+	/// hashed by value.  Returns the new vertex count.
+	///</summary>
+	template<typename VertexT, typename PositionFn, typename MatchFn>
+	static size_t WeldVertices(std::vector<VertexT>& vertices, std::vector<uint32>& indices,
+		float positionTolerance, PositionFn getPosition, MatchFn attributesMatch)
+	{
+		const uint32 none = ~0u;
+
+		const bool exact = !(positionTolerance > 0.0f);
+		const float tolerance = exact ? 0.0f : positionTolerance;
+
+		// Cells are at least twice the tolerance wide, so every vertex within tolerance
+		// of p lies in one of the (at most) 2x2x2 cells overlapping [p - tol, p + tol].
+		// A tolerance too small for its reciprocal puts every vertex in a boundary cell.
+		const float invCellSize = exact ? 0.0f : 1.0f / (2.0f*tolerance);
+
+		auto cellKey = [](int x, int y, int z)
+		{
+			return ((uint64)(x & 0x1fffff) << 42) | ((uint64)(y & 0x1fffff) << 21) | (uint64)(z & 0x1fffff);
+		};
+
+		// Welded vertices of a cell form a linked list through cellNext.
+		std::unordered_map<uint64, uint32> cellHeads;
+		cellHeads.reserve(vertices.size());
+		std::vector<uint32> cellNext;
+		cellNext.reserve(vertices.size());
+
+		auto findInCell = [&](uint64 key, const DirectX::XMFLOAT3& p, const VertexT& v)
+		{
+			auto it = cellHeads.find(key);
+			if(it == cellHeads.end())
+				return none;
+
+			for(uint32 w = it->second; w != none; w = cellNext[w])
+			{
+				const DirectX::XMFLOAT3& q = getPosition(vertices[w]);
+				bool samePosition = exact ? (p.x == q.x && p.y == q.y && p.z == q.z) :
+					(fabsf(p.x - q.x) <= tolerance && fabsf(p.y - q.y) <= tolerance && fabsf(p.z - q.z) <= tolerance);
+
+				if(samePosition && attributesMatch(v, vertices[w]))
+					return w;
+			}
+
+			return none;
+		};
+
+		std::vector<uint32> remap(vertices.size());
+		size_t weldedCount = 0;
+
+		for(size_t i = 0; i < vertices.size(); ++i)
+		{
+			const DirectX::XMFLOAT3& p = getPosition(vertices[i]);
+
+			uint32 match = none;
+			if(exact)
+			{
+				match = findInCell(ExactPositionKey(p), p, vertices[i]);
+			}
+			else
+			{
+				int lo[3] = { CellCoordinate((p.x - tolerance)*invCellSize), CellCoordinate((p.y - tolerance)*invCellSize), CellCoordinate((p.z - tolerance)*invCellSize) };
+				int hi[3] = { CellCoordinate((p.x + tolerance)*invCellSize), CellCoordinate((p.y + tolerance)*invCellSize), CellCoordinate((p.z + tolerance)*invCellSize) };
+
+				for(int x = lo[0]; x <= hi[0] && match == none; ++x)
+				for(int y = lo[1]; y <= hi[1] && match == none; ++y)
+				for(int z = lo[2]; z <= hi[2] && match == none; ++z)
+					match = findInCell(cellKey(x, y, z), p, vertices[i]);
+			}
+
+			if(match == none)
+			{
+				// Keep the vertex; compaction in place is safe since weldedCount <= i.
+				match = (uint32)weldedCount++;
+				vertices[match] = vertices[i];
+
+				uint64 key = exact ? ExactPositionKey(p) :
+					cellKey(CellCoordinate(p.x*invCellSize), CellCoordinate(p.y*invCellSize), CellCoordinate(p.z*invCellSize));
+				auto result = cellHeads.emplace(key, match);
+				cellNext.push_back(result.second ? none : result.first->second);
+				result.first->second = match;
+			}
+
+			remap[i] = match;
+		}
+
+		vertices.resize(weldedCount);
+
+		for(auto& index : indices)
+			index = remap[index];
+
+		return weldedCount;
+	}
+
+	///<summary>
+	/// Returns floor(v) as a weld grid coordinate.  It is clamped to +/-2^20, so the
+	/// conversion is defined for huge and non-finite values; far away vertices share
+	/// the boundary cells, which only costs extra comparisons.
+	///</summary>
+	static int CellCoordinate(float v)
+	{
+		const float limit = (float)(1 << 20);
+		float c = floorf(v);
+		return (int)(c < limit ? (c > -limit ? c : -limit) : limit);
+	}
+
+	///<summary>
+	/// Hashes the bit patterns of a position for exact welding.  Adding +0 turns -0
+	/// into +0 first, so positions that compare equal get the same key.
+	///</summary>
+	static uint64 ExactPositionKey(const DirectX::XMFLOAT3& p)
+	{
+		const float c[3] = { p.x + 0.0f, p.y + 0.0f, p.z + 0.0f };
+		uint32 bits[3];
+		std::memcpy(bits, c, sizeof(bits));
+
+		return ((uint64)bits[0]*0x9e3779b97f4a7c15ull) ^ ((uint64)bits[1]*0xc2b2ae3d27d4eb4full) ^ (uint64)bits[2];
+	}
+
+	///<summary>
+	/// Returns true if every component of the two normals is within tolerance.
+	///</summary>
+	static bool NormalsMatch(const DirectX::XMFLOAT3& n0, const DirectX::XMFLOAT3& n1, float tolerance)
+	{
+		return fabsf(n0.x - n1.x) <= tolerance && fabsf(n0.y - n1.y) <= tolerance && fabsf(n0.z - n1.z) <= tolerance;
+	}
+
+	///<summary>
+	/// Welds a generated mesh.  Vertices must also agree on their tangents and texture
+	/// coordinates so texture seams are kept.  Call this before GetIndices16.
+	///</summary>
+	static size_t WeldVertices(GeometryGenerator::MeshData& meshData, const WeldOptions& options);
+	static size_t WeldVertices(GeometryGenerator::MeshData& meshData);
+
+	///<summary>
+	/// Splits a triangle list into clusters of at most maxVertices unique vertices and
+	/// maxTriangles triangles and computes their bounds and normal cones.  Clusters are
+	/// grown across shared vertices, and the triangles are reordered in place so each
+	/// cluster is a contiguous index range.  positions points at the first vertex
+	/// position and positionStride is the vertex size.
+	///</summary>
+	static std::vector<MeshCluster> BuildClusters(const DirectX::XMFLOAT3* positions, size_t positionStride,
+		size_t vertexCount, uint32* indices, size_t indexCount,
+		uint32 maxVertices = 64, uint32 maxTriangles = 124);
+
+	///<summary>
+	/// Runs the vertex cache pass on the index range of each cluster on its own, so the
+	/// triangles stay in their clusters.  A cluster keeps its order if the pass makes
+	/// it worse.
+	///</summary>
+	static void OptimizeClusterVertexCache(uint32* indices, size_t vertexCount,
+		const std::vector<MeshCluster>& clusters);
+
+	///<summary>
+	/// Computes the axis-aligned box of vertexCount positions and the sphere around the
+	/// box center that just encloses them.  positionStride is the vertex size.
+	///</summary>
+	static void ComputeBounds(const DirectX::XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+		DirectX::BoundingBox& box, DirectX::BoundingSphere& sphere);
+
+	///<summary>
+	/// Returns false if the cluster is entirely outside one of the six planes or
+	/// faces away from the eye.  The eye and planes must be in the cluster's space.
+	///</summary>
+	static bool IsClusterVisible(const MeshCluster& cluster, DirectX::FXMVECTOR eyePos,
+		const DirectX::XMVECTOR planes[6], bool testBackfacing = true);
+
+	///<summary>
+	/// Quadric error edge-collapse simplification.  Returns a new index list of at
+	/// most targetIndexCount indices (if reachable) that references the same vertices,
+	/// so a level of detail can share the vertex buffer of the full mesh.  Vertices on
+	/// open borders and seams are kept in place.  resultError receives the geometric
+	/// error of the result in the units of the positions.
+	///</summary>
+	static std::vector<uint32> Simplify(const DirectX::XMFLOAT3* positions, size_t positionStride,
+		size_t vertexCount, const uint32* indices, size_t indexCount, size_t targetIndexCount,
+		float* resultError = nullptr);
+
+	///<summary>
+	/// Simulates a FIFO post-transform cache of the given size and reports
+	/// how many vertices it would transform.
+	///</summary>
+	static VertexCacheStats AnalyzeVertexCache(const uint32* indices, size_t indexCount,
+		size_t vertexCount, uint32 cacheSize = 16);
+
+	///<summary>
+	/// Reorders the triangles in place for vertex cache locality using Tom Forsyth's
+	/// linear-speed vertex cache optimisation.
+	///</summary>
+	static void OptimizeVertexCache(uint32* indices, size_t indexCount, size_t vertexCount);
+
+	///<summary>
+	/// Renumbers the vertices in the order the index buffer first references them
+	/// and rewrites the indices in place.  Returns the old-to-new remap table to
+	/// apply to the vertex array with RemapVertices.  Unreferenced vertices are
+	/// moved to the end.
+	///</summary>
+	static std::vector<uint32> OptimizeVertexFetch(uint32* indices, size_t indexCount, size_t vertexCount);
+
+	template<typename VertexT>
+	static void RemapVertices(std::vector<VertexT>& vertices, const std::vector<uint32>& remap)
+	{
+		std::vector<VertexT> result(vertices.size());
+		for(size_t i = 0; i < vertices.size(); ++i)
+			result[remap[i]] = vertices[i];
+
+		vertices.swap(result);
+	}
+
+	///<summary>
+	/// Optimizes a mesh that is culled by cluster: splits it with BuildClusters first,
+	/// then reorders the triangles within each cluster for the vertex cache and
+	/// the vertices for fetch.  Neither pass moves a triangle out of its cluster or a
+	/// vertex position, so the clusters' ranges and bounds stay valid.  position selects
+	/// the vertex position.
+	///</summary>
+	template<typename VertexT>
+	static OptimizeStats OptimizeClustered(std::vector<VertexT>& vertices, std::vector<uint32>& indices,
+		DirectX::XMFLOAT3 VertexT::* position, std::vector<MeshCluster>& clusters)
+	{
+		OptimizeStats stats;
+		stats.Before = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+
+		clusters = BuildClusters(&(vertices[0].*position), sizeof(VertexT), vertices.size(),
+			indices.data(), indices.size());
+
+		OptimizeClusterVertexCache(indices.data(), vertices.size(), clusters);
+		RemapVertices(vertices, OptimizeVertexFetch(indices.data(), indices.size(), vertices.size()));
+
+		stats.After = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+		return stats;
+	}
+};
@@ -0,0 +1,146 @@
+//***************************************************************************************
+// MeshQuantizer.cpp
+//***************************************************************************************
+
+#include "MeshQuantizer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	const XMFLOAT3& AttributeAt(const XMFLOAT3* first, size_t stride, size_t i)
+	{
+		return *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const char*>(first) + i*stride);
+	}
+
+	std::uint16_t QuantizeUnorm16(float v)
+	{
+		v = std::min(std::max(v, 0.0f), 1.0f);
+		return (std::uint16_t)(v*65535.0f + 0.5f);
+	}
+
+	std::int16_t QuantizeSnorm16(float v)
+	{
+		v = std::min(std::max(v, -1.0f), 1.0f);
+		return (std::int16_t)floorf(v*32767.0f + 0.5f);
+	}
+
+	float SignNotZero(float v)
+	{
+		return v >= 0.0f ? 1.0f : -1.0f;
+	}
+}
+
+VertexDecode MeshQuantizer::ComputeDecode(const XMFLOAT3* positions, size_t positionStride, size_t vertexCount)
+{
+	XMFLOAT3 vMin(+FLT_MAX, +FLT_MAX, +FLT_MAX);
+	XMFLOAT3 vMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+	for(size_t i = 0; i < vertexCount; ++i)
+	{
+		const XMFLOAT3& p = AttributeAt(positions, positionStride, i);
+
+		vMin.x = std::min(vMin.x, p.x); vMax.x = std::max(vMax.x, p.x);
+		vMin.y = std::min(vMin.y, p.y); vMax.y = std::max(vMax.y, p.y);
+		vMin.z = std::min(vMin.z, p.z); vMax.z = std::max(vMax.z, p.z);
+	}
+
+	VertexDecode decode;
+	if(vertexCount == 0)
+		return decode;
+
+	// Flat axes (a grid's y, for example) still need a non-zero scale.
+	decode.Bias = vMin;
+	decode.Scale.x = vMax.x > vMin.x ? vMax.x - vMin.x : 1.0f;
+	decode.Scale.y = vMax.y > vMin.y ? vMax.y - vMin.y : 1.0f;
+	decode.Scale.z = vMax.z > vMin.z ? vMax.z - vMin.z : 1.0f;
+
+	return decode;
+}
+
+PackedVertex MeshQuantizer::PackVertex(const XMFLOAT3& position, const XMFLOAT3& normal, const VertexDecode& decode)
+{
+	PackedVertex v;
+	v.Position[0] = QuantizeUnorm16((position.x - decode.Bias.x) / decode.Scale.x);
+	v.Position[1] = QuantizeUnorm16((position.y - decode.Bias.y) / decode.Scale.y);
+	v.Position[2] = QuantizeUnorm16((position.z - decode.Bias.z) / decode.Scale.z);
+	v.Position[3] = 0;
+
+	// Project onto the octahedron |x| + |y| + |z| = 1 and fold the lower half
+	// over the diagonals.
+	float l1 = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+	float x = l1 > 0.0f ? normal.x / l1 : 0.0f;
+	float y = l1 > 0.0f ? normal.y / l1 : 0.0f;
+	float z = l1 > 0.0f ? normal.z / l1 : 1.0f;
+
+	if(z < 0.0f)
+	{
+		float fx = (1.0f - fabsf(y))*SignNotZero(x);
+		float fy = (1.0f - fabsf(x))*SignNotZero(y);
+		x = fx;
+		y = fy;
+	}
+
+	v.Normal[0] = QuantizeSnorm16(x);
+	v.Normal[1] = QuantizeSnorm16(y);
+
+	return v;
+}
+
+XMFLOAT3 MeshQuantizer::UnpackPosition(const PackedVertex& v, const VertexDecode& decode)
+{
+	return XMFLOAT3(
+		decode.Bias.x + decode.Scale.x*(v.Position[0] / 65535.0f),
+		decode.Bias.y + decode.Scale.y*(v.Position[1] / 65535.0f),
+		decode.Bias.z + decode.Scale.z*(v.Position[2] / 65535.0f));
+}
+
+XMFLOAT3 MeshQuantizer::UnpackNormal(const PackedVertex& v)
+{
+	// Same decode as the vertex shader.
+	float x = std::max(v.Normal[0] / 32767.0f, -1.0f);
+	float y = std::max(v.Normal[1] / 32767.0f, -1.0f);
+	float z = 1.0f - fabsf(x) - fabsf(y);
+
+	float t = std::max(-z, 0.0f);
+	x += x >= 0.0f ? -t : t;
+	y += y >= 0.0f ? -t : t;
+
+	XMFLOAT3 n;
+	XMStoreFloat3(&n, XMVector3Normalize(XMVectorSet(x, y, z, 0.0f)));
+	return n;
+}
+
+MeshQuantizer::QuantizationError MeshQuantizer::Quantize(const XMFLOAT3* positions, const XMFLOAT3* normals,
+	size_t vertexStride, size_t vertexCount, const VertexDecode& decode, PackedVertex* packedVertices)
+{
+	QuantizationError error;
+	float minNormalDot = 1.0f;
+
+	for(size_t i = 0; i < vertexCount; ++i)
+	{
+		const XMFLOAT3& p = AttributeAt(positions, vertexStride, i);
+		const XMFLOAT3& n = AttributeAt(normals, vertexStride, i);
+
+		packedVertices[i] = PackVertex(p, n, decode);
+
+		XMFLOAT3 p1 = UnpackPosition(packedVertices[i], decode);
+		XMFLOAT3 n1 = UnpackNormal(packedVertices[i]);
+
+		float positionError = XMVectorGetX(XMVector3Length(XMLoadFloat3(&p1) - XMLoadFloat3(&p)));
+		error.MaxPositionError = std::max(error.MaxPositionError, positionError);
+
+		XMVECTOR n0 = XMLoadFloat3(&n);
+		if(XMVectorGetX(XMVector3LengthSq(n0)) > 0.0f)
+		{
+			float d = XMVectorGetX(XMVector3Dot(XMVector3Normalize(n0), XMLoadFloat3(&n1)));
+			minNormalDot = std::min(minNormalDot, d);
+		}
+	}
+
+	error.MaxNormalError = XMConvertToDegrees(acosf(std::min(std::max(minNormalDot, -1.0f), 1.0f)));
+	return error;
+}
@@ -0,0 +1,54 @@
+//***************************************************************************************
+// MeshQuantizer.h
+//
+// Packs float positions and normals into a 12 byte vertex: 16-bit normalized positions
+// relative to the bounds of the submesh and a 32-bit octahedral normal.  The shader
+// restores the position with the per-submesh VertexDecode constants.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <DirectXMath.h>
+#include "VertexDecode.h"
+
+// DXGI_FORMAT_R16G16B16A16_UNORM position (w is unused) followed by a
+// DXGI_FORMAT_R16G16_SNORM octahedral normal.
+struct PackedVertex
+{
+	std::uint16_t Position[4];
+	std::int16_t Normal[2];
+};
+
+class MeshQuantizer
+{
+public:
+
+	struct QuantizationError
+	{
+		// Largest distance between a decoded and an original position, in the
+		// units of the positions.
+		float MaxPositionError = 0.0f;
+
+		// Largest angle between a decoded and an original normal, in degrees.
+		float MaxNormalError = 0.0f;
+	};
+
+	///<summary>
+	/// Returns the decode constants that map [0, 1] onto the bounding box of the positions.
+	///</summary>
+	static VertexDecode ComputeDecode(const DirectX::XMFLOAT3* positions, size_t positionStride, size_t vertexCount);
+
+	///<summary>
+	/// Packs vertexCount vertices into packedVertices using the given decode constants
+	/// and reports the largest error the packing introduced.  positions and normals point
+	/// at the first vertex's attributes and vertexStride is the size of a source vertex.
+	///</summary>
+	static QuantizationError Quantize(const DirectX::XMFLOAT3* positions, const DirectX::XMFLOAT3* normals,
+		size_t vertexStride, size_t vertexCount, const VertexDecode& decode, PackedVertex* packedVertices);
+
+	static PackedVertex PackVertex(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& normal, const VertexDecode& decode);
+	static DirectX::XMFLOAT3 UnpackPosition(const PackedVertex& v, const VertexDecode& decode);
+	static DirectX::XMFLOAT3 UnpackNormal(const PackedVertex& v);
+};
@@ -0,0 +1,106 @@
+//***************************************************************************************
+// ModelCooker.cpp
+//***************************************************************************************
+
+#include "ModelCooker.h"
+#include "MeshBuilder.h"
+#include "MeshNormals.h"
+#include "ModelReader.h"
+#include "ThreadPool.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Target fraction of the triangles for each level of detail.
+	const float kLodRatios[] = { 0.5f, 0.25f, 0.1f };
+}
+
+std::unique_ptr<MeshGeometry> ModelCooker::CookModel(const std::wstring& sourceFile, const std::string& geoName,
+	const std::string& submeshName, ThreadPool* pool, MeshOptimizer::OptimizeStats* optimizeStats)
+{
+	// The AssetCooker cooks several assets at once on pool.  Splitting the file up as
+	// well costs an extra pass, so it is only done while workers are left idle, as
+	// when there are fewer assets than workers; lists under the size that pays for it
+	// are parsed on this thread either way.
+	ModelReader::Model model;
+	const bool parallel = pool != nullptr && pool->GetIdleWorkerCount() > 0;
+	if(!(parallel ? ModelReader::LoadParallel(sourceFile, model, *pool) : ModelReader::Load(sourceFile, model)))
+		return nullptr;
+
+	std::vector<ModelReader::Vertex>& vertices = model.Vertices;
+	std::vector<std::uint32_t>& indices = model.Indices;
+	if(vertices.empty() || indices.empty())
+		throw std::runtime_error(submeshName + ": the model has no triangles");
+
+	// Exported normals are not always usable; rebuild them if any is missing or broken.
+	if(!MeshNormals::NormalsAreValid(&vertices[0].Normal, sizeof(ModelReader::Vertex), vertices.size()))
+	{
+		OutputDebugStringA((submeshName + ": regenerating normals\n").c_str());
+		MeshNormals::GenerateNormals(vertices, indices, &ModelReader::Vertex::Pos, &ModelReader::Vertex::Normal, pool);
+	}
+
+	MeshOptimizer::WeldOptions weldOptions;
+	MeshOptimizer::WeldVertices(vertices, indices, weldOptions.PositionTolerance,
+		[](const ModelReader::Vertex& v) -> const XMFLOAT3& { return v.Pos; },
+		[&weldOptions](const ModelReader::Vertex& a, const ModelReader::Vertex& b)
+		{
+			return MeshOptimizer::NormalsMatch(a.Normal, b.Normal, weldOptions.NormalTolerance);
+		});
+
+	std::vector<MeshCluster> clusters;
+	MeshOptimizer::OptimizeStats stats = MeshOptimizer::OptimizeClustered(vertices, indices, &ModelReader::Vertex::Pos, clusters);
+	LogOptimizeStats(submeshName, stats);
+	if(optimizeStats != nullptr)
+		*optimizeStats = stats;
+
+	MeshBuilder builder;
+	builder.AddMesh(submeshName, &vertices[0].Pos, &vertices[0].Normal, sizeof(ModelReader::Vertex), vertices.size(),
+		indices.data(), indices.size(), std::move(clusters));
+
+	BuildLodChain(submeshName, &vertices[0].Pos, sizeof(ModelReader::Vertex), vertices.size(), indices, builder);
+
+	auto geo = builder.Pack(geoName);
+	LogQuantizationError(submeshName, builder.GetQuantizationError(submeshName));
+
+	return geo;
+}
+
+void ModelCooker::BuildLodChain(const std::string& name, const XMFLOAT3* positions, size_t positionStride,
+	size_t vertexCount, const std::vector<std::uint32_t>& indices, MeshBuilder& builder)
+{
+	int level = 0;
+	for(float ratio : kLodRatios)
+	{
+		float error = 0.0f;
+		std::vector<std::uint32_t> lodIndices = MeshOptimizer::Simplify(positions, positionStride, vertexCount,
+			indices.data(), indices.size(), (size_t)(indices.size()*ratio), &error);
+
+		MeshOptimizer::OptimizeVertexCache(lodIndices.data(), lodIndices.size(), vertexCount);
+		std::vector<MeshCluster> clusters = MeshOptimizer::BuildClusters(positions, positionStride, vertexCount,
+			lodIndices.data(), lodIndices.size());
+
+		char buffer[256];
+		sprintf_s(buffer, "%s lod%d: %u -> %u triangles, error %f\n", name.c_str(), ++level,
+			(UINT)indices.size()/3, (UINT)lodIndices.size()/3, error);
+		OutputDebugStringA(buffer);
+
+		builder.AddLod(name, std::move(lodIndices), error, std::move(clusters));
+	}
+}
+
+void ModelCooker::LogOptimizeStats(const std::string& name, const MeshOptimizer::OptimizeStats& stats)
+{
+	char buffer[256];
+	sprintf_s(buffer, "%s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", name.c_str(),
+		stats.Before.ACMR, stats.After.ACMR, stats.Before.ATVR, stats.After.ATVR);
+	OutputDebugStringA(buffer);
+}
+
+void ModelCooker::LogQuantizationError(const std::string& name, const MeshQuantizer::QuantizationError& error)
+{
+	char buffer[256];
+	sprintf_s(buffer, "%s: quantized, max position error %f, max normal error %f degrees\n", name.c_str(),
+		error.MaxPositionError, error.MaxNormalError);
+	OutputDebugStringA(buffer);
+}
@@ -0,0 +1,51 @@
+//***************************************************************************************
+// ModelCooker.h
+//
+// The processing that turns a source model into the geometry the demos draw: normal
+// repair, welding, vertex cache and fetch optimization, clusters, a chain of
+// simplified levels of detail, quantization and bounds.  Run offline by the
+// AssetCooker tool, so the demos only read the result from a MeshCache file.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "MeshOptimizer.h"
+#include "MeshQuantizer.h"
+
+class MeshBuilder;
+class ThreadPool;
+
+class ModelCooker
+{
+public:
+
+	// Bump whenever the processing below changes its output, so the AssetCooker
+	// recooks every model.
+	static const std::uint32_t Version = 1;
+
+	///<summary>
+	/// Reads a model file (see ModelReader) and processes it into a geometry named
+	/// geoName with one submesh, submeshName, and its levels of detail.  Returns
+	/// nullptr if the file cannot be opened; throws std::runtime_error if it is
+	/// malformed.  The returned geometry has only its CPU copies.  pool, if given, is
+	/// used to parse large files while it has idle workers and to regenerate broken
+	/// normals.  optimizeStats, if given, receives the vertex
+	/// cache statistics of the full mesh before and after optimization.
+	///</summary>
+	static std::unique_ptr<MeshGeometry> CookModel(const std::wstring& sourceFile, const std::string& geoName,
+		const std::string& submeshName, ThreadPool* pool = nullptr, MeshOptimizer::OptimizeStats* optimizeStats = nullptr);
+
+	///<summary>
+	/// Simplifies a mesh added to builder to a chain of coarser levels and queues them
+	/// as its levels of detail.  The levels share the vertices of the full mesh.
+	///</summary>
+	static void BuildLodChain(const std::string& name, const DirectX::XMFLOAT3* positions, size_t positionStride,
+		size_t vertexCount, const std::vector<std::uint32_t>& indices, MeshBuilder& builder);
+
+	// Writes the vertex cache statistics of a mesh to the debugger output.
+	static void LogOptimizeStats(const std::string& name, const MeshOptimizer::OptimizeStats& stats);
+
+	// Writes the largest vertex quantization error of a mesh to the debugger output.
+	static void LogQuantizationError(const std::string& name, const MeshQuantizer::QuantizationError& error);
+};
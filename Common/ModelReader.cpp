@@ -0,0 +1,407 @@
+//***************************************************************************************
+// ModelReader.cpp
+//***************************************************************************************
+
+#include "ModelReader.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	// Lists smaller than this are parsed on the calling thread by ParseParallel too.
+	const size_t kMinParallelListBytes = 1 << 20;
+
+	// Target size of a chunk of a list parsed in parallel.
+	const size_t kChunkBytes = 256 << 10;
+
+	// Powers of ten that are exact in a float.
+	const float kPowersOf10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+	bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+	}
+
+	bool IsDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	class TextCursor
+	{
+	public:
+		TextCursor(const char* first, const char* last) : mFirst(first), mPos(first), mLast(last) {}
+
+		size_t GetRemaining()const { return (size_t)(mLast - mPos); }
+
+		const char* GetPosition()const { return mPos; }
+		void SetPosition(const char* pos) { mPos = pos; }
+
+		// Consumes the next word, which must be the given one.
+		void Expect(const char* word)
+		{
+			SkipWhitespace();
+
+			size_t length = strlen(word);
+			if(GetRemaining() < length || memcmp(mPos, word, length) != 0)
+				Fail(std::string("expected '") + word + "'");
+
+			mPos += length;
+		}
+
+		// Consumes everything up to and including the next c.
+		void SkipPast(char c)
+		{
+			const char* p = static_cast<const char*>(memchr(mPos, c, GetRemaining()));
+			if(p == nullptr)
+				Fail(std::string("expected '") + c + "'");
+
+			mPos = p + 1;
+		}
+
+		std::uint32_t ReadUInt()
+		{
+			SkipWhitespace();
+
+			std::uint32_t value = 0;
+			auto result = std::from_chars(mPos, mLast, value);
+			if(result.ec != std::errc())
+				Fail("expected an unsigned integer");
+
+			mPos = result.ptr;
+			return value;
+		}
+
+		float ReadFloat()
+		{
+			SkipWhitespace();
+
+			float value = 0.0f;
+#if defined(__cpp_lib_to_chars)
+			// Streams accept an explicit plus sign, from_chars does not.
+			if(GetRemaining() > 1 && mPos[0] == '+' && mPos[1] != '-')
+				++mPos;
+
+			auto result = std::from_chars(mPos, mLast, value);
+			if(result.ec != std::errc())
+				Fail("expected a number");
+
+			mPos = result.ptr;
+#else
+			// This standard library only has integer from_chars.
+			if(!ParseFloat(value))
+				Fail("expected a number");
+#endif
+			return value;
+		}
+
+		// Consumes the rest of the line, which must be blank, and its newline.
+		bool SkipLineEnd()
+		{
+			while(mPos != mLast && (*mPos == ' ' || *mPos == '\t' || *mPos == '\r'))
+				++mPos;
+
+			if(mPos == mLast || *mPos != '\n')
+				return false;
+
+			++mPos;
+			return true;
+		}
+
+		[[noreturn]] void Fail(const std::string& what)const
+		{
+			int line = 1 + (int)std::count(mFirst, mPos, '\n');
+			throw std::runtime_error("Model file line " + std::to_string(line) + ": " + what);
+		}
+
+	private:
+		void SkipWhitespace()
+		{
+			while(mPos != mLast && IsSpace(*mPos))
+				++mPos;
+		}
+
+		// Locale independent decimal to float conversion.  When the significant digits
+		// fit in a float's 24-bit mantissa and the power of ten is exact, one float
+		// multiply or divide rounds correctly; the numbers in the model files always
+		// qualify.  Anything else goes through strtof, which is also correctly rounded.
+		bool ParseFloat(float& value)
+		{
+			const char* p = mPos;
+
+			bool negative = false;
+			if(p != mLast && (*p == '-' || *p == '+'))
+			{
+				negative = *p == '-';
+				++p;
+			}
+
+			std::uint64_t mantissa = 0;
+			int exponent = 0;
+			bool anyDigits = false;
+			bool exact = true;
+
+			for(; p != mLast && IsDigit(*p); ++p)
+			{
+				anyDigits = true;
+				if(mantissa < (1ull << 24))
+					mantissa = mantissa*10 + (*p - '0');
+				else
+					exact = false;
+			}
+
+			if(p != mLast && *p == '.')
+			{
+				for(++p; p != mLast && IsDigit(*p); ++p)
+				{
+					anyDigits = true;
+					if(mantissa < (1ull << 24))
+					{
+						mantissa = mantissa*10 + (*p - '0');
+						--exponent;
+					}
+					else
+						exact = false;
+				}
+			}
+
+			if(!anyDigits)
+				return false;
+
+			if(p != mLast && (*p == 'e' || *p == 'E'))
+			{
+				const char* e = p + 1;
+
+				bool negativeExponent = false;
+				if(e != mLast && (*e == '-' || *e == '+'))
+				{
+					negativeExponent = *e == '-';
+					++e;
+				}
+
+				if(e != mLast && IsDigit(*e))
+				{
+					int digits = 0;
+					for(; e != mLast && IsDigit(*e); ++e)
+						digits = std::min(digits*10 + (*e - '0'), 10000);
+
+					exponent += negativeExponent ? -digits : digits;
+					p = e;
+				}
+			}
+
+			if(exact && mantissa <= (1ull << 24) && exponent >= -10 && exponent <= 10)
+			{
+				float f = (float)mantissa;
+				f = exponent < 0 ? f / kPowersOf10[-exponent] : f * kPowersOf10[exponent];
+				value = negative ? -f : f;
+			}
+			else
+			{
+				// The mapped text is not null terminated.
+				char buffer[64];
+				size_t length = (size_t)(p - mPos);
+				if(length >= sizeof(buffer))
+					return false;
+
+				memcpy(buffer, mPos, length);
+				buffer[length] = '\0';
+				value = strtof(buffer, nullptr);
+			}
+
+			mPos = p;
+			return true;
+		}
+
+		const char* mFirst;
+		const char* mPos;
+		const char* mLast;
+	};
+
+	///<summary>
+	/// Parses the count records of the list that starts at the cursor and ends at the
+	/// next '}' in line-aligned chunks on pool.  Chunk k first counts its lines so it
+	/// knows the index of its first record, then parses its records with
+	/// parseRecord(cursor, index) straight into place.  Returns false without moving
+	/// the cursor if the list is too small or its lines do not hold exactly one record
+	/// each; the caller then parses it sequentially, which also reports any error.
+	///</summary>
+	template<typename ParseFn>
+	bool ParseListInParallel(TextCursor& text, ThreadPool& pool, size_t count, ParseFn parseRecord)
+	{
+		if(pool.GetWorkerCount() == 0)
+			return false;
+
+		const char* first = text.GetPosition();
+		const char* close = static_cast<const char*>(memchr(first, '}', text.GetRemaining()));
+		if(close == nullptr || (size_t)(close - first) < kMinParallelListBytes)
+			return false;
+
+		// The lines start after the newline that follows '{' and end with the newline
+		// before the line holding '}'.
+		const char* begin = static_cast<const char*>(memchr(first, '\n', close - first));
+		if(begin == nullptr)
+			return false;
+		++begin;
+
+		const char* end = close;
+		while(end != begin && end[-1] != '\n')
+		{
+			if(!IsSpace(end[-1]))
+				return false;
+			--end;
+		}
+
+		size_t chunkCount = std::min((size_t)(end - begin) / kChunkBytes + 1, (size_t)(pool.GetWorkerCount() + 1) * 4);
+
+		std::vector<const char*> bounds(chunkCount + 1);
+		bounds[0] = begin;
+		bounds[chunkCount] = end;
+		for(size_t k = 1; k < chunkCount; ++k)
+		{
+			const char* p = std::max(begin + (end - begin) * k / chunkCount, bounds[k - 1]);
+			const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+			bounds[k] = newline != nullptr ? newline + 1 : end;
+		}
+
+		std::vector<size_t> firstRecord(chunkCount + 1, 0);
+		pool.ParallelFor(chunkCount, [&bounds, &firstRecord](size_t k)
+		{
+			firstRecord[k + 1] = (size_t)std::count(bounds[k], bounds[k + 1], '\n');
+		});
+
+		for(size_t k = 0; k < chunkCount; ++k)
+			firstRecord[k + 1] += firstRecord[k];
+
+		if(firstRecord[chunkCount] != count)
+			return false;
+
+		std::atomic<bool> wellFormed(true);
+		pool.ParallelFor(chunkCount, [&](size_t k)
+		{
+			TextCursor chunk(bounds[k], bounds[k + 1]);
+			try
+			{
+				for(size_t i = firstRecord[k]; i < firstRecord[k + 1] && wellFormed; ++i)
+				{
+					parseRecord(chunk, i);
+					if(!chunk.SkipLineEnd())
+						wellFormed = false;
+				}
+			}
+			catch(const std::runtime_error&)
+			{
+				wellFormed = false;
+			}
+		});
+
+		if(!wellFormed)
+			return false;
+
+		text.SetPosition(close);
+		return true;
+	}
+
+	///<summary>
+	/// Parse and ParseParallel.  The lists are only offered to ParseListInParallel
+	/// when there is a pool.
+	///</summary>
+	ModelReader::Model ParseModel(const char* first, const char* last, ThreadPool* pool)
+	{
+		TextCursor text(first, last);
+
+		text.Expect("VertexCount:");
+		std::uint32_t vertexCount = text.ReadUInt();
+		text.Expect("TriangleCount:");
+		std::uint32_t triangleCount = text.ReadUInt();
+
+		// Every vertex takes at least 12 characters and every triangle 6, which keeps a
+		// corrupt header from allocating gigabytes.
+		if(vertexCount > text.GetRemaining() / 12 || triangleCount > text.GetRemaining() / 6)
+			text.Fail("vertex or triangle count exceeds the file size");
+
+		ModelReader::Model model;
+		model.Vertices.resize(vertexCount);
+		model.Indices.resize(3 * (size_t)triangleCount);
+
+		auto readVertex = [&model](TextCursor& cursor, size_t i)
+		{
+			ModelReader::Vertex& v = model.Vertices[i];
+			v.Pos.x = cursor.ReadFloat();
+			v.Pos.y = cursor.ReadFloat();
+			v.Pos.z = cursor.ReadFloat();
+			v.Normal.x = cursor.ReadFloat();
+			v.Normal.y = cursor.ReadFloat();
+			v.Normal.z = cursor.ReadFloat();
+		};
+
+		auto readTriangle = [&model, vertexCount](TextCursor& cursor, size_t i)
+		{
+			for(size_t j = 3*i; j < 3*i + 3; ++j)
+			{
+				model.Indices[j] = cursor.ReadUInt();
+				if(model.Indices[j] >= vertexCount)
+					cursor.Fail("vertex index out of range");
+			}
+		};
+
+		text.Expect("VertexList");
+		text.SkipPast('{');
+
+		if(pool == nullptr || !ParseListInParallel(text, *pool, vertexCount, readVertex))
+		{
+			for(size_t i = 0; i < vertexCount; ++i)
+				readVertex(text, i);
+		}
+
+		text.Expect("}");
+		text.Expect("TriangleList");
+		text.Expect("{");
+
+		if(pool == nullptr || !ParseListInParallel(text, *pool, triangleCount, readTriangle))
+		{
+			for(size_t i = 0; i < triangleCount; ++i)
+				readTriangle(text, i);
+		}
+
+		text.Expect("}");
+
+		return model;
+	}
+}
+
+bool ModelReader::Load(const std::wstring& filename, Model& model)
+{
+	MappedFile file;
+	if(!file.Open(filename))
+		return false;
+
+	model = Parse(file.GetData(), file.GetData() + file.GetSize());
+	return true;
+}
+
+ModelReader::Model ModelReader::Parse(const char* first, const char* last)
+{
+	return ParseModel(first, last, nullptr);
+}
+
+bool ModelReader::LoadParallel(const std::wstring& filename, Model& model, ThreadPool& pool)
+{
+	MappedFile file;
+	if(!file.Open(filename))
+		return false;
+
+	model = ParseParallel(file.GetData(), file.GetData() + file.GetSize(), pool);
+	return true;
+}
+
+ModelReader::Model ModelReader::ParseParallel(const char* first, const char* last, ThreadPool& pool)
+{
+	return ParseModel(first, last, &pool);
+}
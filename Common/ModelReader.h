@@ -0,0 +1,70 @@
+//***************************************************************************************
+// ModelReader.h
+//
+// Reads the text models used by the demos (Models/skull.txt, Models/car.txt):
+//
+//   VertexCount: n
+//   TriangleCount: m
+//   VertexList (pos, normal)
+//   {
+//       px py pz nx ny nz      (n lines)
+//   }
+//   TriangleList
+//   {
+//       i0 i1 i2               (m lines)
+//   }
+//
+// The file is memory mapped and parsed in one pass, without streams or locales,
+// into arrays sized from the header.  LoadParallel and ParseParallel instead split
+// large lists into line-aligned chunks that are parsed concurrently into disjoint
+// ranges of those arrays.  That costs an extra pass to count the lines of each chunk,
+// so it only pays off with idle cores to spare; Load and Parse never take it.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+
+class ThreadPool;
+
+class ModelReader
+{
+public:
+
+	struct Vertex
+	{
+		DirectX::XMFLOAT3 Pos;
+		DirectX::XMFLOAT3 Normal;
+	};
+
+	struct Model
+	{
+		std::vector<Vertex> Vertices;
+		std::vector<std::uint32_t> Indices;
+	};
+
+	///<summary>
+	/// Reads a model file.  Returns false if the file cannot be opened and throws
+	/// std::runtime_error if its contents are malformed.
+	///</summary>
+	static bool Load(const std::wstring& filename, Model& model);
+
+	///<summary>
+	/// Parses a model from text in [first, last) on the calling thread.  Throws
+	/// std::runtime_error with the line number if the text is malformed or an index is
+	/// out of range.
+	///</summary>
+	static Model Parse(const char* first, const char* last);
+
+	///<summary>
+	/// Same as Load and Parse, but vertex and triangle lists of at least 1 MB that hold
+	/// one vertex or triangle per line are parsed in chunks on pool and the calling
+	/// thread.  Other lists, and every list when pool has no workers, are parsed as
+	/// Parse does.  The result is the same either way.
+	///</summary>
+	static bool LoadParallel(const std::wstring& filename, Model& model, ThreadPool& pool);
+	static Model ParseParallel(const char* first, const char* last, ThreadPool& pool);
+};
@@ -0,0 +1,75 @@
+//***************************************************************************************
+// RangeAllocator.cpp
+//***************************************************************************************
+
+#include "RangeAllocator.h"
+#include <iterator>
+
+RangeAllocator::RangeAllocator(uint32 capacity)
+	: mCapacity(capacity)
+{
+	if(capacity > 0)
+		AddFreeRange(0, capacity);
+}
+
+bool RangeAllocator::Allocate(uint32 size, uint32& offset)
+{
+	// Smallest free range that fits, lowest offset first.
+	auto bySize = mFreeBySize.lower_bound(std::make_pair(size, (uint32)0));
+	if(bySize == mFreeBySize.end())
+		return false;
+
+	offset = bySize->second;
+	uint32 rangeSize = bySize->first;
+	RemoveFreeRange(mFreeByOffset.find(offset));
+
+	if(rangeSize > size)
+		AddFreeRange(offset + size, rangeSize - size);
+
+	return true;
+}
+
+void RangeAllocator::Free(uint32 offset, uint32 size)
+{
+	// Merge with the free ranges on either side.
+	auto next = mFreeByOffset.lower_bound(offset);
+	if(next != mFreeByOffset.end() && offset + size == next->first)
+	{
+		size += next->second;
+		auto merged = next++;
+		RemoveFreeRange(merged);
+	}
+
+	if(next != mFreeByOffset.begin())
+	{
+		auto prev = std::prev(next);
+		if(prev->first + prev->second == offset)
+		{
+			offset = prev->first;
+			size += prev->second;
+			RemoveFreeRange(prev);
+		}
+	}
+
+	AddFreeRange(offset, size);
+}
+
+RangeAllocator::uint32 RangeAllocator::GetLargestFreeRange()const
+{
+	return mFreeBySize.empty() ? 0 : mFreeBySize.rbegin()->first;
+}
+
+void RangeAllocator::AddFreeRange(uint32 offset, uint32 size)
+{
+	mFreeByOffset.emplace(offset, size);
+	mFreeBySize.emplace(size, offset);
+	mFreeSize += size;
+}
+
+void RangeAllocator::RemoveFreeRange(std::map<uint32, uint32>::iterator range)
+{
+	mFreeBySize.erase(std::make_pair(range->second, range->first));
+
+	mFreeSize -= range->second;
+	mFreeByOffset.erase(range);
+}
@@ -0,0 +1,53 @@
+//***************************************************************************************
+// RangeAllocator.h
+//
+// Best-fit allocator of ranges of [0, capacity) in whole units, such as the vertices or
+// index bytes of a GeometryRegistry arena.  Free ranges are indexed both by offset, so a
+// freed range merges with its free neighbours, and by size, so Allocate finds the
+// smallest range that fits without walking the list.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+
+class RangeAllocator
+{
+public:
+	using uint32 = std::uint32_t;
+
+	explicit RangeAllocator(uint32 capacity = 0);
+
+	///<summary>
+	/// Takes size units from the start of the smallest free range that holds them, the
+	/// one at the lowest offset among equals.  Returns false if no free range does.
+	///</summary>
+	bool Allocate(uint32 size, uint32& offset);
+
+	// Returns a range taken by Allocate.  It merges with the free ranges it touches.
+	void Free(uint32 offset, uint32 size);
+
+	uint32 GetCapacity()const { return mCapacity; }
+
+	// Units in free ranges, and in how many separate ranges.
+	uint32 GetFreeSize()const { return mFreeSize; }
+	size_t GetFreeRangeCount()const { return mFreeByOffset.size(); }
+
+	// Size of the largest free range, the largest Allocate that succeeds.
+	uint32 GetLargestFreeRange()const;
+
+private:
+	void AddFreeRange(uint32 offset, uint32 size);
+	void RemoveFreeRange(std::map<uint32, uint32>::iterator range);
+
+	uint32 mCapacity = 0;
+	uint32 mFreeSize = 0;
+
+	// Offset to size, and (size, offset) pairs in size order.
+	std::map<uint32, uint32> mFreeByOffset;
+	std::set<std::pair<uint32, uint32>> mFreeBySize;
+};
@@ -0,0 +1,442 @@
+//***************************************************************************************
+// SceneFile.cpp
+//***************************************************************************************
+
+#include "SceneFile.h"
+#include <stdexcept>
+
+using namespace DirectX;
+
+namespace
+{
+	const char kMagic[4] = { 'S', 'C', 'N', 'F' };
+
+	// Bump whenever the layout below or the meaning of the source syntax changes.
+	const std::uint32_t kVersion = 2;
+
+	const std::uint32_t kSectionAlignment = 16;
+
+	struct FileHeader
+	{
+		char Magic[4];
+		std::uint32_t Version;
+
+		std::uint32_t NodeOffset;
+		std::uint32_t ShapeOffset;
+		std::uint32_t MaterialOffset;
+		std::uint32_t StringOffset;
+
+		std::uint32_t NodeCount;
+		std::uint32_t ShapeCount;
+		std::uint32_t MaterialCount;
+		std::uint32_t StringByteSize;
+
+		std::uint32_t Reserved[2];
+	};
+
+	// Offsets of null-terminated names in the string table.
+	struct ShapeRecord
+	{
+		std::uint32_t GeoName;
+		std::uint32_t SubmeshName;
+	};
+
+	static_assert(sizeof(FileHeader) == 48, "FileHeader has unexpected padding.");
+	static_assert(sizeof(SceneFile::Node) == 80, "Node has unexpected padding.");
+	static_assert(sizeof(ShapeRecord) == 8, "ShapeRecord has unexpected padding.");
+
+	std::uint64_t AlignUp(std::uint64_t offset)
+	{
+		return (offset + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment;
+	}
+
+	bool InRange(std::uint64_t offset, std::uint64_t byteSize, std::uint64_t fileSize)
+	{
+		return offset % kSectionAlignment == 0 && offset <= fileSize && byteSize <= fileSize - offset;
+	}
+
+	// The tables of a scene being compiled.  Names and shapes are stored once, however
+	// many nodes use them.
+	class SceneTables
+	{
+	public:
+		std::uint32_t AddShape(const std::string& geoName, const std::string& submeshName)
+		{
+			ShapeRecord r = { AddString(geoName), AddString(submeshName) };
+
+			std::uint64_t key = ((std::uint64_t)r.GeoName << 32) | r.SubmeshName;
+			auto it = mShapeLookup.find(key);
+			if(it != mShapeLookup.end())
+				return it->second;
+
+			std::uint32_t index = (std::uint32_t)Shapes.size();
+			Shapes.push_back(r);
+			mShapeLookup[key] = index;
+			return index;
+		}
+
+		std::uint32_t AddMaterial(const std::string& name)
+		{
+			std::uint32_t offset = AddString(name);
+
+			auto it = mMaterialLookup.find(offset);
+			if(it != mMaterialLookup.end())
+				return it->second;
+
+			std::uint32_t index = (std::uint32_t)Materials.size();
+			Materials.push_back(offset);
+			mMaterialLookup[offset] = index;
+			return index;
+		}
+
+		std::vector<ShapeRecord> Shapes;
+		std::vector<std::uint32_t> Materials;
+		std::string Strings;
+
+	private:
+		std::uint32_t AddString(const std::string& s)
+		{
+			auto it = mStringLookup.find(s);
+			if(it != mStringLookup.end())
+				return it->second;
+
+			std::uint32_t offset = (std::uint32_t)Strings.size();
+			Strings.append(s.c_str(), s.size() + 1);
+			mStringLookup[s] = offset;
+			return offset;
+		}
+
+		std::unordered_map<std::string, std::uint32_t> mStringLookup;
+		std::unordered_map<std::uint64_t, std::uint32_t> mShapeLookup;
+		std::unordered_map<std::uint32_t, std::uint32_t> mMaterialLookup;
+	};
+
+	[[noreturn]] void ThrowSyntaxError(int lineNumber, const std::string& message)
+	{
+		throw std::runtime_error("line " + std::to_string(lineNumber) + ": " + message);
+	}
+
+	XMFLOAT3 ReadFloat3(std::istringstream& line, int lineNumber, const std::string& keyword)
+	{
+		XMFLOAT3 v;
+		if(!(line >> v.x >> v.y >> v.z))
+			ThrowSyntaxError(lineNumber, "expected three numbers after '" + keyword + "'");
+
+		return v;
+	}
+
+	// A piece or group as written in the source, before repeat copies it.
+	struct SourceNode
+	{
+		XMFLOAT4X4 ScaleRotation;
+		XMFLOAT3 Translation;
+		XMFLOAT3 Step;
+		int Repeat;
+
+		std::uint32_t Shape;
+		std::uint32_t Material;
+
+		// Indices of the nodes in its block.
+		std::vector<size_t> Children;
+	};
+
+	// The source nodes parsed so far and the blocks still open.
+	struct SourceTree
+	{
+		std::vector<SourceNode> Nodes;
+		std::vector<size_t> Roots;
+
+		// Node and line of each open '{', innermost last.
+		std::vector<std::pair<size_t, int>> OpenBlocks;
+	};
+
+	// Parses one line of the source into tree.
+	void ParseLine(const std::string& text, int lineNumber, SceneTables& tables, SourceTree& tree)
+	{
+		std::istringstream line(text);
+
+		std::string first;
+		if(!(line >> first))
+			return;
+
+		if(first == "}")
+		{
+			std::string rest;
+			if(line >> rest)
+				ThrowSyntaxError(lineNumber, "expected nothing after '}'");
+			if(tree.OpenBlocks.empty())
+				ThrowSyntaxError(lineNumber, "'}' without a matching '{'");
+
+			tree.OpenBlocks.pop_back();
+			return;
+		}
+
+		SourceNode node;
+		node.Repeat = 1;
+		node.Step = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		node.Translation = XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+		const bool isGroup = first == "group";
+		if(isGroup)
+		{
+			node.Shape = SceneFile::kNone;
+			node.Material = SceneFile::kNone;
+		}
+		else
+		{
+			std::string submeshName, materialName;
+			if(!(line >> submeshName >> materialName))
+				ThrowSyntaxError(lineNumber, "expected <geometry> <submesh> <material>");
+
+			node.Shape = tables.AddShape(first, submeshName);
+			node.Material = tables.AddMaterial(materialName);
+		}
+
+		XMFLOAT3 scale(1.0f, 1.0f, 1.0f);
+		XMFLOAT3 rotation(0.0f, 0.0f, 0.0f);
+		bool opensBlock = false;
+
+		std::string keyword;
+		while(line >> keyword)
+		{
+			if(opensBlock)
+				ThrowSyntaxError(lineNumber, "expected nothing after '{'");
+
+			if(keyword == "scale")
+				scale = ReadFloat3(line, lineNumber, keyword);
+			else if(keyword == "rotate")
+				rotation = ReadFloat3(line, lineNumber, keyword);
+			else if(keyword == "translate")
+				node.Translation = ReadFloat3(line, lineNumber, keyword);
+			else if(keyword == "repeat")
+			{
+				if(!(line >> node.Repeat) || node.Repeat < 1)
+					ThrowSyntaxError(lineNumber, "expected a positive count after 'repeat'");
+
+				node.Step = ReadFloat3(line, lineNumber, keyword);
+			}
+			else if(keyword == "{")
+				opensBlock = true;
+			else
+				ThrowSyntaxError(lineNumber, "unknown keyword '" + keyword + "'");
+		}
+
+		if(isGroup && !opensBlock)
+			ThrowSyntaxError(lineNumber, "expected '{' at the end of a group");
+
+		XMStoreFloat4x4(&node.ScaleRotation, XMMatrixScaling(scale.x, scale.y, scale.z) *
+			XMMatrixRotationRollPitchYaw(XMConvertToRadians(rotation.x),
+				XMConvertToRadians(rotation.y), XMConvertToRadians(rotation.z)));
+
+		const size_t index = tree.Nodes.size();
+		tree.Nodes.push_back(std::move(node));
+
+		if(tree.OpenBlocks.empty())
+			tree.Roots.push_back(index);
+		else
+			tree.Nodes[tree.OpenBlocks.back().first].Children.push_back(index);
+
+		if(opensBlock)
+			tree.OpenBlocks.push_back({ index, lineNumber });
+	}
+
+	// Appends the copies of source node i, each followed by its block, under parent.
+	void EmitNode(const SourceTree& tree, size_t i, std::uint32_t parent, std::vector<SceneFile::Node>& nodes)
+	{
+		const SourceNode& source = tree.Nodes[i];
+		XMMATRIX scaleRotation = XMLoadFloat4x4(&source.ScaleRotation);
+
+		for(int r = 0; r < source.Repeat; ++r)
+		{
+			if(nodes.size() >= UINT_MAX / sizeof(SceneFile::Node))
+				throw std::runtime_error("too many nodes");
+
+			SceneFile::Node node = {};
+			XMStoreFloat4x4(&node.Local, scaleRotation * XMMatrixTranslation(source.Translation.x + r*source.Step.x,
+				source.Translation.y + r*source.Step.y, source.Translation.z + r*source.Step.z));
+			node.Parent = parent;
+			node.Shape = source.Shape;
+			node.Material = source.Material;
+
+			const std::uint32_t index = (std::uint32_t)nodes.size();
+			nodes.push_back(node);
+
+			for(size_t child : source.Children)
+				EmitNode(tree, child, index, nodes);
+		}
+	}
+}
+
+std::uint32_t SceneFile::GetVersion()
+{
+	return kVersion;
+}
+
+bool SceneFile::Compile(const std::wstring& sourceFile, const std::wstring& sceneFile)
+{
+	std::ifstream fin(sourceFile);
+	if(!fin)
+		return false;
+
+	SceneTables tables;
+	SourceTree tree;
+
+	std::string text;
+	int lineNumber = 0;
+	while(std::getline(fin, text))
+	{
+		++lineNumber;
+		ParseLine(text.substr(0, text.find('#')), lineNumber, tables, tree);
+	}
+
+	if(!tree.OpenBlocks.empty())
+		ThrowSyntaxError(tree.OpenBlocks.back().second, "'{' is never closed");
+
+	// Lay the nodes out in preorder, expanding repeats.
+	std::vector<Node> nodes;
+	for(size_t root : tree.Roots)
+		EmitNode(tree, root, kNone, nodes);
+
+	FileHeader header = {};
+	memcpy(header.Magic, kMagic, sizeof(kMagic));
+	header.Version = kVersion;
+	header.NodeCount = (std::uint32_t)nodes.size();
+	header.ShapeCount = (std::uint32_t)tables.Shapes.size();
+	header.MaterialCount = (std::uint32_t)tables.Materials.size();
+	header.StringByteSize = (std::uint32_t)tables.Strings.size();
+
+	header.NodeOffset = (std::uint32_t)AlignUp(sizeof(FileHeader));
+	header.ShapeOffset = (std::uint32_t)AlignUp(header.NodeOffset + nodes.size()*sizeof(Node));
+	header.MaterialOffset = (std::uint32_t)AlignUp(header.ShapeOffset + tables.Shapes.size()*sizeof(ShapeRecord));
+	header.StringOffset = (std::uint32_t)AlignUp(header.MaterialOffset + tables.Materials.size()*sizeof(std::uint32_t));
+
+	//
+	// Write to a temporary file and move it over the old scene, so a crash never
+	// leaves a truncated scene behind.
+	//
+
+	std::wstring tempFile = sceneFile + L".tmp";
+	{
+		std::ofstream fout(tempFile, std::ios::binary | std::ios::trunc);
+		if(!fout)
+			return false;
+
+		const char padding[kSectionAlignment] = {};
+		auto writeSection = [&fout, &padding](std::uint64_t offset, const void* data, size_t byteSize)
+		{
+			std::uint64_t position = (std::uint64_t)fout.tellp();
+			fout.write(padding, (std::streamsize)(offset - position));
+			fout.write(static_cast<const char*>(data), (std::streamsize)byteSize);
+		};
+
+		fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		writeSection(header.NodeOffset, nodes.data(), nodes.size()*sizeof(Node));
+		writeSection(header.ShapeOffset, tables.Shapes.data(), tables.Shapes.size()*sizeof(ShapeRecord));
+		writeSection(header.MaterialOffset, tables.Materials.data(), tables.Materials.size()*sizeof(std::uint32_t));
+		writeSection(header.StringOffset, tables.Strings.data(), tables.Strings.size());
+
+		if(!fout)
+		{
+			fout.close();
+			DeleteFileW(tempFile.c_str());
+			return false;
+		}
+	}
+
+	if(!MoveFileExW(tempFile.c_str(), sceneFile.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileW(tempFile.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+std::unique_ptr<SceneFile> SceneFile::Load(const std::wstring& sceneFile)
+{
+	std::ifstream fin(sceneFile, std::ios::binary | std::ios::ate);
+	if(!fin)
+		return nullptr;
+
+	const std::uint64_t fileSize = (std::uint64_t)fin.tellg();
+	if(fileSize < sizeof(FileHeader) || fileSize > UINT_MAX)
+		return nullptr;
+
+	std::unique_ptr<SceneFile> scene(new SceneFile());
+	scene->mData.reset(new char[(size_t)fileSize]);
+
+	fin.seekg(0, std::ios::beg);
+	if(!fin.read(scene->mData.get(), (std::streamsize)fileSize))
+		return nullptr;
+
+	const char* data = scene->mData.get();
+
+	FileHeader header;
+	memcpy(&header, data, sizeof(header));
+
+	if(memcmp(header.Magic, kMagic, sizeof(kMagic)) != 0 || header.Version != kVersion)
+		return nullptr;
+
+	//
+	// Validate the sections before trusting any offset in them.  The string table ends
+	// with a terminator, so every name inside it is terminated.
+	//
+
+	if(!InRange(header.NodeOffset, (std::uint64_t)header.NodeCount*sizeof(Node), fileSize) ||
+	   !InRange(header.ShapeOffset, (std::uint64_t)header.ShapeCount*sizeof(ShapeRecord), fileSize) ||
+	   !InRange(header.MaterialOffset, (std::uint64_t)header.MaterialCount*sizeof(std::uint32_t), fileSize) ||
+	   !InRange(header.StringOffset, header.StringByteSize, fileSize) ||
+	   (header.StringByteSize > 0 && data[header.StringOffset + header.StringByteSize - 1] != '\0'))
+	{
+		return nullptr;
+	}
+
+	const ShapeRecord* shapes = reinterpret_cast<const ShapeRecord*>(data + header.ShapeOffset);
+	const std::uint32_t* materials = reinterpret_cast<const std::uint32_t*>(data + header.MaterialOffset);
+	const char* strings = data + header.StringOffset;
+
+	scene->mShapes.resize(header.ShapeCount);
+	for(std::uint32_t i = 0; i < header.ShapeCount; ++i)
+	{
+		if(shapes[i].GeoName >= header.StringByteSize || shapes[i].SubmeshName >= header.StringByteSize)
+			return nullptr;
+
+		scene->mShapes[i].GeoName = strings + shapes[i].GeoName;
+		scene->mShapes[i].SubmeshName = strings + shapes[i].SubmeshName;
+	}
+
+	scene->mMaterialNames.resize(header.MaterialCount);
+	for(std::uint32_t i = 0; i < header.MaterialCount; ++i)
+	{
+		if(materials[i] >= header.StringByteSize)
+			return nullptr;
+
+		scene->mMaterialNames[i] = strings + materials[i];
+	}
+
+	scene->mNodes = reinterpret_cast<const Node*>(data + header.NodeOffset);
+	scene->mNodeCount = header.NodeCount;
+
+	// In preorder, a node's parent is the node before it or one of that node's
+	// ancestors, which are kept on a stack.
+	std::vector<std::uint32_t> ancestors;
+	for(UINT i = 0; i < scene->mNodeCount; ++i)
+	{
+		const Node& node = scene->mNodes[i];
+
+		if(node.Shape == kNone ? node.Material != kNone :
+		   node.Shape >= header.ShapeCount || node.Material >= header.MaterialCount)
+		{
+			return nullptr;
+		}
+
+		while(!ancestors.empty() && ancestors.back() != node.Parent)
+			ancestors.pop_back();
+		if(ancestors.empty() && node.Parent != kNone)
+			return nullptr;
+
+		ancestors.push_back(i);
+	}
+
+	return scene;
+}
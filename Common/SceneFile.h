@@ -0,0 +1,100 @@
+//***************************************************************************************
+// SceneFile.h
+//
+// Scene layouts described as text, one piece per line, and compiled offline into a flat
+// binary file that loads with a single read:
+//
+//   <geometry> <submesh> <material> [scale x y z] [rotate x y z] [translate x y z]
+//       [repeat n dx dy dz] [{]
+//   group [scale x y z] [rotate x y z] [translate x y z] [repeat n dx dy dz] {
+//   }
+//
+// Rotations are in degrees about x, y and z (pitch, yaw and roll); a piece is scaled,
+// rotated, then translated.  repeat places n copies, each offset by (dx, dy, dz) from the
+// one before.  Everything after a '#' is a comment.
+//
+// A line ending in '{' opens a block, closed by a '}' line, whose pieces are placed
+// relative to it.  A group is a node with no geometry of its own that only places its
+// block.  repeat copies a node together with its whole block.
+//
+// The compiled file holds the nodes in depth-first preorder, each parent before its
+// children and every block right after its node, followed by tables of the distinct
+// shapes (geometry and submesh) and materials they use, so names are looked up once per
+// table entry instead of once per node.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+
+class SceneFile
+{
+public:
+
+	// Parent of a root node, and shape and material of a group.
+	static const std::uint32_t kNone = 0xffffffff;
+
+	// One node of the scene, as stored in the compiled file.
+	struct Node
+	{
+		// Transform relative to the parent node, or to the world for a root.
+		DirectX::XMFLOAT4X4 Local;
+
+		// Index of the parent node, which comes earlier in the file, or kNone.
+		std::uint32_t Parent;
+
+		// Indices into the shape and material tables, or kNone for a group.
+		std::uint32_t Shape;
+		std::uint32_t Material;
+
+		std::uint32_t Reserved;
+	};
+
+	// Geometry and submesh a node draws.
+	struct Shape
+	{
+		const char* GeoName = nullptr;
+		const char* SubmeshName = nullptr;
+	};
+
+	SceneFile(const SceneFile& rhs) = delete;
+	SceneFile& operator=(const SceneFile& rhs) = delete;
+
+	///<summary>
+	/// Parses the text scene sourceFile and writes it compiled to sceneFile, which is
+	/// replaced atomically.  Throws a std::runtime_error naming the line of a syntax
+	/// error; returns false if a file cannot be read or written.
+	///</summary>
+	static bool Compile(const std::wstring& sourceFile, const std::wstring& sceneFile);
+
+	///<summary>
+	/// Reads a compiled scene with one read and validates it, including that the nodes
+	/// are in preorder.  Returns nullptr if the file is missing, from another version
+	/// or malformed.
+	///</summary>
+	static std::unique_ptr<SceneFile> Load(const std::wstring& sceneFile);
+
+	// Version of the compiled layout; files of any other version are not read.
+	static std::uint32_t GetVersion();
+
+	UINT GetNodeCount()const { return mNodeCount; }
+	const Node* GetNodes()const { return mNodes; }
+
+	UINT GetShapeCount()const { return (UINT)mShapes.size(); }
+	const Shape& GetShape(UINT i)const { return mShapes[i]; }
+
+	UINT GetMaterialCount()const { return (UINT)mMaterialNames.size(); }
+	const char* GetMaterialName(UINT i)const { return mMaterialNames[i]; }
+
+private:
+	SceneFile() = default;
+
+	// The whole file; the nodes and names point into it.
+	std::unique_ptr<char[]> mData;
+
+	const Node* mNodes = nullptr;
+	UINT mNodeCount = 0;
+
+	std::vector<Shape> mShapes;
+	std::vector<const char*> mMaterialNames;
+};
@@ -0,0 +1,73 @@
+//***************************************************************************************
+// SceneGraph.cpp
+//***************************************************************************************
+
+#include "SceneGraph.h"
+#include <stdexcept>
+
+using namespace DirectX;
+
+UINT SceneGraph::AddNode(UINT parent, const XMFLOAT4X4& local)
+{
+	const UINT node = GetNodeCount();
+
+	// In preorder, the parent's subtree must still end at the new node.
+	if(parent != kNoParent && (parent >= node || parent + mSubtreeSizes[parent] != node))
+		throw std::invalid_argument("SceneGraph nodes must be added in preorder.");
+
+	for(UINT ancestor = parent; ancestor != kNoParent; ancestor = mParents[ancestor])
+		++mSubtreeSizes[ancestor];
+
+	mParents.push_back(parent);
+	mSubtreeSizes.push_back(1);
+	mLocals.push_back(local);
+	mWorlds.push_back(local);
+
+	mDirtyNodes.push_back(node);
+	mDirty.push_back(true);
+
+	return node;
+}
+
+void SceneGraph::SetLocal(UINT node, FXMMATRIX local)
+{
+	XMStoreFloat4x4(&mLocals[node], local);
+
+	if(!mDirty[node])
+	{
+		mDirty[node] = true;
+		mDirtyNodes.push_back(node);
+	}
+}
+
+const std::vector<UINT>& SceneGraph::Update()
+{
+	mUpdated.clear();
+	if(mDirtyNodes.empty())
+		return mUpdated;
+
+	std::sort(mDirtyNodes.begin(), mDirtyNodes.end());
+
+	// A dirty node inside a subtree already recomputed is covered by it.
+	UINT end = 0;
+	for(UINT root : mDirtyNodes)
+	{
+		mDirty[root] = false;
+		if(root < end)
+			continue;
+
+		end = root + mSubtreeSizes[root];
+		for(UINT i = root; i < end; ++i)
+		{
+			if(mParents[i] == kNoParent)
+				mWorlds[i] = mLocals[i];
+			else
+				XMStoreFloat4x4(&mWorlds[i], XMLoadFloat4x4(&mLocals[i])*XMLoadFloat4x4(&mWorlds[mParents[i]]));
+
+			mUpdated.push_back(i);
+		}
+	}
+
+	mDirtyNodes.clear();
+	return mUpdated;
+}
@@ -0,0 +1,62 @@
+//***************************************************************************************
+// SceneGraph.h
+//
+// Transform hierarchy kept in flat arrays in depth-first preorder: a node's parent
+// comes before it and its descendants follow it directly, so the subtree under node n
+// is the range [n, n + subtree size).  One linear pass over that range brings its
+// world matrices up to date, and only the subtrees under nodes whose local transform
+// changed are visited.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+
+class SceneGraph
+{
+public:
+	static const UINT kNoParent = 0xffffffff;
+
+	SceneGraph() = default;
+	SceneGraph(const SceneGraph& rhs) = delete;
+	SceneGraph& operator=(const SceneGraph& rhs) = delete;
+
+	///<summary>
+	/// Appends a node with the given transform relative to parent, or to the world for
+	/// kNoParent, and returns its index.  Nodes must be added in preorder: parent is
+	/// the last node added or one of its ancestors.  Throws std::invalid_argument
+	/// otherwise.  The new node is dirty.
+	///</summary>
+	UINT AddNode(UINT parent, const DirectX::XMFLOAT4X4& local);
+
+	UINT GetNodeCount()const { return (UINT)mParents.size(); }
+	UINT GetParent(UINT node)const { return mParents[node]; }
+	UINT GetSubtreeSize(UINT node)const { return mSubtreeSizes[node]; }
+
+	// Replaces the transform of node relative to its parent and marks it dirty.
+	void SetLocal(UINT node, DirectX::FXMMATRIX local);
+	DirectX::XMMATRIX GetLocal(UINT node)const { return DirectX::XMLoadFloat4x4(&mLocals[node]); }
+
+	// As of the last Update.
+	DirectX::XMMATRIX GetWorld(UINT node)const { return DirectX::XMLoadFloat4x4(&mWorlds[node]); }
+
+	///<summary>
+	/// Recomputes the world matrices of the dirty nodes and their descendants and
+	/// returns those nodes in ascending order.  The result stays valid until the next
+	/// call.
+	///</summary>
+	const std::vector<UINT>& Update();
+
+private:
+	std::vector<UINT> mParents;
+	std::vector<UINT> mSubtreeSizes;
+	std::vector<DirectX::XMFLOAT4X4> mLocals;
+	std::vector<DirectX::XMFLOAT4X4> mWorlds;
+
+	// Nodes whose local transform changed since the last Update, each listed once.
+	std::vector<UINT> mDirtyNodes;
+	std::vector<bool> mDirty;
+
+	// The list handed out by Update.
+	std::vector<UINT> mUpdated;
+};
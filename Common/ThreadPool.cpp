@@ -0,0 +1,152 @@
+//***************************************************************************************
+// ThreadPool.cpp
+//***************************************************************************************
+
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+ThreadPool::ThreadPool()
+	: ThreadPool(std::max(std::thread::hardware_concurrency(), 2u) - 1)
+{
+}
+
+ThreadPool::ThreadPool(unsigned workerCount)
+{
+	mWorkers.reserve(workerCount);
+	for(unsigned i = 0; i < workerCount; ++i)
+		mWorkers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+
+	mTaskAvailable.notify_all();
+
+	for(std::thread& worker : mWorkers)
+		worker.join();
+}
+
+unsigned ThreadPool::GetIdleWorkerCount()const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mWaitingCount > mTasks.size() ? mWaitingCount - (unsigned)mTasks.size() : 0;
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+	if(mWorkers.empty())
+	{
+		task();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mTasks.push_back(std::move(task));
+	}
+
+	mTaskAvailable.notify_one();
+}
+
+void ThreadPool::WorkerLoop()
+{
+	for(;;)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			++mWaitingCount;
+			mTaskAvailable.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+			--mWaitingCount;
+
+			if(mTasks.empty())
+				return;
+
+			task = std::move(mTasks.front());
+			mTasks.pop_front();
+		}
+
+		// Submit wraps every task in a packaged_task, which captures its exceptions.
+		task();
+	}
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& body)
+{
+	if(count == 0)
+		return;
+
+	// Helpers may start after the items have run out, possibly after this call has
+	// returned, so they share the loop state instead of referencing this frame.
+	struct Loop
+	{
+		std::atomic<size_t> Next{ 0 };
+		size_t Count = 0;
+		const std::function<void(size_t)>* Body = nullptr;
+
+		std::mutex Mutex;
+		std::condition_variable Finished;
+		size_t ActiveHelpers = 0;
+		std::exception_ptr Error;
+
+		void Run()
+		{
+			try
+			{
+				for(size_t i = Next++; i < Count; i = Next++)
+					(*Body)(i);
+			}
+			catch(...)
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				if(!Error)
+					Error = std::current_exception();
+
+				// Stop handing out items.
+				Next = Count;
+			}
+		}
+	};
+
+	auto loop = std::make_shared<Loop>();
+	loop->Count = count;
+	loop->Body = &body;
+
+	size_t helperCount = std::min(mWorkers.size(), count - 1);
+	for(size_t i = 0; i < helperCount; ++i)
+	{
+		Enqueue([loop]()
+		{
+			{
+				std::lock_guard<std::mutex> lock(loop->Mutex);
+				if(loop->Next >= loop->Count)
+					return;
+
+				++loop->ActiveHelpers;
+			}
+
+			loop->Run();
+
+			std::lock_guard<std::mutex> lock(loop->Mutex);
+			if(--loop->ActiveHelpers == 0)
+				loop->Finished.notify_all();
+		});
+	}
+
+	// The calling thread takes items too, so the loop finishes even when every
+	// worker is busy, including when this is called from a pool task.  Helpers that
+	// have not started by then skip the loop, so only the running ones are awaited.
+	loop->Run();
+
+	std::unique_lock<std::mutex> lock(loop->Mutex);
+	loop->Finished.wait(lock, [&loop]() { return loop->ActiveHelpers == 0; });
+
+	if(loop->Error)
+		std::rethrow_exception(loop->Error);
+}
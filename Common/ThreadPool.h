@@ -0,0 +1,77 @@
+//***************************************************************************************
+// ThreadPool.h
+//
+// Fixed set of worker threads for CPU-side asset work: loading, parsing and mesh
+// processing.  Tasks run in submission order; results and exceptions come back
+// through std::future.
+//***************************************************************************************
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool
+{
+public:
+	// One worker per hardware thread, less one for the thread that owns the pool.
+	ThreadPool();
+
+	// A pool without workers runs every task on the calling thread.
+	explicit ThreadPool(unsigned workerCount);
+
+	ThreadPool(const ThreadPool& rhs) = delete;
+	ThreadPool& operator=(const ThreadPool& rhs) = delete;
+
+	// Finishes the queued tasks, then joins the workers.
+	~ThreadPool();
+
+	unsigned GetWorkerCount()const { return (unsigned)mWorkers.size(); }
+
+	// Workers waiting for a task that no queued task is about to wake.  Only a hint:
+	// it may change as soon as it is read.
+	unsigned GetIdleWorkerCount()const;
+
+	///<summary>
+	/// Queues task and returns a future for its result.  An exception thrown by the
+	/// task is rethrown by the future's get().
+	///</summary>
+	template<typename F>
+	std::future<std::invoke_result_t<std::decay_t<F>>> Submit(F&& task)
+	{
+		using R = std::invoke_result_t<std::decay_t<F>>;
+
+		// std::function needs a copyable target, so share the packaged task.
+		auto packaged = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+		std::future<R> result = packaged->get_future();
+		Enqueue([packaged]() { (*packaged)(); });
+
+		return result;
+	}
+
+	///<summary>
+	/// Calls body(i) for every i in [0, count) on the workers and the calling thread
+	/// and returns when all calls are done.  The first exception thrown by body is
+	/// rethrown after the running calls finish.  May be called from a pool task.
+	///</summary>
+	void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+private:
+	void Enqueue(std::function<void()> task);
+	void WorkerLoop();
+
+	std::vector<std::thread> mWorkers;
+	std::deque<std::function<void()>> mTasks;
+	mutable std::mutex mMutex;
+	std::condition_variable mTaskAvailable;
+	unsigned mWaitingCount = 0;
+	bool mStopping = false;
+};
@@ -0,0 +1,145 @@
+//***************************************************************************************
+// TransformStore.cpp
+//***************************************************************************************
+
+#include "TransformStore.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Stores v to 16-byte aligned dst without pulling the line into the cache.
+	inline void StreamFloat4(float* dst, FXMVECTOR v)
+	{
+#if defined(_XM_SSE_INTRINSICS_) && !defined(_XM_NO_INTRINSICS_)
+		_mm_stream_ps(dst, v);
+#else
+		XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(dst), v);
+#endif
+	}
+}
+
+void TransformStore::Resize(UINT count)
+{
+	Block identity = {};
+	for(int lane = 0; lane < 4; ++lane)
+	{
+		identity.Elements[0][lane] = 1.0f;
+		identity.Elements[5][lane] = 1.0f;
+		identity.Elements[10][lane] = 1.0f;
+		identity.Elements[15][lane] = 1.0f;
+	}
+
+	const UINT oldCount = mCount;
+	mBlocks.resize((count + 3) / 4, identity);
+	mCount = count;
+
+	// The lanes of the old last block past the old count may still hold matrices
+	// from before a shrink.
+	for(UINT i = oldCount; i < count && i % 4 != 0; ++i)
+		Set(i, MathHelper::Identity4x4());
+}
+
+void TransformStore::Set(UINT i, const XMFLOAT4X4& m)
+{
+	assert(i < mCount);
+
+	Block& block = mBlocks[i / 4];
+	UINT lane = i % 4;
+	for(int j = 0; j < 16; ++j)
+		block.Elements[j][lane] = m.m[j / 4][j % 4];
+}
+
+void TransformStore::Set(UINT i, FXMMATRIX m)
+{
+	XMFLOAT4X4 m4x4;
+	XMStoreFloat4x4(&m4x4, m);
+	Set(i, m4x4);
+}
+
+XMMATRIX TransformStore::Get(UINT i)const
+{
+	assert(i < mCount);
+
+	const Block& block = mBlocks[i / 4];
+	UINT lane = i % 4;
+
+	XMFLOAT4X4 m;
+	for(int j = 0; j < 16; ++j)
+		m.m[j / 4][j % 4] = block.Elements[j][lane];
+
+	return XMLoadFloat4x4(&m);
+}
+
+void TransformStore::StreamTransposed(UINT first, UINT count, void* dst, UINT dstStride)const
+{
+	assert((UINT64)first + count <= mCount);
+	assert(reinterpret_cast<uintptr_t>(dst) % 16 == 0 && dstStride % 16 == 0);
+
+	BYTE* out = static_cast<BYTE*>(dst);
+	const UINT end = first + count;
+
+	UINT i = first;
+	while(i < end)
+	{
+		const Block& block = mBlocks[i / 4];
+		const UINT lane = i % 4;
+		const UINT laneEnd = end - i < 4 - lane ? lane + (end - i) : 4;
+
+		// Row r of a transposed matrix is column r of the matrix: elements r, 4 + r,
+		// 8 + r and 12 + r.  Transposing those four vectors of the block gives row r
+		// of all four transposed matrices at once, matrix k in rows[r].r[k].
+		XMMATRIX rows[4];
+		for(int r = 0; r < 4; ++r)
+		{
+			rows[r] = XMMatrixTranspose(XMMATRIX(
+				XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(block.Elements[r])),
+				XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(block.Elements[4 + r])),
+				XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(block.Elements[8 + r])),
+				XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(block.Elements[12 + r]))));
+		}
+
+		for(UINT k = lane; k < laneEnd; ++k, out += dstStride)
+		{
+			float* m = reinterpret_cast<float*>(out);
+			StreamFloat4(m, rows[0].r[k]);
+			StreamFloat4(m + 4, rows[1].r[k]);
+			StreamFloat4(m + 8, rows[2].r[k]);
+			StreamFloat4(m + 12, rows[3].r[k]);
+		}
+
+		i += laneEnd - lane;
+	}
+
+#if defined(_XM_SSE_INTRINSICS_) && !defined(_XM_NO_INTRINSICS_)
+	// Make the streamed stores visible before the GPU is told to read them.
+	_mm_sfence();
+#endif
+}
+
+void TransformStore::StreamVectors(const XMFLOAT4A* src, UINT vectorCount, UINT count, void* dst, UINT dstStride)
+{
+	assert(reinterpret_cast<uintptr_t>(dst) % 16 == 0 && dstStride % 64 == 0);
+
+	// Vectors written per element, up to the end of the line the last one is in.
+	const UINT lineOffset = (UINT)(reinterpret_cast<uintptr_t>(dst) % 64 / 16);
+	const UINT paddedCount = ((lineOffset + vectorCount + 3) & ~3u) - lineOffset;
+	assert(paddedCount*16 <= dstStride);
+
+	BYTE* out = static_cast<BYTE*>(dst);
+	const XMVECTOR zero = XMVectorZero();
+	for(UINT i = 0; i < count; ++i, src += vectorCount, out += dstStride)
+	{
+		float* v = reinterpret_cast<float*>(out);
+
+		UINT j = 0;
+		for(; j < vectorCount; ++j)
+			StreamFloat4(v + 4*j, XMLoadFloat4A(src + j));
+		for(; j < paddedCount; ++j)
+			StreamFloat4(v + 4*j, zero);
+	}
+
+#if defined(_XM_SSE_INTRINSICS_) && !defined(_XM_NO_INTRINSICS_)
+	_mm_sfence();
+#endif
+}
@@ -0,0 +1,61 @@
+//***************************************************************************************
+// TransformStore.h
+//
+// Matrices for many objects kept in blocks of four, structure-of-arrays within a block:
+// each of the 16 elements holds the four objects' values side by side.  Loading the
+// four values of an element is then a single vector load, and transposing four
+// matrices, as the shaders' constants need them, is four 4x4 shuffles.
+//
+// StreamTransposed writes whole runs of transposed matrices straight into mapped
+// upload memory with non-temporal stores, and StreamVectors the per-object constants
+// that go with them.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+
+class TransformStore
+{
+public:
+	TransformStore() = default;
+	TransformStore(const TransformStore& rhs) = delete;
+	TransformStore& operator=(const TransformStore& rhs) = delete;
+
+	// Resizes to count matrices.  New matrices are the identity.
+	void Resize(UINT count);
+
+	UINT GetCount()const { return mCount; }
+
+	void Set(UINT i, const DirectX::XMFLOAT4X4& m);
+	void Set(UINT i, DirectX::FXMMATRIX m);
+	DirectX::XMMATRIX Get(UINT i)const;
+
+	///<summary>
+	/// Writes the transposes of matrices [first, first + count) to dst, one every
+	/// dstStride bytes.  dst and dstStride must be multiples of 16.  The stores bypass
+	/// the cache, so dst should be write-combined memory, such as a mapped upload
+	/// buffer, that is not read back on the CPU.
+	///</summary>
+	void StreamTransposed(UINT first, UINT count, void* dst, UINT dstStride)const;
+
+	///<summary>
+	/// Writes count elements of vectorCount vectors each from src to dst, one element
+	/// every dstStride bytes, with the same stores as StreamTransposed.  dst must be a
+	/// multiple of 16 and dstStride a multiple of 64.  Each element is padded with zero
+	/// vectors to the end of its 64-byte line, since partly written lines are flushed
+	/// piecemeal; the padding must be free in the destination.
+	///</summary>
+	static void StreamVectors(const DirectX::XMFLOAT4A* src, UINT vectorCount, UINT count, void* dst,
+		UINT dstStride);
+
+private:
+	struct Block
+	{
+		// Elements[row*4 + column][lane] is that element of matrix 4*block + lane.
+		alignas(16) float Elements[16][4];
+	};
+
+	std::vector<Block> mBlocks;
+	UINT mCount = 0;
+};
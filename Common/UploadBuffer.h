@@ -55,6 +55,19 @@ public:
         memcpy(&mMappedData[elementIndex*mElementByteSize], &data, sizeof(T));
     }
 
+    // Mapped memory of the first element, for writers that fill many elements at once.
+    // It is write-combined: write it sequentially and never read it back.
+    BYTE* GetMappedData()const
+    {
+        return mMappedData;
+    }
+
+    // Distance between elements in the mapped memory.
+    UINT GetElementByteSize()const
+    {
+        return mElementByteSize;
+    }
+
 private:
     Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
     BYTE* mMappedData = nullptr;
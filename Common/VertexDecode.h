@@ -0,0 +1,18 @@
+//***************************************************************************************
+// VertexDecode.h
+//
+// Per-submesh constants that restore quantized vertex positions.  Kept apart from
+// MeshQuantizer, which computes them, so d3dUtil.h can hold them in SubmeshGeometry
+// without including the quantizer.
+//***************************************************************************************
+
+#pragma once
+
+#include <DirectXMath.h>
+
+// Restores a packed position: p = Bias + Scale*unorm(Position).
+struct VertexDecode
+{
+	DirectX::XMFLOAT3 Scale = { 1.0f, 1.0f, 1.0f };
+	DirectX::XMFLOAT3 Bias = { 0.0f, 0.0f, 0.0f };
+};
@@ -28,6 +28,8 @@
 #include "d3dx12.h"
 #include "DDSTextureLoader.h"
 #include "MathHelper.h"
+#include "MeshCluster.h"
+#include "VertexDecode.h"
 
 extern const int gNumFrameResources;
 
@@ -152,9 +154,29 @@ struct SubmeshGeometry
 	UINT StartIndexLocation = 0;
 	INT BaseVertexLocation = 0;
 
-    // Bounding box of the geometry defined by this submesh. 
-    // This is used in later chapters of the book.
+	// Index size of this submesh.  StartIndexLocation counts indices of this size
+	// from the start of the index buffer, see MeshGeometry::IndexBufferView.
+	DXGI_FORMAT IndexFormat = DXGI_FORMAT_R16_UINT;
+
+    // Object space bounds of the vertices this submesh draws from.  Filled in by
+    // MeshBuilder; levels of detail share the bounds of their full detail submesh.
 	DirectX::BoundingBox Bounds;
+	DirectX::BoundingSphere Sphere;
+
+	// Optional clusters covering [StartIndexLocation, StartIndexLocation + IndexCount),
+	// built with MeshOptimizer::BuildClusters.
+	std::vector<MeshCluster> Clusters;
+
+	// Geometric error of this submesh relative to the full detail mesh, in object
+	// space units.  Zero for meshes that were not simplified.
+	float LodError = 0.0f;
+
+	// Coarser levels of detail, finest first.  They are other entries of the same
+	// MeshGeometry::DrawArgs, which never moves its elements.
+	std::vector<const SubmeshGeometry*> Lods;
+
+	// Decode constants of the submesh's PackedVertex positions.
+	VertexDecode Decode;
 };
 
 struct MeshGeometry
@@ -179,6 +201,15 @@ struct MeshGeometry
 	DXGI_FORMAT IndexFormat = DXGI_FORMAT_R16_UINT;
 	UINT IndexBufferByteSize = 0;
 
+	// Set when the GPU buffers are arenas shared with other geometries, see
+	// GeometryRegistry.  The geometry's data starts at these offsets, which are added
+	// to the submesh locations when drawing, and the views cover the whole arenas so
+	// every geometry in the same arenas binds the same buffers.
+	INT BaseVertexLocation = 0;
+	UINT IndexByteOffset = 0;
+	UINT SharedVertexBufferByteSize = 0;
+	UINT SharedIndexBufferByteSize = 0;
+
 	// A MeshGeometry may store multiple geometries in one vertex/index buffer.
 	// Use this container to define the Submesh geometries so we can draw
 	// the Submeshes individually.
@@ -189,7 +220,7 @@ struct MeshGeometry
 		D3D12_VERTEX_BUFFER_VIEW vbv;
 		vbv.BufferLocation = VertexBufferGPU->GetGPUVirtualAddress();
 		vbv.StrideInBytes = VertexByteStride;
-		vbv.SizeInBytes = VertexBufferByteSize;
+		vbv.SizeInBytes = SharedVertexBufferByteSize != 0 ? SharedVertexBufferByteSize : VertexBufferByteSize;
 
 		return vbv;
 	}
@@ -199,11 +230,33 @@ struct MeshGeometry
 		D3D12_INDEX_BUFFER_VIEW ibv;
 		ibv.BufferLocation = IndexBufferGPU->GetGPUVirtualAddress();
 		ibv.Format = IndexFormat;
-		ibv.SizeInBytes = IndexBufferByteSize;
+		ibv.SizeInBytes = SharedIndexBufferByteSize != 0 ? SharedIndexBufferByteSize : IndexBufferByteSize;
 
 		return ibv;
 	}
 
+	// View of the whole index buffer as indices of the given format, for buffers
+	// whose submeshes mix 16-bit and 32-bit indices.
+	D3D12_INDEX_BUFFER_VIEW IndexBufferView(DXGI_FORMAT format)const
+	{
+		UINT indexSize = format == DXGI_FORMAT_R32_UINT ? 4 : 2;
+		UINT byteSize = SharedIndexBufferByteSize != 0 ? SharedIndexBufferByteSize : IndexBufferByteSize;
+
+		D3D12_INDEX_BUFFER_VIEW ibv;
+		ibv.BufferLocation = IndexBufferGPU->GetGPUVirtualAddress();
+		ibv.Format = format;
+		ibv.SizeInBytes = byteSize / indexSize * indexSize;
+
+		return ibv;
+	}
+
+	// Location of the first index of a submesh with the given index format, for
+	// DrawIndexedInstanced.
+	UINT GetStartIndexLocation(DXGI_FORMAT format, UINT startIndexLocation)const
+	{
+		return IndexByteOffset / (format == DXGI_FORMAT_R32_UINT ? 4 : 2) + startIndexLocation;
+	}
+
 	// We can free this memory after we finish upload to the GPU.
 	void DisposeUploaders()
 	{
@@ -250,11 +303,8 @@ struct Material
 	// Index into SRV heap for normal texture.
 	int NormalSrvHeapIndex = -1;
 
-	// Dirty flag indicating the material has changed and we need to update the constant buffer.
-	// Because we have a material constant buffer for each FrameResource, we have to apply the
-	// update to each FrameResource.  Thus, when we modify a material we should set 
-	// NumFramesDirty = gNumFrameResources so that each frame resource gets the update.
-	int NumFramesDirty = gNumFrameResources;
+	// Which frame resources still need a changed material's constants is tracked by
+	// the application, by MatCBIndex; see DirtyTracker.
 
 	// Material constant buffer data used for shading.
 	DirectX::XMFLOAT4 DiffuseAlbedo = { 1.0f, 1.0f, 1.0f, 1.0f };
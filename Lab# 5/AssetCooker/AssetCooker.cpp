@@ -0,0 +1,353 @@
+//***************************************************************************************
+// AssetCooker.cpp
+//
+// Command line tool that cooks the source assets of a directory into the files the
+// demos load at run time:
+//
+//   AssetCooker [-force] <source directory> [<output directory>]
+//
+// Models (*.txt) are processed by ModelCooker and saved as compressed MeshCache
+// files (*.mesh); scene layouts (*.scene) are compiled by SceneFile (*.scn).  The
+// output directory keeps a manifest, cook.manifest, with a hash of every source's
+// contents and of the versions of the processing and file format it was cooked with.
+// Assets whose hash is unchanged and whose output exists are skipped; the rest are
+// cooked in parallel on a ThreadPool.  Each cooked model's line shows its vertex cache
+// statistics before and after optimization.
+//***************************************************************************************
+
+#include "../../Common/MappedFile.h"
+#include "../../Common/MeshCache.h"
+#include "../../Common/ModelCooker.h"
+#include "../../Common/SceneFile.h"
+#include "../../Common/ThreadPool.h"
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+#pragma comment(lib, "d3dcompiler.lib")
+
+namespace
+{
+	const wchar_t kManifestName[] = L"cook.manifest";
+
+	// Cooks source into output.  Returns false if output cannot be written and throws,
+	// with the reason, if source cannot be read or cooked.  notes receives anything
+	// worth printing about the result.
+	using CookFn = bool (*)(const std::wstring& source, const std::wstring& output, ThreadPool& pool,
+		std::wstring& notes);
+
+	// How the assets with one source extension are cooked.
+	struct AssetType
+	{
+		const wchar_t* SourceExtension;
+		const wchar_t* OutputExtension;
+
+		// Mixed into the hash of every source, so assets are recooked when either changes.
+		std::uint32_t (*GetProcessingVersion)();
+		std::uint32_t (*GetFormatVersion)();
+
+		CookFn Cook;
+	};
+
+	struct Asset
+	{
+		std::wstring Name;
+		const AssetType* Type = nullptr;
+	};
+
+	// The result of one asset, written back to the manifest.
+	struct Result
+	{
+		std::uint64_t Hash = 0;
+		bool Cooked = false;
+		bool Failed = false;
+	};
+
+	std::string ToUtf8(const std::wstring& s)
+	{
+		if(s.empty())
+			return std::string();
+
+		int size = WideCharToMultiByte(CP_UTF8, 0, s.data(), (int)s.size(), nullptr, 0, nullptr, nullptr);
+		std::string utf8(size, '\0');
+		WideCharToMultiByte(CP_UTF8, 0, s.data(), (int)s.size(), &utf8[0], size, nullptr, nullptr);
+		return utf8;
+	}
+
+	std::wstring FromUtf8(const std::string& s)
+	{
+		if(s.empty())
+			return std::wstring();
+
+		int size = MultiByteToWideChar(CP_UTF8, 0, s.data(), (int)s.size(), nullptr, 0);
+		std::wstring wide(size, L'\0');
+		MultiByteToWideChar(CP_UTF8, 0, s.data(), (int)s.size(), &wide[0], size);
+		return wide;
+	}
+
+	std::wstring ReplaceExtension(const std::wstring& name, const wchar_t* extension)
+	{
+		return name.substr(0, name.rfind(L'.')) + extension;
+	}
+
+	bool FileExists(const std::wstring& path)
+	{
+		DWORD attributes = GetFileAttributesW(path.c_str());
+		return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) == 0;
+	}
+
+	// 64-bit FNV-1a.
+	const std::uint64_t kHashSeed = 0xcbf29ce484222325ull;
+
+	std::uint64_t Hash(std::uint64_t hash, const void* data, size_t byteSize)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for(size_t i = 0; i < byteSize; ++i)
+			hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+
+		return hash;
+	}
+
+	// Hash of a source's contents and the versions it is cooked with.
+	bool HashSource(const std::wstring& path, const AssetType& type, std::uint64_t& hash)
+	{
+		MappedFile file;
+		if(!file.Open(path))
+			return false;
+
+		std::uint32_t versions[2] = { type.GetProcessingVersion(), type.GetFormatVersion() };
+		hash = Hash(kHashSeed, versions, sizeof(versions));
+		hash = Hash(hash, file.GetData(), file.GetSize());
+		return true;
+	}
+
+	bool CookModel(const std::wstring& source, const std::wstring& output, ThreadPool& pool, std::wstring& notes)
+	{
+		// Models/foo.txt becomes submesh "foo" of geometry "fooGeo".
+		size_t slash = source.find_last_of(L"\\/");
+		std::string name = ToUtf8(ReplaceExtension(source.substr(slash == std::wstring::npos ? 0 : slash + 1), L""));
+
+		MeshOptimizer::OptimizeStats stats;
+		std::unique_ptr<MeshGeometry> geo = ModelCooker::CookModel(source, name + "Geo", name, &pool, &stats);
+		if(geo == nullptr)
+			throw std::runtime_error("cannot open the source");
+
+		wchar_t buffer[128];
+		swprintf_s(buffer, L"ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+			stats.Before.ACMR, stats.After.ACMR, stats.Before.ATVR, stats.After.ATVR);
+		notes = buffer;
+
+		return MeshCache::Save(output, source, *geo, MeshCache::Encoding::Compressed);
+	}
+
+	std::uint32_t GetModelCookerVersion() { return ModelCooker::Version; }
+
+	bool CompileScene(const std::wstring& source, const std::wstring& output, ThreadPool& pool, std::wstring& notes)
+	{
+		return SceneFile::Compile(source, output);
+	}
+
+	// The scene file version covers its source syntax as well as its layout.
+	const AssetType kAssetTypes[] =
+	{
+		{ L".txt", L".mesh", GetModelCookerVersion, MeshCache::GetVersion, CookModel },
+		{ L".scene", L".scn", SceneFile::GetVersion, SceneFile::GetVersion, CompileScene },
+	};
+
+	// Source name to hash of the last successful cook.
+	using Manifest = std::map<std::wstring, std::uint64_t>;
+
+	// One line per asset: the hash in hexadecimal, a space and the source name.
+	Manifest ReadManifest(const std::wstring& path)
+	{
+		Manifest manifest;
+
+		std::ifstream fin(path);
+		std::string line;
+		while(std::getline(fin, line))
+		{
+			size_t space = line.find(' ');
+			if(space == std::string::npos)
+				continue;
+
+			manifest[FromUtf8(line.substr(space + 1))] = std::strtoull(line.substr(0, space).c_str(), nullptr, 16);
+		}
+
+		return manifest;
+	}
+
+	// Replaces the manifest atomically, so an interrupted cook leaves the old one.
+	bool WriteManifest(const std::wstring& path, const Manifest& manifest)
+	{
+		std::wstring tempFile = path + L".tmp";
+		{
+			std::ofstream fout(tempFile, std::ios::trunc);
+			for(auto& e : manifest)
+			{
+				char hash[17];
+				sprintf_s(hash, "%016llx", (unsigned long long)e.second);
+				fout << hash << ' ' << ToUtf8(e.first) << '\n';
+			}
+
+			if(!fout)
+			{
+				fout.close();
+				DeleteFileW(tempFile.c_str());
+				return false;
+			}
+		}
+
+		return MoveFileExW(tempFile.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+	}
+
+	std::vector<Asset> FindAssets(const std::wstring& sourceDir)
+	{
+		std::vector<Asset> assets;
+		for(const AssetType& type : kAssetTypes)
+		{
+			WIN32_FIND_DATAW data;
+			HANDLE find = FindFirstFileW((sourceDir + L"\\*" + type.SourceExtension).c_str(), &data);
+			if(find == INVALID_HANDLE_VALUE)
+				continue;
+
+			do
+			{
+				if((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+					assets.push_back({ data.cFileName, &type });
+			}
+			while(FindNextFileW(find, &data));
+
+			FindClose(find);
+		}
+
+		return assets;
+	}
+
+	int PrintUsage()
+	{
+		wprintf(L"usage: AssetCooker [-force] <source directory> [<output directory>]\n");
+		return 2;
+	}
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+	bool force = false;
+	std::vector<std::wstring> dirs;
+	for(int i = 1; i < argc; ++i)
+	{
+		std::wstring arg = argv[i];
+		if(arg == L"-force")
+			force = true;
+		else if(arg[0] == L'-')
+			return PrintUsage();
+		else
+			dirs.push_back(arg);
+	}
+
+	if(dirs.empty() || dirs.size() > 2)
+		return PrintUsage();
+
+	const std::wstring& sourceDir = dirs.front();
+	const std::wstring& outputDir = dirs.back();
+	if(!CreateDirectoryW(outputDir.c_str(), nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+	{
+		wprintf(L"error: cannot create %ls\n", outputDir.c_str());
+		return 1;
+	}
+
+	std::vector<Asset> assets = FindAssets(sourceDir);
+	const std::wstring manifestFile = outputDir + L"\\" + kManifestName;
+	const Manifest manifest = force ? Manifest() : ReadManifest(manifestFile);
+
+	//
+	// Hash every source and cook the ones that changed.  Each asset is a task; the
+	// cookers spread their own work over the same pool.
+	//
+
+	ThreadPool pool;
+	std::vector<Result> results(assets.size());
+	std::mutex printMutex;
+
+	pool.ParallelFor(assets.size(), [&](size_t i)
+	{
+		const Asset& asset = assets[i];
+		Result& result = results[i];
+
+		std::wstring source = sourceDir + L"\\" + asset.Name;
+		std::wstring output = outputDir + L"\\" + ReplaceExtension(asset.Name, asset.Type->OutputExtension);
+
+		auto start = std::chrono::steady_clock::now();
+		std::wstring error;
+		std::wstring notes;
+		try
+		{
+			if(!HashSource(source, *asset.Type, result.Hash))
+			{
+				error = L"cannot read the source";
+			}
+			else
+			{
+				auto entry = manifest.find(asset.Name);
+				if(entry != manifest.end() && entry->second == result.Hash && FileExists(output))
+					return;
+
+				result.Cooked = asset.Type->Cook(source, output, pool, notes);
+				if(!result.Cooked)
+					error = L"cannot write " + output;
+			}
+		}
+		catch(const DxException& e)
+		{
+			error = e.ToString();
+		}
+		catch(const std::exception& e)
+		{
+			error = FromUtf8(e.what());
+		}
+
+		result.Failed = !error.empty();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		std::lock_guard<std::mutex> lock(printMutex);
+		if(result.Failed)
+			wprintf(L"%ls: error: %ls\n", asset.Name.c_str(), error.c_str());
+		else if(notes.empty())
+			wprintf(L"%ls -> %ls (%.0f ms)\n", asset.Name.c_str(), output.c_str(), ms);
+		else
+			wprintf(L"%ls -> %ls (%.0f ms; %ls)\n", asset.Name.c_str(), output.c_str(), ms, notes.c_str());
+	});
+
+	//
+	// Sources that failed keep no entry, so they are retried next time; sources that
+	// were removed drop out.
+	//
+
+	Manifest cooked;
+	size_t cookedCount = 0;
+	size_t failedCount = 0;
+	for(size_t i = 0; i < assets.size(); ++i)
+	{
+		if(results[i].Failed)
+		{
+			++failedCount;
+			continue;
+		}
+
+		cookedCount += results[i].Cooked ? 1 : 0;
+		cooked[assets[i].Name] = results[i].Hash;
+	}
+
+	if(!WriteManifest(manifestFile, cooked))
+	{
+		wprintf(L"error: cannot write %ls\n", manifestFile.c_str());
+		return 1;
+	}
+
+	wprintf(L"%zu cooked, %zu up to date, %zu failed\n", cookedCount,
+		assets.size() - cookedCount - failedCount, failedCount);
+
+	return failedCount == 0 ? 0 : 1;
+}
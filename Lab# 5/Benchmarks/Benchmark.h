@@ -0,0 +1,66 @@
+//***************************************************************************************
+// Benchmark.h
+//
+// Shared pieces of the benchmark suites: wall clock timing, a sink that keeps results
+// alive, a check that two loaders agree, and the table of suites BenchmarkMain runs.
+//***************************************************************************************
+
+#pragma once
+
+#include "../../Common/d3dUtil.h"
+#include "../../Common/ModelReader.h"
+#include <chrono>
+#include <cstdio>
+
+struct BenchmarkContext
+{
+	// Where the source models (skull.txt, car.txt) are, with a trailing separator.
+	std::wstring ModelDirectory;
+};
+
+struct BenchmarkSuite
+{
+	const char* Name;
+	void (*Run)(const BenchmarkContext& context);
+};
+
+// Every result a suite computes is folded into this, so the optimizer cannot discard
+// the work being timed.
+extern volatile std::uint64_t gBenchmarkSink;
+
+///<summary>
+/// Calls fn repetitions times and returns the fastest call in milliseconds.  The
+/// fastest, rather than the mean, is the least disturbed by the rest of the machine.
+///</summary>
+template<typename Fn>
+double MeasureBestMs(int repetitions, Fn&& fn)
+{
+	double best = 1e30;
+	for(int i = 0; i < repetitions; ++i)
+	{
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		auto stop = std::chrono::steady_clock::now();
+
+		best = std::min(best, std::chrono::duration<double, std::milli>(stop - start).count());
+	}
+
+	return best;
+}
+
+// True if both models have the same indices and bit for bit the same vertices.
+inline bool SameModel(const ModelReader::Model& a, const ModelReader::Model& b)
+{
+	return a.Indices == b.Indices && a.Vertices.size() == b.Vertices.size() &&
+		memcmp(a.Vertices.data(), b.Vertices.data(), a.Vertices.size()*sizeof(ModelReader::Vertex)) == 0;
+}
+
+// The suites, defined one per file.
+void RunSubdivideBenchmark(const BenchmarkContext& context);
+void RunModelLoadBenchmark(const BenchmarkContext& context);
+void RunModelParseBenchmark(const BenchmarkContext& context);
+void RunMeshCodecBenchmark(const BenchmarkContext& context);
+void RunTransformBenchmark(const BenchmarkContext& context);
+void RunFrustumCullBenchmark(const BenchmarkContext& context);
+void RunMeshNormalsBenchmark(const BenchmarkContext& context);
+void RunSceneFileBenchmark(const BenchmarkContext& context);
@@ -0,0 +1,90 @@
+//***************************************************************************************
+// BenchmarkMain.cpp
+//
+// Command line runner for the CPU-side benchmarks of the Common code:
+//
+//   Benchmarks [-models <directory>] [<suite> ...]
+//
+// Runs the named suites, or all of them, and prints their timings.  The models
+// directory defaults to the demo's, relative to this project's directory.  Build and
+// run the Release configuration; Debug timings say nothing.
+//***************************************************************************************
+
+#include "Benchmark.h"
+
+#pragma comment(lib, "d3dcompiler.lib")
+
+volatile std::uint64_t gBenchmarkSink = 0;
+
+namespace
+{
+	const BenchmarkSuite kSuites[] =
+	{
+		{ "subdivide", RunSubdivideBenchmark },
+		{ "modelload", RunModelLoadBenchmark },
+		{ "modelparse", RunModelParseBenchmark },
+		{ "meshcodec", RunMeshCodecBenchmark },
+		{ "transforms", RunTransformBenchmark },
+		{ "frustumcull", RunFrustumCullBenchmark },
+		{ "meshnormals", RunMeshNormalsBenchmark },
+		{ "scenefile", RunSceneFileBenchmark },
+	};
+
+	int PrintUsage()
+	{
+		wprintf(L"usage: Benchmarks [-models <directory>] [<suite> ...]\nsuites:");
+		for(const BenchmarkSuite& suite : kSuites)
+			wprintf(L" %hs", suite.Name);
+		wprintf(L"\n");
+		return 2;
+	}
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+	BenchmarkContext context;
+	context.ModelDirectory = L"..\\Project\\Models\\";
+
+	std::vector<const BenchmarkSuite*> selected;
+	for(int i = 1; i < argc; ++i)
+	{
+		std::wstring arg = argv[i];
+		if(arg == L"-models" && i + 1 < argc)
+		{
+			context.ModelDirectory = argv[++i];
+			if(context.ModelDirectory.back() != L'\\' && context.ModelDirectory.back() != L'/')
+				context.ModelDirectory += L'\\';
+			continue;
+		}
+
+		auto suite = std::find_if(std::begin(kSuites), std::end(kSuites),
+			[&](const BenchmarkSuite& s) { return arg == std::wstring(s.Name, s.Name + strlen(s.Name)); });
+		if(suite == std::end(kSuites))
+			return PrintUsage();
+
+		selected.push_back(suite);
+	}
+
+	if(selected.empty())
+	{
+		for(const BenchmarkSuite& suite : kSuites)
+			selected.push_back(&suite);
+	}
+
+	for(const BenchmarkSuite* suite : selected)
+	{
+		wprintf(L"== %hs ==\n", suite->Name);
+		try
+		{
+			suite->Run(context);
+		}
+		catch(const std::exception& e)
+		{
+			wprintf(L"error: %hs\n", e.what());
+			return 1;
+		}
+		wprintf(L"\n");
+	}
+
+	return 0;
+}
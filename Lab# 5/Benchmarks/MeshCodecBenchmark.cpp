@@ -0,0 +1,61 @@
+//***************************************************************************************
+// MeshCodecBenchmark.cpp
+//
+// How much MeshCodec shrinks the cooked skull and car, and how fast it encodes and
+// decodes them.  The packed size is what a cache stores without the codec; decode
+// throughput is in megabytes of packed vertex and index data per second.
+//***************************************************************************************
+
+#include "Benchmark.h"
+#include "../../Common/MeshCache.h"
+#include "../../Common/MeshCodec.h"
+#include "../../Common/ModelCooker.h"
+
+void RunMeshCodecBenchmark(const BenchmarkContext& context)
+{
+	const wchar_t* files[] = { L"skull.txt", L"car.txt" };
+
+	wprintf(L"model        KB packed   KB encoded   ratio   ms encode   ms decode   MB/s decode\n");
+	for(const wchar_t* file : files)
+	{
+		const std::wstring filename = context.ModelDirectory + file;
+		const std::wstring stem(file, wcschr(file, L'.'));
+		const std::string name(stem.begin(), stem.end());
+
+		std::unique_ptr<MeshGeometry> geo = ModelCooker::CookModel(filename, name + "Geo", name);
+		if(geo == nullptr)
+			throw std::runtime_error("cannot cook " + std::string(filename.begin(), filename.end()));
+
+		const void* vertices = geo->VertexBufferCPU->GetBufferPointer();
+		const void* indices = geo->IndexBufferCPU->GetBufferPointer();
+		const size_t vertexCount = geo->VertexBufferByteSize / geo->VertexByteStride;
+		const size_t packedByteSize = (size_t)geo->VertexBufferByteSize + geo->IndexBufferByteSize;
+		const std::vector<MeshCodec::IndexRange> ranges = MeshCache::GetIndexRanges(*geo);
+
+		std::vector<MeshCodec::uint8> data;
+		double encodeMs = MeasureBestMs(10, [&]()
+		{
+			data.clear();
+			MeshCodec::Encode(vertices, vertexCount, geo->VertexByteStride,
+				indices, geo->IndexBufferByteSize, ranges, data);
+		});
+
+		std::vector<MeshCodec::uint8> decodedVertices(geo->VertexBufferByteSize);
+		std::vector<MeshCodec::uint8> decodedIndices(geo->IndexBufferByteSize);
+		double decodeMs = MeasureBestMs(10, [&]()
+		{
+			if(!MeshCodec::Decode(decodedVertices.data(), vertexCount, geo->VertexByteStride,
+				decodedIndices.data(), decodedIndices.size(), ranges, data.data(), data.size()))
+				throw std::runtime_error("MeshCodec cannot decode its own encoding of " + name);
+		});
+
+		if(memcmp(decodedVertices.data(), vertices, decodedVertices.size()) != 0 ||
+			memcmp(decodedIndices.data(), indices, decodedIndices.size()) != 0)
+			throw std::runtime_error("MeshCodec does not round trip " + name);
+
+		gBenchmarkSink += data.size() + decodedVertices[0] + decodedIndices[0];
+		wprintf(L"%-12ls %10.1f %12.1f %7.2f %11.3f %11.3f %13.0f\n", file, packedByteSize / 1024.0,
+			data.size() / 1024.0, (double)packedByteSize / data.size(), encodeMs, decodeMs,
+			packedByteSize / (1024.0*1024.0) / (decodeMs / 1000.0));
+	}
+}
@@ -0,0 +1,94 @@
+//***************************************************************************************
+// MeshNormalsBenchmark.cpp
+//
+// Scaling of MeshNormals::GenerateNormalsAndTangents with the thread count on a
+// terraced grid of about a million vertices and two million triangles, smoothed and
+// with a crease angle and smoothing groups.  The creased mesh is split once before
+// timing; regenerating it again resolves every crease but adds no vertices, so each
+// repetition does the same work.  Every thread count must produce exactly what the
+// calling thread does alone.
+//***************************************************************************************
+
+#include "Benchmark.h"
+#include "../../Common/MeshNormals.h"
+#include "../../Common/ThreadPool.h"
+#include <cstring>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	using MeshData = GeometryGenerator::MeshData;
+	using uint32 = MeshNormals::uint32;
+
+	// Vertices along each side of the grid.
+	const uint32 kGridSize = 1025;
+
+	// Terraces, whose risers meet the treads at creases, and random smoothing groups.
+	MeshData MakeTerrain(std::vector<uint32>& groups)
+	{
+		GeometryGenerator geoGen;
+		MeshData terrain = geoGen.CreateGrid(400.0f, 400.0f, kGridSize, kGridSize);
+		for(GeometryGenerator::Vertex& v : terrain.Vertices)
+		{
+			float height = 4.0f*sinf(0.11f*v.Position.x)*cosf(0.07f*v.Position.z);
+			v.Position.y = 0.5f*floorf(2.0f*height) + 0.1f*height;
+		}
+
+		std::mt19937 random(3);
+		groups.resize(terrain.Indices32.size() / 3);
+		for(uint32& group : groups)
+			group = random() % 8 == 0 ? 0 : 1u << (random() % 3);
+
+		return terrain;
+	}
+
+	bool SameMesh(const MeshData& a, const MeshData& b)
+	{
+		return a.Indices32 == b.Indices32 && a.Vertices.size() == b.Vertices.size() &&
+			memcmp(a.Vertices.data(), b.Vertices.data(), a.Vertices.size()*sizeof(GeometryGenerator::Vertex)) == 0;
+	}
+
+	void Run(const wchar_t* name, const MeshData& source, const MeshNormals::Options& options)
+	{
+		MeshData reference = source;
+		MeshNormals::GenerateNormalsAndTangents(reference, nullptr, options);
+
+		double sequentialMs = MeasureBestMs(3, [&]() { MeshNormals::GenerateNormalsAndTangents(reference, nullptr, options); });
+		wprintf(L"%-8ls %zu vertices\n", name, reference.Vertices.size());
+		wprintf(L"  no pool  %9.1f ms\n", sequentialMs);
+
+		for(unsigned threads : { 1u, 2u, 4u, 8u })
+		{
+			// The calling thread takes ranges too.
+			ThreadPool pool(threads - 1);
+
+			MeshData mesh = source;
+			MeshNormals::GenerateNormalsAndTangents(mesh, &pool, options);
+			double ms = MeasureBestMs(3, [&]() { MeshNormals::GenerateNormalsAndTangents(mesh, &pool, options); });
+
+			if(!SameMesh(mesh, reference))
+				throw std::runtime_error("MeshNormals results differ between thread counts");
+
+			gBenchmarkSink += mesh.Vertices.size();
+			wprintf(L"  %2u t     %9.1f ms  %5.2fx\n", threads, ms, sequentialMs / ms);
+		}
+	}
+}
+
+void RunMeshNormalsBenchmark(const BenchmarkContext& context)
+{
+	std::vector<uint32> groups;
+	const MeshData terrain = MakeTerrain(groups);
+
+	wprintf(L"%zu vertices, %zu triangles, %u hardware threads\n", terrain.Vertices.size(),
+		terrain.Indices32.size() / 3, std::thread::hardware_concurrency());
+
+	Run(L"smooth", terrain, MeshNormals::Options());
+
+	MeshNormals::Options creased;
+	creased.CreaseAngle = XMConvertToRadians(45.0f);
+	creased.SmoothingGroups = groups.data();
+	Run(L"creased", terrain, creased);
+}
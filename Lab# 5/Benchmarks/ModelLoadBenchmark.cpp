@@ -0,0 +1,79 @@
+//***************************************************************************************
+// ModelLoadBenchmark.cpp
+//
+// Load times of the text models through ModelReader, which maps the file and parses
+// it with from_chars, against the std::ifstream >> loop the demo used to read them
+// with.  Both must produce the same vertices and indices.
+//***************************************************************************************
+
+#include "Benchmark.h"
+#include "../../Common/ModelReader.h"
+
+namespace
+{
+	// The original skull loader, kept as the baseline.
+	bool LegacyLoad(const std::wstring& filename, ModelReader::Model& model)
+	{
+		std::ifstream fin(filename);
+		if(!fin)
+			return false;
+
+		UINT vcount = 0;
+		UINT tcount = 0;
+		std::string ignore;
+
+		fin >> ignore >> vcount;
+		fin >> ignore >> tcount;
+		fin >> ignore >> ignore >> ignore >> ignore;
+
+		model.Vertices.resize(vcount);
+		for(UINT i = 0; i < vcount; ++i)
+		{
+			ModelReader::Vertex& v = model.Vertices[i];
+			fin >> v.Pos.x >> v.Pos.y >> v.Pos.z;
+			fin >> v.Normal.x >> v.Normal.y >> v.Normal.z;
+		}
+
+		fin >> ignore;
+		fin >> ignore;
+		fin >> ignore;
+
+		model.Indices.resize(3 * tcount);
+		for(UINT i = 0; i < tcount; ++i)
+			fin >> model.Indices[i * 3 + 0] >> model.Indices[i * 3 + 1] >> model.Indices[i * 3 + 2];
+
+		return true;
+	}
+}
+
+void RunModelLoadBenchmark(const BenchmarkContext& context)
+{
+	const wchar_t* files[] = { L"skull.txt", L"car.txt" };
+
+	wprintf(L"model          vertices   triangles   ms ifstream   ms mapped   speedup\n");
+	for(const wchar_t* file : files)
+	{
+		const std::wstring filename = context.ModelDirectory + file;
+
+		ModelReader::Model legacy, mapped;
+		double legacyMs = MeasureBestMs(10, [&]()
+		{
+			if(!LegacyLoad(filename, legacy))
+				throw std::runtime_error("cannot open " + std::string(filename.begin(), filename.end()));
+		});
+
+		double mappedMs = MeasureBestMs(10, [&]()
+		{
+			if(!ModelReader::Load(filename, mapped))
+				throw std::runtime_error("cannot open " + std::string(filename.begin(), filename.end()));
+		});
+
+		if(!SameModel(legacy, mapped))
+			throw std::runtime_error("ModelReader and the ifstream loader disagree on " +
+				std::string(filename.begin(), filename.end()));
+
+		gBenchmarkSink += mapped.Vertices.size() + legacy.Indices.size();
+		wprintf(L"%-12ls %10zu %11zu %13.3f %11.3f %8.1fx\n", file, mapped.Vertices.size(),
+			mapped.Indices.size()/3, legacyMs, mappedMs, legacyMs / mappedMs);
+	}
+}
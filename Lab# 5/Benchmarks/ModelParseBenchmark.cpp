@@ -0,0 +1,86 @@
+//***************************************************************************************
+// ModelParseBenchmark.cpp
+//
+// Scaling of ModelReader::ParseParallel with the thread count on a synthetic model of
+// two million vertices and four million triangles (about 200 MB of text), against
+// the sequential ModelReader::Parse, which ModelCooker falls back to while no worker
+// is idle.  Every thread count must produce exactly what Parse does.
+//***************************************************************************************
+
+#include "Benchmark.h"
+#include "../../Common/ModelReader.h"
+#include "../../Common/ThreadPool.h"
+#include <random>
+
+namespace
+{
+	const std::uint32_t kVertexCount = 2000000;
+	const std::uint32_t kTriangleCount = 4000000;
+
+	// Random positions and normals with the six significant digits the exporters
+	// write, one record per line.
+	std::string MakeModelText()
+	{
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+		std::uniform_real_distribution<float> normal(-1.0f, 1.0f);
+		std::uniform_int_distribution<std::uint32_t> index(0, kVertexCount - 1);
+
+		std::string text;
+		text.reserve(210u << 20);
+
+		char line[160];
+		snprintf(line, sizeof(line), "VertexCount: %u\nTriangleCount: %u\nVertexList (pos, normal)\n{\n",
+			kVertexCount, kTriangleCount);
+		text += line;
+
+		for(std::uint32_t i = 0; i < kVertexCount; ++i)
+		{
+			float p[6] = { position(random), position(random), position(random), normal(random), normal(random), normal(random) };
+			snprintf(line, sizeof(line), "\t%.6g %.6g %.6g %.6g %.6g %.6g\n", p[0], p[1], p[2], p[3], p[4], p[5]);
+			text += line;
+		}
+
+		text += "}\nTriangleList\n{\n";
+
+		for(std::uint32_t i = 0; i < kTriangleCount; ++i)
+		{
+			std::uint32_t a = index(random), b = index(random), c = index(random);
+			snprintf(line, sizeof(line), "\t%u %u %u\n", a, b, c);
+			text += line;
+		}
+
+		text += "}\n";
+
+		return text;
+	}
+}
+
+void RunModelParseBenchmark(const BenchmarkContext& context)
+{
+	const std::string text = MakeModelText();
+	const char* first = text.data();
+	const char* last = text.data() + text.size();
+
+	ModelReader::Model reference;
+	double sequentialMs = MeasureBestMs(3, [&]() { reference = ModelReader::Parse(first, last); });
+
+	wprintf(L"%.1f MB, %u vertices, %u triangles, %u hardware threads\n", text.size() / 1048576.0,
+		kVertexCount, kTriangleCount, std::thread::hardware_concurrency());
+	wprintf(L"Parse              %9.1f ms\n", sequentialMs);
+
+	for(unsigned threads : { 1u, 2u, 4u, 8u })
+	{
+		// The calling thread takes chunks too.
+		ThreadPool pool(threads - 1);
+
+		ModelReader::Model model;
+		double ms = MeasureBestMs(3, [&]() { model = ModelReader::ParseParallel(first, last, pool); });
+
+		if(!SameModel(model, reference))
+			throw std::runtime_error("ParseParallel and Parse disagree");
+
+		gBenchmarkSink += model.Vertices.size();
+		wprintf(L"ParseParallel %2u t %9.1f ms  %5.2fx\n", threads, ms, sequentialMs / ms);
+	}
+}
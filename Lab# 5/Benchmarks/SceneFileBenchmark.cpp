@@ -0,0 +1,132 @@
+//***************************************************************************************
+// SceneFileBenchmark.cpp
+//
+// Startup cost of a scene of 10k and 100k pieces: SceneFile::Load of the compiled file,
+// then the work LitColumnsApp::BuildRenderItems does with it before any asset is
+// resolved, which is adding every node to the scene graph, filling in the render items
+// and placing them through the first SceneGraph::Update.  Compiling the source, which
+// the AssetCooker does offline, is timed once for comparison.
+//***************************************************************************************
+
+#include "Benchmark.h"
+#include "../../Common/DirtyTracker.h"
+#include "../../Common/SceneFile.h"
+#include "../../Common/SceneGraph.h"
+#include "../../Common/TransformStore.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const wchar_t kSourceFile[] = L"SceneFileBenchmark.scene";
+	const wchar_t kSceneFile[] = L"SceneFileBenchmark.scn";
+
+	// As many frame resources as LitColumns keeps.
+	const UINT kFrameResourceCount = 3;
+
+	// The fields of RenderItem that BuildRenderItems sets.
+	struct Item
+	{
+		UINT ObjCBIndex = 0;
+		UINT Node = 0;
+		UINT ShapeIndex = 0;
+		UINT MatIndex = 0;
+	};
+
+	// Rows of 100 boxes, each row under a group of its own.
+	void WriteSource(UINT pieceCount)
+	{
+		std::ofstream fout(kSourceFile, std::ios::trunc);
+		fout << "group repeat " << pieceCount / 100 << " 0 0 4 {\n";
+		fout << "\tshapeGeo box wallMat translate 0 1 0 repeat 100 4 0 0\n";
+		fout << "}\n";
+	}
+
+	// BuildRenderItems and the UpdateSceneGraph it ends with, without the device.
+	void BuildItems(const SceneFile& scene)
+	{
+		const SceneFile::Node* nodes = scene.GetNodes();
+		const UINT nodeCount = scene.GetNodeCount();
+
+		UINT itemCount = 0;
+		for(UINT i = 0; i < nodeCount; ++i)
+		{
+			if(nodes[i].Shape != SceneFile::kNone)
+				++itemCount;
+		}
+
+		std::vector<Item> items(itemCount);
+		TransformStore worldTransforms;
+		TransformStore texTransforms;
+		worldTransforms.Resize(itemCount);
+		texTransforms.Resize(itemCount);
+		DirtyTracker objectCBDirty(kFrameResourceCount);
+		objectCBDirty.Resize(itemCount);
+		std::vector<UINT> nodeObjCBIndices(nodeCount, (UINT)-1);
+
+		SceneGraph sceneGraph;
+		UINT objCBIndex = 0;
+		for(UINT i = 0; i < nodeCount; ++i)
+		{
+			sceneGraph.AddNode(nodes[i].Parent, nodes[i].Local);
+			if(nodes[i].Shape == SceneFile::kNone)
+				continue;
+
+			Item& item = items[objCBIndex];
+			item.ObjCBIndex = objCBIndex;
+			item.Node = i;
+			item.ShapeIndex = nodes[i].Shape;
+			item.MatIndex = nodes[i].Material;
+			nodeObjCBIndices[i] = objCBIndex;
+			++objCBIndex;
+		}
+
+		for(UINT node : sceneGraph.Update())
+		{
+			const UINT index = nodeObjCBIndices[node];
+			if(index == (UINT)-1)
+				continue;
+
+			worldTransforms.Set(index, sceneGraph.GetWorld(node));
+			objectCBDirty.MarkDirty(index);
+		}
+
+		gBenchmarkSink += objectCBDirty.TakePending(0).size() + items.back().Node;
+	}
+}
+
+void RunSceneFileBenchmark(const BenchmarkContext& context)
+{
+	wprintf(L"  pieces    nodes      KB  compile ms  load ms  build ms\n");
+
+	for(UINT pieceCount : { 10000u, 100000u })
+	{
+		WriteSource(pieceCount);
+
+		double compileMs = MeasureBestMs(1, []()
+		{
+			if(!SceneFile::Compile(kSourceFile, kSceneFile))
+				throw std::runtime_error("cannot write the benchmark scene");
+		});
+
+		std::unique_ptr<SceneFile> scene;
+		double loadMs = MeasureBestMs(5, [&scene]()
+		{
+			scene = SceneFile::Load(kSceneFile);
+			if(scene == nullptr)
+				throw std::runtime_error("cannot load the benchmark scene");
+		});
+
+		double buildMs = MeasureBestMs(5, [&scene]() { BuildItems(*scene); });
+
+		std::ifstream fin(kSceneFile, std::ios::binary | std::ios::ate);
+		const double kilobytes = (double)fin.tellg() / 1024.0;
+		fin.close();
+
+		wprintf(L"  %6u  %7u  %6.0f  %10.2f  %7.2f  %8.2f\n", pieceCount, scene->GetNodeCount(), kilobytes,
+			compileMs, loadMs, buildMs);
+	}
+
+	DeleteFileW(kSourceFile);
+	DeleteFileW(kSceneFile);
+}
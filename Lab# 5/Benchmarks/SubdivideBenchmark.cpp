@@ -0,0 +1,173 @@
+//***************************************************************************************
+// SubdivideBenchmark.cpp
+//
+// Vertex counts and build times of GeometryGenerator's subdivided shapes per level,
+// against the original Subdivide, which gave every triangle its own three corners and
+// three midpoints.
+//***************************************************************************************
+
+#include "Benchmark.h"
+#include "../../Common/GeometryGenerator.h"
+
+using namespace DirectX;
+
+namespace
+{
+	using Vertex = GeometryGenerator::Vertex;
+	using MeshData = GeometryGenerator::MeshData;
+	using uint32 = GeometryGenerator::uint32;
+
+	//
+	// The original Subdivide and the geosphere built with it, kept as the baseline.
+	//
+
+	Vertex LegacyMidPoint(const Vertex& v0, const Vertex& v1)
+	{
+		XMVECTOR pos = 0.5f*(XMLoadFloat3(&v0.Position) + XMLoadFloat3(&v1.Position));
+		XMVECTOR normal = XMVector3Normalize(0.5f*(XMLoadFloat3(&v0.Normal) + XMLoadFloat3(&v1.Normal)));
+		XMVECTOR tangent = XMVector3Normalize(0.5f*(XMLoadFloat3(&v0.TangentU) + XMLoadFloat3(&v1.TangentU)));
+		XMVECTOR tex = 0.5f*(XMLoadFloat2(&v0.TexC) + XMLoadFloat2(&v1.TexC));
+
+		Vertex v;
+		XMStoreFloat3(&v.Position, pos);
+		XMStoreFloat3(&v.Normal, normal);
+		XMStoreFloat3(&v.TangentU, tangent);
+		XMStoreFloat2(&v.TexC, tex);
+
+		return v;
+	}
+
+	void LegacySubdivide(MeshData& meshData)
+	{
+		MeshData inputCopy = meshData;
+
+		meshData.Vertices.resize(0);
+		meshData.Indices32.resize(0);
+
+		uint32 numTris = (uint32)inputCopy.Indices32.size()/3;
+		for(uint32 i = 0; i < numTris; ++i)
+		{
+			Vertex v0 = inputCopy.Vertices[inputCopy.Indices32[i*3+0]];
+			Vertex v1 = inputCopy.Vertices[inputCopy.Indices32[i*3+1]];
+			Vertex v2 = inputCopy.Vertices[inputCopy.Indices32[i*3+2]];
+
+			meshData.Vertices.push_back(v0);
+			meshData.Vertices.push_back(v1);
+			meshData.Vertices.push_back(v2);
+			meshData.Vertices.push_back(LegacyMidPoint(v0, v1));
+			meshData.Vertices.push_back(LegacyMidPoint(v1, v2));
+			meshData.Vertices.push_back(LegacyMidPoint(v0, v2));
+
+			const uint32 indices[12] = { 0, 3, 5,  3, 4, 5,  5, 4, 2,  3, 1, 4 };
+			for(uint32 index : indices)
+				meshData.Indices32.push_back(i*6 + index);
+		}
+	}
+
+	MeshData LegacyGeosphere(float radius, uint32 numSubdivisions)
+	{
+		const float X = 0.525731f;
+		const float Z = 0.850651f;
+
+		const XMFLOAT3 pos[12] =
+		{
+			XMFLOAT3(-X, 0.0f, Z),  XMFLOAT3(X, 0.0f, Z),
+			XMFLOAT3(-X, 0.0f, -Z), XMFLOAT3(X, 0.0f, -Z),
+			XMFLOAT3(0.0f, Z, X),   XMFLOAT3(0.0f, Z, -X),
+			XMFLOAT3(0.0f, -Z, X),  XMFLOAT3(0.0f, -Z, -X),
+			XMFLOAT3(Z, X, 0.0f),   XMFLOAT3(-Z, X, 0.0f),
+			XMFLOAT3(Z, -X, 0.0f),  XMFLOAT3(-Z, -X, 0.0f)
+		};
+
+		const uint32 k[60] =
+		{
+			1,4,0,  4,9,0,  4,5,9,  8,5,4,  1,8,4,
+			1,10,8, 10,3,8, 8,3,5,  3,2,5,  3,7,2,
+			3,10,7, 10,6,7, 6,11,7, 6,0,11, 6,1,0,
+			10,1,6, 11,0,9, 2,11,9, 5,2,9,  11,2,7
+		};
+
+		MeshData meshData;
+		meshData.Vertices.resize(12);
+		meshData.Indices32.assign(&k[0], &k[60]);
+
+		for(uint32 i = 0; i < 12; ++i)
+			meshData.Vertices[i].Position = pos[i];
+
+		for(uint32 i = 0; i < numSubdivisions; ++i)
+			LegacySubdivide(meshData);
+
+		for(Vertex& v : meshData.Vertices)
+		{
+			XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&v.Position));
+			XMStoreFloat3(&v.Position, radius*n);
+			XMStoreFloat3(&v.Normal, n);
+
+			float theta = atan2f(v.Position.z, v.Position.x);
+			if(theta < 0.0f)
+				theta += XM_2PI;
+
+			float phi = acosf(v.Position.y / radius);
+
+			v.TexC.x = theta/XM_2PI;
+			v.TexC.y = phi/XM_PI;
+
+			XMVECTOR t = XMVectorSet(-radius*sinf(phi)*sinf(theta), 0.0f, +radius*sinf(phi)*cosf(theta), 0.0f);
+			XMStoreFloat3(&v.TangentU, XMVector3Normalize(t));
+		}
+
+		return meshData;
+	}
+
+	// Fewer repetitions at the higher levels, which take long enough to time on their own.
+	int RepetitionsForLevel(uint32 level)
+	{
+		return level < 4 ? 200 : (level < 6 ? 20 : 5);
+	}
+}
+
+void RunSubdivideBenchmark(const BenchmarkContext& context)
+{
+	GeometryGenerator geoGen;
+
+	// CreateGeosphere caps its level at 6.
+	wprintf(L"geosphere   triangles   vertices (legacy)   ms (legacy)\n");
+	for(uint32 level = 0; level <= 6; ++level)
+	{
+		size_t vertexCount = 0, legacyVertexCount = 0, triangleCount = 0;
+
+		double ms = MeasureBestMs(RepetitionsForLevel(level), [&]()
+		{
+			MeshData mesh = geoGen.CreateGeosphere(1.0f, level);
+			vertexCount = mesh.Vertices.size();
+			triangleCount = mesh.Indices32.size()/3;
+		});
+
+		double legacyMs = MeasureBestMs(RepetitionsForLevel(level), [&]()
+		{
+			MeshData mesh = LegacyGeosphere(1.0f, level);
+			legacyVertexCount = mesh.Vertices.size();
+		});
+
+		gBenchmarkSink += vertexCount + legacyVertexCount;
+		wprintf(L"level %u %11zu %10zu (%7zu) %8.3f (%7.3f)\n", level, triangleCount,
+			vertexCount, legacyVertexCount, ms, legacyMs);
+	}
+
+	// Box faces keep their own vertices, so only edges inside a face are shared.
+	wprintf(L"\nbox         triangles   vertices   ms\n");
+	for(uint32 level = 0; level <= 6; ++level)
+	{
+		size_t vertexCount = 0, triangleCount = 0;
+
+		double ms = MeasureBestMs(RepetitionsForLevel(level), [&]()
+		{
+			MeshData mesh = geoGen.CreateBox(1.0f, 1.0f, 1.0f, level);
+			vertexCount = mesh.Vertices.size();
+			triangleCount = mesh.Indices32.size()/3;
+		});
+
+		gBenchmarkSink += vertexCount;
+		wprintf(L"level %u %11zu %10zu %8.3f\n", level, triangleCount, vertexCount, ms);
+	}
+}
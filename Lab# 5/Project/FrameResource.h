@@ -8,6 +8,12 @@ struct ObjectConstants
 {
     DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
 	DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
+
+	// Restores the object's quantized vertex positions, see VertexDecode.
+	DirectX::XMFLOAT3 PosDecodeScale = { 1.0f, 1.0f, 1.0f };
+	float cbPerObjectPad0 = 0.0f;
+	DirectX::XMFLOAT3 PosDecodeBias = { 0.0f, 0.0f, 0.0f };
+	float cbPerObjectPad1 = 0.0f;
 };
 
 struct PassConstants
@@ -3,9 +3,23 @@
 //***************************************************************************************
 
 #include "../../Common/d3dApp.h"
+#include "../../Common/AssetLoader.h"
+#include "../../Common/DirtyTracker.h"
+#include "../../Common/FrustumCuller.h"
 #include "../../Common/MathHelper.h"
 #include "../../Common/UploadBuffer.h"
 #include "../../Common/GeometryGenerator.h"
+#include "../../Common/GeometryRegistry.h"
+#include "../../Common/GeometryResidency.h"
+#include "../../Common/MeshOptimizer.h"
+#include "../../Common/MeshQuantizer.h"
+#include "../../Common/MeshBuilder.h"
+#include "../../Common/MeshCache.h"
+#include "../../Common/ModelCooker.h"
+#include "../../Common/SceneFile.h"
+#include "../../Common/SceneGraph.h"
+#include "../../Common/ThreadPool.h"
+#include "../../Common/TransformStore.h"
 #include "FrameResource.h"
 
 using Microsoft::WRL::ComPtr;
@@ -17,28 +31,46 @@ using namespace DirectX::PackedVector;
 
 const int gNumFrameResources = 3;
 
+// Shapes with fewer indices than this are drawn at full detail only.
+static const size_t gMinLodIndexCount = 1500;
+
+// Largest screen-space error, in pixels, a level of detail may introduce.
+static const float gLodPixelError = 1.0f;
+
+// System memory copies of the geometry kept after upload, for picking and collision.
+// The shapes (about 200 KB) and the skull (about 1 MB) fit together; evicted copies
+// are read back from their cache files.
+static const size_t gGeometryCpuByteBudget = 4*1024*1024;
+
+// The shapes are generated in code, so their cache is stamped with the executable and
+// goes stale whenever it is rebuilt.
+static const wchar_t gShapeCacheFile[] = L"Models/shapes.mesh";
+static const wchar_t gSkullCacheFile[] = L"Models/skull.mesh";
+
 // Lightweight structure stores parameters to draw a shape.  This will
 // vary from app-to-app.
 struct RenderItem
 {
 	RenderItem() = default;
 
-    // World matrix of the shape that describes the object's local space
-    // relative to the world space, which defines the position, orientation,
-    // and scale of the object in the world.
-    XMFLOAT4X4 World = MathHelper::Identity4x4();
-
-	XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
-
-	// Dirty flag indicating the object data has changed and we need to update the constant buffer.
-	// Because we have an object cbuffer for each FrameResource, we have to apply the
-	// update to each FrameResource.  Thus, when we modify obect data we should set 
-	// NumFramesDirty = gNumFrameResources so that each frame resource gets the update.
-	int NumFramesDirty = gNumFrameResources;
+	// The world matrix of the shape, which describes the object's local space relative
+	// to the world space, and its texture transform are kept at ObjCBIndex in the app's
+	// transform stores, so the object constants can be written in batches.  When they
+	// change, MarkRenderItemDirty queues the item for every FrameResource.
 
 	// Index into GPU constant buffer corresponding to the ObjectCB for this render item.
 	UINT ObjCBIndex = -1;
 
+	// Scene graph node the item is drawn at.  The item moves with the node's local
+	// transform and with those of the nodes above it.
+	UINT Node = 0;
+
+	// Assets the item is drawn with, as indices into the scene's shape and material
+	// tables.  Mat, Geo and Submesh stay null, and the item is skipped, until the assets
+	// are loaded and ResolveRenderItems finds them.
+	UINT ShapeIndex = 0;
+	UINT MatIndex = 0;
+
 	Material* Mat = nullptr;
 	MeshGeometry* Geo = nullptr;
 
@@ -49,6 +81,19 @@ struct RenderItem
     UINT IndexCount = 0;
     UINT StartIndexLocation = 0;
     int BaseVertexLocation = 0;
+
+	// Submesh being drawn.  When set, DrawRenderItems picks one of its levels of
+	// detail and culls its clusters instead of drawing the index range above.
+	const SubmeshGeometry* Submesh = nullptr;
+
+	// World space bounds of Submesh, updated by MarkRenderItemDirty.
+	BoundingBox WorldBounds;
+	BoundingSphere WorldSphere;
+
+	// Inverse of the world matrix, and whether the world matrix mirrors, for culling
+	// the clusters of Submesh in object space.  Updated with the bounds.
+	XMFLOAT4X4 InvWorld = MathHelper::Identity4x4();
+	bool Mirrored = false;
 };
 
 class LitColumnsApp : public D3DApp
@@ -73,18 +118,21 @@ private:
     void OnKeyboardInput(const GameTimer& gt);
 	void UpdateCamera(const GameTimer& gt);
 	void AnimateMaterials(const GameTimer& gt);
+	void UpdateSceneGraph();
 	void UpdateObjectCBs(const GameTimer& gt);
 	void UpdateMaterialCBs(const GameTimer& gt);
 	void UpdateMainPassCB(const GameTimer& gt);
+	void CullRenderItems();
 
     void BuildRootSignature();
     void BuildShadersAndInputLayout();
-    void BuildShapeGeometry();
-	void BuildSkullGeometry();
+    std::unique_ptr<MeshGeometry> BuildShapeGeometry(const std::wstring& executable);
     void BuildPSOs();
     void BuildFrameResources();
     void BuildMaterials();
     void BuildRenderItems();
+	void ResolveRenderItems();
+	void MarkRenderItemDirty(UINT objCBIndex);
     void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
  
 private:
@@ -99,6 +147,24 @@ private:
 
 	ComPtr<ID3D12DescriptorHeap> mSrvDescriptorHeap = nullptr;
 
+	// Workers for CPU-side asset work such as model parsing.
+	ThreadPool mThreadPool;
+
+	// Vertex and index arenas shared by all the geometry.
+	std::unique_ptr<GeometryRegistry> mGeometryRegistry;
+
+	// Releases the geometry's upload heaps and keeps its CPU copies within budget.
+	GeometryResidency mGeometryResidency{ gGeometryCpuByteBudget };
+
+	// Builds the geometry and materials on mThreadPool while frames are drawn.  Declared
+	// after what the loads use, so it is destroyed, and waits for them, first.
+	std::unique_ptr<AssetLoader> mAssetLoader;
+
+	// Material constant buffer slots handed out by BuildMaterials, and the materials
+	// that have arrived in them.
+	UINT mMaterialCount = 0;
+	std::vector<Material*> mMaterialsByCBIndex;
+
 	std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> mGeometries;
 	std::unordered_map<std::string, std::unique_ptr<Material>> mMaterials;
 	std::unordered_map<std::string, std::unique_ptr<Texture>> mTextures;
@@ -108,10 +174,40 @@ private:
 
     ComPtr<ID3D12PipelineState> mOpaquePSO = nullptr;
  
-	// List of all the render items.
-	std::vector<std::unique_ptr<RenderItem>> mAllRitems;
-
-	// Render items divided by PSO.
+	// The castle layout.  Its shapes and materials resolve to the loaded assets once,
+	// however many render items use them.
+	std::unique_ptr<SceneFile> mScene;
+	std::vector<const SubmeshGeometry*> mSceneSubmeshes;
+	std::vector<MeshGeometry*> mSceneGeometries;
+	std::vector<Material*> mSceneMaterials;
+
+	// Transform hierarchy of the scene's nodes, and the ObjCBIndex of the render item
+	// drawn at each node, or -1 for a group.
+	SceneGraph mSceneGraph;
+	std::vector<UINT> mNodeObjCBIndices;
+
+	// List of all the render items, one per scene node with a shape in file order.
+	// Never resized after BuildRenderItems, so pointers to them stay valid.  Item i
+	// has ObjCBIndex i.
+	std::vector<RenderItem> mAllRitems;
+
+	// World and texture transforms of the render items, by ObjCBIndex.
+	TransformStore mWorldTransforms;
+	TransformStore mTexTransforms;
+
+	// PosDecodeScale and PosDecodeBias of the render items, two per ObjCBIndex.
+	std::vector<XMFLOAT4A> mObjectDecode;
+
+	// Object and material constant buffer slots each frame resource has yet to see
+	// changed.
+	DirtyTracker mObjectCBDirty{ gNumFrameResources };
+	DirtyTracker mMaterialCBDirty{ gNumFrameResources };
+
+	// World space bounding spheres of the render items, by ObjCBIndex.
+	FrustumCuller mRitemCuller;
+
+	// Render items divided by PSO, refilled every frame with the ones that pass
+	// culling.
 	std::vector<RenderItem*> mOpaqueRitems;
 
     PassConstants mMainPassCB;
@@ -120,6 +216,9 @@ private:
 	XMFLOAT4X4 mView = MathHelper::Identity4x4();
 	XMFLOAT4X4 mProj = MathHelper::Identity4x4();
 
+	// Planes of the main pass's view frustum in world space, normals pointing in.
+	XMFLOAT4 mFrustumPlanes[6];
+
     float mTheta = 1.5f*XM_PI;
     float mPhi = 0.2f*XM_PI;
     float mRadius = 15.0f;
@@ -148,6 +247,11 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
         MessageBox(nullptr, e.ToString().c_str(), L"HR Failed", MB_OK);
         return 0;
     }
+    catch(std::exception& e)
+    {
+        MessageBoxA(nullptr, e.what(), "Error", MB_OK);
+        return 0;
+    }
 }
 
 LitColumnsApp::LitColumnsApp(HINSTANCE hInstance)
@@ -175,8 +279,28 @@ bool LitColumnsApp::Initialize()
 
     BuildRootSignature();
     BuildShadersAndInputLayout();
-    BuildShapeGeometry();
-	BuildSkullGeometry();
+
+	// The geometry is built on worker threads and shows up once Update publishes it,
+	// so the first frames are drawn without waiting for any of it.
+	mGeometryRegistry = std::make_unique<GeometryRegistry>(md3dDevice.Get());
+	mAssetLoader = std::make_unique<AssetLoader>(mThreadPool, md3dDevice.Get(), mCommandQueue.Get(),
+		mGeometryRegistry.get(), &mGeometryResidency);
+	wchar_t executable[MAX_PATH];
+	const DWORD executableLength = GetModuleFileNameW(nullptr, executable, MAX_PATH);
+	const std::wstring shapeSource(executable, executableLength);
+
+	// Both are uploaded straight from their cache files; the shapes are rebuilt when
+	// the executable that generates them changes.  The skull is cooked offline by the
+	// AssetCooker project, which LitColumns runs before every build, so startup only
+	// reads the result.  A failure is rethrown by Publish on the main thread, which
+	// reports it.
+	mAssetLoader->LoadGeometryFromCache(gShapeCacheFile, shapeSource,
+		[this, shapeSource]() { return BuildShapeGeometry(shapeSource); });
+	mAssetLoader->LoadGeometryFromCache(gSkullCacheFile, L"", []() -> std::unique_ptr<MeshGeometry>
+	{
+		throw std::runtime_error("Models/skull.mesh not found or invalid.  Build the AssetCooker project.");
+	});
+
 	BuildMaterials();
     BuildRenderItems();
     BuildFrameResources();
@@ -221,10 +345,18 @@ void LitColumnsApp::Update(const GameTimer& gt)
         CloseHandle(eventHandle);
     }
 
+	// Take in the assets that finished loading before anything reads them this frame.
+	if(mAssetLoader->Publish(mGeometries, mMaterials) > 0)
+		ResolveRenderItems();
+
+	mGeometryResidency.Update();
+
 	AnimateMaterials(gt);
+	UpdateSceneGraph();
 	UpdateObjectCBs(gt);
 	UpdateMaterialCBs(gt);
 	UpdateMainPassCB(gt);
+	CullRenderItems();
 }
 
 void LitColumnsApp::Draw(const GameTimer& gt)
@@ -354,53 +486,69 @@ void LitColumnsApp::AnimateMaterials(const GameTimer& gt)
 	
 }
 
-void LitColumnsApp::UpdateObjectCBs(const GameTimer& gt)
+// Brings the world transforms of the nodes that moved, and of the nodes under them, up
+// to date and queues the render items drawn at them.
+void LitColumnsApp::UpdateSceneGraph()
 {
-	auto currObjectCB = mCurrFrameResource->ObjectCB.get();
-	for(auto& e : mAllRitems)
+	for(UINT node : mSceneGraph.Update())
 	{
-		// Only update the cbuffer data if the constants have changed.  
-		// This needs to be tracked per frame resource.
-		if(e->NumFramesDirty > 0)
-		{
-			XMMATRIX world = XMLoadFloat4x4(&e->World);
-			XMMATRIX texTransform = XMLoadFloat4x4(&e->TexTransform);
+		const UINT objCBIndex = mNodeObjCBIndices[node];
+		if(objCBIndex == (UINT)-1)
+			continue;
 
-			ObjectConstants objConstants;
-			XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
-			XMStoreFloat4x4(&objConstants.TexTransform, XMMatrixTranspose(texTransform));
+		mWorldTransforms.Set(objCBIndex, mSceneGraph.GetWorld(node));
+		MarkRenderItemDirty(objCBIndex);
+	}
+}
 
-			currObjectCB->CopyData(e->ObjCBIndex, objConstants);
+void LitColumnsApp::UpdateObjectCBs(const GameTimer& gt)
+{
+	auto currObjectCB = mCurrFrameResource->ObjectCB.get();
+	BYTE* objectCBData = currObjectCB->GetMappedData();
+	const UINT objCBByteSize = currObjectCB->GetElementByteSize();
 
-			// Next FrameResource need to be updated too.
-			e->NumFramesDirty--;
-		}
+	static_assert(offsetof(ObjectConstants, PosDecodeBias) == offsetof(ObjectConstants, PosDecodeScale) + sizeof(XMFLOAT4),
+		"mObjectDecode does not match the ObjectConstants layout.");
+
+	// Only the items this frame resource missed are written.  The constants of a run of
+	// consecutive items are streamed into the constant buffer together, transposing
+	// the matrices on the way.
+	const std::vector<UINT>& dirty = mObjectCBDirty.TakePending(mCurrFrameResourceIndex);
+	for(size_t k = 0; k < dirty.size(); )
+	{
+		const UINT first = dirty[k];
+		UINT end = first + 1;
+		while(++k < dirty.size() && dirty[k] == end)
+			++end;
+
+		BYTE* dst = objectCBData + (size_t)first*objCBByteSize;
+		mWorldTransforms.StreamTransposed(first, end - first, dst + offsetof(ObjectConstants, World), objCBByteSize);
+		mTexTransforms.StreamTransposed(first, end - first, dst + offsetof(ObjectConstants, TexTransform), objCBByteSize);
+		TransformStore::StreamVectors(&mObjectDecode[2*first], 2, end - first,
+			dst + offsetof(ObjectConstants, PosDecodeScale), objCBByteSize);
 	}
 }
 
 void LitColumnsApp::UpdateMaterialCBs(const GameTimer& gt)
 {
 	auto currMaterialCB = mCurrFrameResource->MaterialCB.get();
-	for(auto& e : mMaterials)
+	for(UINT i : mMaterialCBDirty.TakePending(mCurrFrameResourceIndex))
 	{
-		// Only update the cbuffer data if the constants have changed.  If the cbuffer
-		// data changes, it needs to be updated for each FrameResource.
-		Material* mat = e.second.get();
-		if(mat->NumFramesDirty > 0)
-		{
-			XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
+		// Only materials whose constants changed since this frame resource was last
+		// used are written.
+		Material* mat = mMaterialsByCBIndex[i];
+		if(mat == nullptr)
+			continue;
 
-			MaterialConstants matConstants;
-			matConstants.DiffuseAlbedo = mat->DiffuseAlbedo;
-			matConstants.FresnelR0 = mat->FresnelR0;
-			matConstants.Roughness = mat->Roughness;
-			XMStoreFloat4x4(&matConstants.MatTransform, XMMatrixTranspose(matTransform));
+		XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
 
-			currMaterialCB->CopyData(mat->MatCBIndex, matConstants);
+		MaterialConstants matConstants;
+		matConstants.DiffuseAlbedo = mat->DiffuseAlbedo;
+		matConstants.FresnelR0 = mat->FresnelR0;
+		matConstants.Roughness = mat->Roughness;
+		XMStoreFloat4x4(&matConstants.MatTransform, XMMatrixTranspose(matTransform));
 
-			// Next FrameResource need to be updated too.
-			mat->NumFramesDirty--;
-		}
+		currMaterialCB->CopyData(mat->MatCBIndex, matConstants);
 	}
 }
 
@@ -414,6 +562,11 @@ void LitColumnsApp::UpdateMainPassCB(const GameTimer& gt)
 	XMMATRIX invProj = XMMatrixInverse(&XMMatrixDeterminant(proj), proj);
 	XMMATRIX invViewProj = XMMatrixInverse(&XMMatrixDeterminant(viewProj), viewProj);
 
+	XMVECTOR frustumPlanes[6];
+	MathHelper::ExtractFrustumPlanes(frustumPlanes, viewProj);
+	for(int i = 0; i < 6; ++i)
+		XMStoreFloat4(&mFrustumPlanes[i], frustumPlanes[i]);
+
 	XMStoreFloat4x4(&mMainPassCB.View, XMMatrixTranspose(view));
 	XMStoreFloat4x4(&mMainPassCB.InvView, XMMatrixTranspose(invView));
 	XMStoreFloat4x4(&mMainPassCB.Proj, XMMatrixTranspose(proj));
@@ -439,6 +592,23 @@ void LitColumnsApp::UpdateMainPassCB(const GameTimer& gt)
 	currPassCB->CopyData(0, mMainPassCB);
 }
 
+// Refills mOpaqueRitems with the render items whose bounding sphere and box are not
+// outside the view frustum.  Items still loading have no bounds yet and are left out.
+void LitColumnsApp::CullRenderItems()
+{
+	XMVECTOR planes[6];
+	for(int i = 0; i < 6; ++i)
+		planes[i] = XMLoadFloat4(&mFrustumPlanes[i]);
+
+	const UINT visibleCount = mRitemCuller.Cull(planes);
+	const UINT* visible = mRitemCuller.GetVisible();
+
+	// All the render items are opaque.
+	mOpaqueRitems.resize(visibleCount);
+	for(UINT i = 0; i < visibleCount; ++i)
+		mOpaqueRitems[i] = &mAllRitems[visible[i]];
+}
+
 void LitColumnsApp::BuildRootSignature()
 {
 	// Root parameter can be a table, root descriptor or root constants.
@@ -484,13 +654,13 @@ void LitColumnsApp::BuildShadersAndInputLayout()
 	
     mInputLayout =
     {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
     };
 }
 
-void LitColumnsApp::BuildShapeGeometry()
+// Runs on a worker thread.
+std::unique_ptr<MeshGeometry> LitColumnsApp::BuildShapeGeometry(const std::wstring& executable)
 {
     GeometryGenerator geoGen;
 	GeometryGenerator::MeshData box = geoGen.CreateBox(1.0f, 1.0f, 1.0f, 3);
@@ -507,298 +677,58 @@ void LitColumnsApp::BuildShapeGeometry()
 	GeometryGenerator::MeshData tetrahedron = geoGen.CreateTetrahedron(1.0f, 1.0f);
 
 	//
-	// We are concatenating all the geometry into one big vertex/index buffer.  So
-	// define the regions in the buffer each submesh covers.
+	// Weld duplicate vertices, split each shape into clusters, then reorder the
+	// clusters for the post-transform vertex cache and vertex fetch.
 	//
 
-	// Cache the vertex offsets to each object in the concatenated vertex buffer.
-	UINT boxVertexOffset = 0;
-	UINT gridVertexOffset = (UINT)box.Vertices.size();
-	UINT sphereVertexOffset = gridVertexOffset + (UINT)grid.Vertices.size();
-	UINT cylinderVertexOffset = sphereVertexOffset + (UINT)sphere.Vertices.size();
-	UINT diamondVertextOffset = cylinderVertexOffset + (UINT)cylinder.Vertices.size();
-	UINT coneVertexOffset = diamondVertextOffset + (UINT)diamond.Vertices.size();
-	UINT wedgeVertexOffset = coneVertexOffset + (UINT)cone.Vertices.size();
-	UINT pyramidVertexOffset = wedgeVertexOffset + (UINT)wedge.Vertices.size();
-	UINT truncPyramidVertexOffset = pyramidVertexOffset + (UINT)pyramid.Vertices.size();
-	UINT triangularPrismVertexOffset = truncPyramidVertexOffset + (UINT)truncPyramid.Vertices.size();
-	UINT tetrahedronVertexOffset = triangularPrismVertexOffset + (UINT)triangularPrism.Vertices.size();
-
-	// Cache the starting index for each object in the concatenated index buffer.
-	UINT boxIndexOffset = 0;
-	UINT gridIndexOffset = (UINT)box.Indices32.size();
-	UINT sphereIndexOffset = gridIndexOffset + (UINT)grid.Indices32.size();
-	UINT cylinderIndexOffset = sphereIndexOffset + (UINT)sphere.Indices32.size();
-	UINT diamondIndexOffset = cylinderIndexOffset + (UINT)cylinder.Indices32.size();
-	UINT coneIndexOffset = diamondIndexOffset + (UINT)diamond.Indices32.size();
-	UINT wedgeIndexOffset = coneIndexOffset + (UINT)cone.Indices32.size();
-	UINT pyramidIndexOffset = wedgeIndexOffset + (UINT)wedge.Indices32.size();
-	UINT truncPyramidIndexOffset = pyramidIndexOffset + (UINT)pyramid.Indices32.size();
-	UINT triangularPrismIndexOffset = truncPyramidIndexOffset + (UINT)truncPyramid.Indices32.size();
-	UINT tetrahedronIndexOffset = triangularPrismIndexOffset + (UINT)triangularPrism.Indices32.size();
-
-	SubmeshGeometry boxSubmesh;
-	boxSubmesh.IndexCount = (UINT)box.Indices32.size();
-	boxSubmesh.StartIndexLocation = boxIndexOffset;
-	boxSubmesh.BaseVertexLocation = boxVertexOffset;
-
-	SubmeshGeometry gridSubmesh;
-	gridSubmesh.IndexCount = (UINT)grid.Indices32.size();
-	gridSubmesh.StartIndexLocation = gridIndexOffset;
-	gridSubmesh.BaseVertexLocation = gridVertexOffset;
-
-	SubmeshGeometry sphereSubmesh;
-	sphereSubmesh.IndexCount = (UINT)sphere.Indices32.size();
-	sphereSubmesh.StartIndexLocation = sphereIndexOffset;
-	sphereSubmesh.BaseVertexLocation = sphereVertexOffset;
-
-	SubmeshGeometry cylinderSubmesh;
-	cylinderSubmesh.IndexCount = (UINT)cylinder.Indices32.size();
-	cylinderSubmesh.StartIndexLocation = cylinderIndexOffset;
-	cylinderSubmesh.BaseVertexLocation = cylinderVertexOffset;
-
-
-	SubmeshGeometry diamondSubmesh;
-	diamondSubmesh.IndexCount = (UINT)diamond.Indices32.size();
-	diamondSubmesh.StartIndexLocation = diamondIndexOffset;
-	diamondSubmesh.BaseVertexLocation = diamondVertextOffset;
-
-	SubmeshGeometry coneSubmesh;
-	coneSubmesh.IndexCount = (UINT)cone.Indices32.size();
-	coneSubmesh.StartIndexLocation = coneIndexOffset;
-	coneSubmesh.BaseVertexLocation = coneVertexOffset;
-
-	SubmeshGeometry wedgeSubmesh;
-	wedgeSubmesh.IndexCount = (UINT)wedge.Indices32.size();
-	wedgeSubmesh.StartIndexLocation = wedgeIndexOffset;
-	wedgeSubmesh.BaseVertexLocation = wedgeVertexOffset;
-
-	SubmeshGeometry pyramidSubmesh;
-	pyramidSubmesh.IndexCount = (UINT)pyramid.Indices32.size();
-	pyramidSubmesh.StartIndexLocation = pyramidIndexOffset;
-	pyramidSubmesh.BaseVertexLocation = pyramidVertexOffset;
-
-	SubmeshGeometry truncPyramidSubmesh;
-	truncPyramidSubmesh.IndexCount = (UINT)truncPyramid.Indices32.size();
-	truncPyramidSubmesh.StartIndexLocation = truncPyramidIndexOffset;
-	truncPyramidSubmesh.BaseVertexLocation = truncPyramidVertexOffset;
-
-	SubmeshGeometry triangularPrismSubmesh;
-	triangularPrismSubmesh.IndexCount = (UINT)triangularPrism.Indices32.size();
-	triangularPrismSubmesh.StartIndexLocation = triangularPrismIndexOffset;
-	triangularPrismSubmesh.BaseVertexLocation = triangularPrismVertexOffset;
-
-	SubmeshGeometry tetrahedronSubmesh;
-	tetrahedronSubmesh.IndexCount = (UINT)tetrahedron.Indices32.size();
-	tetrahedronSubmesh.StartIndexLocation = tetrahedronIndexOffset;
-	tetrahedronSubmesh.BaseVertexLocation = tetrahedronVertexOffset;
-
-	//
-	// Extract the vertex elements we are interested in and pack the
-	// vertices of all the meshes into one vertex buffer.
-	//
-
-	auto totalVertexCount =
-		box.Vertices.size() +
-		grid.Vertices.size() +
-		sphere.Vertices.size() +
-		cylinder.Vertices.size() +
-		diamond.Vertices.size() +
-		cone.Vertices.size() +
-		wedge.Vertices.size() +
-		pyramid.Vertices.size() +
-		truncPyramid.Vertices.size() +
-		triangularPrism.Vertices.size() +
-		tetrahedron.Vertices.size();
-
-	std::vector<Vertex> vertices(totalVertexCount);
-
-	UINT k = 0;
-	for(size_t i = 0; i < box.Vertices.size(); ++i, ++k)
+	std::pair<const char*, GeometryGenerator::MeshData*> meshes[] =
 	{
-		vertices[k].Pos = box.Vertices[i].Position;
-		vertices[k].Normal = box.Vertices[i].Normal;
-	}
-
-	for(size_t i = 0; i < grid.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = grid.Vertices[i].Position;
-		vertices[k].Normal = grid.Vertices[i].Normal;
-	}
+		{ "box", &box }, { "grid", &grid }, { "sphere", &sphere }, { "cylinder", &cylinder },
+		{ "diamond", &diamond }, { "cone", &cone }, { "wedge", &wedge }, { "pyramid", &pyramid },
+		{ "truncPyramid", &truncPyramid }, { "triangularPrism", &triangularPrism }, { "tetrahedron", &tetrahedron }
+	};
 
-	for(size_t i = 0; i < sphere.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = sphere.Vertices[i].Position;
-		vertices[k].Normal = sphere.Vertices[i].Normal;
-	}
+	// Each shape is split into clusters for per-cluster culling in DrawRenderItems.
+	// The builder packs all of them into one vertex/index buffer: every shape is
+	// quantized relative to its own bounds and gets 16-bit indices whenever the
+	// range of vertices it references fits.
+	MeshBuilder builder;
 
-	for(size_t i = 0; i < cylinder.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = cylinder.Vertices[i].Position;
-		vertices[k].Normal = cylinder.Vertices[i].Normal;
-	}
-	for (size_t i = 0; i < diamond.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = diamond.Vertices[i].Position;
-		vertices[k].Normal = diamond.Vertices[i].Normal;
-	}
-	for (size_t i = 0; i < cone.Vertices.size(); ++i, ++k)
+	for(auto& mesh : meshes)
 	{
-		vertices[k].Pos = cone.Vertices[i].Position;
-		vertices[k].Normal = cone.Vertices[i].Normal;
-	}
-	for (size_t i = 0; i < wedge.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = wedge.Vertices[i].Position;
-		vertices[k].Normal = wedge.Vertices[i].Normal;
-	}
-	for (size_t i = 0; i < pyramid.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = pyramid.Vertices[i].Position;
-		vertices[k].Normal = pyramid.Vertices[i].Normal;
-	}
-	for (size_t i = 0; i < truncPyramid.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = truncPyramid.Vertices[i].Position;
-		vertices[k].Normal = truncPyramid.Vertices[i].Normal;
-	}
-	for (size_t i = 0; i < triangularPrism.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = triangularPrism.Vertices[i].Position;
-		vertices[k].Normal = triangularPrism.Vertices[i].Normal;
-	}
-	for (size_t i = 0; i < tetrahedron.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = tetrahedron.Vertices[i].Position;
-		vertices[k].Normal = tetrahedron.Vertices[i].Normal;
-	}
+		GeometryGenerator::MeshData& meshData = *mesh.second;
 
-	std::vector<std::uint16_t> indices;
-	indices.insert(indices.end(), std::begin(box.GetIndices16()), std::end(box.GetIndices16()));
-	indices.insert(indices.end(), std::begin(grid.GetIndices16()), std::end(grid.GetIndices16()));
-	indices.insert(indices.end(), std::begin(sphere.GetIndices16()), std::end(sphere.GetIndices16()));
-	indices.insert(indices.end(), std::begin(cylinder.GetIndices16()), std::end(cylinder.GetIndices16()));
-	indices.insert(indices.end(), std::begin(diamond.GetIndices16()), std::end(diamond.GetIndices16()));
-	indices.insert(indices.end(), std::begin(cone.GetIndices16()), std::end(cone.GetIndices16()));
-	indices.insert(indices.end(), std::begin(wedge.GetIndices16()), std::end(wedge.GetIndices16()));
-	indices.insert(indices.end(), std::begin(pyramid.GetIndices16()), std::end(pyramid.GetIndices16()));
-	indices.insert(indices.end(), std::begin(truncPyramid.GetIndices16()), std::end(truncPyramid.GetIndices16()));
-	indices.insert(indices.end(), std::begin(triangularPrism.GetIndices16()), std::end(triangularPrism.GetIndices16()));
-	indices.insert(indices.end(), std::begin(tetrahedron.GetIndices16()), std::end(tetrahedron.GetIndices16()));
-
-
-    const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
-    const UINT ibByteSize = (UINT)indices.size()  * sizeof(std::uint16_t);
-
-	auto geo = std::make_unique<MeshGeometry>();
-	geo->Name = "shapeGeo";
-
-	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
-
-	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
-
-	geo->VertexByteStride = sizeof(Vertex);
-	geo->VertexBufferByteSize = vbByteSize;
-	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-	geo->IndexBufferByteSize = ibByteSize;
-
-	geo->DrawArgs["box"] = boxSubmesh;
-	geo->DrawArgs["grid"] = gridSubmesh;
-	geo->DrawArgs["sphere"] = sphereSubmesh;
-	geo->DrawArgs["cylinder"] = cylinderSubmesh;
-	geo->DrawArgs["diamond"] = diamondSubmesh;
-	geo->DrawArgs["cone"] = coneSubmesh;
-	geo->DrawArgs["wedge"] = wedgeSubmesh;
-	geo->DrawArgs["pyramid"] = pyramidSubmesh;
-	geo->DrawArgs["truncPyramid"] = truncPyramidSubmesh;
-	geo->DrawArgs["triangularPrism"] = triangularPrismSubmesh;
-	geo->DrawArgs["tetrahedron"] = tetrahedronSubmesh;
-	
+		MeshOptimizer::WeldVertices(meshData);
 
-	mGeometries[geo->Name] = std::move(geo);
-}
+		std::vector<MeshCluster> clusters;
+		ModelCooker::LogOptimizeStats(mesh.first, MeshOptimizer::OptimizeClustered(meshData.Vertices, meshData.Indices32,
+			&GeometryGenerator::Vertex::Position, clusters));
 
-void LitColumnsApp::BuildSkullGeometry()
-{
-	std::ifstream fin("Models/skull.txt");
-
-	if(!fin)
-	{
-		MessageBox(0, L"Models/skull.txt not found.", 0, 0);
-		return;
+		builder.AddMesh(mesh.first, meshData, std::move(clusters));
 	}
 
-	UINT vcount = 0;
-	UINT tcount = 0;
-	std::string ignore;
-
-	fin >> ignore >> vcount;
-	fin >> ignore >> tcount;
-	fin >> ignore >> ignore >> ignore >> ignore;
-
-	std::vector<Vertex> vertices(vcount);
-	for(UINT i = 0; i < vcount; ++i)
+	// The denser shapes get a chain of simplified levels after all the shapes.
+	for(auto& mesh : meshes)
 	{
-		fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-		fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
-	}
+		const GeometryGenerator::MeshData& meshData = *mesh.second;
+		if(meshData.Indices32.size() < gMinLodIndexCount)
+			continue;
 
-	fin >> ignore;
-	fin >> ignore;
-	fin >> ignore;
-
-	std::vector<std::int32_t> indices(3 * tcount);
-	for(UINT i = 0; i < tcount; ++i)
-	{
-		fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
+		ModelCooker::BuildLodChain(mesh.first, &meshData.Vertices[0].Position, sizeof(GeometryGenerator::Vertex),
+			meshData.Vertices.size(), meshData.Indices32, builder);
 	}
 
-	fin.close();
+	auto geo = builder.Pack("shapeGeo");
 
-	//
-	// Pack the indices of all the meshes into one index buffer.
-	//
-
-	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
-
-	const UINT ibByteSize = (UINT)indices.size() * sizeof(std::int32_t);
-
-	auto geo = std::make_unique<MeshGeometry>();
-	geo->Name = "skullGeo";
-
-	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
-
-	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
-
-	geo->VertexByteStride = sizeof(Vertex);
-	geo->VertexBufferByteSize = vbByteSize;
-	geo->IndexFormat = DXGI_FORMAT_R32_UINT;
-	geo->IndexBufferByteSize = ibByteSize;
-
-	SubmeshGeometry submesh;
-	submesh.IndexCount = (UINT)indices.size();
-	submesh.StartIndexLocation = 0;
-	submesh.BaseVertexLocation = 0;
+	for(auto& mesh : meshes)
+		ModelCooker::LogQuantizationError(mesh.first, builder.GetQuantizationError(mesh.first));
 
-	geo->DrawArgs["skull"] = submesh;
+	// Evicted CPU copies are read back from the cache, so if it cannot be written they
+	// stay evicted and AcquireCpuCopies fails for the shapes.
+	if(!MeshCache::Save(gShapeCacheFile, executable, *geo))
+		OutputDebugStringA("LitColumns: cannot write the shape cache\n");
 
-	mGeometries[geo->Name] = std::move(geo);
+	return geo;
 }
 
 void LitColumnsApp::BuildPSOs()
@@ -839,816 +769,182 @@ void LitColumnsApp::BuildFrameResources()
     for(int i = 0; i < gNumFrameResources; ++i)
     {
         mFrameResources.push_back(std::make_unique<FrameResource>(md3dDevice.Get(),
-            1, (UINT)mAllRitems.size(), (UINT)mMaterials.size()));
+            1, (UINT)mAllRitems.size(), mMaterialCount));
     }
 }
 
 void LitColumnsApp::BuildMaterials()
 {
-	auto bricks0 = std::make_unique<Material>();
-	bricks0->Name = "bricks0";
-	bricks0->MatCBIndex = 0;
-	bricks0->DiffuseSrvHeapIndex = 0;
-	bricks0->DiffuseAlbedo = XMFLOAT4(Colors::ForestGreen);
-	bricks0->FresnelR0 = XMFLOAT3(0.02f, 0.02f, 0.02f);
-	bricks0->Roughness = 0.1f;
-
-	auto stone0 = std::make_unique<Material>();
-	stone0->Name = "stone0";
-	stone0->MatCBIndex = 1;
-	stone0->DiffuseSrvHeapIndex = 1;
-	stone0->DiffuseAlbedo = XMFLOAT4(Colors::LightSteelBlue);
-	stone0->FresnelR0 = XMFLOAT3(0.05f, 0.05f, 0.05f);
-	stone0->Roughness = 0.3f;
- 
-	auto tile0 = std::make_unique<Material>();
-	tile0->Name = "tile0";
-	tile0->MatCBIndex = 2;
-	tile0->DiffuseSrvHeapIndex = 2;
-	tile0->DiffuseAlbedo = XMFLOAT4(Colors::DarkGreen);
-	tile0->FresnelR0 = XMFLOAT3(0.02f, 0.02f, 0.02f);
-	tile0->Roughness = 0.2f;
-
-	auto skullMat = std::make_unique<Material>();
-	skullMat->Name = "skullMat";
-	skullMat->MatCBIndex = 3;
-	skullMat->DiffuseSrvHeapIndex = 3;
-	skullMat->DiffuseAlbedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-	skullMat->FresnelR0 = XMFLOAT3(0.05f, 0.05f, 0.05f);
-	skullMat->Roughness = 0.3f;
-
-	auto diamondMat = std::make_unique<Material>();
-	diamondMat->Name = "diamondMat";
-	diamondMat->MatCBIndex = 4;
-	diamondMat->DiffuseSrvHeapIndex = 4;
-	diamondMat->DiffuseAlbedo = XMFLOAT4(0.0f, 0.0f, 1.0f, 1.0f);
-	diamondMat->FresnelR0 = XMFLOAT3(0.05f, 0.05f, 0.15f);
-	diamondMat->Roughness = 0.9f;
-
-	auto coneMat = std::make_unique<Material>();
-	coneMat->Name = "coneMat";
-	coneMat->MatCBIndex = 5;
-	coneMat->DiffuseSrvHeapIndex = 5;
-	coneMat->DiffuseAlbedo = XMFLOAT4(Colors::DarkGoldenrod);
-	coneMat->FresnelR0 = XMFLOAT3(0.05f, 0.05f, 0.15f);
-	coneMat->Roughness = 0.5f;
-
-	auto wallMat = std::make_unique<Material>();
-	wallMat->Name = "wallMat";
-	wallMat->MatCBIndex = 6;
-	wallMat->DiffuseSrvHeapIndex = 6;
-	wallMat->DiffuseAlbedo = XMFLOAT4(Colors::DarkGray);
-	wallMat->FresnelR0 = XMFLOAT3(0.05f, 0.05f, 0.15f);
-	wallMat->Roughness = 0.5f;
-	
-	mMaterials["bricks0"] = std::move(bricks0);
-	mMaterials["stone0"] = std::move(stone0);
-	mMaterials["tile0"] = std::move(tile0);
-	mMaterials["skullMat"] = std::move(skullMat);
-	mMaterials["diamondMat"] = std::move(diamondMat);
-	mMaterials["coneMat"] = std::move(coneMat);
-	mMaterials["wallMat"] = std::move(wallMat);
+	// Materials are loaded like the geometry and come in through mMaterials; each
+	// gets its constant buffer slot up front, so BuildFrameResources can size the
+	// buffers before any of them arrive.
+	auto loadMaterial = [this](const std::string& name, const XMFLOAT4& diffuseAlbedo,
+		const XMFLOAT3& fresnelR0, float roughness)
+	{
+		UINT index = mMaterialCount++;
+		mAssetLoader->LoadMaterial([=]()
+		{
+			auto mat = std::make_unique<Material>();
+			mat->Name = name;
+			mat->MatCBIndex = index;
+			mat->DiffuseSrvHeapIndex = index;
+			mat->DiffuseAlbedo = diffuseAlbedo;
+			mat->FresnelR0 = fresnelR0;
+			mat->Roughness = roughness;
+			return mat;
+		});
+	};
+
+	loadMaterial("bricks0", XMFLOAT4(Colors::ForestGreen), XMFLOAT3(0.02f, 0.02f, 0.02f), 0.1f);
+	loadMaterial("stone0", XMFLOAT4(Colors::LightSteelBlue), XMFLOAT3(0.05f, 0.05f, 0.05f), 0.3f);
+	loadMaterial("tile0", XMFLOAT4(Colors::DarkGreen), XMFLOAT3(0.02f, 0.02f, 0.02f), 0.2f);
+	loadMaterial("skullMat", XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), XMFLOAT3(0.05f, 0.05f, 0.05f), 0.3f);
+	loadMaterial("diamondMat", XMFLOAT4(0.0f, 0.0f, 1.0f, 1.0f), XMFLOAT3(0.05f, 0.05f, 0.15f), 0.9f);
+	loadMaterial("coneMat", XMFLOAT4(Colors::DarkGoldenrod), XMFLOAT3(0.05f, 0.05f, 0.15f), 0.5f);
+	loadMaterial("wallMat", XMFLOAT4(Colors::DarkGray), XMFLOAT3(0.05f, 0.05f, 0.15f), 0.5f);
+
+	mMaterialsByCBIndex.assign(mMaterialCount, nullptr);
+	mMaterialCBDirty.Resize(mMaterialCount);
 }
 
 void LitColumnsApp::BuildRenderItems()
 {
-	UINT objCBIndex = 0;
+	// The layout is compiled from Models/castle.scene by the AssetCooker project, which
+	// LitColumns runs before it builds.
+	mScene = SceneFile::Load(L"Models/castle.scn");
+	if(mScene == nullptr)
+		throw std::runtime_error("Models/castle.scn not found or invalid.  Build the AssetCooker project.");
 
-	// Grid
-    auto gridRitem = std::make_unique<RenderItem>();
-    gridRitem->World = MathHelper::Identity4x4();
-	XMStoreFloat4x4(&gridRitem->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
-	gridRitem->ObjCBIndex = objCBIndex++;
-	gridRitem->Mat = mMaterials["tile0"].get();
-	gridRitem->Geo = mGeometries["shapeGeo"].get();
-	gridRitem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-    gridRitem->IndexCount = gridRitem->Geo->DrawArgs["grid"].IndexCount;
-    gridRitem->StartIndexLocation = gridRitem->Geo->DrawArgs["grid"].StartIndexLocation;
-    gridRitem->BaseVertexLocation = gridRitem->Geo->DrawArgs["grid"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(gridRitem));
-
-
-	//Main Pillars
-	//Back Right cylinder
-	auto cylinderBRItem = std::make_unique<RenderItem>();
-	XMMATRIX cylinderBRWorld = XMMatrixScaling(1.5f, 6.0f, 1.5f) * XMMatrixTranslation(10.5f, 3.0f, 10.5f);
-	XMStoreFloat4x4(&cylinderBRItem->World, cylinderBRWorld);
-	cylinderBRItem->TexTransform = MathHelper::Identity4x4();
-	cylinderBRItem->ObjCBIndex = objCBIndex++;
-	cylinderBRItem->Mat = mMaterials["wallMat"].get();
-	cylinderBRItem->Geo = mGeometries["shapeGeo"].get();
-	cylinderBRItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	cylinderBRItem->IndexCount = cylinderBRItem->Geo->DrawArgs["cylinder"].IndexCount;
-	cylinderBRItem->StartIndexLocation = cylinderBRItem->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	cylinderBRItem->BaseVertexLocation = cylinderBRItem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(cylinderBRItem));
-
-	//Back Left cylinder
-	auto cylinderBLItem = std::make_unique<RenderItem>();
-	XMMATRIX cylinderBLWorld = XMMatrixScaling(1.5f, 6.0f, 1.5f) * XMMatrixTranslation(-10.5f, 3.0f, 10.5f);
-	XMStoreFloat4x4(&cylinderBLItem->World, cylinderBLWorld);
-	cylinderBLItem->TexTransform = MathHelper::Identity4x4();
-	cylinderBLItem->ObjCBIndex = objCBIndex++;
-	cylinderBLItem->Mat = mMaterials["wallMat"].get();
-	cylinderBLItem->Geo = mGeometries["shapeGeo"].get();
-	cylinderBLItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	cylinderBLItem->IndexCount = cylinderBLItem->Geo->DrawArgs["cylinder"].IndexCount;
-	cylinderBLItem->StartIndexLocation = cylinderBLItem->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	cylinderBLItem->BaseVertexLocation = cylinderBLItem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(cylinderBLItem));
-
-	//Front Right cylinder
-	auto cylinderFRItem = std::make_unique<RenderItem>();
-	XMMATRIX cylinderFRWorld = XMMatrixScaling(1.5f, 6.0f, 1.5f) * XMMatrixTranslation(10.5f, 3.0f, -10.5f);
-	XMStoreFloat4x4(&cylinderFRItem->World, cylinderFRWorld);
-	cylinderFRItem->TexTransform = MathHelper::Identity4x4();
-	cylinderFRItem->ObjCBIndex = objCBIndex++;
-	cylinderFRItem->Mat = mMaterials["wallMat"].get();
-	cylinderFRItem->Geo = mGeometries["shapeGeo"].get();
-	cylinderFRItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	cylinderFRItem->IndexCount = cylinderFRItem->Geo->DrawArgs["cylinder"].IndexCount;
-	cylinderFRItem->StartIndexLocation = cylinderFRItem->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	cylinderFRItem->BaseVertexLocation = cylinderFRItem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(cylinderFRItem));
-
-	//Front Left cylinder
-	auto cylinderFLItem = std::make_unique<RenderItem>();
-	XMMATRIX cylinderFLWorld = XMMatrixScaling(1.5f, 6.0f, 1.5f) * XMMatrixTranslation(-10.5f, 3.0f, -10.5f);
-	XMStoreFloat4x4(&cylinderFLItem->World, cylinderFLWorld);
-	cylinderFLItem->TexTransform = MathHelper::Identity4x4();
-	cylinderFLItem->ObjCBIndex = objCBIndex++;
-	cylinderFLItem->Mat = mMaterials["wallMat"].get();
-	cylinderFLItem->Geo = mGeometries["shapeGeo"].get();
-	cylinderFLItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	cylinderFLItem->IndexCount = cylinderFLItem->Geo->DrawArgs["cylinder"].IndexCount;
-	cylinderFLItem->StartIndexLocation = cylinderFLItem->Geo->DrawArgs["cylinder"].StartIndexLocation;
-	cylinderFLItem->BaseVertexLocation = cylinderFLItem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(cylinderFLItem));
-
-	//Back Right Cone
-	auto coneBRItem = std::make_unique<RenderItem>();
-	XMMATRIX coneBRWorld = XMMatrixScaling(3.0f, 2.0f, 3.0f) * XMMatrixTranslation(10.5f, 7.0f, 10.5f);
-	XMStoreFloat4x4(&coneBRItem->World, coneBRWorld);
-	coneBRItem->TexTransform = MathHelper::Identity4x4();
-	coneBRItem->ObjCBIndex = objCBIndex++;
-	coneBRItem->Mat = mMaterials["coneMat"].get();
-	coneBRItem->Geo = mGeometries["shapeGeo"].get();
-	coneBRItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	coneBRItem->IndexCount = coneBRItem->Geo->DrawArgs["cone"].IndexCount;
-	coneBRItem->StartIndexLocation = coneBRItem->Geo->DrawArgs["cone"].StartIndexLocation;
-	coneBRItem->BaseVertexLocation = coneBRItem->Geo->DrawArgs["cone"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(coneBRItem));
-	
-	//Back Left Cone
-	auto coneBLItem = std::make_unique<RenderItem>();
-	XMMATRIX coneBLWorld = XMMatrixScaling(3.0f, 2.0f, 3.0f) * XMMatrixTranslation(-10.5f, 7.0f, 10.5f);
-	XMStoreFloat4x4(&coneBLItem->World, coneBLWorld);
-	coneBLItem->TexTransform = MathHelper::Identity4x4();
-	coneBLItem->ObjCBIndex = objCBIndex++;
-	coneBLItem->Mat = mMaterials["coneMat"].get();
-	coneBLItem->Geo = mGeometries["shapeGeo"].get();
-	coneBLItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	coneBLItem->IndexCount = coneBLItem->Geo->DrawArgs["cone"].IndexCount;
-	coneBLItem->StartIndexLocation = coneBLItem->Geo->DrawArgs["cone"].StartIndexLocation;
-	coneBLItem->BaseVertexLocation = coneBLItem->Geo->DrawArgs["cone"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(coneBLItem));
-	
-	//Front Right Cone
-	auto coneFRItem = std::make_unique<RenderItem>();
-	XMMATRIX coneFRWorld = XMMatrixScaling(3.0f, 2.0f, 3.0f) * XMMatrixTranslation(10.5f, 7.0f, -10.5f);
-	XMStoreFloat4x4(&coneFRItem->World, coneFRWorld);
-	coneFRItem->TexTransform = MathHelper::Identity4x4();
-	coneFRItem->ObjCBIndex = objCBIndex++;
-	coneFRItem->Mat = mMaterials["coneMat"].get();
-	coneFRItem->Geo = mGeometries["shapeGeo"].get();
-	coneFRItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	coneFRItem->IndexCount = coneFRItem->Geo->DrawArgs["cone"].IndexCount;
-	coneFRItem->StartIndexLocation = coneFRItem->Geo->DrawArgs["cone"].StartIndexLocation;
-	coneFRItem->BaseVertexLocation = coneFRItem->Geo->DrawArgs["cone"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(coneFRItem));
-
-	//Front Left Cone
-	auto coneFLItem = std::make_unique<RenderItem>();
-	XMMATRIX coneFLWorld = XMMatrixScaling(3.0f, 2.0f, 3.0f) * XMMatrixTranslation(-10.5f, 7.0f, -10.5f);
-	XMStoreFloat4x4(&coneFLItem->World, coneFLWorld);
-	coneFLItem->TexTransform = MathHelper::Identity4x4();
-	coneFLItem->ObjCBIndex = objCBIndex++;
-	coneFLItem->Mat = mMaterials["coneMat"].get();
-	coneFLItem->Geo = mGeometries["shapeGeo"].get();
-	coneFLItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	coneFLItem->IndexCount = coneFLItem->Geo->DrawArgs["cone"].IndexCount;
-	coneFLItem->StartIndexLocation = coneFLItem->Geo->DrawArgs["cone"].StartIndexLocation;
-	coneFLItem->BaseVertexLocation = coneFLItem->Geo->DrawArgs["cone"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(coneFLItem));
-
-
-	// Walls
-	// Left Wall
-	auto wallLeftItem = std::make_unique<RenderItem>();
-	XMMATRIX wallLeftWorld = XMMatrixScaling(1.5f, 4.0f, 18.5f) * XMMatrixTranslation(-10.5f, 2.0f, 0.0f);
-	XMStoreFloat4x4(&wallLeftItem->World, wallLeftWorld);
-	wallLeftItem->TexTransform = MathHelper::Identity4x4();
-	wallLeftItem->ObjCBIndex = objCBIndex++;
-	wallLeftItem->Mat = mMaterials["wallMat"].get();
-	wallLeftItem->Geo = mGeometries["shapeGeo"].get();
-	wallLeftItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	wallLeftItem->IndexCount = wallLeftItem->Geo->DrawArgs["box"].IndexCount;
-	wallLeftItem->StartIndexLocation = wallLeftItem->Geo->DrawArgs["box"].StartIndexLocation;
-	wallLeftItem->BaseVertexLocation = wallLeftItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(wallLeftItem));
-
-	// Wall Right
-	auto wallRightItem = std::make_unique<RenderItem>();
-	XMMATRIX wallRightWorld = XMMatrixScaling(1.5f, 4.0f, 18.5f) * XMMatrixTranslation(10.5f, 2.0f, 0.0f);
-	XMStoreFloat4x4(&wallRightItem->World, wallRightWorld);
-	wallRightItem->TexTransform = MathHelper::Identity4x4();
-	wallRightItem->ObjCBIndex = objCBIndex++;
-	wallRightItem->Mat = mMaterials["wallMat"].get();
-	wallRightItem->Geo = mGeometries["shapeGeo"].get();
-	wallRightItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	wallRightItem->IndexCount = wallRightItem->Geo->DrawArgs["box"].IndexCount;
-	wallRightItem->StartIndexLocation = wallRightItem->Geo->DrawArgs["box"].StartIndexLocation;
-	wallRightItem->BaseVertexLocation = wallRightItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(wallRightItem));
-
-	// Wall Back
-	auto wallBackItem = std::make_unique<RenderItem>();
-	XMMATRIX wallBackWorld = XMMatrixScaling(18.5f, 4.0f, 1.5f) * XMMatrixTranslation(0.0f, 2.0f, 10.5f);
-	XMStoreFloat4x4(&wallBackItem->World, wallBackWorld);
-	wallBackItem->TexTransform = MathHelper::Identity4x4();
-	wallBackItem->ObjCBIndex = objCBIndex++;
-	wallBackItem->Mat = mMaterials["wallMat"].get();
-	wallBackItem->Geo = mGeometries["shapeGeo"].get();
-	wallBackItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	wallBackItem->IndexCount = wallBackItem->Geo->DrawArgs["box"].IndexCount;
-	wallBackItem->StartIndexLocation = wallBackItem->Geo->DrawArgs["box"].StartIndexLocation;
-	wallBackItem->BaseVertexLocation = wallBackItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(wallBackItem));
-
-	// Wall Front Left
-	auto wallFLItem = std::make_unique<RenderItem>();
-	XMMATRIX wallFLWorld = XMMatrixScaling(7.0f, 3.0f, 1.5f) * XMMatrixTranslation(-5.75f, 2.0f, -10.5f);
-	XMStoreFloat4x4(&wallFLItem->World, wallFLWorld);
-	wallFLItem->TexTransform = MathHelper::Identity4x4();
-	wallFLItem->ObjCBIndex = objCBIndex++;
-	wallFLItem->Mat = mMaterials["wallMat"].get();
-	wallFLItem->Geo = mGeometries["shapeGeo"].get();
-	wallFLItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	wallFLItem->IndexCount = wallFLItem->Geo->DrawArgs["box"].IndexCount;
-	wallFLItem->StartIndexLocation = wallFLItem->Geo->DrawArgs["box"].StartIndexLocation;
-	wallFLItem->BaseVertexLocation = wallFLItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(wallFLItem));
-
-	// Wall Front Right
-	auto wallFRItem = std::make_unique<RenderItem>();
-	XMMATRIX wallFRWorld = XMMatrixScaling(7.0f, 3.0f, 1.5f) * XMMatrixTranslation(5.75f, 2.0f, -10.5f);
-	XMStoreFloat4x4(&wallFRItem->World, wallFRWorld);
-	wallFRItem->TexTransform = MathHelper::Identity4x4();
-	wallFRItem->ObjCBIndex = objCBIndex++;
-	wallFRItem->Mat = mMaterials["wallMat"].get();
-	wallFRItem->Geo = mGeometries["shapeGeo"].get();
-	wallFRItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	wallFRItem->IndexCount = wallFRItem->Geo->DrawArgs["box"].IndexCount;
-	wallFRItem->StartIndexLocation = wallFRItem->Geo->DrawArgs["box"].StartIndexLocation;
-	wallFRItem->BaseVertexLocation = wallFRItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(wallFRItem));
-
-	// Wall Front Top
-	auto wallFTItem = std::make_unique<RenderItem>();
-	XMMATRIX wallFTWorld = XMMatrixScaling(18.5f, 0.5f, 1.5f) * XMMatrixTranslation(0.0f, 3.75f, -10.5f);
-	XMStoreFloat4x4(&wallFTItem->World, wallFTWorld);
-	wallFTItem->TexTransform = MathHelper::Identity4x4();
-	wallFTItem->ObjCBIndex = objCBIndex++;
-	wallFTItem->Mat = mMaterials["wallMat"].get();
-	wallFTItem->Geo = mGeometries["shapeGeo"].get();
-	wallFTItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	wallFTItem->IndexCount = wallFTItem->Geo->DrawArgs["box"].IndexCount;
-	wallFTItem->StartIndexLocation = wallFTItem->Geo->DrawArgs["box"].StartIndexLocation;
-	wallFTItem->BaseVertexLocation = wallFTItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(wallFTItem));
-
-	// Wall Front Bottom
-	auto wallFBItem = std::make_unique<RenderItem>();
-	XMMATRIX wallFBWorld = XMMatrixScaling(18.5f, 0.5f, 1.5f) * XMMatrixTranslation(0.0f, 0.25f, -10.5f);
-	XMStoreFloat4x4(&wallFBItem->World, wallFBWorld);
-	wallFBItem->TexTransform = MathHelper::Identity4x4();
-	wallFBItem->ObjCBIndex = objCBIndex++;
-	wallFBItem->Mat = mMaterials["wallMat"].get();
-	wallFBItem->Geo = mGeometries["shapeGeo"].get();
-	wallFBItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	wallFBItem->IndexCount = wallFBItem->Geo->DrawArgs["box"].IndexCount;
-	wallFBItem->StartIndexLocation = wallFBItem->Geo->DrawArgs["box"].StartIndexLocation;
-	wallFBItem->BaseVertexLocation = wallFBItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(wallFBItem));
-
-
-	// Wall Tops
-	XMMATRIX rotation = XMMatrixRotationY(0.0f);
-	XMMATRIX scaling = XMMatrixScaling(1.5f, 1.0f, 1.5f);
-	XMMATRIX translation = XMMatrixTranslation(8.0f, 4.0f, 10.5f);
-	float spacing = 4.0f;
-
-	// Back Wall Tops
-	for (int i = 0; i < 5; i++)
+	mSceneGeometries.assign(mScene->GetShapeCount(), nullptr);
+	mSceneSubmeshes.assign(mScene->GetShapeCount(), nullptr);
+	mSceneMaterials.assign(mScene->GetMaterialCount(), nullptr);
+
+	const SceneFile::Node* nodes = mScene->GetNodes();
+	const UINT nodeCount = mScene->GetNodeCount();
+
+	UINT itemCount = 0;
+	for(UINT i = 0; i < nodeCount; ++i)
 	{
-		translation = XMMatrixTranslation(8.0f - (i * spacing), 4.5f, 10.5f);
-		
-		XMMATRIX triangularPrismBWorld = rotation * scaling * translation;
-
-		auto wallTopItem = std::make_unique<RenderItem>();
-		
-		XMStoreFloat4x4(&wallTopItem->World, triangularPrismBWorld);
-		wallTopItem->TexTransform = MathHelper::Identity4x4();
-		wallTopItem->ObjCBIndex = objCBIndex++;
-		wallTopItem->Mat = mMaterials["wallMat"].get();
-		wallTopItem->Geo = mGeometries["shapeGeo"].get();
-		wallTopItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-		wallTopItem->IndexCount = wallTopItem->Geo->DrawArgs["truncPyramid"].IndexCount;
-		wallTopItem->StartIndexLocation = wallTopItem->Geo->DrawArgs["truncPyramid"].StartIndexLocation;
-		wallTopItem->BaseVertexLocation = wallTopItem->Geo->DrawArgs["truncPyramid"].BaseVertexLocation;
-		mAllRitems.push_back(std::move(wallTopItem));
+		if(nodes[i].Shape != SceneFile::kNone)
+			++itemCount;
 	}
 
-	// Front wall tops
-	for (int i = 0; i < 5; i++)
+	mAllRitems.resize(itemCount);
+	mOpaqueRitems.reserve(itemCount);
+	mRitemCuller.Resize(itemCount);
+	mWorldTransforms.Resize(itemCount);
+	mTexTransforms.Resize(itemCount);
+	mObjectDecode.resize(2*itemCount);
+	mObjectCBDirty.Resize(itemCount);
+	mNodeObjCBIndices.assign(nodeCount, (UINT)-1);
+
+	static_assert(SceneGraph::kNoParent == SceneFile::kNone, "Scene file parents cannot be passed to the scene graph.");
+
+	// The scene file lists the nodes in the preorder the scene graph keeps them in.
+	UINT objCBIndex = 0;
+	for(UINT i = 0; i < nodeCount; ++i)
 	{
-		translation = XMMatrixTranslation(8.0f - (i * spacing), 4.5f, -10.5f);
-
-		XMMATRIX triangularPrismBWorld = rotation * scaling * translation;
-
-		auto wallTopItem = std::make_unique<RenderItem>();
-
-		XMStoreFloat4x4(&wallTopItem->World, triangularPrismBWorld);
-		wallTopItem->TexTransform = MathHelper::Identity4x4();
-		wallTopItem->ObjCBIndex = objCBIndex++;
-		wallTopItem->Mat = mMaterials["wallMat"].get();
-		wallTopItem->Geo = mGeometries["shapeGeo"].get();
-		wallTopItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-		wallTopItem->IndexCount = wallTopItem->Geo->DrawArgs["truncPyramid"].IndexCount;
-		wallTopItem->StartIndexLocation = wallTopItem->Geo->DrawArgs["truncPyramid"].StartIndexLocation;
-		wallTopItem->BaseVertexLocation = wallTopItem->Geo->DrawArgs["truncPyramid"].BaseVertexLocation;
-		mAllRitems.push_back(std::move(wallTopItem));
+		mSceneGraph.AddNode(nodes[i].Parent, nodes[i].Local);
+		if(nodes[i].Shape == SceneFile::kNone)
+			continue;
+
+		RenderItem& ri = mAllRitems[objCBIndex];
+		mObjectDecode[2*objCBIndex] = XMFLOAT4A(1.0f, 1.0f, 1.0f, 0.0f);
+		mObjectDecode[2*objCBIndex + 1] = XMFLOAT4A(0.0f, 0.0f, 0.0f, 0.0f);
+		ri.ObjCBIndex = objCBIndex;
+		ri.Node = i;
+		ri.ShapeIndex = nodes[i].Shape;
+		ri.MatIndex = nodes[i].Material;
+		mNodeObjCBIndices[i] = objCBIndex;
+		++objCBIndex;
 	}
 
-	// Left Wall Tops
-	for (int i = 0; i < 5; i++)
+	// Every node starts dirty, so this places all the items and queues their constants.
+	UpdateSceneGraph();
+}
+
+// Points the render items at the assets that have arrived since the last call.
+void LitColumnsApp::ResolveRenderItems()
+{
+	for(auto& e : mMaterials)
 	{
-		translation = XMMatrixTranslation(-10.5f, 4.5f, 8.0f - (i * spacing));
-
-		XMMATRIX triangularPrismBWorld = rotation * scaling * translation;
-
-		auto wallTopItem = std::make_unique<RenderItem>();
-
-		XMStoreFloat4x4(&wallTopItem->World, triangularPrismBWorld);
-		wallTopItem->TexTransform = MathHelper::Identity4x4();
-		wallTopItem->ObjCBIndex = objCBIndex++;
-		wallTopItem->Mat = mMaterials["wallMat"].get();
-		wallTopItem->Geo = mGeometries["shapeGeo"].get();
-		wallTopItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-		wallTopItem->IndexCount = wallTopItem->Geo->DrawArgs["truncPyramid"].IndexCount;
-		wallTopItem->StartIndexLocation = wallTopItem->Geo->DrawArgs["truncPyramid"].StartIndexLocation;
-		wallTopItem->BaseVertexLocation = wallTopItem->Geo->DrawArgs["truncPyramid"].BaseVertexLocation;
-		mAllRitems.push_back(std::move(wallTopItem));
+		Material* mat = e.second.get();
+		if(mMaterialsByCBIndex[mat->MatCBIndex] != mat)
+		{
+			mMaterialsByCBIndex[mat->MatCBIndex] = mat;
+			mMaterialCBDirty.MarkDirty(mat->MatCBIndex);
+		}
 	}
 
-	// Right Wall Tops
-	for (int i = 0; i < 5; i++)
+	for(UINT i = 0; i < mSceneMaterials.size(); ++i)
 	{
-		translation = XMMatrixTranslation(10.5f, 4.5f, 8.0f - (i * spacing));
-
-		XMMATRIX triangularPrismBWorld = rotation * scaling * translation;
-
-		auto wallTopItem = std::make_unique<RenderItem>();
-
-		XMStoreFloat4x4(&wallTopItem->World, triangularPrismBWorld);
-		wallTopItem->TexTransform = MathHelper::Identity4x4();
-		wallTopItem->ObjCBIndex = objCBIndex++;
-		wallTopItem->Mat = mMaterials["wallMat"].get();
-		wallTopItem->Geo = mGeometries["shapeGeo"].get();
-		wallTopItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-		wallTopItem->IndexCount = wallTopItem->Geo->DrawArgs["truncPyramid"].IndexCount;
-		wallTopItem->StartIndexLocation = wallTopItem->Geo->DrawArgs["truncPyramid"].StartIndexLocation;
-		wallTopItem->BaseVertexLocation = wallTopItem->Geo->DrawArgs["truncPyramid"].BaseVertexLocation;
-		mAllRitems.push_back(std::move(wallTopItem));
+		if(mSceneMaterials[i] == nullptr)
+		{
+			auto mat = mMaterials.find(mScene->GetMaterialName(i));
+			if(mat != mMaterials.end())
+				mSceneMaterials[i] = mat->second.get();
+		}
 	}
 
+	// A geometry can also be replaced by a newer load of the same name; the items
+	// drawing the old one move to it.
+	for(UINT i = 0; i < mSceneGeometries.size(); ++i)
+	{
+		const SceneFile::Shape& shape = mScene->GetShape(i);
+		auto geo = mGeometries.find(shape.GeoName);
+		if(geo == mGeometries.end() || geo->second.get() == mSceneGeometries[i])
+			continue;
 
-	// Front
-	// Outside Ramp
-	auto rampItem = std::make_unique<RenderItem>();
-	XMMATRIX rampWorld = XMMatrixScaling(4.75f, 0.5f, 1.5f) * XMMatrixTranslation(0.0f, 0.25, -12.0f);
-	XMStoreFloat4x4(&rampItem->World, rampWorld);
-	rampItem->TexTransform = MathHelper::Identity4x4();
-	rampItem->ObjCBIndex = objCBIndex++;
-	rampItem->Mat = mMaterials["coneMat"].get();
-	rampItem->Geo = mGeometries["shapeGeo"].get();
-	rampItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	rampItem->IndexCount = rampItem->Geo->DrawArgs["wedge"].IndexCount;
-	rampItem->StartIndexLocation = rampItem->Geo->DrawArgs["wedge"].StartIndexLocation;
-	rampItem->BaseVertexLocation = rampItem->Geo->DrawArgs["wedge"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(rampItem));
-
-	auto rampInItem = std::make_unique<RenderItem>();
-	XMMATRIX rampInWorld = XMMatrixRotationY(180.0f * (XM_PI / 180.0f)) * XMMatrixScaling(4.75f, 0.5f, 1.5f) * XMMatrixTranslation(0.0f, 0.25, -9.0f);
-	XMStoreFloat4x4(&rampInItem->World, rampInWorld);
-	rampInItem->TexTransform = MathHelper::Identity4x4();
-	rampInItem->ObjCBIndex = objCBIndex++;
-	rampInItem->Mat = mMaterials["coneMat"].get();
-	rampInItem->Geo = mGeometries["shapeGeo"].get();
-	rampInItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	rampInItem->IndexCount = rampInItem->Geo->DrawArgs["wedge"].IndexCount;
-	rampInItem->StartIndexLocation = rampInItem->Geo->DrawArgs["wedge"].StartIndexLocation;
-	rampInItem->BaseVertexLocation = rampInItem->Geo->DrawArgs["wedge"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(rampInItem));
-	
+		auto submesh = geo->second->DrawArgs.find(shape.SubmeshName);
+		if(submesh == geo->second->DrawArgs.end())
+			continue;
 
-	// Castle Wall Back
-	auto castleWallBItem = std::make_unique<RenderItem>();
-	XMMATRIX castleWallBWorld = XMMatrixScaling(10.0f, 5.0f, 0.5f) * XMMatrixTranslation(0.0f, 2.5f, 7.8f);
-	XMStoreFloat4x4(&castleWallBItem->World, castleWallBWorld);
-	castleWallBItem->TexTransform = MathHelper::Identity4x4();
-	castleWallBItem->ObjCBIndex = objCBIndex++;
-	castleWallBItem->Mat = mMaterials["wallMat"].get();
-	castleWallBItem->Geo = mGeometries["shapeGeo"].get();
-	castleWallBItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	castleWallBItem->IndexCount = castleWallBItem->Geo->DrawArgs["box"].IndexCount;
-	castleWallBItem->StartIndexLocation = castleWallBItem->Geo->DrawArgs["box"].StartIndexLocation;
-	castleWallBItem->BaseVertexLocation = castleWallBItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(castleWallBItem));
-
-
-	// Castle Wall Right
-	auto castleWallRItem = std::make_unique<RenderItem>();
-	XMMATRIX castleWallRWorld = XMMatrixScaling(0.5f, 5.0f, 10.0f) * XMMatrixTranslation(5.0f, 2.5f, 3.05f);
-	XMStoreFloat4x4(&castleWallRItem->World, castleWallRWorld);
-	castleWallRItem->TexTransform = MathHelper::Identity4x4();
-	castleWallRItem->ObjCBIndex = objCBIndex++;
-	castleWallRItem->Mat = mMaterials["wallMat"].get();
-	castleWallRItem->Geo = mGeometries["shapeGeo"].get();
-	castleWallRItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	castleWallRItem->IndexCount = castleWallRItem->Geo->DrawArgs["box"].IndexCount;
-	castleWallRItem->StartIndexLocation = castleWallRItem->Geo->DrawArgs["box"].StartIndexLocation;
-	castleWallRItem->BaseVertexLocation = castleWallRItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(castleWallRItem));
-
-	// Castle Wall Left
-	auto castleWallLItem = std::make_unique<RenderItem>();
-	XMMATRIX castleWallLWorld = XMMatrixScaling(0.5f, 5.0f, 10.0f) * XMMatrixTranslation(-5.0f, 2.5f, 3.05f);
-	XMStoreFloat4x4(&castleWallLItem->World, castleWallLWorld);
-	castleWallLItem->TexTransform = MathHelper::Identity4x4();
-	castleWallLItem->ObjCBIndex = objCBIndex++;
-	castleWallLItem->Mat = mMaterials["wallMat"].get();
-	castleWallLItem->Geo = mGeometries["shapeGeo"].get();
-	castleWallLItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	castleWallLItem->IndexCount = castleWallLItem->Geo->DrawArgs["box"].IndexCount;
-	castleWallLItem->StartIndexLocation = castleWallLItem->Geo->DrawArgs["box"].StartIndexLocation;
-	castleWallLItem->BaseVertexLocation = castleWallLItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(castleWallLItem));
-
-
-	// Castle Wall Front Left
-	auto castleWallFLItem = std::make_unique<RenderItem>();
-	XMMATRIX castleWallFLWorld = XMMatrixScaling(4.0f, 5.0f, 0.5f) * XMMatrixTranslation(-3.25f, 2.5f, -2.0f);
-	XMStoreFloat4x4(&castleWallFLItem->World, castleWallFLWorld);
-	castleWallFLItem->TexTransform = MathHelper::Identity4x4();
-	castleWallFLItem->ObjCBIndex = objCBIndex++;
-	castleWallFLItem->Mat = mMaterials["wallMat"].get();
-	castleWallFLItem->Geo = mGeometries["shapeGeo"].get();
-	castleWallFLItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	castleWallFLItem->IndexCount = castleWallFLItem->Geo->DrawArgs["box"].IndexCount;
-	castleWallFLItem->StartIndexLocation = castleWallFLItem->Geo->DrawArgs["box"].StartIndexLocation;
-	castleWallFLItem->BaseVertexLocation = castleWallFLItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(castleWallFLItem));
-
-
-	// Castle Wall Front Right
-	auto castleWallFRItem = std::make_unique<RenderItem>();
-	XMMATRIX castleWallFRWorld = XMMatrixScaling(4.0f, 5.0f, 0.5f) * XMMatrixTranslation(3.25f, 2.5f, -2.0f);
-	XMStoreFloat4x4(&castleWallFRItem->World, castleWallFRWorld);
-	castleWallFRItem->TexTransform = MathHelper::Identity4x4();
-	castleWallFRItem->ObjCBIndex = objCBIndex++;
-	castleWallFRItem->Mat = mMaterials["wallMat"].get();
-	castleWallFRItem->Geo = mGeometries["shapeGeo"].get();
-	castleWallFRItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	castleWallFRItem->IndexCount = castleWallFRItem->Geo->DrawArgs["box"].IndexCount;
-	castleWallFRItem->StartIndexLocation = castleWallFRItem->Geo->DrawArgs["box"].StartIndexLocation;
-	castleWallFRItem->BaseVertexLocation = castleWallFRItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(castleWallFRItem));
-
-
-	//Castle Roof Pyramid
-	auto pyramidRoofItem = std::make_unique<RenderItem>();
-	XMMATRIX pyramidRoofWorld = XMMatrixScaling(10.5f, 4.0f, 10.5f) * XMMatrixTranslation(0.0f, 7.0f, 2.75f);
-	XMStoreFloat4x4(&pyramidRoofItem->World, pyramidRoofWorld);
-	pyramidRoofItem->TexTransform = MathHelper::Identity4x4();
-	pyramidRoofItem->ObjCBIndex = objCBIndex++;
-	pyramidRoofItem->Mat = mMaterials["coneMat"].get();
-	pyramidRoofItem->Geo = mGeometries["shapeGeo"].get();
-	pyramidRoofItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	pyramidRoofItem->IndexCount = pyramidRoofItem->Geo->DrawArgs["pyramid"].IndexCount;
-	pyramidRoofItem->StartIndexLocation = pyramidRoofItem->Geo->DrawArgs["pyramid"].StartIndexLocation;
-	pyramidRoofItem->BaseVertexLocation = pyramidRoofItem->Geo->DrawArgs["pyramid"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(pyramidRoofItem));
-
-	// Left tower Cube
-	auto cubeTowerLItem = std::make_unique<RenderItem>();
-	XMMATRIX cubeTowerLWorld = XMMatrixScaling(3.0f, 6.0f, 4.0f) * XMMatrixTranslation(-6.5f, 3.0f, 4.0f);
-	XMStoreFloat4x4(&cubeTowerLItem->World, cubeTowerLWorld);
-	cubeTowerLItem->TexTransform = MathHelper::Identity4x4();
-	cubeTowerLItem->ObjCBIndex = objCBIndex++;
-	cubeTowerLItem->Mat = mMaterials["wallMat"].get();
-	cubeTowerLItem->Geo = mGeometries["shapeGeo"].get();
-	cubeTowerLItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	cubeTowerLItem->IndexCount = cubeTowerLItem->Geo->DrawArgs["box"].IndexCount;
-	cubeTowerLItem->StartIndexLocation = cubeTowerLItem->Geo->DrawArgs["box"].StartIndexLocation;
-	cubeTowerLItem->BaseVertexLocation = cubeTowerLItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(cubeTowerLItem));
-
-	// Left tower Top
-	auto truncTopLItem = std::make_unique<RenderItem>();
-	XMMATRIX truncTopLWorld = XMMatrixScaling(3.0f,3.0f, 4.0f) * XMMatrixTranslation(-6.5f, 7.5f, 4.0f);
-	XMStoreFloat4x4(&truncTopLItem->World, truncTopLWorld);
-	truncTopLItem->TexTransform = MathHelper::Identity4x4();
-	truncTopLItem->ObjCBIndex = objCBIndex++;
-	truncTopLItem->Mat = mMaterials["coneMat"].get();
-	truncTopLItem->Geo = mGeometries["shapeGeo"].get();
-	truncTopLItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	truncTopLItem->IndexCount = truncTopLItem->Geo->DrawArgs["truncPyramid"].IndexCount;
-	truncTopLItem->StartIndexLocation = truncTopLItem->Geo->DrawArgs["truncPyramid"].StartIndexLocation;
-	truncTopLItem->BaseVertexLocation = truncTopLItem->Geo->DrawArgs["truncPyramid"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(truncTopLItem));
-
-
-	// Right tower Cube
-	auto cubeTowerRItem = std::make_unique<RenderItem>();
-	XMMATRIX cubeTowerRWorld = XMMatrixScaling(3.0f, 6.0f, 4.0f) * XMMatrixTranslation(6.5f, 3.0f, 4.0f);
-	XMStoreFloat4x4(&cubeTowerRItem->World, cubeTowerRWorld);
-	cubeTowerRItem->TexTransform = MathHelper::Identity4x4();
-	cubeTowerRItem->ObjCBIndex = objCBIndex++;
-	cubeTowerRItem->Mat = mMaterials["wallMat"].get();
-	cubeTowerRItem->Geo = mGeometries["shapeGeo"].get();
-	cubeTowerRItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	cubeTowerRItem->IndexCount = cubeTowerRItem->Geo->DrawArgs["box"].IndexCount;
-	cubeTowerRItem->StartIndexLocation = cubeTowerRItem->Geo->DrawArgs["box"].StartIndexLocation;
-	cubeTowerRItem->BaseVertexLocation = cubeTowerRItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(cubeTowerRItem));
-
-	// Right tower Top
-	auto truncTopRItem = std::make_unique<RenderItem>();
-	XMMATRIX truncTopRWorld = XMMatrixScaling(3.0f, 3.0f, 4.0f) * XMMatrixTranslation(6.5f, 7.5f, 4.0f);
-	XMStoreFloat4x4(&truncTopRItem->World, truncTopRWorld);
-	truncTopRItem->TexTransform = MathHelper::Identity4x4();
-	truncTopRItem->ObjCBIndex = objCBIndex++;
-	truncTopRItem->Mat = mMaterials["coneMat"].get();
-	truncTopRItem->Geo = mGeometries["shapeGeo"].get();
-	truncTopRItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	truncTopRItem->IndexCount = truncTopRItem->Geo->DrawArgs["truncPyramid"].IndexCount;
-	truncTopRItem->StartIndexLocation = truncTopRItem->Geo->DrawArgs["truncPyramid"].StartIndexLocation;
-	truncTopRItem->BaseVertexLocation = truncTopRItem->Geo->DrawArgs["truncPyramid"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(truncTopRItem));
-
-
-
-	// Right House long Cube
-	auto cubeHouseRItem = std::make_unique<RenderItem>();
-	XMMATRIX cubeHouseRWorld = XMMatrixScaling(2.0f, 2.0f, 5.0f) * XMMatrixTranslation(7.5f, 1.0f, -6.5f);
-	XMStoreFloat4x4(&cubeHouseRItem->World, cubeHouseRWorld);
-	cubeHouseRItem->TexTransform = MathHelper::Identity4x4();
-	cubeHouseRItem->ObjCBIndex = objCBIndex++;
-	cubeHouseRItem->Mat = mMaterials["wallMat"].get();
-	cubeHouseRItem->Geo = mGeometries["shapeGeo"].get();
-	cubeHouseRItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	cubeHouseRItem->IndexCount = cubeHouseRItem->Geo->DrawArgs["box"].IndexCount;
-	cubeHouseRItem->StartIndexLocation = cubeHouseRItem->Geo->DrawArgs["box"].StartIndexLocation;
-	cubeHouseRItem->BaseVertexLocation = cubeHouseRItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(cubeHouseRItem));
-
-
-	// Right House long Pyramid Top
-	auto cubeHouseRTopItem = std::make_unique<RenderItem>();
-	XMMATRIX cubeHouseRTopWorld = XMMatrixScaling(2.0f, 2.0f, 5.0f) * XMMatrixTranslation(7.5f, 3.0f, -6.5f);
-	XMStoreFloat4x4(&cubeHouseRTopItem->World, cubeHouseRTopWorld);
-	cubeHouseRTopItem->TexTransform = MathHelper::Identity4x4();
-	cubeHouseRTopItem->ObjCBIndex = objCBIndex++;
-	cubeHouseRTopItem->Mat = mMaterials["coneMat"].get();
-	cubeHouseRTopItem->Geo = mGeometries["shapeGeo"].get();
-	cubeHouseRTopItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	cubeHouseRTopItem->IndexCount = cubeHouseRTopItem->Geo->DrawArgs["pyramid"].IndexCount;
-	cubeHouseRTopItem->StartIndexLocation = cubeHouseRTopItem->Geo->DrawArgs["pyramid"].StartIndexLocation;
-	cubeHouseRTopItem->BaseVertexLocation = cubeHouseRTopItem->Geo->DrawArgs["pyramid"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(cubeHouseRTopItem));
-
-
-	// Right House Small house front Cube
-	auto cubeHouseSFItem = std::make_unique<RenderItem>();
-	XMMATRIX cubeHouseSFWorld = XMMatrixScaling(1.0f, 1.0f, 1.0f) * XMMatrixTranslation(5.0f, 0.5f, -6.0f);
-	XMStoreFloat4x4(&cubeHouseSFItem->World, cubeHouseSFWorld);
-	cubeHouseSFItem->TexTransform = MathHelper::Identity4x4();
-	cubeHouseSFItem->ObjCBIndex = objCBIndex++;
-	cubeHouseSFItem->Mat = mMaterials["wallMat"].get();
-	cubeHouseSFItem->Geo = mGeometries["shapeGeo"].get();
-	cubeHouseSFItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	cubeHouseSFItem->IndexCount = cubeHouseSFItem->Geo->DrawArgs["box"].IndexCount;
-	cubeHouseSFItem->StartIndexLocation = cubeHouseSFItem->Geo->DrawArgs["box"].StartIndexLocation;
-	cubeHouseSFItem->BaseVertexLocation = cubeHouseSFItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(cubeHouseSFItem));
-
-
-	// Right House Small house front Cube Top
-	auto cubeHouseSFTItem = std::make_unique<RenderItem>();
-	XMMATRIX cubeHouseSFTWorld = XMMatrixScaling(1.0f, 1.0f, 1.0f) * XMMatrixTranslation(5.0f, 1.5f, -6.0f);
-	XMStoreFloat4x4(&cubeHouseSFTItem->World, cubeHouseSFTWorld);
-	cubeHouseSFTItem->TexTransform = MathHelper::Identity4x4();
-	cubeHouseSFTItem->ObjCBIndex = objCBIndex++;
-	cubeHouseSFTItem->Mat = mMaterials["coneMat"].get();
-	cubeHouseSFTItem->Geo = mGeometries["shapeGeo"].get();
-	cubeHouseSFTItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	cubeHouseSFTItem->IndexCount = cubeHouseSFTItem->Geo->DrawArgs["pyramid"].IndexCount;
-	cubeHouseSFTItem->StartIndexLocation = cubeHouseSFTItem->Geo->DrawArgs["pyramid"].StartIndexLocation;
-	cubeHouseSFTItem->BaseVertexLocation = cubeHouseSFTItem->Geo->DrawArgs["pyramid"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(cubeHouseSFTItem));
+		mSceneGeometries[i] = geo->second.get();
+		mSceneSubmeshes[i] = &submesh->second;
+	}
 
-	
-	// Right House Small house back Cube
-	auto cubeHouseSBItem = std::make_unique<RenderItem>();
-	XMMATRIX cubeHouseSBWorld = XMMatrixScaling(1.0f, 1.0f, 1.0f) * XMMatrixTranslation(5.0f, 0.5f, -8.0f);
-	XMStoreFloat4x4(&cubeHouseSBItem->World, cubeHouseSBWorld);
-	cubeHouseSBItem->TexTransform = MathHelper::Identity4x4();
-	cubeHouseSBItem->ObjCBIndex = objCBIndex++;
-	cubeHouseSBItem->Mat = mMaterials["wallMat"].get();
-	cubeHouseSBItem->Geo = mGeometries["shapeGeo"].get();
-	cubeHouseSBItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	cubeHouseSBItem->IndexCount = cubeHouseSBItem->Geo->DrawArgs["box"].IndexCount;
-	cubeHouseSBItem->StartIndexLocation = cubeHouseSBItem->Geo->DrawArgs["box"].StartIndexLocation;
-	cubeHouseSBItem->BaseVertexLocation = cubeHouseSBItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(cubeHouseSBItem));
+	for(RenderItem& ri : mAllRitems)
+	{
+		if(ri.Mat == nullptr)
+			ri.Mat = mSceneMaterials[ri.MatIndex];
 
-	
-	// Right House Small house back Cube Top
-	auto cubeHouseSBTItem = std::make_unique<RenderItem>();
-	XMMATRIX cubeHouseSBTWorld = XMMatrixScaling(1.0f, 1.0f, 1.0f) * XMMatrixTranslation(5.0f, 1.5f, -8.0f);
-	XMStoreFloat4x4(&cubeHouseSBTItem->World, cubeHouseSBTWorld);
-	cubeHouseSBTItem->TexTransform = MathHelper::Identity4x4();
-	cubeHouseSBTItem->ObjCBIndex = objCBIndex++;
-	cubeHouseSBTItem->Mat = mMaterials["coneMat"].get();
-	cubeHouseSBTItem->Geo = mGeometries["shapeGeo"].get();
-	cubeHouseSBTItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	cubeHouseSBTItem->IndexCount = cubeHouseSBTItem->Geo->DrawArgs["truncPyramid"].IndexCount;
-	cubeHouseSBTItem->StartIndexLocation = cubeHouseSBTItem->Geo->DrawArgs["truncPyramid"].StartIndexLocation;
-	cubeHouseSBTItem->BaseVertexLocation = cubeHouseSBTItem->Geo->DrawArgs["truncPyramid"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(cubeHouseSBTItem));
-
-
-	// Left House long Cube
-	auto cubeHouseLItem = std::make_unique<RenderItem>();
-	XMMATRIX cubeHouseLWorld = XMMatrixScaling(2.0f, 2.0f, 6.0f) * XMMatrixTranslation(-7.5f, 1.0f, -5.5f);
-	XMStoreFloat4x4(&cubeHouseLItem->World, cubeHouseLWorld);
-	cubeHouseLItem->TexTransform = MathHelper::Identity4x4();
-	cubeHouseLItem->ObjCBIndex = objCBIndex++;
-	cubeHouseLItem->Mat = mMaterials["wallMat"].get();
-	cubeHouseLItem->Geo = mGeometries["shapeGeo"].get();
-	cubeHouseLItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	cubeHouseLItem->IndexCount = cubeHouseLItem->Geo->DrawArgs["box"].IndexCount;
-	cubeHouseLItem->StartIndexLocation = cubeHouseLItem->Geo->DrawArgs["box"].StartIndexLocation;
-	cubeHouseLItem->BaseVertexLocation = cubeHouseLItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(cubeHouseLItem));
-
-
-	// Left House long Cube L
-	auto cubeHouseLLItem = std::make_unique<RenderItem>();
-	XMMATRIX cubeHouseLLWorld = XMMatrixScaling(2.0f, 2.0f, 2.0f) * XMMatrixTranslation(-5.5f, 1.0f, -7.5f);
-	XMStoreFloat4x4(&cubeHouseLLItem->World, cubeHouseLLWorld);
-	cubeHouseLLItem->TexTransform = MathHelper::Identity4x4();
-	cubeHouseLLItem->ObjCBIndex = objCBIndex++;
-	cubeHouseLLItem->Mat = mMaterials["wallMat"].get();
-	cubeHouseLLItem->Geo = mGeometries["shapeGeo"].get();
-	cubeHouseLLItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	cubeHouseLLItem->IndexCount = cubeHouseLLItem->Geo->DrawArgs["box"].IndexCount;
-	cubeHouseLLItem->StartIndexLocation = cubeHouseLLItem->Geo->DrawArgs["box"].StartIndexLocation;
-	cubeHouseLLItem->BaseVertexLocation = cubeHouseLLItem->Geo->DrawArgs["box"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(cubeHouseLLItem));
-
-
-	// Left House long top
-	auto cubeHouseLTItem = std::make_unique<RenderItem>();
-	XMMATRIX cubeHouseLTWorld = XMMatrixScaling(2.0f, 2.0f, 6.0f) * XMMatrixTranslation(-7.5f, 3.0f, -5.5f);
-	XMStoreFloat4x4(&cubeHouseLTItem->World, cubeHouseLTWorld);
-	cubeHouseLTItem->TexTransform = MathHelper::Identity4x4();
-	cubeHouseLTItem->ObjCBIndex = objCBIndex++;
-	cubeHouseLTItem->Mat = mMaterials["coneMat"].get();
-	cubeHouseLTItem->Geo = mGeometries["shapeGeo"].get();
-	cubeHouseLTItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	cubeHouseLTItem->IndexCount = cubeHouseLTItem->Geo->DrawArgs["triangularPrism"].IndexCount;
-	cubeHouseLTItem->StartIndexLocation = cubeHouseLTItem->Geo->DrawArgs["triangularPrism"].StartIndexLocation;
-	cubeHouseLTItem->BaseVertexLocation = cubeHouseLTItem->Geo->DrawArgs["triangularPrism"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(cubeHouseLTItem));
-
-
-	// Left House long Cube L Top
-	auto cubeHouseLLTItem = std::make_unique<RenderItem>();
-	XMMATRIX cubeHouseLLTWorld = XMMatrixRotationY(90.0f * (XM_PI / 180.0f)) * XMMatrixScaling(3.0f, 2.0f, 2.0f) * XMMatrixTranslation(-6.0f, 3.0f, -7.5f);
-	XMStoreFloat4x4(&cubeHouseLLTItem->World, cubeHouseLLTWorld);
-	cubeHouseLLTItem->TexTransform = MathHelper::Identity4x4();
-	cubeHouseLLTItem->ObjCBIndex = objCBIndex++;
-	cubeHouseLLTItem->Mat = mMaterials["coneMat"].get();
-	cubeHouseLLTItem->Geo = mGeometries["shapeGeo"].get();
-	cubeHouseLLTItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	cubeHouseLLTItem->IndexCount = cubeHouseLLTItem->Geo->DrawArgs["triangularPrism"].IndexCount;
-	cubeHouseLLTItem->StartIndexLocation = cubeHouseLLTItem->Geo->DrawArgs["triangularPrism"].StartIndexLocation;
-	cubeHouseLLTItem->BaseVertexLocation = cubeHouseLLTItem->Geo->DrawArgs["triangularPrism"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(cubeHouseLLTItem));
-
-
-	// Primitive Examples
-	/*
-	// Cone 
-	auto coneItem = std::make_unique<RenderItem>();
-	XMMATRIX coneWorld = XMMatrixRotationY(0.0f * (XM_PI / 180.0f)) * XMMatrixScaling(1.5f, 2.0f, 1.5f) * XMMatrixTranslation(-5.0f, 1.0f, -4.0f);
-	XMStoreFloat4x4(&coneItem->World, coneWorld);
-	coneItem->TexTransform = MathHelper::Identity4x4();
-	coneItem->ObjCBIndex = objCBIndex++;
-	coneItem->Mat = mMaterials["coneMat"].get();
-	coneItem->Geo = mGeometries["shapeGeo"].get();
-	coneItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	coneItem->IndexCount = coneItem->Geo->DrawArgs["cone"].IndexCount;
-	coneItem->StartIndexLocation = coneItem->Geo->DrawArgs["cone"].StartIndexLocation;
-	coneItem->BaseVertexLocation = coneItem->Geo->DrawArgs["cone"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(coneItem));
-
-	// Wedge
-	auto wedgeItem = std::make_unique<RenderItem>();
-	XMMATRIX wedgeWorld  = XMMatrixScaling(1.5f, 2.0f, 1.5f) * XMMatrixTranslation(-3.0f, 1.0f, -4.0f);
-	XMStoreFloat4x4(&wedgeItem->World, wedgeWorld);
-	wedgeItem->TexTransform = MathHelper::Identity4x4();
-	wedgeItem->ObjCBIndex = objCBIndex++;
-	wedgeItem->Mat = mMaterials["coneMat"].get();
-	wedgeItem->Geo = mGeometries["shapeGeo"].get();
-	wedgeItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	wedgeItem->IndexCount = wedgeItem->Geo->DrawArgs["wedge"].IndexCount;
-	wedgeItem->StartIndexLocation = wedgeItem->Geo->DrawArgs["wedge"].StartIndexLocation;
-	wedgeItem->BaseVertexLocation = wedgeItem->Geo->DrawArgs["wedge"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(wedgeItem));
-
-	// Pyramid
-	auto pyramidItem = std::make_unique<RenderItem>();
-	XMMATRIX pyramidWorld = XMMatrixScaling(1.5f, 2.0f, 1.5f) * XMMatrixTranslation(-1.0f, 1.0f, -4.0f);
-	XMStoreFloat4x4(&pyramidItem->World, pyramidWorld);
-	pyramidItem->TexTransform = MathHelper::Identity4x4();
-	pyramidItem->ObjCBIndex = objCBIndex++;
-	pyramidItem->Mat = mMaterials["coneMat"].get();
-	pyramidItem->Geo = mGeometries["shapeGeo"].get();
-	pyramidItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	pyramidItem->IndexCount = pyramidItem->Geo->DrawArgs["pyramid"].IndexCount;
-	pyramidItem->StartIndexLocation = pyramidItem->Geo->DrawArgs["pyramid"].StartIndexLocation;
-	pyramidItem->BaseVertexLocation = pyramidItem->Geo->DrawArgs["pyramid"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(pyramidItem));
-
-	// Truncated pyramid
-	auto truncPyramidItem = std::make_unique<RenderItem>();
-	XMMATRIX truncPyramidWorld = XMMatrixScaling(1.5f, 2.0f, 1.5f) * XMMatrixTranslation(1.0f, 1.0f, -4.0f);
-	XMStoreFloat4x4(&truncPyramidItem->World, truncPyramidWorld);
-	truncPyramidItem->TexTransform = MathHelper::Identity4x4();
-	truncPyramidItem->ObjCBIndex = objCBIndex++;
-	truncPyramidItem->Mat = mMaterials["coneMat"].get();
-	truncPyramidItem->Geo = mGeometries["shapeGeo"].get();
-	truncPyramidItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	truncPyramidItem->IndexCount = truncPyramidItem->Geo->DrawArgs["truncPyramid"].IndexCount;
-	truncPyramidItem->StartIndexLocation = truncPyramidItem->Geo->DrawArgs["truncPyramid"].StartIndexLocation;
-	truncPyramidItem->BaseVertexLocation = truncPyramidItem->Geo->DrawArgs["truncPyramid"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(truncPyramidItem));
-
-	// Triangular prism
-	auto triangularPrismItem = std::make_unique<RenderItem>();
-	XMMATRIX triangularPrismWorld = XMMatrixScaling(1.5f, 2.0f, 1.5f) * XMMatrixTranslation(3.0f, 1.0f, -4.0f);
-	XMStoreFloat4x4(&triangularPrismItem->World, triangularPrismWorld);
-	triangularPrismItem->TexTransform = MathHelper::Identity4x4();
-	triangularPrismItem->ObjCBIndex = objCBIndex++;
-	triangularPrismItem->Mat = mMaterials["coneMat"].get();
-	triangularPrismItem->Geo = mGeometries["shapeGeo"].get();
-	triangularPrismItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	triangularPrismItem->IndexCount = triangularPrismItem->Geo->DrawArgs["triangularPrism"].IndexCount;
-	triangularPrismItem->StartIndexLocation = triangularPrismItem->Geo->DrawArgs["triangularPrism"].StartIndexLocation;
-	triangularPrismItem->BaseVertexLocation = triangularPrismItem->Geo->DrawArgs["triangularPrism"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(triangularPrismItem));
-
-	// Tetrahedron
-	auto tetrahedronItem = std::make_unique<RenderItem>();
-	XMMATRIX tetrahedronWorld = XMMatrixScaling(1.5f, 2.0f, 1.5f) * XMMatrixTranslation(5.0f, 1.0f, -4.0f);
-	XMStoreFloat4x4(&tetrahedronItem->World, tetrahedronWorld);
-	tetrahedronItem->TexTransform = MathHelper::Identity4x4();
-	tetrahedronItem->ObjCBIndex = objCBIndex++;
-	tetrahedronItem->Mat = mMaterials["coneMat"].get();
-	tetrahedronItem->Geo = mGeometries["shapeGeo"].get();
-	tetrahedronItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	tetrahedronItem->IndexCount = tetrahedronItem->Geo->DrawArgs["tetrahedron"].IndexCount;
-	tetrahedronItem->StartIndexLocation = tetrahedronItem->Geo->DrawArgs["tetrahedron"].StartIndexLocation;
-	tetrahedronItem->BaseVertexLocation = tetrahedronItem->Geo->DrawArgs["tetrahedron"].BaseVertexLocation;
-	mAllRitems.push_back(std::move(tetrahedronItem));
-	*/
+		if(mSceneGeometries[ri.ShapeIndex] != nullptr && ri.Submesh != mSceneSubmeshes[ri.ShapeIndex])
+		{
+			const SubmeshGeometry* submesh = mSceneSubmeshes[ri.ShapeIndex];
+
+			ri.Geo = mSceneGeometries[ri.ShapeIndex];
+			ri.Submesh = submesh;
+			ri.IndexCount = submesh->IndexCount;
+			ri.StartIndexLocation = submesh->StartIndexLocation;
+			ri.BaseVertexLocation = submesh->BaseVertexLocation;
+
+			// The object constants carry the submesh's vertex decode.
+			const VertexDecode& decode = submesh->Decode;
+			mObjectDecode[2*ri.ObjCBIndex] = XMFLOAT4A(decode.Scale.x, decode.Scale.y, decode.Scale.z, 0.0f);
+			mObjectDecode[2*ri.ObjCBIndex + 1] = XMFLOAT4A(decode.Bias.x, decode.Bias.y, decode.Bias.z, 0.0f);
+			MarkRenderItemDirty(ri.ObjCBIndex);
+		}
+	}
+}
 
-	// All the render items are opaque.
-	for(auto& e : mAllRitems)
-		mOpaqueRitems.push_back(e.get());
+// Updates the world bounds of a render item whose transform or submesh changed and
+// queues its object constants for every frame resource.
+void LitColumnsApp::MarkRenderItemDirty(UINT objCBIndex)
+{
+	RenderItem& ri = mAllRitems[objCBIndex];
+	if(ri.Submesh != nullptr)
+	{
+		XMMATRIX world = mWorldTransforms.Get(objCBIndex);
+		ri.Submesh->Bounds.Transform(ri.WorldBounds, world);
+		ri.Submesh->Sphere.Transform(ri.WorldSphere, world);
+		mRitemCuller.SetBounds(objCBIndex, ri.WorldSphere, ri.WorldBounds);
+
+		XMVECTOR det = XMMatrixDeterminant(world);
+		XMStoreFloat4x4(&ri.InvWorld, XMMatrixInverse(&det, world));
+		ri.Mirrored = XMVectorGetX(det) <= 0.0f;
+	}
+
+	mObjectCBDirty.MarkDirty(objCBIndex);
 }
 
 void LitColumnsApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems)
@@ -1659,13 +955,51 @@ void LitColumnsApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const st
 	auto objectCB = mCurrFrameResource->ObjectCB->Resource();
 	auto matCB = mCurrFrameResource->MaterialCB->Resource();
 
+	XMVECTOR worldPlanes[6];
+	for(int p = 0; p < 6; ++p)
+		worldPlanes[p] = XMLoadFloat4(&mFrustumPlanes[p]);
+	XMVECTOR eyePos = XMLoadFloat3(&mEyePos);
+
+	// Object space error to pixels at unit distance.
+	float pixelsPerUnit = 0.5f*mClientHeight*mProj(1, 1);
+
+	// Geometries in the same registry arenas have identical views, so the buffers are
+	// only rebound when they actually change.
+	D3D12_VERTEX_BUFFER_VIEW boundVertexBuffer = {};
+	D3D12_INDEX_BUFFER_VIEW boundIndexBuffer = {};
+
+	auto setVertexBuffer = [cmdList, &boundVertexBuffer](const D3D12_VERTEX_BUFFER_VIEW& vbv)
+	{
+		if(vbv.BufferLocation != boundVertexBuffer.BufferLocation || vbv.SizeInBytes != boundVertexBuffer.SizeInBytes ||
+		   vbv.StrideInBytes != boundVertexBuffer.StrideInBytes)
+		{
+			cmdList->IASetVertexBuffers(0, 1, &vbv);
+			boundVertexBuffer = vbv;
+		}
+	};
+
+	auto setIndexBuffer = [cmdList, &boundIndexBuffer](const D3D12_INDEX_BUFFER_VIEW& ibv)
+	{
+		if(ibv.BufferLocation != boundIndexBuffer.BufferLocation || ibv.SizeInBytes != boundIndexBuffer.SizeInBytes ||
+		   ibv.Format != boundIndexBuffer.Format)
+		{
+			cmdList->IASetIndexBuffer(&ibv);
+			boundIndexBuffer = ibv;
+		}
+	};
+
     // For each render item...
     for(size_t i = 0; i < ritems.size(); ++i)
     {
         auto ri = ritems[i];
 
-        cmdList->IASetVertexBuffers(0, 1, &ri->Geo->VertexBufferView());
-        cmdList->IASetIndexBuffer(&ri->Geo->IndexBufferView());
+		// Still loading.
+		if(ri->Geo == nullptr || ri->Mat == nullptr)
+			continue;
+
+        const MeshGeometry* geo = ri->Geo;
+
+        setVertexBuffer(geo->VertexBufferView());
         cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
 
         D3D12_GPU_VIRTUAL_ADDRESS objCBAddress = objectCB->GetGPUVirtualAddress() + ri->ObjCBIndex*objCBByteSize;
@@ -1674,6 +1008,81 @@ void LitColumnsApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const st
         cmdList->SetGraphicsRootConstantBufferView(0, objCBAddress);
 		cmdList->SetGraphicsRootConstantBufferView(1, matCBAddress);
 
-        cmdList->DrawIndexedInstanced(ri->IndexCount, 1, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
+        if(ri->Submesh == nullptr)
+        {
+            setIndexBuffer(geo->IndexBufferView());
+            cmdList->DrawIndexedInstanced(ri->IndexCount, 1, geo->GetStartIndexLocation(geo->IndexFormat, ri->StartIndexLocation),
+                geo->BaseVertexLocation + ri->BaseVertexLocation, 0);
+            continue;
+        }
+
+		XMMATRIX world = mWorldTransforms.Get(ri->ObjCBIndex);
+
+		// Pick the coarsest level of detail whose error, scaled by the largest axis
+		// scale of the world matrix, projects to at most gLodPixelError pixels.
+		const SubmeshGeometry* submesh = ri->Submesh;
+		if(!submesh->Lods.empty())
+		{
+			float scale = sqrtf(MathHelper::Max(XMVectorGetX(XMVector3LengthSq(world.r[0])),
+				MathHelper::Max(XMVectorGetX(XMVector3LengthSq(world.r[1])), XMVectorGetX(XMVector3LengthSq(world.r[2])))));
+			float distance = XMVectorGetX(XMVector3Length(eyePos - world.r[3]));
+
+			for(const SubmeshGeometry* lod : ri->Submesh->Lods)
+			{
+				if(lod->LodError*scale*pixelsPerUnit > gLodPixelError*distance)
+					break;
+
+				submesh = lod;
+			}
+		}
+
+		// Levels of detail may use a different index size than the full mesh.
+		setIndexBuffer(geo->IndexBufferView(submesh->IndexFormat));
+
+		UINT startIndexLocation = geo->GetStartIndexLocation(submesh->IndexFormat, submesh->StartIndexLocation);
+		INT baseVertexLocation = geo->BaseVertexLocation + submesh->BaseVertexLocation;
+
+		if(submesh->Clusters.empty())
+		{
+			cmdList->DrawIndexedInstanced(submesh->IndexCount, 1, startIndexLocation, baseVertexLocation, 0);
+			continue;
+		}
+
+		// Cull the clusters in object space: bring the eye and the frustum planes
+		// into the item's local space instead of transforming every cluster.
+		XMMATRIX worldT = XMMatrixTranspose(world);
+
+		XMVECTOR localPlanes[6];
+		for(int p = 0; p < 6; ++p)
+			localPlanes[p] = XMPlaneNormalize(XMVector4Transform(worldPlanes[p], worldT));
+
+		XMVECTOR localEye = XMVector3TransformCoord(eyePos, XMLoadFloat4x4(&ri->InvWorld));
+
+		// A mirroring transform flips the winding, so the normal cones no longer apply.
+		bool testBackfacing = !ri->Mirrored;
+
+		// Merge consecutive visible clusters into a single draw.
+		UINT runStart = 0;
+		UINT runCount = 0;
+		for(const MeshCluster& cluster : submesh->Clusters)
+		{
+			if(MeshOptimizer::IsClusterVisible(cluster, localEye, localPlanes, testBackfacing))
+			{
+				if(runCount > 0 && runStart + runCount == cluster.StartIndex)
+				{
+					runCount += cluster.IndexCount;
+					continue;
+				}
+
+				if(runCount > 0)
+					cmdList->DrawIndexedInstanced(runCount, 1, startIndexLocation + runStart, baseVertexLocation, 0);
+
+				runStart = cluster.StartIndex;
+				runCount = cluster.IndexCount;
+			}
+		}
+
+		if(runCount > 0)
+			cmdList->DrawIndexedInstanced(runCount, 1, startIndexLocation + runStart, baseVertexLocation, 0);
     }
 }
@@ -25,6 +25,13 @@
 cbuffer cbPerObject : register(b0)
 {
     float4x4 gWorld;
+    float4x4 gTexTransform;
+
+    // Quantized positions are restored as gPosDecodeBias + gPosDecodeScale*PosL.
+    float3 gPosDecodeScale;
+    float cbPerObjectPad0;
+    float3 gPosDecodeBias;
+    float cbPerObjectPad1;
 };
 
 cbuffer cbMaterial : register(b1)
@@ -63,8 +70,8 @@ cbuffer cbPass : register(b2)
  
 struct VertexIn
 {
-	float3 PosL    : POSITION;
-    float3 NormalL : NORMAL;
+	float3 PosL    : POSITION; // R16G16B16A16_UNORM, relative to the submesh bounds
+    float2 NormalL : NORMAL;   // R16G16_SNORM, octahedral encoded
 };
 
 struct VertexOut
@@ -74,16 +81,28 @@ struct VertexOut
     float3 NormalW : NORMAL;
 };
 
+// Unfolds an octahedral encoded unit vector.
+float3 DecodeOctahedral(float2 e)
+{
+    float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += n.xy >= 0.0f ? -t : t;
+    return normalize(n);
+}
+
 VertexOut VS(VertexIn vin)
 {
 	VertexOut vout = (VertexOut)0.0f;
+
+    float3 posL = gPosDecodeBias + gPosDecodeScale*vin.PosL;
+    float3 normalL = DecodeOctahedral(vin.NormalL);
 	
     // Transform to world space.
-    float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
+    float4 posW = mul(float4(posL, 1.0f), gWorld);
     vout.PosW = posW.xyz;
 
     // Assumes nonuniform scaling; otherwise, need to use inverse-transpose of world matrix.
-    vout.NormalW = mul(vin.NormalL, (float3x3)gWorld);
+    vout.NormalW = mul(normalL, (float3x3)gWorld);
 
     // Transform to homogeneous clip space.
     vout.PosH = mul(posW, gViewProj);
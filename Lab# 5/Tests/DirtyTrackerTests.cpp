@@ -0,0 +1,190 @@
+//***************************************************************************************
+// DirtyTrackerTests.cpp
+//
+// DirtyTracker on either side of the point where TakePending stops sorting its list and
+// scans the masks instead, at a sixteenth of the objects; both must return every
+// object marked since the frame resource last took them, once and in ascending order,
+// and leave the other frame resources' lists alone.  Shrinking drops the pending
+// objects past the new count, and the constructor accepts 1 to 8 frame resources.
+// Last, a model check over random marks, takes and resizes.
+//***************************************************************************************
+
+#include "Test.h"
+#include "../../Common/DirtyTracker.h"
+#include <algorithm>
+#include <random>
+#include <set>
+#include <stdexcept>
+
+namespace
+{
+	bool Takes(DirtyTracker& tracker, UINT frameIndex, const std::vector<UINT>& expected)
+	{
+		return tracker.TakePending(frameIndex) == expected;
+	}
+
+	// Marks count objects spread over the tracker in a scrambled order, each twice, and
+	// returns them sorted.
+	std::vector<UINT> MarkSpread(DirtyTracker& tracker, UINT count)
+	{
+		std::vector<UINT> marked;
+		for(UINT k = 0; k < count; ++k)
+			marked.push_back(k*(tracker.GetCount() / count));
+
+		std::vector<UINT> order = marked;
+		std::shuffle(order.begin(), order.end(), std::mt19937(7));
+		for(UINT i : order)
+			tracker.MarkDirty(i);
+		for(UINT i : order)
+			tracker.MarkDirty(i);
+
+		return marked;
+	}
+
+	void CheckSortAndScan()
+	{
+		// 1600 objects: lists shorter than 100 are sorted, longer ones come from the masks.
+		for(UINT count : { 1u, 99u, 100u, 101u, 1600u })
+		{
+			DirtyTracker tracker(3);
+			tracker.Resize(1600);
+
+			const std::vector<UINT> marked = MarkSpread(tracker, count);
+			CHECK(Takes(tracker, 0, marked));
+			CHECK(Takes(tracker, 0, {}));
+
+			// Marking again after frame resource 0 took the objects queues them for it
+			// alone; the others still have them once.
+			for(UINT i : marked)
+				tracker.MarkDirty(i);
+			CHECK(Takes(tracker, 1, marked));
+			CHECK(Takes(tracker, 0, marked));
+			CHECK(Takes(tracker, 2, marked));
+			CHECK(Takes(tracker, 1, {}));
+			CHECK(Takes(tracker, 2, {}));
+		}
+
+		// A frame resource that falls behind switches from sorting to scanning as its
+		// list grows, without losing what it had.
+		DirtyTracker tracker(2);
+		tracker.Resize(1600);
+		tracker.MarkDirty(1500);
+		CHECK(Takes(tracker, 0, { 1500 }));
+		for(UINT i = 0; i < 200; ++i)
+			tracker.MarkDirty(i);
+
+		std::vector<UINT> expected(200);
+		for(UINT i = 0; i < 200; ++i)
+			expected[i] = i;
+		CHECK(Takes(tracker, 0, expected));
+
+		expected.push_back(1500);
+		CHECK(Takes(tracker, 1, expected));
+	}
+
+	void CheckResize()
+	{
+		for(UINT count : { 3u, 40u })
+		{
+			DirtyTracker tracker(2);
+			tracker.Resize(640);
+			std::vector<UINT> marked = MarkSpread(tracker, count);
+
+			// Shrinking drops the objects past the end from both lists.
+			tracker.Resize(320);
+			CHECK(tracker.GetCount() == 320);
+			marked.erase(std::remove_if(marked.begin(), marked.end(), [](UINT i) { return i >= 320; }), marked.end());
+			CHECK(Takes(tracker, 0, marked));
+
+			// Objects that come back start clean, and are queued once when marked.
+			tracker.Resize(640);
+			tracker.MarkDirty(600);
+			marked.push_back(600);
+			CHECK(Takes(tracker, 1, marked));
+			CHECK(Takes(tracker, 0, { 600 }));
+		}
+
+		DirtyTracker tracker(1);
+		tracker.Resize(8);
+		tracker.MarkDirty(7);
+		tracker.Resize(0);
+		CHECK(tracker.GetCount() == 0);
+		CHECK(Takes(tracker, 0, {}));
+	}
+
+	void CheckFrameResourceCounts()
+	{
+		for(UINT frameResourceCount : { 0u, DirtyTracker::kMaxFrameResources + 1 })
+		{
+			bool threw = false;
+			try { DirtyTracker tracker(frameResourceCount); }
+			catch(const std::invalid_argument&) { threw = true; }
+			CHECK(threw);
+		}
+
+		// Every one of the most frame resources the masks have bits for gets its own list.
+		DirtyTracker tracker(DirtyTracker::kMaxFrameResources);
+		tracker.Resize(4);
+		tracker.MarkDirty(2);
+		tracker.MarkDirty(2);
+		for(UINT f = 0; f < DirtyTracker::kMaxFrameResources; ++f)
+			CHECK(Takes(tracker, f, { 2 }));
+
+		tracker.MarkDirty(3);
+		CHECK(Takes(tracker, DirtyTracker::kMaxFrameResources - 1, { 3 }));
+		CHECK(Takes(tracker, 0, { 3 }));
+	}
+
+	// Random marks, takes and resizes against a set of pending objects per frame resource.
+	void CheckAgainstModel()
+	{
+		const UINT frameResourceCount = 3;
+		DirtyTracker tracker(frameResourceCount);
+		std::vector<std::set<UINT>> model(frameResourceCount);
+
+		UINT count = 2000;
+		tracker.Resize(count);
+
+		std::mt19937 random(11);
+		for(int step = 0; step < 3000; ++step)
+		{
+			const UINT action = random() % 100;
+			if(action < 90)
+			{
+				// Bursts of marks, from a few to a good part of the objects.
+				const UINT marks = random() % 2 == 0 ? random() % 8 : random() % 400;
+				for(UINT k = 0; k < marks; ++k)
+				{
+					const UINT i = random() % count;
+					tracker.MarkDirty(i);
+					for(auto& pending : model)
+						pending.insert(i);
+				}
+			}
+			else if(action < 98)
+			{
+				const UINT f = random() % frameResourceCount;
+				CHECK(Takes(tracker, f, std::vector<UINT>(model[f].begin(), model[f].end())));
+				model[f].clear();
+			}
+			else
+			{
+				count = 1000 + random() % 2000;
+				tracker.Resize(count);
+				for(auto& pending : model)
+					pending.erase(pending.lower_bound(count), pending.end());
+			}
+		}
+
+		for(UINT f = 0; f < frameResourceCount; ++f)
+			CHECK(Takes(tracker, f, std::vector<UINT>(model[f].begin(), model[f].end())));
+	}
+}
+
+void RunDirtyTrackerTests(const TestContext& context)
+{
+	CheckSortAndScan();
+	CheckResize();
+	CheckFrameResourceCounts();
+	CheckAgainstModel();
+}
@@ -0,0 +1,227 @@
+//***************************************************************************************
+// FrustumCullerTests.cpp
+//
+// FrustumCuller against DirectXCollision over random objects and random perspective
+// frusta.  The culler must keep exactly the objects whose sphere and box are both not
+// behind any plane by BoundingSphere::ContainedBy and BoundingBox::ContainedBy, list
+// them in ascending order, and never cull an object whose sphere and box both
+// intersect the frustum by BoundingFrustum::Contains.  Objects never set, or dropped by
+// a shrink, must stay culled.  Every vector width the CPU supports is tested.
+//***************************************************************************************
+
+#include "Test.h"
+#include "../../Common/FrustumCuller.h"
+#include "../../Common/MathHelper.h"
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	// Not a multiple of the culler's block size, so the last block is partial.
+	const UINT kObjectCount = 10007;
+	const int kFrustumCount = 25;
+
+	struct Object
+	{
+		bool Set = false;
+		BoundingSphere Sphere;
+		BoundingBox Box;
+	};
+
+	// Whether an object is within tolerance of a plane, where float rounding may put it
+	// on either side.
+	bool NearPlane(const Object& o, const XMVECTOR planes[6])
+	{
+		const float tolerance = 1e-3f;
+		for(int p = 0; p < 6; ++p)
+		{
+			XMFLOAT4 plane;
+			XMStoreFloat4(&plane, planes[p]);
+
+			float sphereDistance = plane.x*o.Sphere.Center.x + plane.y*o.Sphere.Center.y + plane.z*o.Sphere.Center.z + plane.w;
+			float boxDistance = plane.x*o.Box.Center.x + plane.y*o.Box.Center.y + plane.z*o.Box.Center.z + plane.w;
+			float boxReach = fabsf(plane.x)*o.Box.Extents.x + fabsf(plane.y)*o.Box.Extents.y + fabsf(plane.z)*o.Box.Extents.z;
+
+			if(fabsf(sphereDistance + o.Sphere.Radius) < tolerance || fabsf(boxDistance + boxReach) < tolerance)
+				return true;
+		}
+
+		return false;
+	}
+}
+
+void RunFrustumCullerTests(const TestContext& context)
+{
+	std::mt19937 random(11);
+	auto uniform = [&random](float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(random); };
+
+	// Boxes with a sphere around each.  Some spheres are much larger than their box, so
+	// the box is what culls them; every twelfth object is never set.
+	std::vector<Object> objects(kObjectCount);
+	FrustumCuller culler;
+	culler.Resize(kObjectCount);
+
+	for(UINT i = 0; i < kObjectCount; ++i)
+	{
+		if(i % 12 == 5)
+			continue;
+
+		Object& o = objects[i];
+		o.Set = true;
+		o.Box.Center = XMFLOAT3(uniform(-100.0f, 100.0f), uniform(-100.0f, 100.0f), uniform(-100.0f, 100.0f));
+		o.Box.Extents = XMFLOAT3(uniform(0.1f, 6.0f), uniform(0.1f, 6.0f), uniform(0.1f, 6.0f));
+
+		XMVECTOR extents = XMLoadFloat3(&o.Box.Extents);
+		XMVECTOR offset = XMVectorSet(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), 0.0f);
+		if(i % 3 == 0)
+			offset *= 8.0f;
+
+		XMStoreFloat3(&o.Sphere.Center, XMLoadFloat3(&o.Box.Center) + offset);
+		o.Sphere.Radius = XMVectorGetX(XMVector3Length(extents) + XMVector3Length(offset));
+
+		culler.SetBounds(i, o.Sphere, o.Box);
+	}
+
+	// Objects dropped by a shrink come back empty.
+	const UINT dropped = 5;
+	culler.Resize(kObjectCount - dropped);
+	culler.Resize(kObjectCount);
+	for(UINT i = kObjectCount - dropped; i < kObjectCount; ++i)
+		objects[i].Set = false;
+
+	CHECK(culler.GetCount() == kObjectCount);
+
+	size_t visibleTotal = 0;
+	size_t culledByBoxOnly = 0;
+	size_t culledBySphere = 0;
+	size_t nearPlaneMismatches = 0;
+
+	for(int f = 0; f < kFrustumCount; ++f)
+	{
+		XMVECTOR eye = XMVectorSet(uniform(-60.0f, 60.0f), uniform(-60.0f, 60.0f), uniform(-60.0f, 60.0f), 1.0f);
+		XMVECTOR target = XMVectorSet(uniform(-60.0f, 60.0f), uniform(-60.0f, 60.0f), uniform(-60.0f, 60.0f), 1.0f);
+		XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+		XMMATRIX view = XMMatrixLookAtLH(eye, target, up);
+		XMMATRIX proj = XMMatrixPerspectiveFovLH(uniform(0.2f, 0.6f)*MathHelper::Pi, uniform(0.5f, 2.0f),
+			uniform(0.1f, 2.0f), uniform(50.0f, 300.0f));
+
+		XMVECTOR planes[6];
+		MathHelper::ExtractFrustumPlanes(planes, XMMatrixMultiply(view, proj));
+
+		// DirectXCollision's planes face out of the frustum.
+		XMVECTOR outward[6];
+		for(int p = 0; p < 6; ++p)
+			outward[p] = XMVectorNegate(planes[p]);
+
+		BoundingFrustum frustum;
+		BoundingFrustum::CreateFromMatrix(frustum, proj);
+		XMVECTOR det = XMMatrixDeterminant(view);
+		frustum.Transform(frustum, XMMatrixInverse(&det, view));
+
+		// What DirectXCollision says about each object.
+		std::vector<bool> outside(kObjectCount), intersects(kObjectCount), nearPlane(kObjectCount);
+		for(UINT i = 0; i < kObjectCount; ++i)
+		{
+			const Object& o = objects[i];
+			if(!o.Set)
+				continue;
+
+			const bool sphereOut = o.Sphere.ContainedBy(outward[0], outward[1], outward[2],
+				outward[3], outward[4], outward[5]) == DISJOINT;
+			const bool boxOut = o.Box.ContainedBy(outward[0], outward[1], outward[2],
+				outward[3], outward[4], outward[5]) == DISJOINT;
+
+			outside[i] = sphereOut || boxOut;
+			intersects[i] = frustum.Contains(o.Sphere) != DISJOINT && frustum.Contains(o.Box) != DISJOINT;
+			nearPlane[i] = NearPlane(o, planes);
+
+			culledBySphere += sphereOut;
+			culledByBoxOnly += !sphereOut && boxOut;
+		}
+
+		// Every width the CPU has must give the same answer.
+		for(UINT width = 4; width <= (UINT)FrustumCuller::GetMaxWidth(); width *= 2)
+		{
+			culler.SetWidth((FrustumCuller::Width)width);
+			CHECK((UINT)culler.GetWidth() == width);
+
+			const UINT visibleCount = culler.Cull(planes);
+			const UINT* visible = culler.GetVisible();
+			visibleTotal += visibleCount;
+
+			bool ascending = true;
+			for(UINT k = 1; k < visibleCount; ++k)
+				ascending &= visible[k - 1] < visible[k];
+			CHECK(ascending);
+			CHECK(visibleCount == 0 || visible[visibleCount - 1] < kObjectCount);
+
+			std::vector<bool> kept(kObjectCount);
+			for(UINT k = 0; k < visibleCount; ++k)
+				kept[visible[k]] = true;
+
+			bool unsetKept = false;
+			bool matchesPlanes = true;
+			bool visibleCulled = false;
+			for(UINT i = 0; i < kObjectCount; ++i)
+			{
+				if(!objects[i].Set)
+				{
+					unsetKept |= kept[i];
+					continue;
+				}
+
+				if(kept[i] == outside[i])
+				{
+					if(nearPlane[i])
+						++nearPlaneMismatches;
+					else
+						matchesPlanes = false;
+				}
+
+				// The planes can only keep more than the exact tests, never less.
+				visibleCulled |= !kept[i] && intersects[i];
+			}
+
+			CHECK(!unsetKept);
+			CHECK(matchesPlanes);
+			CHECK(!visibleCulled);
+		}
+	}
+
+	// Every stage was exercised: objects kept, culled by their spheres, and culled by
+	// their boxes after their spheres straddled a plane.
+	CHECK(visibleTotal > 0);
+	CHECK(culledBySphere > 0);
+	CHECK(culledByBoxOnly > 0);
+	CHECK(nearPlaneMismatches < 10);
+
+	// Asking for more than the CPU has gets what it has.
+	culler.SetWidth(FrustumCuller::Width::Sixteen);
+	CHECK(culler.GetWidth() == FrustumCuller::GetMaxWidth());
+
+	// Nothing set, nothing kept, at every width.
+	FrustumCuller empty;
+	empty.Resize(13);
+	XMVECTOR planes[6];
+	MathHelper::ExtractFrustumPlanes(planes, XMMatrixPerspectiveFovLH(0.25f*MathHelper::Pi, 1.0f, 1.0f, 1000.0f));
+	for(UINT width = 4; width <= (UINT)FrustumCuller::GetMaxWidth(); width *= 2)
+	{
+		empty.SetWidth((FrustumCuller::Width)width);
+		CHECK(empty.Cull(planes) == 0);
+	}
+
+	// A shrink drops objects at once, not only when the culler grows again.
+	const BoundingSphere inFrontSphere(XMFLOAT3(0.0f, 0.0f, 10.0f), 1.0f);
+	const BoundingBox inFrontBox(XMFLOAT3(0.0f, 0.0f, 10.0f), XMFLOAT3(0.5f, 0.5f, 0.5f));
+	FrustumCuller shrunk;
+	shrunk.Resize(20);
+	for(UINT i = 0; i < 20; ++i)
+		shrunk.SetBounds(i, inFrontSphere, inFrontBox);
+	shrunk.Resize(18);
+	for(UINT width = 4; width <= (UINT)FrustumCuller::GetMaxWidth(); width *= 2)
+	{
+		shrunk.SetWidth((FrustumCuller::Width)width);
+		CHECK(shrunk.Cull(planes) == 18);
+	}
+}
@@ -0,0 +1,495 @@
+//***************************************************************************************
+// LegacyShapes.cpp
+//
+// The wedge, pyramid, truncated pyramid, triangular prism, tetrahedron and diamond
+// generators as they were before they were rewritten around constexpr unit tables,
+// together with the Subdivide and MidPoint they used.  ShapeTests checks the current
+// generators against these bit for bit.  Keep them as they are.
+//***************************************************************************************
+
+#include "LegacyShapes.h"
+#include <unordered_map>
+
+using namespace DirectX;
+
+namespace LegacyShapes
+{
+using Vertex = GeometryGenerator::Vertex;
+using MeshData = GeometryGenerator::MeshData;
+using uint32 = GeometryGenerator::uint32;
+using uint64 = GeometryGenerator::uint64;
+
+namespace
+{
+Vertex MidPoint(const Vertex& v0, const Vertex& v1);
+
+void Subdivide(MeshData& meshData)
+{
+	//       v1
+	//       *
+	//      / \
+	//     /   \
+	//  m0*-----*m1
+	//   / \   / \
+	//  /   \ /   \
+	// *-----*-----*
+	// v0    m2     v2
+
+	uint32 numVerts = (uint32)meshData.Vertices.size();
+	uint32 numTris = (uint32)meshData.Indices32.size()/3;
+
+	//
+	// Assign one midpoint vertex per unique edge.  Triangles that share an edge
+	// (by vertex index) share its midpoint, so hard edges built from duplicated
+	// vertices, like the box faces, stay split.
+	//
+
+	std::unordered_map<uint64, uint32> edgeMidPoints;
+	edgeMidPoints.reserve(numTris*3);
+
+	std::vector<uint32> edges;
+	edges.reserve(numTris*3);
+
+	std::vector<uint32> triMidPoints(numTris*3);
+
+	for(uint32 i = 0; i < numTris; ++i)
+	{
+		for(uint32 e = 0; e < 3; ++e)
+		{
+			// Edge e of the triangle runs v0->v1, v1->v2 and v0->v2 to match m0, m1, m2.
+			uint32 a = meshData.Indices32[i*3 + (e == 2 ? 0 : e)];
+			uint32 b = meshData.Indices32[i*3 + (e == 2 ? 2 : e+1)];
+
+			uint64 key = a < b ? ((uint64)a << 32) | b : ((uint64)b << 32) | a;
+
+			auto result = edgeMidPoints.emplace(key, numVerts + (uint32)edges.size()/2);
+			if(result.second)
+			{
+				edges.push_back(a);
+				edges.push_back(b);
+			}
+
+			triMidPoints[i*3 + e] = result.first->second;
+		}
+	}
+
+	//
+	// Generate the midpoints directly after the existing vertices.
+	//
+
+	uint32 numEdges = (uint32)edges.size()/2;
+	meshData.Vertices.resize(numVerts + numEdges);
+
+	for(uint32 i = 0; i < numEdges; ++i)
+		meshData.Vertices[numVerts + i] = MidPoint(meshData.Vertices[edges[i*2]], meshData.Vertices[edges[i*2+1]]);
+
+	//
+	// Emit four triangles per input triangle.  Walk backwards so the output,
+	// which is four times larger, never overwrites input that is still unread.
+	//
+
+	meshData.Indices32.resize(numTris*12);
+
+	for(uint32 i = numTris; i-- > 0;)
+	{
+		uint32 v0 = meshData.Indices32[i*3+0];
+		uint32 v1 = meshData.Indices32[i*3+1];
+		uint32 v2 = meshData.Indices32[i*3+2];
+
+		uint32 m0 = triMidPoints[i*3+0];
+		uint32 m1 = triMidPoints[i*3+1];
+		uint32 m2 = triMidPoints[i*3+2];
+
+		uint32* out = &meshData.Indices32[i*12];
+
+		out[0] = v0; out[1]  = m0; out[2]  = m2;
+		out[3] = m0; out[4]  = m1; out[5]  = m2;
+		out[6] = m2; out[7]  = m1; out[8]  = v2;
+		out[9] = m0; out[10] = v1; out[11] = m1;
+	}
+}
+
+Vertex MidPoint(const Vertex& v0, const Vertex& v1)
+{
+    XMVECTOR p0 = XMLoadFloat3(&v0.Position);
+    XMVECTOR p1 = XMLoadFloat3(&v1.Position);
+
+    XMVECTOR n0 = XMLoadFloat3(&v0.Normal);
+    XMVECTOR n1 = XMLoadFloat3(&v1.Normal);
+
+    XMVECTOR tan0 = XMLoadFloat3(&v0.TangentU);
+    XMVECTOR tan1 = XMLoadFloat3(&v1.TangentU);
+
+    XMVECTOR tex0 = XMLoadFloat2(&v0.TexC);
+    XMVECTOR tex1 = XMLoadFloat2(&v1.TexC);
+
+    // Compute the midpoints of all the attributes.  Vectors need to be normalized
+    // since linear interpolating can make them not unit length.  
+    XMVECTOR pos = 0.5f*(p0 + p1);
+    XMVECTOR normal = XMVector3Normalize(0.5f*(n0 + n1));
+    XMVECTOR tangent = XMVector3Normalize(0.5f*(tan0+tan1));
+    XMVECTOR tex = 0.5f*(tex0 + tex1);
+
+    Vertex v;
+    XMStoreFloat3(&v.Position, pos);
+    XMStoreFloat3(&v.Normal, normal);
+    XMStoreFloat3(&v.TangentU, tangent);
+    XMStoreFloat2(&v.TexC, tex);
+
+    return v;
+}
+}
+
+MeshData CreateDiamondOfDeath(float height)
+{
+	MeshData meshData;
+
+	//
+	// Create the vertices.
+	//
+
+	Vertex v[17];
+
+
+	float verts = 17.f;
+	float heightBottom;
+	heightBottom = 0.75f * height;
+
+	//Bottom point vert
+	v[0] = Vertex(0.0f, 0.25f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	// bottom center point
+	// Used polygon formula to create the large and small octagons
+	v[1] = Vertex(cos((1 * (2 * XM_PI)) / 8)*0.75f, heightBottom, sin((1 * (2 * XM_PI)) / 8)*0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	v[2] = Vertex(cos((2 * (2 * XM_PI)) / 8)*0.75f, heightBottom, sin((2 * (2 * XM_PI)) / 8)*0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	v[3] = Vertex(cos((3 * (2 * XM_PI)) / 8)*0.75f, heightBottom, sin((3 * (2 * XM_PI)) / 8)*0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	v[4] = Vertex(cos((4 * (2 * XM_PI)) / 8)*0.75f, heightBottom, sin((4 * (2 * XM_PI)) / 8)*0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	v[5] = Vertex(cos((5 * (2 * XM_PI)) / 8)*0.75f, heightBottom, sin((5 * (2 * XM_PI)) / 8)*0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	v[6] = Vertex(cos((6 * (2 * XM_PI)) / 8)*0.75f, heightBottom, sin((6 * (2 * XM_PI)) / 8)*0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	v[7] = Vertex(cos((7 * (2 * XM_PI)) / 8)*0.75f, heightBottom, sin((7 * (2 * XM_PI)) / 8)*0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	v[8] = Vertex(cos((8 * (2 * XM_PI)) / 8)*0.75f, heightBottom, sin((8 * (2 * XM_PI)) / 8)*0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	//Top Octagon Vets
+	v[9] = Vertex(cos((1 * (2 * XM_PI)) / 8)*0.25f, height, sin((1 * (2 * XM_PI)) / 8)*0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	v[10] = Vertex(cos((2 * (2 * XM_PI)) / 8)*0.25f, height, sin((2 * (2 * XM_PI)) / 8)*0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	v[11] = Vertex(cos((3 * (2 * XM_PI)) / 8)*0.25f, height, sin((3 * (2 * XM_PI)) / 8)*0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	v[12] = Vertex(cos((4 * (2 * XM_PI)) / 8)*0.25f, height, sin((4 * (2 * XM_PI)) / 8)*0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	v[13] = Vertex(cos((5 * (2 * XM_PI)) / 8)*0.25f, height, sin((5 * (2 * XM_PI)) / 8)*0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	v[14] = Vertex(cos((6 * (2 * XM_PI)) / 8)*0.25f, height, sin((6 * (2 * XM_PI)) / 8)*0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	v[15] = Vertex(cos((7 * (2 * XM_PI)) / 8)*0.25f, height, sin((7 * (2 * XM_PI)) / 8)*0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	v[16] = Vertex(cos((8 * (2 * XM_PI)) / 8)*0.25f, height, sin((8 * (2 * XM_PI)) / 8)*0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+
+	// The original read &v[0]..&v[36] out of this 17 element array, which appended 19
+	// unreferenced vertices of stack garbage and shifted every midpoint index by 19.
+	// Only the 17 real vertices are kept here; see ShapeTests.cpp.
+	meshData.Vertices.assign(&v[0], &v[17]);
+
+	uint32 i[72];
+
+	i[0] = 0;	i[1] = 1;	i[2] = 2;
+	i[3] = 0;	i[4] = 2;	i[5] = 3;
+	i[6] = 0;	i[7] = 3;	i[8] = 4;
+	i[9] = 0;	i[10] = 4;	i[11] = 5;
+	i[12] = 0;	i[13] = 5;	i[14] = 6;
+	i[15] = 0;	i[16] = 6;	i[17] = 7;
+	i[18] = 0;	i[19] = 7;	i[20] = 8;
+	i[21] = 0;	i[22] = 8;	i[23] = 1;
+
+
+	i[24] = 1;	i[25] = 9;	i[26] = 2;
+	i[27] = 2;	i[28] = 9;	i[29] = 10;
+	i[30] = 2;	i[31] = 10;	i[32] = 3;
+	i[33] = 3;	i[34] = 10;	i[35] = 11;
+	i[36] = 3;	i[37] = 11;	i[38] = 4;
+	i[39] = 4;	i[40] = 11;	i[41] = 12;
+	i[42] = 4;	i[43] = 12;	i[44] = 5;
+	i[45] = 5;	i[46] = 12;	i[47] = 13;
+	i[48] = 5;	i[49] = 13;	i[50] = 6;
+	i[51] = 6;	i[52] = 13;	i[53] = 14;
+	i[54] = 6;	i[55] = 14;	i[56] = 7;
+	i[57] = 7;	i[58] = 14;	i[59] = 15;
+	i[60] = 7;	i[61] = 15;	i[62] = 8;
+	i[63] = 8;	i[64] = 15;	i[65] = 16;
+	i[66] = 8;	i[67] = 16;	i[68] = 1;
+	i[69] = 1;	i[70] = 16;	i[71] = 9;
+	meshData.Indices32.assign(&i[0], &i[72]);
+
+	for (uint32 i = 0; i < 3; ++i)
+	{
+		Subdivide(meshData);
+	}
+
+	return meshData;
+}
+
+// Shape #2 - Wedge
+MeshData CreateWedge(float width, float depth, float height)
+{
+	MeshData meshData;
+
+	//
+	// Create the vertices.
+	//
+
+	Vertex v[6];
+	
+	v[0] = Vertex(-(width*0.5f), -(height*0.5f), -(depth*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-front-left
+	v[1] = Vertex(-(width*0.5f), -(height*0.5f), depth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-back-left
+	v[2] = Vertex(width*0.5f, -(height*0.5f), -(depth*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-front-right
+	v[3] = Vertex(width*0.5f, -(height*0.5f), depth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-back-right
+	v[4] = Vertex(width*0.5f, height*0.5f, depth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-right
+	v[5] = Vertex(-(width*0.5f), height*0.5f, depth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-left
+	
+	meshData.Vertices.assign(&v[0], &v[6]);
+
+	uint32 i[24];
+
+	// Bottom
+	i[0] = 0;	i[1] = 2;	i[2] = 1;
+	i[3] = 2;	i[4] = 3;	i[5] = 1;
+
+	// Right Side
+	i[6] = 4;	i[7] = 3;	i[8] = 2;
+
+	// Left Side
+	i[9] = 5;	i[10] = 0;	i[11] = 1;
+
+	// Front
+	i[12] = 2;	i[13] = 0;	i[14] = 5;
+	i[15] = 2;	i[16] = 5;	i[17] = 4;
+
+	// Back
+	i[18] = 5;	i[19] = 1;	i[20] = 3;
+	i[21] = 5;	i[22] = 3;	i[23] = 4;
+
+	meshData.Indices32.assign(&i[0], &i[24]);
+
+	for (uint32 i = 0; i < 3; ++i)
+	{
+		Subdivide(meshData);
+	}
+
+	return meshData;
+}
+
+// Shape #3 - Pyramid
+MeshData CreatePyramid(float width, float depth, float height)
+{
+	MeshData meshData;
+
+	Vertex v[5];
+
+	v[0] = Vertex(0.0f, height*0.5f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-center
+	v[1] = Vertex(-(width*0.5f), -(height*0.5f), -(depth*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-front-left
+	v[2] = Vertex(-(width*0.5f), -(height*0.5f), depth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-back-left
+	v[3] = Vertex(width*0.5f, -(height*0.5f), -(depth*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-front-right
+	v[4] = Vertex(width*0.5f, -(height*0.5f), depth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-back-right
+
+	meshData.Vertices.assign(&v[0], &v[5]);
+
+	uint32 i[18];
+
+	// Bottom
+	i[0] = 1;	i[1] = 3;	i[2] = 4;
+	i[3] = 1;	i[4] = 4;	i[5] = 2;
+
+	// Right Side
+	i[6] = 0;	i[7] = 2;	i[8] = 4;
+
+	// Left Side
+	i[9] = 0;	i[10] = 3;	i[11] = 1;
+
+	// Front
+	i[12] = 0;	i[13] = 4;	i[14] = 3;
+
+	// Back
+	i[15] = 0;	i[16] = 1;	i[17] = 2;
+
+	meshData.Indices32.assign(&i[0], &i[18]);
+
+	for (uint32 i = 0; i < 3; ++i)
+	{
+		Subdivide(meshData);
+	}
+
+	return meshData;
+}
+
+// Shape #4 - Truncated Pyramid
+MeshData CreateTruncatedPyramid(float bottomWidth, float bottomDepth, float topWidth, float topDepth, float height)
+{
+	MeshData meshData;
+
+	Vertex v[8];
+
+	v[0] = Vertex(-(bottomWidth*0.5f), -(height*0.5f), -(bottomDepth*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-front-left
+	v[1] = Vertex(-(bottomWidth*0.5f), -(height*0.5f), bottomDepth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-back-left
+	v[2] = Vertex(bottomWidth*0.5f, -(height*0.5f), -(bottomDepth*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-front-right
+	v[3] = Vertex(bottomWidth*0.5f, -(height*0.5f), bottomDepth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-back-right
+
+	v[4] = Vertex(-(topWidth*0.5f), height*0.5f, -(topDepth*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-front-left
+	v[5] = Vertex(-(topWidth*0.5f), height*0.5f, topDepth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-back-left
+	v[6] = Vertex(topWidth*0.5f, height*0.5f, -(topDepth*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-front-right
+	v[7] = Vertex(topWidth*0.5f, height*0.5f, topDepth*0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-back-right
+
+	meshData.Vertices.assign(&v[0], &v[8]);
+
+	uint32 i[36];
+
+	// Bottom
+	i[0] = 0;	i[1] = 2;	i[2] = 1;
+	i[3] = 2;	i[4] = 3;	i[5] = 1;
+
+	// Right Side
+	i[6] = 2;	i[7] = 6;	i[8] = 3;
+	i[9] = 3;	i[10] = 6;	i[11] = 7;
+
+	//Left Side
+	i[12] = 1;	i[13] = 5;	i[14] = 0;
+	i[15] = 0;	i[16] = 5;	i[17] = 4;
+
+	// Front
+	i[18] = 0;	i[19] = 4;	i[20] = 2;
+	i[21] = 2;	i[22] = 4;	i[23] = 6;
+
+	// Back
+	i[24] = 3;	i[25] = 7;	i[26] = 1;
+	i[27] = 1;	i[28] = 7;	i[29] = 5;
+
+	// Top
+	i[30] = 4;	i[31] = 5;	i[32] = 6;
+	i[33] = 6;	i[34] = 5;	i[35] = 7;
+
+	meshData.Indices32.assign(&i[0], &i[36]);
+
+	for (uint32 i = 0; i < 3; ++i)
+	{
+		Subdivide(meshData);
+	}
+
+	return meshData;
+}
+
+// Shape #5 - Triangular Prism
+MeshData CreateTriangularPrism(float width, float depth, float height)
+{
+	MeshData meshData;
+
+	/*
+	Vertex v[6];
+
+	v[0] = Vertex(-(bottomSideLength*0.5f), -(height*0.5f), -(bottomSideLength*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-left
+	v[1] = Vertex(-(bottomSideLength*0.25f), -(height*0.5f), bottomSideLength*0.25f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-back
+	v[2] = Vertex(bottomSideLength*0.5f, -(height*0.5f), -(bottomSideLength*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom-right
+	v[3] = Vertex(-(topSideLength*0.5), height*0.5f, -(topSideLength*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-Left
+	v[4] = Vertex(-(topSideLength*0.25f), height*0.5f, topSideLength*0.25f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-back
+	v[5] = Vertex(topSideLength*0.5f, height*0.5f, -(topSideLength*0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top-right
+	
+
+	meshData.Vertices.assign(&v[0], &v[6]);
+
+	uint32 i[36];
+	
+	// Bottom
+	i[0] = 0;	i[1] = 2;	i[2] = 1;
+	
+
+	// Right Side
+	i[3] = 2;	i[4] = 4;	i[5] = 1;
+	i[6] = 5;	i[7] = 4;	i[8] = 2;
+
+	//Left Side
+	i[9] = 5;	i[10] = 2;	i[11] = 0;
+	i[12] = 0;	i[13] = 3;	i[14] = 5;
+
+	// Back
+	i[15] = 1;	i[16] = 3;	i[17] = 0;
+	i[18] = 4;	i[19] = 3;	i[20] = 1;
+
+	// Top
+	i[21] = 5;	i[22] = 3;	i[23] = 4;
+	*/
+
+	Vertex v[6];
+
+	v[0] = Vertex(-(width * 0.5f), -(height * 0.5f), depth * 0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom back left
+	v[1] = Vertex(width * 0.5f, -(height * 0.5f), depth * 0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom back right
+	v[2] = Vertex(-(width * 0.5f), -(height * 0.5f), -(depth * 0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom front left
+	v[3] = Vertex(width * 0.5f, -(height * 0.5f), -(depth * 0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom front right
+
+	v[4] = Vertex(0.0f, height * 0.5f, depth * 0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top back
+	v[5] = Vertex(0.0f, height * 0.5f, -(depth * 0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top front
+
+
+	meshData.Vertices.assign(&v[0], &v[6]);
+
+	uint32 i[36];
+
+	// Bottom
+	i[0] = 0;	i[1] = 2;	i[2] = 3;
+	i[3] = 0;	i[4] = 3;	i[5] = 1;
+
+	// Left
+	i[6] = 0;	i[7] = 5;	i[8] = 2;
+	i[9] = 0;	i[10] = 4;	i[11] = 5;
+
+	// Right
+	i[12] = 3;	i[13] = 4;	i[14] = 1;
+	i[15] = 3;	i[16] = 5;	i[17] = 4;
+
+	// Back
+	i[18] = 4;	i[19] = 0;	i[20] = 1;
+
+	// Front
+	i[21] = 5;	i[22] = 3;	i[23] = 2;
+
+
+	meshData.Indices32.assign(&i[0], &i[24]);
+	
+
+	for (uint32 i = 0; i < 3; ++i)
+	{
+		Subdivide(meshData);
+	}
+
+	return meshData;
+}
+
+// Shape #6 - Tetrahedron
+MeshData CreateTetrahedron(float width, float height)
+{
+	MeshData meshData;
+
+	Vertex v[4];
+
+	v[0] = Vertex(0.0f, height * 0.5f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // top center
+	v[1] = Vertex(0.0f, -(height * 0.5f), width * 0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom back
+	v[2] = Vertex(-(width * 0.5f), -(height * 0.5f), -(width * 0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom front left
+	v[3] = Vertex(width * 0.5f, -(height * 0.5f), -(width * 0.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f); // bottom front right
+	
+	meshData.Vertices.assign(&v[0], &v[4]);
+
+	uint32 i[12];
+
+	// Bottom
+	i[0] = 1;	i[1] = 2;	i[2] = 3;
+
+	// Left
+	i[3] = 1;	i[4] = 0;	i[5] = 2;
+	
+	// Right
+	i[6] = 1;	i[7] = 3;	i[8] = 0;
+	
+	// Front
+	i[9] = 2;	i[10] = 0;	i[11] = 3;
+	
+
+	meshData.Indices32.assign(&i[0], &i[12]);
+
+
+	for (uint32 i = 0; i < 3; ++i)
+	{
+		Subdivide(meshData);
+	}
+
+	return meshData;
+}
+}
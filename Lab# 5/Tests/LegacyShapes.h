@@ -0,0 +1,20 @@
+//***************************************************************************************
+// LegacyShapes.h
+//
+// Reference copies of the hand-written shape generators that GeometryGenerator used
+// to have.  See LegacyShapes.cpp.
+//***************************************************************************************
+
+#pragma once
+
+#include "../../Common/GeometryGenerator.h"
+
+namespace LegacyShapes
+{
+	GeometryGenerator::MeshData CreateDiamondOfDeath(float height);
+	GeometryGenerator::MeshData CreateWedge(float width, float depth, float height);
+	GeometryGenerator::MeshData CreatePyramid(float width, float depth, float height);
+	GeometryGenerator::MeshData CreateTruncatedPyramid(float bottomWidth, float bottomDepth, float topWidth, float topDepth, float height);
+	GeometryGenerator::MeshData CreateTriangularPrism(float width, float depth, float height);
+	GeometryGenerator::MeshData CreateTetrahedron(float width, float height);
+}
@@ -0,0 +1,132 @@
+//***************************************************************************************
+// MeshCacheTests.cpp
+//
+// Saves the cooked skull and car to a cache, packed and compressed, and reads them
+// back with MeshCache::Read and MeshCache::Map.  Both must restore every byte of the
+// vertex and index data and every submesh, and agree with the saved geometry on the
+// triangle lists the codec codes, whatever the order of the rebuilt DrawArgs.
+//***************************************************************************************
+
+#include "Test.h"
+#include "../../Common/MappedFile.h"
+#include "../../Common/MeshCache.h"
+#include "../../Common/ModelCooker.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	bool SameRanges(const std::vector<MeshCodec::IndexRange>& a, const std::vector<MeshCodec::IndexRange>& b)
+	{
+		return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+			[](const MeshCodec::IndexRange& x, const MeshCodec::IndexRange& y)
+			{
+				return x.ByteOffset == y.ByteOffset && x.IndexCount == y.IndexCount &&
+					x.IndexByteSize == y.IndexByteSize && x.BaseVertex == y.BaseVertex;
+			});
+	}
+
+	bool SameSubmeshes(const MeshGeometry& a, const MeshGeometry& b)
+	{
+		if(a.DrawArgs.size() != b.DrawArgs.size())
+			return false;
+
+		for(const auto& e : a.DrawArgs)
+		{
+			auto it = b.DrawArgs.find(e.first);
+			if(it == b.DrawArgs.end())
+				return false;
+
+			const SubmeshGeometry& x = e.second;
+			const SubmeshGeometry& y = it->second;
+			if(x.IndexCount != y.IndexCount || x.StartIndexLocation != y.StartIndexLocation ||
+			   x.BaseVertexLocation != y.BaseVertexLocation || x.IndexFormat != y.IndexFormat ||
+			   x.LodError != y.LodError || x.Clusters.size() != y.Clusters.size() || x.Lods.size() != y.Lods.size())
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// The geometry's data as the GPU would get it, from the CPU copies of a read cache
+	// or out of a mapped one.
+	bool SameData(const MeshGeometry& expected, const void* vertices, const void* indices)
+	{
+		return std::memcmp(vertices, expected.VertexBufferCPU->GetBufferPointer(), expected.VertexBufferByteSize) == 0 &&
+			std::memcmp(indices, expected.IndexBufferCPU->GetBufferPointer(), expected.IndexBufferByteSize) == 0;
+	}
+
+	size_t FileSize(const std::wstring& filename)
+	{
+		MappedFile file;
+		return file.Open(filename) ? file.GetSize() : 0;
+	}
+
+	void CheckModel(const TestContext& context, const std::wstring& stem)
+	{
+		const std::wstring sourceFile = context.ModelDirectory + stem + L".txt";
+		const std::wstring cacheFile = context.ModelDirectory + stem + L".test.mesh";
+		const std::string name(stem.begin(), stem.end());
+
+		std::unique_ptr<MeshGeometry> geo = ModelCooker::CookModel(sourceFile, name + "Geo", name);
+		CHECK(geo != nullptr);
+		if(geo == nullptr)
+			return;
+
+		// Rebuilt with more buckets, DrawArgs iterates in another order.
+		MeshGeometry reordered;
+		reordered.DrawArgs.reserve(1024);
+		reordered.DrawArgs.insert(geo->DrawArgs.begin(), geo->DrawArgs.end());
+		CHECK(SameRanges(MeshCache::GetIndexRanges(reordered), MeshCache::GetIndexRanges(*geo)));
+
+		size_t fileSizes[2] = {};
+		for(MeshCache::Encoding encoding : { MeshCache::Encoding::Packed, MeshCache::Encoding::Compressed })
+		{
+			CHECK(MeshCache::Save(cacheFile, sourceFile, *geo, encoding));
+			fileSizes[(int)encoding] = FileSize(cacheFile);
+
+			std::unique_ptr<MeshGeometry> read = MeshCache::Read(cacheFile, sourceFile);
+			CHECK(read != nullptr);
+			if(read != nullptr)
+			{
+				CHECK(read->Name == geo->Name);
+				CHECK(read->VertexByteStride == geo->VertexByteStride);
+				CHECK(read->VertexBufferByteSize == geo->VertexBufferByteSize);
+				CHECK(read->IndexFormat == geo->IndexFormat);
+				CHECK(read->IndexBufferByteSize == geo->IndexBufferByteSize);
+				CHECK(SameData(*geo, read->VertexBufferCPU->GetBufferPointer(), read->IndexBufferCPU->GetBufferPointer()));
+				CHECK(SameSubmeshes(*read, *geo));
+				CHECK(SameRanges(MeshCache::GetIndexRanges(*read), MeshCache::GetIndexRanges(*geo)));
+			}
+
+			MeshCache::CopyDataFn copyData;
+			std::unique_ptr<MeshGeometry> mapped = MeshCache::Map(cacheFile, sourceFile, copyData);
+			CHECK(mapped != nullptr && copyData);
+			if(mapped != nullptr && copyData)
+			{
+				CHECK(mapped->VertexBufferCPU == nullptr && mapped->IndexBufferCPU == nullptr);
+
+				// Start from a pattern the copy must overwrite everywhere.
+				std::vector<char> vertices(mapped->VertexBufferByteSize, (char)0xcd);
+				std::vector<char> indices(mapped->IndexBufferByteSize, (char)0xcd);
+				copyData(vertices.data(), indices.data());
+				CHECK(SameData(*geo, vertices.data(), indices.data()));
+			}
+
+			copyData = nullptr;
+			DeleteFileW(cacheFile.c_str());
+		}
+
+		// Compressed files are only smaller if the data was actually encoded.
+		CHECK(fileSizes[(int)MeshCache::Encoding::Compressed] > 0);
+		CHECK(fileSizes[(int)MeshCache::Encoding::Compressed] < fileSizes[(int)MeshCache::Encoding::Packed]);
+	}
+}
+
+void RunMeshCacheTests(const TestContext& context)
+{
+	CheckModel(context, L"skull");
+	CheckModel(context, L"car");
+}
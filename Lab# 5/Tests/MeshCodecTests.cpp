@@ -0,0 +1,112 @@
+//***************************************************************************************
+// MeshCodecTests.cpp
+//
+// Round trips through MeshCodec: the cooked skull and car, whose buffers hold 16-bit
+// submeshes and their levels of detail, and a synthetic buffer with 32-bit indices,
+// base vertices and raw bytes between the triangle lists.  Decoding must restore every
+// byte, and truncated data must be rejected rather than read past.
+//***************************************************************************************
+
+#include "Test.h"
+#include "../../Common/MeshCache.h"
+#include "../../Common/MeshCodec.h"
+#include "../../Common/ModelCooker.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+namespace
+{
+	using uint8 = MeshCodec::uint8;
+
+	// Encodes and decodes the buffers and checks the result, then checks that every
+	// truncation of the encoding is rejected.
+	void CheckRoundTrip(const void* vertices, size_t vertexCount, size_t vertexByteStride,
+		const void* indices, size_t indexByteSize, const std::vector<MeshCodec::IndexRange>& ranges)
+	{
+		std::vector<uint8> data;
+		MeshCodec::Encode(vertices, vertexCount, vertexByteStride, indices, indexByteSize, ranges, data);
+
+		// Start from a pattern the decoder must overwrite everywhere.
+		std::vector<uint8> decodedVertices(vertexCount*vertexByteStride, 0xcd);
+		std::vector<uint8> decodedIndices(indexByteSize, 0xcd);
+
+		CHECK(MeshCodec::Decode(decodedVertices.data(), vertexCount, vertexByteStride,
+			decodedIndices.data(), indexByteSize, ranges, data.data(), data.size()));
+		CHECK(memcmp(decodedVertices.data(), vertices, decodedVertices.size()) == 0);
+		CHECK(memcmp(decodedIndices.data(), indices, decodedIndices.size()) == 0);
+
+		// Every length for small encodings, a spread of them for large ones.
+		const size_t step = std::max<size_t>(1, data.size() / 997);
+		bool rejected = true;
+		for(size_t length = 0; length < data.size(); length += step)
+		{
+			rejected &= !MeshCodec::Decode(decodedVertices.data(), vertexCount, vertexByteStride,
+				decodedIndices.data(), indexByteSize, ranges, data.data(), length);
+		}
+		CHECK(rejected);
+	}
+
+	void CheckCookedModel(const std::wstring& filename, const std::string& name)
+	{
+		std::unique_ptr<MeshGeometry> geo = ModelCooker::CookModel(filename, name + "Geo", name);
+		CHECK(geo != nullptr);
+		if(geo == nullptr)
+			return;
+
+		CheckRoundTrip(geo->VertexBufferCPU->GetBufferPointer(), geo->VertexBufferByteSize / geo->VertexByteStride,
+			geo->VertexByteStride, geo->IndexBufferCPU->GetBufferPointer(), geo->IndexBufferByteSize, MeshCache::GetIndexRanges(*geo));
+	}
+
+	// Two triangle lists with 32-bit indices and base vertices, 6 raw bytes in front of
+	// the first and 10 between them, over vertices of random 16-bit lanes.
+	void CheckSynthetic()
+	{
+		const size_t vertexCount = 5000;
+		const size_t vertexByteStride = 12;
+
+		std::mt19937 random(7);
+		std::vector<uint8> vertices(vertexCount*vertexByteStride);
+		for(uint8& b : vertices)
+			b = (uint8)random();
+
+		MeshCodec::IndexRange first;
+		first.ByteOffset = 8;
+		first.IndexCount = 3000;
+		first.IndexByteSize = 4;
+		first.BaseVertex = 100;
+
+		MeshCodec::IndexRange second;
+		second.ByteOffset = first.ByteOffset + first.IndexCount*4 + 8;
+		second.IndexCount = 1500;
+		second.IndexByteSize = 4;
+		second.BaseVertex = 2000;
+
+		const size_t indexByteSize = second.ByteOffset + second.IndexCount*4;
+		std::vector<uint8> indices(indexByteSize);
+		for(uint8& b : indices)
+			b = (uint8)random();
+
+		std::uniform_int_distribution<std::uint32_t> index(0, 2999);
+		for(const MeshCodec::IndexRange& range : { first, second })
+		{
+			for(size_t i = 0; i < range.IndexCount; ++i)
+			{
+				std::uint32_t value = index(random);
+				memcpy(&indices[range.ByteOffset + i*4], &value, 4);
+			}
+		}
+
+		CheckRoundTrip(vertices.data(), vertexCount, vertexByteStride, indices.data(), indexByteSize, { first, second });
+
+		// No triangle lists at all: everything is stored as raw bytes.
+		CheckRoundTrip(vertices.data(), vertexCount, vertexByteStride, indices.data(), indexByteSize, {});
+	}
+}
+
+void RunMeshCodecTests(const TestContext& context)
+{
+	CheckCookedModel(context.ModelDirectory + L"skull.txt", "skull");
+	CheckCookedModel(context.ModelDirectory + L"car.txt", "car");
+	CheckSynthetic();
+}
@@ -0,0 +1,244 @@
+//***************************************************************************************
+// MeshNormalsTests.cpp
+//
+// MeshNormals on a cube of 8 shared corners, which smooths into 8 diagonal normals but
+// splits into the 24 vertices of a box at a crease angle below 90 degrees or with a
+// smoothing group per face; on a flat grid, whose regenerated normals and tangents
+// must match the ones GeometryGenerator writes; and on a terraced grid large enough
+// to be split into ranges, where every worker count must produce bit for bit what the
+// calling thread produces alone.
+//***************************************************************************************
+
+#include "Test.h"
+#include "../../Common/MeshNormals.h"
+#include "../../Common/ThreadPool.h"
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+using namespace DirectX;
+
+namespace
+{
+	using MeshData = GeometryGenerator::MeshData;
+	using uint32 = MeshNormals::uint32;
+
+	const float kTolerance = 1e-4f;
+
+	bool NearlyEqual(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return fabsf(a.x - b.x) <= kTolerance && fabsf(a.y - b.y) <= kTolerance && fabsf(a.z - b.z) <= kTolerance;
+	}
+
+	// A unit cube whose faces share their corners, with the normals and tangents cleared.
+	MeshData MakeSharedCube()
+	{
+		MeshData cube;
+		for(uint32 i = 0; i < 8; ++i)
+		{
+			GeometryGenerator::Vertex v;
+			v.Position = XMFLOAT3(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f);
+			v.Normal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+			v.TangentU = XMFLOAT3(0.0f, 0.0f, 0.0f);
+			v.TexC = XMFLOAT2(v.Position.x + v.Position.z, v.Position.y);
+			cube.Vertices.push_back(v);
+		}
+
+		// Two clockwise triangles per face, seen from outside: -x, +x, -y, +y, -z, +z.
+		const uint32 indices[36] =
+		{
+			0, 4, 6,  0, 6, 2,   1, 3, 7,  1, 7, 5,
+			0, 1, 5,  0, 5, 4,   2, 6, 7,  2, 7, 3,
+			0, 2, 3,  0, 3, 1,   4, 5, 7,  4, 7, 6,
+		};
+		cube.Indices32.assign(std::begin(indices), std::end(indices));
+
+		return cube;
+	}
+
+	XMFLOAT3 FaceNormal(const MeshData& mesh, size_t triangle)
+	{
+		XMVECTOR p[3];
+		for(int k = 0; k < 3; ++k)
+			p[k] = XMLoadFloat3(&mesh.Vertices[mesh.Indices32[3*triangle + k]].Position);
+
+		XMFLOAT3 n;
+		XMStoreFloat3(&n, XMVector3Normalize(XMVector3Cross(p[1] - p[0], p[2] - p[0])));
+		return n;
+	}
+
+	// Every corner of every triangle has the triangle's face normal, and a tangent of
+	// unit length perpendicular to it.
+	bool FlatShaded(const MeshData& mesh)
+	{
+		for(size_t t = 0; t < mesh.Indices32.size() / 3; ++t)
+		{
+			XMFLOAT3 faceNormal = FaceNormal(mesh, t);
+			for(int k = 0; k < 3; ++k)
+			{
+				const GeometryGenerator::Vertex& v = mesh.Vertices[mesh.Indices32[3*t + k]];
+				XMVECTOR tangent = XMLoadFloat3(&v.TangentU);
+				if(!NearlyEqual(v.Normal, faceNormal) ||
+				   fabsf(XMVectorGetX(XMVector3Length(tangent)) - 1.0f) > kTolerance ||
+				   fabsf(XMVectorGetX(XMVector3Dot(tangent, XMLoadFloat3(&v.Normal)))) > kTolerance)
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	void CheckCube()
+	{
+		// Smoothed, each corner points away from the center.
+		MeshData smooth = MakeSharedCube();
+		MeshNormals::GenerateNormalsAndTangents(smooth);
+		CHECK(smooth.Vertices.size() == 8);
+		for(const GeometryGenerator::Vertex& v : smooth.Vertices)
+		{
+			XMFLOAT3 diagonal;
+			XMStoreFloat3(&diagonal, XMVector3Normalize(XMLoadFloat3(&v.Position)));
+			CHECK(NearlyEqual(v.Normal, diagonal));
+		}
+
+		// The faces meet at 90 degrees, so a smaller crease angle gives every face its
+		// own corners; the two triangles of a face are coplanar and share theirs.
+		MeshNormals::Options creased;
+		creased.CreaseAngle = XMConvertToRadians(60.0f);
+
+		MeshData box = MakeSharedCube();
+		MeshNormals::GenerateNormalsAndTangents(box, nullptr, creased);
+		CHECK(box.Vertices.size() == 24);
+		CHECK(box.Indices32.size() == 36);
+		CHECK(FlatShaded(box));
+
+		// The split vertices keep the position of the vertex they were copied from.
+		const MeshData cube = MakeSharedCube();
+		for(size_t i = 0; i < cube.Indices32.size(); ++i)
+			CHECK(NearlyEqual(box.Vertices[box.Indices32[i]].Position, cube.Vertices[cube.Indices32[i]].Position));
+
+		// A smoothing group per face does the same at any crease angle.
+		uint32 groups[12];
+		for(uint32 t = 0; t < 12; ++t)
+			groups[t] = 1u << (t / 2);
+
+		MeshNormals::Options grouped;
+		grouped.SmoothingGroups = groups;
+
+		MeshData groupedBox = MakeSharedCube();
+		MeshNormals::GenerateNormalsAndTangents(groupedBox, nullptr, grouped);
+		CHECK(groupedBox.Vertices.size() == 24);
+		CHECK(FlatShaded(groupedBox));
+
+		// Faces sharing a bit smooth: with -x and +y in one group, the two corners of
+		// their shared edge need one vertex less each.
+		groups[0] = groups[1] = groups[6] = groups[7] = 1;
+		MeshData merged = MakeSharedCube();
+		MeshNormals::GenerateNormalsAndTangents(merged, nullptr, grouped);
+		CHECK(merged.Vertices.size() == 22);
+	}
+
+	void CheckGrid()
+	{
+		GeometryGenerator geoGen;
+		MeshData expected = geoGen.CreateGrid(4.0f, 3.0f, 9, 13);
+
+		MeshData grid = expected;
+		for(GeometryGenerator::Vertex& v : grid.Vertices)
+		{
+			v.Normal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+			v.TangentU = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		}
+
+		MeshNormals::GenerateNormalsAndTangents(grid);
+		CHECK(grid.Vertices.size() == expected.Vertices.size());
+		CHECK(grid.Indices32 == expected.Indices32);
+
+		bool same = true;
+		for(size_t i = 0; i < grid.Vertices.size(); ++i)
+		{
+			same = same && NearlyEqual(grid.Vertices[i].Normal, expected.Vertices[i].Normal) &&
+				NearlyEqual(grid.Vertices[i].TangentU, expected.Vertices[i].TangentU);
+		}
+		CHECK(same);
+	}
+
+	// A grid with terraces, whose risers meet the treads at creases, and random
+	// smoothing groups, so many vertices are split.
+	MeshData MakeTerrain(uint32 size, std::vector<uint32>& groups)
+	{
+		GeometryGenerator geoGen;
+		MeshData terrain = geoGen.CreateGrid(100.0f, 100.0f, size, size);
+		for(GeometryGenerator::Vertex& v : terrain.Vertices)
+		{
+			float height = 4.0f*sinf(0.11f*v.Position.x)*cosf(0.07f*v.Position.z);
+			v.Position.y = 0.5f*floorf(2.0f*height) + 0.1f*height;
+		}
+
+		std::mt19937 random(3);
+		groups.resize(terrain.Indices32.size() / 3);
+		for(uint32& group : groups)
+			group = random() % 8 == 0 ? 0 : 1u << (random() % 3);
+
+		return terrain;
+	}
+
+	void CheckWorkerCounts()
+	{
+		// Enough positions and triangles for several ranges per pass.
+		std::vector<uint32> groups;
+		const MeshData terrain = MakeTerrain(260, groups);
+
+		MeshNormals::Options options;
+		options.CreaseAngle = XMConvertToRadians(45.0f);
+		options.SmoothingGroups = groups.data();
+
+		MeshData reference = terrain;
+		MeshNormals::GenerateNormalsAndTangents(reference, nullptr, options);
+		CHECK(reference.Vertices.size() > terrain.Vertices.size());
+		CHECK(MeshNormals::NormalsAreValid(&reference.Vertices[0].Normal, sizeof(GeometryGenerator::Vertex),
+			reference.Vertices.size()));
+
+		for(unsigned threads : { 1u, 2u, 4u, 8u })
+		{
+			ThreadPool pool(threads - 1);
+
+			MeshData mesh = terrain;
+			MeshNormals::GenerateNormalsAndTangents(mesh, &pool, options);
+
+			CHECK(mesh.Indices32 == reference.Indices32);
+			CHECK(mesh.Vertices.size() == reference.Vertices.size() &&
+				std::memcmp(mesh.Vertices.data(), reference.Vertices.data(),
+					mesh.Vertices.size()*sizeof(GeometryGenerator::Vertex)) == 0);
+		}
+	}
+
+	void CheckInvalidIndices()
+	{
+		MeshData cube = MakeSharedCube();
+		cube.Indices32.pop_back();
+
+		bool threw = false;
+		try { MeshNormals::GenerateNormalsAndTangents(cube); }
+		catch(const std::invalid_argument&) { threw = true; }
+		CHECK(threw);
+
+		cube = MakeSharedCube();
+		cube.Indices32[7] = 8;
+
+		threw = false;
+		try { MeshNormals::GenerateNormalsAndTangents(cube); }
+		catch(const std::invalid_argument&) { threw = true; }
+		CHECK(threw);
+	}
+}
+
+void RunMeshNormalsTests(const TestContext& context)
+{
+	CheckCube();
+	CheckGrid();
+	CheckWorkerCounts();
+	CheckInvalidIndices();
+}
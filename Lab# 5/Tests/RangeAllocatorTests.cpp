@@ -0,0 +1,203 @@
+//***************************************************************************************
+// RangeAllocatorTests.cpp
+//
+// RangeAllocator on small hand-made layouts, then against a unit-by-unit model over
+// random allocations and frees.  Allocate must take the smallest free range that fits,
+// the lowest one among equals, and fail once nothing fits; Free must merge a range
+// with both of its free neighbours, so freeing everything leaves one range again.
+//***************************************************************************************
+
+#include "Test.h"
+#include "../../Common/RangeAllocator.h"
+#include <random>
+
+namespace
+{
+	using uint32 = RangeAllocator::uint32;
+
+	struct Range
+	{
+		uint32 Offset = 0;
+		uint32 Size = 0;
+	};
+
+	void CheckAllocateAndFree()
+	{
+		RangeAllocator allocator(60);
+		CHECK(allocator.GetCapacity() == 60);
+		CHECK(allocator.GetFreeSize() == 60);
+		CHECK(allocator.GetFreeRangeCount() == 1);
+		CHECK(allocator.GetLargestFreeRange() == 60);
+
+		// Ranges are taken from the front, one after the other.
+		uint32 a = 99, b = 99, c = 99;
+		CHECK(allocator.Allocate(10, a) && a == 0);
+		CHECK(allocator.Allocate(20, b) && b == 10);
+		CHECK(allocator.Allocate(30, c) && c == 30);
+		CHECK(allocator.GetFreeSize() == 0);
+		CHECK(allocator.GetFreeRangeCount() == 0);
+		CHECK(allocator.GetLargestFreeRange() == 0);
+
+		uint32 none = 99;
+		CHECK(!allocator.Allocate(1, none));
+		CHECK(none == 99);
+
+		// Freeing the middle range, then the first, merges them.
+		allocator.Free(b, 20);
+		CHECK(allocator.GetFreeRangeCount() == 1);
+		CHECK(!allocator.Allocate(30, none));
+
+		allocator.Free(a, 10);
+		CHECK(allocator.GetFreeRangeCount() == 1);
+		CHECK(allocator.GetFreeSize() == 30);
+		CHECK(allocator.GetLargestFreeRange() == 30);
+
+		uint32 d = 99;
+		CHECK(allocator.Allocate(30, d) && d == 0);
+		CHECK(allocator.GetFreeSize() == 0);
+
+		// Freeing between two free ranges merges all three.
+		allocator.Free(0, 10);
+		allocator.Free(20, 10);
+		CHECK(allocator.GetFreeRangeCount() == 2);
+		allocator.Free(10, 10);
+		CHECK(allocator.GetFreeRangeCount() == 1);
+		CHECK(allocator.GetLargestFreeRange() == 30);
+
+		allocator.Free(c, 30);
+		CHECK(allocator.GetFreeRangeCount() == 1);
+		CHECK(allocator.GetFreeSize() == 60);
+		CHECK(allocator.GetLargestFreeRange() == 60);
+
+		RangeAllocator empty;
+		CHECK(empty.GetFreeRangeCount() == 0);
+		CHECK(!empty.Allocate(1, none));
+	}
+
+	void CheckBestFit()
+	{
+		// Free ranges of 8 at 0, 4 at 10, 6 at 16, 4 at 24 and 100 at 30.
+		RangeAllocator allocator(130);
+		uint32 offset = 0;
+		for(uint32 size : { 8u, 2u, 4u, 2u, 6u, 2u, 4u, 2u })
+			CHECK(allocator.Allocate(size, offset));
+
+		allocator.Free(0, 8);
+		allocator.Free(10, 4);
+		allocator.Free(16, 6);
+		allocator.Free(24, 4);
+		CHECK(allocator.GetFreeRangeCount() == 5);
+		CHECK(allocator.GetLargestFreeRange() == 100);
+
+		// The smallest range that fits, not the first.
+		CHECK(allocator.Allocate(5, offset) && offset == 16);
+
+		// Equal sizes: the lower offset.
+		CHECK(allocator.Allocate(4, offset) && offset == 10);
+		CHECK(allocator.Allocate(4, offset) && offset == 24);
+
+		// The remainder of a split range is free again.
+		CHECK(allocator.Allocate(1, offset) && offset == 21);
+		CHECK(allocator.Allocate(7, offset) && offset == 0);
+		CHECK(allocator.Allocate(100, offset) && offset == 30);
+		CHECK(allocator.GetFreeRangeCount() == 1);
+		CHECK(allocator.GetFreeSize() == 1);
+		CHECK(allocator.Allocate(1, offset) && offset == 7);
+		CHECK(!allocator.Allocate(1, offset));
+	}
+
+	// Random allocations and frees against a map of the units in use.
+	void CheckAgainstModel()
+	{
+		const uint32 capacity = 4096;
+		RangeAllocator allocator(capacity);
+		std::vector<bool> used(capacity, false);
+		std::vector<Range> live;
+
+		// The best fit as a linear scan of the free runs.
+		auto bestFit = [&used](uint32 size, uint32& offset)
+		{
+			uint32 bestSize = UINT32_MAX;
+			for(uint32 i = 0; i < (uint32)used.size();)
+			{
+				if(used[i])
+				{
+					++i;
+					continue;
+				}
+
+				uint32 end = i;
+				while(end < (uint32)used.size() && !used[end])
+					++end;
+
+				if(end - i >= size && end - i < bestSize)
+				{
+					bestSize = end - i;
+					offset = i;
+				}
+				i = end;
+			}
+
+			return bestSize != UINT32_MAX;
+		};
+
+		std::mt19937 random(5);
+		for(int step = 0; step < 20000; ++step)
+		{
+			if(live.empty() || random() % 5 < 3)
+			{
+				uint32 size = 1 + random() % 64;
+				uint32 expected = 0;
+				const bool fits = bestFit(size, expected);
+
+				uint32 offset = 0;
+				const bool allocated = allocator.Allocate(size, offset);
+				CHECK(allocated == fits);
+				if(!allocated)
+					continue;
+
+				CHECK(offset == expected);
+				for(uint32 i = offset; i < offset + size; ++i)
+					used[i] = true;
+
+				live.push_back({ offset, size });
+			}
+			else
+			{
+				size_t index = random() % live.size();
+				Range range = live[index];
+				live[index] = live.back();
+				live.pop_back();
+
+				allocator.Free(range.Offset, range.Size);
+				for(uint32 i = range.Offset; i < range.Offset + range.Size; ++i)
+					used[i] = false;
+			}
+
+			// Merged ranges mean one free range per run of free units.
+			uint32 freeSize = 0;
+			size_t runCount = 0;
+			for(uint32 i = 0; i < capacity; ++i)
+			{
+				freeSize += used[i] ? 0 : 1;
+				runCount += !used[i] && (i == 0 || used[i - 1]) ? 1 : 0;
+			}
+
+			CHECK(allocator.GetFreeSize() == freeSize);
+			CHECK(allocator.GetFreeRangeCount() == runCount);
+		}
+
+		for(const Range& range : live)
+			allocator.Free(range.Offset, range.Size);
+
+		CHECK(allocator.GetFreeRangeCount() == 1);
+		CHECK(allocator.GetLargestFreeRange() == capacity);
+	}
+}
+
+void RunRangeAllocatorTests(const TestContext& context)
+{
+	CheckAllocateAndFree();
+	CheckBestFit();
+	CheckAgainstModel();
+}
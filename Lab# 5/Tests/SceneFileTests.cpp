@@ -0,0 +1,241 @@
+//***************************************************************************************
+// SceneFileTests.cpp
+//
+// Compiles a small scene with repeats and nested blocks and checks the nodes Load
+// returns: their count, parents, tables and local matrices.  Syntax errors must name
+// their line.  Load must reject every truncation of the compiled file, shape and
+// material indices past their tables, and parents that break the preorder.
+//***************************************************************************************
+
+#include "Test.h"
+#include "../../Common/SceneFile.h"
+#include <cstring>
+#include <stdexcept>
+
+using namespace DirectX;
+
+namespace
+{
+	const wchar_t kSourceFile[] = L"SceneFileTests.scene";
+	const wchar_t kSceneFile[] = L"SceneFileTests.scn";
+
+	// A root box, a group placed twice holding three columns that each carry a cone,
+	// and a rotated root box: 16 nodes in preorder.
+	const char kSource[] =
+		"# comment\n"
+		"shapeGeo box wallMat translate 1 2 3\n"
+		"\n"
+		"group translate 10 0 0 repeat 2 0 0 5 {   # two rows\n"
+		"\tshapeGeo cylinder coneMat scale 2 2 2 repeat 3 1 0 0 {\n"
+		"\t\tshapeGeo cone coneMat translate 0 1 0\n"
+		"\t}\n"
+		"}\n"
+		"shapeGeo box wallMat rotate 0 90 0\n";
+
+	const UINT kNone = SceneFile::kNone;
+
+	void WriteFile(const std::wstring& filename, const void* data, size_t byteSize)
+	{
+		std::ofstream fout(filename, std::ios::binary | std::ios::trunc);
+		fout.write(static_cast<const char*>(data), (std::streamsize)byteSize);
+	}
+
+	std::vector<char> ReadFile(const std::wstring& filename)
+	{
+		std::ifstream fin(filename, std::ios::binary);
+		return std::vector<char>(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+	}
+
+	bool LoadsFrom(const std::vector<char>& bytes)
+	{
+		WriteFile(kSceneFile, bytes.data(), bytes.size());
+		return SceneFile::Load(kSceneFile) != nullptr;
+	}
+
+	// The message of the error compiling source, or empty if it compiles.
+	std::string CompileError(const std::string& source)
+	{
+		WriteFile(kSourceFile, source.data(), source.size());
+		try
+		{
+			SceneFile::Compile(kSourceFile, kSceneFile);
+		}
+		catch(const std::runtime_error& e)
+		{
+			return e.what();
+		}
+
+		return std::string();
+	}
+
+	bool NearlyEqual(const XMFLOAT4X4& a, FXMMATRIX b)
+	{
+		XMFLOAT4X4 m;
+		XMStoreFloat4x4(&m, b);
+		for(int i = 0; i < 4; ++i)
+		{
+			for(int j = 0; j < 4; ++j)
+			{
+				if(fabsf(a.m[i][j] - m.m[i][j]) > 1e-5f)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	void CheckCompile()
+	{
+		WriteFile(kSourceFile, kSource, sizeof(kSource) - 1);
+		CHECK(SceneFile::Compile(kSourceFile, kSceneFile));
+
+		std::unique_ptr<SceneFile> scene = SceneFile::Load(kSceneFile);
+		CHECK(scene != nullptr);
+		if(scene == nullptr)
+			return;
+
+		CHECK(scene->GetNodeCount() == 16);
+		CHECK(scene->GetShapeCount() == 3);
+		CHECK(scene->GetMaterialCount() == 2);
+		if(scene->GetNodeCount() != 16 || scene->GetShapeCount() != 3 || scene->GetMaterialCount() != 2)
+			return;
+
+		const UINT parents[16] = { kNone, kNone, 1, 2, 1, 4, 1, 6, kNone, 8, 9, 8, 11, 8, 13, kNone };
+		const SceneFile::Node* nodes = scene->GetNodes();
+		for(UINT i = 0; i < 16; ++i)
+			CHECK(nodes[i].Parent == parents[i]);
+
+		// Shapes and materials are numbered in the order they first appear.
+		CHECK(strcmp(scene->GetShape(0).GeoName, "shapeGeo") == 0 && strcmp(scene->GetShape(0).SubmeshName, "box") == 0);
+		CHECK(strcmp(scene->GetShape(1).SubmeshName, "cylinder") == 0);
+		CHECK(strcmp(scene->GetShape(2).SubmeshName, "cone") == 0);
+		CHECK(strcmp(scene->GetMaterialName(0), "wallMat") == 0);
+		CHECK(strcmp(scene->GetMaterialName(1), "coneMat") == 0);
+
+		CHECK(nodes[0].Shape == 0 && nodes[0].Material == 0);
+		CHECK(nodes[1].Shape == kNone && nodes[1].Material == kNone);
+		CHECK(nodes[6].Shape == 1 && nodes[6].Material == 1);
+		CHECK(nodes[7].Shape == 2 && nodes[7].Material == 1);
+		CHECK(nodes[15].Shape == 0 && nodes[15].Material == 0);
+
+		// Each repeat is offset by its step from the one before; every copy of a block
+		// is the same relative to its node.
+		CHECK(NearlyEqual(nodes[0].Local, XMMatrixTranslation(1.0f, 2.0f, 3.0f)));
+		CHECK(NearlyEqual(nodes[1].Local, XMMatrixTranslation(10.0f, 0.0f, 0.0f)));
+		CHECK(NearlyEqual(nodes[8].Local, XMMatrixTranslation(10.0f, 0.0f, 5.0f)));
+		for(UINT row : { 1u, 8u })
+		{
+			for(UINT column = 0; column < 3; ++column)
+			{
+				const UINT node = row + 1 + 2*column;
+				CHECK(NearlyEqual(nodes[node].Local, XMMatrixScaling(2.0f, 2.0f, 2.0f) * XMMatrixTranslation((float)column, 0.0f, 0.0f)));
+				CHECK(NearlyEqual(nodes[node + 1].Local, XMMatrixTranslation(0.0f, 1.0f, 0.0f)));
+			}
+		}
+		CHECK(NearlyEqual(nodes[15].Local, XMMatrixRotationY(XM_PIDIV2)));
+	}
+
+	bool NamesLine(const std::string& error, int line)
+	{
+		const std::string prefix = "line " + std::to_string(line) + ": ";
+		return error.compare(0, prefix.size(), prefix) == 0;
+	}
+
+	void CheckSyntaxErrors()
+	{
+		CHECK(NamesLine(CompileError("shapeGeo box\n"), 1));
+		CHECK(NamesLine(CompileError("# comment\n\nshapeGeo box wallMat scale 1 2\n"), 3));
+		CHECK(NamesLine(CompileError("shapeGeo box wallMat translate 1 2 3 spin 4\n"), 1));
+		CHECK(NamesLine(CompileError("shapeGeo box wallMat\nshapeGeo box wallMat repeat 0 1 1 1\n"), 2));
+		CHECK(NamesLine(CompileError("group translate 1 0 0\n"), 1));
+		CHECK(NamesLine(CompileError("group {\n}\n}\n"), 3));
+		CHECK(NamesLine(CompileError("group {\n} x\n"), 2));
+		CHECK(NamesLine(CompileError("\ngroup { translate 1 0 0\n}\n"), 2));
+
+		// An unclosed block is reported where it opens.
+		CHECK(NamesLine(CompileError("shapeGeo box wallMat\ngroup {\n\tshapeGeo box wallMat {\n\t}\n"), 2));
+	}
+
+	// Writes a copy of the compiled scene with node i changed by edit and returns
+	// whether it loads.
+	template<typename Edit>
+	bool LoadsWithNode(const std::vector<char>& bytes, size_t nodeOffset, UINT i, Edit edit)
+	{
+		std::vector<char> changed = bytes;
+		SceneFile::Node node;
+		memcpy(&node, &changed[nodeOffset + i*sizeof(node)], sizeof(node));
+		edit(node);
+		memcpy(&changed[nodeOffset + i*sizeof(node)], &node, sizeof(node));
+
+		return LoadsFrom(changed);
+	}
+
+	void CheckMalformedFiles()
+	{
+		WriteFile(kSourceFile, kSource, sizeof(kSource) - 1);
+		CHECK(SceneFile::Compile(kSourceFile, kSceneFile));
+
+		const std::vector<char> bytes = ReadFile(kSceneFile);
+		std::unique_ptr<SceneFile> scene = SceneFile::Load(kSceneFile);
+		CHECK(scene != nullptr);
+		if(scene == nullptr)
+			return;
+
+		CHECK(LoadsFrom(bytes));
+
+		for(size_t length = 0; length < bytes.size(); ++length)
+		{
+			if(LoadsFrom(std::vector<char>(bytes.begin(), bytes.begin() + length)))
+			{
+				CHECK(!"a truncated scene loaded");
+				break;
+			}
+		}
+
+		// The nodes are stored as Load returns them; find them in the file.
+		const SceneFile::Node* nodes = scene->GetNodes();
+		const size_t nodesByteSize = scene->GetNodeCount()*sizeof(SceneFile::Node);
+		size_t nodeOffset = 0;
+		while(nodeOffset + nodesByteSize <= bytes.size() && memcmp(&bytes[nodeOffset], nodes, nodesByteSize) != 0)
+			++nodeOffset;
+		CHECK(nodeOffset + nodesByteSize <= bytes.size());
+		if(nodeOffset + nodesByteSize > bytes.size())
+			return;
+
+		// Shapes and materials past their tables, and a group with a material.
+		CHECK(!LoadsWithNode(bytes, nodeOffset, 0, [](SceneFile::Node& n) { n.Shape = 3; }));
+		CHECK(!LoadsWithNode(bytes, nodeOffset, 6, [](SceneFile::Node& n) { n.Material = 2; }));
+		CHECK(!LoadsWithNode(bytes, nodeOffset, 1, [](SceneFile::Node& n) { n.Material = 0; }));
+
+		// A group may draw nothing, but a shape needs a material.
+		CHECK(!LoadsWithNode(bytes, nodeOffset, 0, [](SceneFile::Node& n) { n.Material = kNone; }));
+
+		// Parents: a later node, the node itself, a node whose subtree has ended, and a
+		// parent for the first node.  Moving a node up to an ancestor's level, or out of
+		// the last subtree to the root, is fine.
+		CHECK(!LoadsWithNode(bytes, nodeOffset, 3, [](SceneFile::Node& n) { n.Parent = 4; }));
+		CHECK(!LoadsWithNode(bytes, nodeOffset, 3, [](SceneFile::Node& n) { n.Parent = 3; }));
+		CHECK(!LoadsWithNode(bytes, nodeOffset, 5, [](SceneFile::Node& n) { n.Parent = 3; }));
+		CHECK(!LoadsWithNode(bytes, nodeOffset, 0, [](SceneFile::Node& n) { n.Parent = 0; }));
+		CHECK(!LoadsWithNode(bytes, nodeOffset, 9, [](SceneFile::Node& n) { n.Parent = 1; }));
+		CHECK(LoadsWithNode(bytes, nodeOffset, 4, [](SceneFile::Node& n) { n.Parent = 2; }));
+		CHECK(LoadsWithNode(bytes, nodeOffset, 14, [](SceneFile::Node& n) { n.Parent = kNone; }));
+
+		// Another version.
+		std::vector<char> version = bytes;
+		version[4] ^= 1;
+		CHECK(!LoadsFrom(version));
+
+		CHECK(SceneFile::Load(L"SceneFileTests.missing") == nullptr);
+	}
+}
+
+void RunSceneFileTests(const TestContext& context)
+{
+	CheckCompile();
+	CheckSyntaxErrors();
+	CheckMalformedFiles();
+
+	DeleteFileW(kSourceFile);
+	DeleteFileW(kSceneFile);
+}
@@ -0,0 +1,215 @@
+//***************************************************************************************
+// SceneGraphTests.cpp
+//
+// SceneGraph on a small hand-built tree: the subtree sizes AddNode keeps, AddNode
+// refusing a parent that breaks the preorder, and Update recomputing exactly the dirty
+// subtrees, each node once and in ascending order, however the dirty nodes nest and in
+// whatever order they were changed.  A dirty node inside a subtree already recomputed
+// is skipped but must be clean afterwards.  Last, random trees and changes against
+// world matrices recomputed from scratch.
+//***************************************************************************************
+
+#include "Test.h"
+#include "../../Common/SceneGraph.h"
+#include <random>
+#include <stdexcept>
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT kNoParent = SceneGraph::kNoParent;
+
+	XMFLOAT4X4 Translation(float x, float y, float z)
+	{
+		XMFLOAT4X4 m;
+		XMStoreFloat4x4(&m, XMMatrixTranslation(x, y, z));
+		return m;
+	}
+
+	bool NearlyEqual(FXMMATRIX a, CXMMATRIX b)
+	{
+		XMFLOAT4X4 x, y;
+		XMStoreFloat4x4(&x, a);
+		XMStoreFloat4x4(&y, b);
+		for(int i = 0; i < 4; ++i)
+		{
+			for(int j = 0; j < 4; ++j)
+			{
+				if(fabsf(x.m[i][j] - y.m[i][j]) > 1e-4f)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool Updates(SceneGraph& graph, const std::vector<UINT>& expected)
+	{
+		return graph.Update() == expected;
+	}
+
+	//    0        4
+	//   / \       |
+	//  1   3      5
+	//  |
+	//  2
+	void BuildTree(SceneGraph& graph)
+	{
+		graph.AddNode(kNoParent, Translation(1.0f, 0.0f, 0.0f));
+		graph.AddNode(0, Translation(0.0f, 2.0f, 0.0f));
+		graph.AddNode(1, Translation(0.0f, 0.0f, 3.0f));
+		graph.AddNode(0, Translation(0.0f, 4.0f, 0.0f));
+		graph.AddNode(kNoParent, Translation(5.0f, 0.0f, 0.0f));
+		graph.AddNode(4, Translation(0.0f, 6.0f, 0.0f));
+	}
+
+	void CheckAddNode()
+	{
+		SceneGraph graph;
+		BuildTree(graph);
+		CHECK(graph.GetNodeCount() == 6);
+
+		const UINT parents[6] = { kNoParent, 0, 1, 0, kNoParent, 4 };
+		const UINT subtreeSizes[6] = { 4, 2, 1, 1, 2, 1 };
+		for(UINT i = 0; i < 6; ++i)
+		{
+			CHECK(graph.GetParent(i) == parents[i]);
+			CHECK(graph.GetSubtreeSize(i) == subtreeSizes[i]);
+		}
+
+		// The parent must be the last node or one of its ancestors: not a node yet to
+		// come, and not one whose subtree has ended.
+		for(UINT parent : { 6u, 7u, 0u, 1u, 2u, 3u })
+		{
+			bool threw = false;
+			try { graph.AddNode(parent, Translation(0.0f, 0.0f, 0.0f)); }
+			catch(const std::invalid_argument&) { threw = true; }
+			CHECK(threw);
+		}
+
+		// A refused node leaves the graph as it was.
+		CHECK(graph.GetNodeCount() == 6);
+		CHECK(graph.GetSubtreeSize(0) == 4 && graph.GetSubtreeSize(4) == 2);
+
+		CHECK(graph.AddNode(4, Translation(0.0f, 0.0f, 0.0f)) == 6);
+		CHECK(graph.GetSubtreeSize(4) == 3);
+		CHECK(graph.AddNode(6, Translation(0.0f, 0.0f, 0.0f)) == 7);
+		CHECK(graph.GetSubtreeSize(4) == 4 && graph.GetSubtreeSize(6) == 2);
+	}
+
+	void CheckUpdate()
+	{
+		SceneGraph graph;
+		BuildTree(graph);
+
+		// New nodes are dirty.
+		CHECK(Updates(graph, { 0, 1, 2, 3, 4, 5 }));
+		CHECK(NearlyEqual(graph.GetWorld(2), XMMatrixTranslation(1.0f, 2.0f, 3.0f)));
+		CHECK(NearlyEqual(graph.GetWorld(3), XMMatrixTranslation(1.0f, 4.0f, 0.0f)));
+		CHECK(NearlyEqual(graph.GetWorld(5), XMMatrixTranslation(5.0f, 6.0f, 0.0f)));
+		CHECK(Updates(graph, {}));
+
+		// Node 2 lies in the subtree of node 0, changed after it, and is changed twice;
+		// it is recomputed once, as part of that subtree, with its new transform.
+		graph.SetLocal(2, XMMatrixTranslation(0.0f, 0.0f, 7.0f));
+		graph.SetLocal(0, XMMatrixTranslation(-1.0f, 0.0f, 0.0f));
+		graph.SetLocal(2, XMMatrixTranslation(0.0f, 0.0f, 8.0f));
+		CHECK(Updates(graph, { 0, 1, 2, 3 }));
+		CHECK(NearlyEqual(graph.GetWorld(2), XMMatrixTranslation(-1.0f, 2.0f, 8.0f)));
+		CHECK(NearlyEqual(graph.GetWorld(5), XMMatrixTranslation(5.0f, 6.0f, 0.0f)));
+
+		// The skipped node is clean again, so changing it on its own queues it.
+		graph.SetLocal(2, XMMatrixTranslation(0.0f, 0.0f, 9.0f));
+		CHECK(Updates(graph, { 2 }));
+		CHECK(NearlyEqual(graph.GetWorld(2), XMMatrixTranslation(-1.0f, 2.0f, 9.0f)));
+
+		// Nested and separate subtrees, changed in any order.
+		graph.SetLocal(3, graph.GetLocal(3));
+		graph.SetLocal(1, graph.GetLocal(1));
+		CHECK(Updates(graph, { 1, 2, 3 }));
+
+		graph.SetLocal(5, graph.GetLocal(5));
+		graph.SetLocal(2, graph.GetLocal(2));
+		CHECK(Updates(graph, { 2, 5 }));
+
+		graph.SetLocal(5, XMMatrixTranslation(0.0f, 1.0f, 0.0f));
+		graph.SetLocal(4, XMMatrixTranslation(0.0f, 0.0f, 1.0f));
+		graph.SetLocal(0, graph.GetLocal(0));
+		CHECK(Updates(graph, { 0, 1, 2, 3, 4, 5 }));
+		CHECK(NearlyEqual(graph.GetWorld(5), XMMatrixTranslation(0.0f, 1.0f, 1.0f)));
+		CHECK(Updates(graph, {}));
+	}
+
+	// Random trees in preorder and random changes.  Update must return the changed nodes
+	// and their descendants, and leave every world matrix as a pass over all the nodes
+	// computes it.
+	void CheckAgainstModel()
+	{
+		std::mt19937 random(13);
+		std::uniform_real_distribution<float> offset(-2.0f, 2.0f);
+		auto randomLocal = [&]()
+		{
+			return XMMatrixRotationY(offset(random)) * XMMatrixTranslation(offset(random), offset(random), offset(random));
+		};
+
+		for(int tree = 0; tree < 20; ++tree)
+		{
+			SceneGraph graph;
+
+			// Each node goes under the last node or one of its ancestors, or is a root.
+			std::vector<UINT> ancestors;
+			const UINT nodeCount = 1 + random() % 300;
+			for(UINT i = 0; i < nodeCount; ++i)
+			{
+				ancestors.resize(random() % (ancestors.size() + 1));
+				XMFLOAT4X4 local;
+				XMStoreFloat4x4(&local, randomLocal());
+				graph.AddNode(ancestors.empty() ? kNoParent : ancestors.back(), local);
+				ancestors.push_back(i);
+			}
+			graph.Update();
+
+			for(int step = 0; step < 20; ++step)
+			{
+				std::vector<bool> expected(nodeCount, false);
+				const UINT changes = random() % 6;
+				for(UINT k = 0; k < changes; ++k)
+				{
+					const UINT node = random() % nodeCount;
+					graph.SetLocal(node, randomLocal());
+					for(UINT i = node; i < node + graph.GetSubtreeSize(node); ++i)
+						expected[i] = true;
+				}
+
+				std::vector<UINT> expectedNodes;
+				for(UINT i = 0; i < nodeCount; ++i)
+				{
+					if(expected[i])
+						expectedNodes.push_back(i);
+				}
+				CHECK(Updates(graph, expectedNodes));
+
+				std::vector<XMFLOAT4X4> worlds(nodeCount);
+				bool same = true;
+				for(UINT i = 0; i < nodeCount; ++i)
+				{
+					XMMATRIX world = graph.GetLocal(i);
+					if(graph.GetParent(i) != kNoParent)
+						world = world * XMLoadFloat4x4(&worlds[graph.GetParent(i)]);
+
+					XMStoreFloat4x4(&worlds[i], world);
+					same = same && NearlyEqual(graph.GetWorld(i), world);
+				}
+				CHECK(same);
+			}
+		}
+	}
+}
+
+void RunSceneGraphTests(const TestContext& context)
+{
+	CheckAddNode();
+	CheckUpdate();
+	CheckAgainstModel();
+}
@@ -0,0 +1,69 @@
+//***************************************************************************************
+// ShapeTests.cpp
+//
+// Checks that the table driven shape generators produce exactly the vertices and
+// indices of the hand-written ones they replaced, kept in LegacyShapes.
+//
+// The diamond is the one exception.  The original copied 37 vertices out of a 17
+// element array, so its meshes carried 19 unreferenced vertices of whatever was on the
+// stack, and every midpoint index Subdivide added was 19 higher.  LegacyShapes keeps
+// only the 17 real vertices, which makes the rest of the comparison exact; the test
+// also checks that the current diamond references every vertex it has.
+//***************************************************************************************
+
+#include "Test.h"
+#include "LegacyShapes.h"
+#include <cstring>
+
+namespace
+{
+	using MeshData = GeometryGenerator::MeshData;
+
+	bool BitIdentical(const MeshData& a, const MeshData& b)
+	{
+		return a.Vertices.size() == b.Vertices.size() &&
+			a.Indices32 == b.Indices32 &&
+			std::memcmp(a.Vertices.data(), b.Vertices.data(),
+				a.Vertices.size()*sizeof(GeometryGenerator::Vertex)) == 0;
+	}
+
+	bool ReferencesEveryVertex(const MeshData& mesh)
+	{
+		std::vector<bool> used(mesh.Vertices.size(), false);
+		for(GeometryGenerator::uint32 i : mesh.Indices32)
+			used[i] = true;
+
+		return std::find(used.begin(), used.end(), false) == used.end();
+	}
+
+	// The sizes the demo uses, unit and odd sizes, zero, and negative sizes, which
+	// mirror the shape and must keep the signs of the zero components.
+	const float kSizes[][5] =
+	{
+		{ 1.0f, 1.0f, 1.0f, 0.5f, 0.5f },
+		{ 2.0f, 3.0f, 0.75f, 1.5f, 0.25f },
+		{ 0.1f, 7.3f, 12.9f, 0.01f, 5.5f },
+		{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f },
+		{ -1.0f, 2.0f, -0.5f, -0.25f, 1.0f },
+		{ -3.0f, -3.0f, -3.0f, -3.0f, -3.0f },
+	};
+}
+
+void RunShapeTests(const TestContext& context)
+{
+	GeometryGenerator geoGen;
+
+	for(const float* s : kSizes)
+	{
+		CHECK(BitIdentical(geoGen.CreateWedge(s[0], s[1], s[2]), LegacyShapes::CreateWedge(s[0], s[1], s[2])));
+		CHECK(BitIdentical(geoGen.CreatePyramid(s[0], s[1], s[2]), LegacyShapes::CreatePyramid(s[0], s[1], s[2])));
+		CHECK(BitIdentical(geoGen.CreateTruncatedPyramid(s[0], s[1], s[2], s[3], s[4]),
+			LegacyShapes::CreateTruncatedPyramid(s[0], s[1], s[2], s[3], s[4])));
+		CHECK(BitIdentical(geoGen.CreateTriangularPrism(s[0], s[1], s[2]), LegacyShapes::CreateTriangularPrism(s[0], s[1], s[2])));
+		CHECK(BitIdentical(geoGen.CreateTetrahedron(s[0], s[1]), LegacyShapes::CreateTetrahedron(s[0], s[1])));
+
+		MeshData diamond = geoGen.CreateDiamondOfDeath(s[0]);
+		CHECK(BitIdentical(diamond, LegacyShapes::CreateDiamondOfDeath(s[0])));
+		CHECK(ReferencesEveryVertex(diamond));
+	}
+}
@@ -0,0 +1,47 @@
+//***************************************************************************************
+// Test.h
+//
+// Shared pieces of the headless tests: the check macro, which counts failures and
+// reports where they happened, and the table of test suites TestMain runs.
+//***************************************************************************************
+
+#pragma once
+
+#include "../../Common/d3dUtil.h"
+#include <cstdio>
+
+struct TestContext
+{
+	// Where the source models (skull.txt, car.txt) are, with a trailing separator.
+	std::wstring ModelDirectory;
+};
+
+struct TestSuite
+{
+	const char* Name;
+	void (*Run)(const TestContext& context);
+};
+
+// Number of failed checks so far.
+extern int gTestFailures;
+
+void ReportTestFailure(const char* expression, const char* file, int line);
+
+// Records a failure, and carries on, if the condition does not hold.
+#ifndef CHECK
+#define CHECK(condition)                                              \
+{                                                                     \
+	if(!(condition)) { ReportTestFailure(#condition, __FILE__, __LINE__); } \
+}
+#endif
+
+// The suites, defined one per file.
+void RunShapeTests(const TestContext& context);
+void RunMeshCodecTests(const TestContext& context);
+void RunMeshCacheTests(const TestContext& context);
+void RunFrustumCullerTests(const TestContext& context);
+void RunMeshNormalsTests(const TestContext& context);
+void RunRangeAllocatorTests(const TestContext& context);
+void RunSceneFileTests(const TestContext& context);
+void RunDirtyTrackerTests(const TestContext& context);
+void RunSceneGraphTests(const TestContext& context);
@@ -0,0 +1,97 @@
+//***************************************************************************************
+// TestMain.cpp
+//
+// Command line runner for the headless tests of the Common code:
+//
+//   Tests [-models <directory>] [<suite> ...]
+//
+// Runs the named suites, or all of them, and exits with 1 if any check failed.  The
+// models directory defaults to the demo's, relative to this project's directory.
+//***************************************************************************************
+
+#include "Test.h"
+
+#pragma comment(lib, "d3dcompiler.lib")
+
+int gTestFailures = 0;
+
+namespace
+{
+	const TestSuite kSuites[] =
+	{
+		{ "shapes", RunShapeTests },
+		{ "meshcodec", RunMeshCodecTests },
+		{ "meshcache", RunMeshCacheTests },
+		{ "frustumculler", RunFrustumCullerTests },
+		{ "meshnormals", RunMeshNormalsTests },
+		{ "rangeallocator", RunRangeAllocatorTests },
+		{ "scenefile", RunSceneFileTests },
+		{ "dirtytracker", RunDirtyTrackerTests },
+		{ "scenegraph", RunSceneGraphTests },
+	};
+
+	int PrintUsage()
+	{
+		wprintf(L"usage: Tests [-models <directory>] [<suite> ...]\nsuites:");
+		for(const TestSuite& suite : kSuites)
+			wprintf(L" %hs", suite.Name);
+		wprintf(L"\n");
+		return 2;
+	}
+}
+
+void ReportTestFailure(const char* expression, const char* file, int line)
+{
+	wprintf(L"%hs(%d): check failed: %hs\n", file, line, expression);
+	++gTestFailures;
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+	TestContext context;
+	context.ModelDirectory = L"..\\Project\\Models\\";
+
+	std::vector<const TestSuite*> selected;
+	for(int i = 1; i < argc; ++i)
+	{
+		std::wstring arg = argv[i];
+		if(arg == L"-models" && i + 1 < argc)
+		{
+			context.ModelDirectory = argv[++i];
+			if(context.ModelDirectory.back() != L'\\' && context.ModelDirectory.back() != L'/')
+				context.ModelDirectory += L'\\';
+			continue;
+		}
+
+		auto suite = std::find_if(std::begin(kSuites), std::end(kSuites),
+			[&](const TestSuite& s) { return arg == std::wstring(s.Name, s.Name + strlen(s.Name)); });
+		if(suite == std::end(kSuites))
+			return PrintUsage();
+
+		selected.push_back(suite);
+	}
+
+	if(selected.empty())
+	{
+		for(const TestSuite& suite : kSuites)
+			selected.push_back(&suite);
+	}
+
+	for(const TestSuite* suite : selected)
+	{
+		const int failuresBefore = gTestFailures;
+		try
+		{
+			suite->Run(context);
+		}
+		catch(const std::exception& e)
+		{
+			wprintf(L"%hs: exception: %hs\n", suite->Name, e.what());
+			++gTestFailures;
+		}
+
+		wprintf(L"%hs: %ls\n", suite->Name, gTestFailures == failuresBefore ? L"ok" : L"FAILED");
+	}
+
+	return gTestFailures == 0 ? 0 : 1;
+}